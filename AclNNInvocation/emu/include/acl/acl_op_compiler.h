@@ -0,0 +1,12 @@
+/**
+ * @file acl_op_compiler.h
+ *
+ * CPU emulation of the AscendCL op compiler header. The emulated runtime has
+ * no online compilation, the header only exists so sources include unchanged.
+ */
+#ifndef ACL_EMU_ACL_OP_COMPILER_H
+#define ACL_EMU_ACL_OP_COMPILER_H
+
+#include "acl/acl.h"
+
+#endif // ACL_EMU_ACL_OP_COMPILER_H
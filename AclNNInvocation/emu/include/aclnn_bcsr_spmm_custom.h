@@ -0,0 +1,27 @@
+/**
+ * @file aclnn_bcsr_spmm_custom.h
+ *
+ * CPU emulation of the generated single op API of BcsrSpmmCustom.
+ */
+#ifndef ACL_EMU_ACLNN_BCSR_SPMM_CUSTOM_H
+#define ACL_EMU_ACLNN_BCSR_SPMM_CUSTOM_H
+
+#include "aclnn/acl_meta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+aclnnStatus aclnnBcsrSpmmCustomGetWorkspaceSize(const aclIntArray *aShape, const aclTensor *rowPtr,
+                                                const aclTensor *col, const aclTensor *val, const aclTensor *b,
+                                                const aclTensor *out, uint64_t *workspaceSize,
+                                                aclOpExecutor **executor);
+
+aclnnStatus aclnnBcsrSpmmCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor,
+                                aclrtStream stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACL_EMU_ACLNN_BCSR_SPMM_CUSTOM_H
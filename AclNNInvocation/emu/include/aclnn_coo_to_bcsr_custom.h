@@ -0,0 +1,28 @@
+/**
+ * @file aclnn_coo_to_bcsr_custom.h
+ *
+ * CPU emulation of the generated single op API of CooToBcsrCustom.
+ */
+#ifndef ACL_EMU_ACLNN_COO_TO_BCSR_CUSTOM_H
+#define ACL_EMU_ACLNN_COO_TO_BCSR_CUSTOM_H
+
+#include "aclnn/acl_meta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+aclnnStatus aclnnCooToBcsrCustomGetWorkspaceSize(const aclIntArray *cooShape, const aclTensor *row,
+                                                 const aclTensor *col, const aclTensor *value,
+                                                 const aclTensor *rowPtr, const aclTensor *bcsrCol,
+                                                 const aclTensor *bcsrVal, uint64_t *workspaceSize,
+                                                 aclOpExecutor **executor);
+
+aclnnStatus aclnnCooToBcsrCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor,
+                                 aclrtStream stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACL_EMU_ACLNN_COO_TO_BCSR_CUSTOM_H
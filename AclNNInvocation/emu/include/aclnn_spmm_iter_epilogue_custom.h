@@ -0,0 +1,27 @@
+/**
+ * @file aclnn_spmm_iter_epilogue_custom.h
+ *
+ * CPU emulation of the generated single op API of SpmmIterEpilogueCustom.
+ */
+#ifndef ACL_EMU_ACLNN_SPMM_ITER_EPILOGUE_CUSTOM_H
+#define ACL_EMU_ACLNN_SPMM_ITER_EPILOGUE_CUSTOM_H
+
+#include "aclnn/acl_meta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+aclnnStatus aclnnSpmmIterEpilogueCustomGetWorkspaceSize(const aclTensor *c, const aclTensor *x, double scale,
+                                                        bool withNorm, const aclTensor *xNext,
+                                                        const aclTensor *norm, uint64_t *workspaceSize,
+                                                        aclOpExecutor **executor);
+
+aclnnStatus aclnnSpmmIterEpilogueCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor,
+                                        aclrtStream stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ACL_EMU_ACLNN_SPMM_ITER_EPILOGUE_CUSTOM_H
@@ -0,0 +1,51 @@
+/**
+ * @file acl_emu_internal.h
+ *
+ * Object layouts shared by the emulated runtime and the emulated ops.
+ */
+#ifndef ACL_EMU_INTERNAL_H
+#define ACL_EMU_INTERNAL_H
+
+#include <vector>
+
+#include "acl/acl.h"
+#include "aclnn/acl_meta.h"
+
+struct aclTensorDesc {
+    aclDataType dataType;
+    aclFormat format;
+    std::vector<int64_t> dims;
+};
+
+struct aclDataBuffer {
+    void *data;
+    size_t size;
+};
+
+struct aclTensor {
+    aclDataType dataType;
+    aclFormat format;
+    std::vector<int64_t> dims;
+    void *data;
+};
+
+struct aclIntArray {
+    std::vector<int64_t> values;
+};
+
+/**
+ * An executor captures what GetWorkspaceSize resolved and runs it on the
+ * calling thread. Non-repeatable executors are released after one launch.
+ */
+struct aclOpExecutor {
+    virtual ~aclOpExecutor() {}
+    virtual aclnnStatus Run(void *workspace, uint64_t workspaceSize) = 0;
+    bool repeatable = false;
+};
+
+namespace aclemu {
+int64_t ElementCount(const std::vector<int64_t> &dims);
+aclnnStatus LaunchExecutor(aclOpExecutor *executor, void *workspace, uint64_t workspaceSize, aclrtStream stream);
+} // namespace aclemu
+
+#endif // ACL_EMU_INTERNAL_H
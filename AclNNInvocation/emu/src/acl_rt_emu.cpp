@@ -0,0 +1,437 @@
+/**
+ * @file acl_rt_emu.cpp
+ *
+ * CPU emulation of the AscendCL runtime entry points used by AclNNInvocation.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "acl_emu_internal.h"
+
+namespace {
+// matches the 32B alignment GM buffers get from the device allocator
+constexpr size_t EMU_MEM_ALIGN = 64;
+
+struct EmuStream {
+    int placeholder;
+};
+
+struct EmuEvent {
+    std::chrono::steady_clock::time_point stamp;
+    bool recorded;
+};
+
+void *AlignedAlloc(size_t size)
+{
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, EMU_MEM_ALIGN, size == 0 ? EMU_MEM_ALIGN : size) != 0) {
+        return nullptr;
+    }
+    return ptr;
+}
+} // namespace
+
+namespace aclemu {
+int64_t ElementCount(const std::vector<int64_t> &dims)
+{
+    int64_t count = 1;
+    for (int64_t dim : dims) {
+        count *= dim;
+    }
+    return count;
+}
+
+aclnnStatus LaunchExecutor(aclOpExecutor *executor, void *workspace, uint64_t workspaceSize, aclrtStream stream)
+{
+    (void)stream;
+    if (executor == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    aclnnStatus ret = executor->Run(workspace, workspaceSize);
+    // 启动失败时执行器仍归调用方，由其 aclDestroyAclOpExecutor
+    if (!executor->repeatable && ret == ACL_SUCCESS) {
+        delete executor;
+    }
+    return ret;
+}
+} // namespace aclemu
+
+extern "C" {
+aclError aclInit(const char *configPath)
+{
+    (void)configPath;
+    return ACL_SUCCESS;
+}
+
+aclError aclFinalize()
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSetDevice(int32_t deviceId)
+{
+    return deviceId < 0 ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclrtResetDevice(int32_t deviceId)
+{
+    return deviceId < 0 ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclrtGetRunMode(aclrtRunMode *runMode)
+{
+    if (runMode == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *runMode = ACL_HOST;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMalloc(void **devPtr, size_t size, aclrtMemMallocPolicy policy)
+{
+    (void)policy;
+    if (devPtr == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *devPtr = AlignedAlloc(size);
+    return *devPtr == nullptr ? ACL_ERROR_BAD_ALLOC : ACL_SUCCESS;
+}
+
+aclError aclrtMallocHost(void **hostPtr, size_t size)
+{
+    return aclrtMalloc(hostPtr, size, ACL_MEM_MALLOC_HUGE_FIRST);
+}
+
+aclError aclrtFree(void *devPtr)
+{
+    free(devPtr);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtFreeHost(void *hostPtr)
+{
+    free(hostPtr);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMemset(void *devPtr, size_t maxCount, int32_t value, size_t count)
+{
+    if (devPtr == nullptr || count > maxCount) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    memset(devPtr, value, count);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMemsetAsync(void *devPtr, size_t maxCount, int32_t value, size_t count, aclrtStream stream)
+{
+    (void)stream;
+    return aclrtMemset(devPtr, maxCount, value, count);
+}
+
+aclError aclrtMemcpy(void *dst, size_t destMax, const void *src, size_t count, aclrtMemcpyKind kind)
+{
+    (void)kind;
+    if (count > destMax || (count != 0 && (dst == nullptr || src == nullptr))) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    if (count != 0) {
+        memmove(dst, src, count);
+    }
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMemcpyAsync(void *dst, size_t destMax, const void *src, size_t count, aclrtMemcpyKind kind,
+                          aclrtStream stream)
+{
+    (void)stream;
+    return aclrtMemcpy(dst, destMax, src, count, kind);
+}
+
+aclError aclrtCreateStream(aclrtStream *stream)
+{
+    if (stream == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *stream = new EmuStream();
+    return ACL_SUCCESS;
+}
+
+aclError aclrtDestroyStream(aclrtStream stream)
+{
+    delete static_cast<EmuStream *>(stream);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSynchronizeStream(aclrtStream stream)
+{
+    (void)stream;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSynchronizeStreamWithTimeout(aclrtStream stream, int32_t timeout)
+{
+    (void)timeout;
+    return aclrtSynchronizeStream(stream);
+}
+
+aclError aclrtStreamWaitEvent(aclrtStream stream, aclrtEvent event)
+{
+    (void)stream;
+    return event == nullptr ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclrtCreateEvent(aclrtEvent *event)
+{
+    if (event == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    EmuEvent *emuEvent = new EmuEvent();
+    emuEvent->recorded = false;
+    *event = emuEvent;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtDestroyEvent(aclrtEvent event)
+{
+    delete static_cast<EmuEvent *>(event);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtRecordEvent(aclrtEvent event, aclrtStream stream)
+{
+    (void)stream;
+    if (event == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    EmuEvent *emuEvent = static_cast<EmuEvent *>(event);
+    emuEvent->stamp = std::chrono::steady_clock::now();
+    emuEvent->recorded = true;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSynchronizeEvent(aclrtEvent event)
+{
+    return event == nullptr ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclrtEventElapsedTime(float *ms, aclrtEvent startEvent, aclrtEvent endEvent)
+{
+    EmuEvent *start = static_cast<EmuEvent *>(startEvent);
+    EmuEvent *end = static_cast<EmuEvent *>(endEvent);
+    if (ms == nullptr || start == nullptr || end == nullptr || !start->recorded || !end->recorded) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *ms = std::chrono::duration<float, std::milli>(end->stamp - start->stamp).count();
+    return ACL_SUCCESS;
+}
+
+aclDataBuffer *aclCreateDataBuffer(void *data, size_t size)
+{
+    aclDataBuffer *buffer = new aclDataBuffer();
+    buffer->data = data;
+    buffer->size = size;
+    return buffer;
+}
+
+aclError aclDestroyDataBuffer(const aclDataBuffer *dataBuffer)
+{
+    delete dataBuffer;
+    return ACL_SUCCESS;
+}
+
+aclTensorDesc *aclCreateTensorDesc(aclDataType dataType, int numDims, const int64_t *dims, aclFormat format)
+{
+    if (numDims < 0 || (numDims > 0 && dims == nullptr)) {
+        return nullptr;
+    }
+    aclTensorDesc *desc = new aclTensorDesc();
+    desc->dataType = dataType;
+    desc->format = format;
+    desc->dims.assign(dims, dims + numDims);
+    return desc;
+}
+
+void aclDestroyTensorDesc(const aclTensorDesc *desc)
+{
+    delete desc;
+}
+
+size_t aclDataTypeSize(aclDataType dataType)
+{
+    switch (dataType) {
+        case ACL_BOOL:
+        case ACL_INT8:
+        case ACL_UINT8:
+            return 1;
+        case ACL_FLOAT16:
+        case ACL_INT16:
+        case ACL_UINT16:
+            return 2;
+        case ACL_FLOAT:
+        case ACL_INT32:
+        case ACL_UINT32:
+            return 4;
+        case ACL_INT64:
+        case ACL_UINT64:
+        case ACL_DOUBLE:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+size_t aclGetTensorDescElementCount(const aclTensorDesc *desc)
+{
+    return desc == nullptr ? 0 : static_cast<size_t>(aclemu::ElementCount(desc->dims));
+}
+
+size_t aclGetTensorDescSize(const aclTensorDesc *desc)
+{
+    return desc == nullptr ? 0 : aclGetTensorDescElementCount(desc) * aclDataTypeSize(desc->dataType);
+}
+
+size_t aclGetTensorDescNumDims(const aclTensorDesc *desc)
+{
+    return desc == nullptr ? 0 : desc->dims.size();
+}
+
+aclError aclGetTensorDescDimV2(const aclTensorDesc *desc, size_t index, int64_t *dimSize)
+{
+    if (desc == nullptr || dimSize == nullptr || index >= desc->dims.size()) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *dimSize = desc->dims[index];
+    return ACL_SUCCESS;
+}
+
+aclDataType aclGetTensorDescType(const aclTensorDesc *desc)
+{
+    return desc == nullptr ? ACL_DT_UNDEFINED : desc->dataType;
+}
+
+aclFormat aclGetTensorDescFormat(const aclTensorDesc *desc)
+{
+    return desc == nullptr ? ACL_FORMAT_UNDEFINED : desc->format;
+}
+
+float aclFloat16ToFloat(aclFloat16 value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // subnormal half: normalise into a float exponent
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+    } else if (exponent == 0x1f) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+aclFloat16 aclFloatToFloat16(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffffu;
+    if (((bits >> 23) & 0xffu) == 0xffu) {
+        return static_cast<aclFloat16>(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0));
+    }
+    if (exponent >= 0x1f) {
+        return static_cast<aclFloat16>(sign | 0x7c00u);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return static_cast<aclFloat16>(sign);
+        }
+        mantissa |= 0x800000u;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u) != 0)) {
+            ++half;
+        }
+        return static_cast<aclFloat16>(sign | half);
+    }
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u) != 0)) {
+        ++half; // carries into the exponent correctly, up to infinity
+    }
+    return static_cast<aclFloat16>(half);
+}
+
+aclTensor *aclCreateTensor(const int64_t *viewDims, uint64_t viewDimsNum, aclDataType dataType,
+                           const int64_t *stride, int64_t offset, aclFormat format, const int64_t *storageDims,
+                           uint64_t storageDimsNum, void *tensorData)
+{
+    (void)stride;
+    (void)offset;
+    (void)storageDims;
+    (void)storageDimsNum;
+    if (viewDimsNum > 0 && viewDims == nullptr) {
+        return nullptr;
+    }
+    aclTensor *tensor = new aclTensor();
+    tensor->dataType = dataType;
+    tensor->format = format;
+    tensor->dims.assign(viewDims, viewDims + viewDimsNum);
+    tensor->data = tensorData;
+    return tensor;
+}
+
+aclnnStatus aclDestroyTensor(const aclTensor *tensor)
+{
+    delete tensor;
+    return ACL_SUCCESS;
+}
+
+aclIntArray *aclCreateIntArray(const int64_t *value, uint64_t size)
+{
+    if (size > 0 && value == nullptr) {
+        return nullptr;
+    }
+    aclIntArray *array = new aclIntArray();
+    array->values.assign(value, value + size);
+    return array;
+}
+
+aclnnStatus aclDestroyIntArray(const aclIntArray *array)
+{
+    delete array;
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclSetAclOpExecutorRepeatable(aclOpExecutor *executor)
+{
+    if (executor == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    executor->repeatable = true;
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclDestroyAclOpExecutor(aclOpExecutor *executor)
+{
+    delete executor;
+    return ACL_SUCCESS;
+}
+} // extern "C"
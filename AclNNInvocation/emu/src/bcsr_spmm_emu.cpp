@@ -0,0 +1,399 @@
+/**
+ * @file bcsr_spmm_emu.cpp
+ *
+ * CPU emulation of aclnnBcsrSpmmCustom on top of the CpuSpmm engine. Follows
+ * the device kernel semantics: 16x16 fp16 blocks, fp32 accumulation, and
+ * results added onto the existing contents of C the way the kernel's atomic
+ * Fixpipe does, or written over C with BCSR_SPMM_FLAG_DIRECT_OUTPUT. The
+ * tuning parameters are resolved like TilingFunc does; with
+ * BCSR_SPMM_FLAG_PROFILE the row windows are split over cores by the tuned
+ * core count and partition, each core's share runs on one thread and its
+ * counters land in the workspace region the instrumented kernel would fill.
+ * With BCSR_SPMM_FLAG_SCHEDULE the cores take their windows from the schedule
+ * the host wrote after the counters, in the order the kernel would. With
+ * BCSR_SPMM_FLAG_DENSE the dense windows are computed from the dense rows the
+ * host wrote to the workspace, not from val, so the host copy is checked too.
+ * With BCSR_SPMM_FLAG_MIX the last mixNum schedule entries are profiled as the
+ * vector cores of the gather kernel, two per cube core, in the slots after
+ * the cube cores.
+ */
+#include "aclnn_bcsr_spmm_custom.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "acl_emu_internal.h"
+#include "bcsr_spmm_desc.h"
+#include "bcsr_spmm_tune.h"
+#include "cpu_spmm.h"
+
+namespace {
+constexpr int64_t EMU_AIC_CORE_NUM = 24;    // GetCoreNumAic() of ascend910b
+constexpr int64_t EMU_AIV_CORE_NUM = 48;    // GetCoreNumAiv()，N < BCSR_SPMM_SMALL_N 时的向量 kernel
+constexpr int64_t EMU_TILE_M = 16;
+constexpr int64_t EMU_TILE_K = 16;
+constexpr uint64_t EMU_CYCLE_MHZ = 1000;    // 计数按 ns 记录
+constexpr uint64_t EMU_L1_BYTES = 512 * 1024;   // 每个 cube core 的 L1，决定 B 面板缓存的槽位数
+constexpr uint64_t EMU_L0B_BYTES = 64 * 1024;   // 每个 cube core 的 L0B，决定稠密窗口一次 Mmad 的 K
+constexpr uint64_t EMU_UB_BYTES = 192 * 1024;   // 每个向量核的 UB，决定 MIX 模式一次累加的 N 列数
+
+CpuIndexType ToCpuIndexType(aclDataType dataType)
+{
+    switch (dataType) {
+        case ACL_UINT16:
+            return CPU_INDEX_BLOCK_U16;
+        case ACL_INT64:
+            return CPU_INDEX_INT64;
+        default:
+            return CPU_INDEX_INT32;
+    }
+}
+
+size_t IndexSize(CpuIndexType type)
+{
+    return type == CPU_INDEX_INT64 ? sizeof(int64_t) : (type == CPU_INDEX_BLOCK_U16 ? sizeof(uint16_t) : sizeof(int32_t));
+}
+
+int64_t LoadIndex(const void *data, CpuIndexType type, int64_t i)
+{
+    switch (type) {
+        case CPU_INDEX_BLOCK_U16:
+            return static_cast<int64_t>(static_cast<const uint16_t *>(data)[i]) * EMU_TILE_K;
+        case CPU_INDEX_INT64:
+            return static_cast<const int64_t *>(data)[i];
+        default:
+            return static_cast<const int32_t *>(data)[i];
+    }
+}
+
+// 与 TilingFunc 相同：a_shape 显式给出的调优参数优先，否则按稀疏签名查调优库
+BcsrSpmmTuneConfig ResolveTune(const aclIntArray *aShape, const aclTensor *col, const aclTensor *b,
+                               const aclTensor *out)
+{
+    const std::vector<int64_t> &values = aShape->values;
+    int64_t flags = values.size() > BCSR_SPMM_SHAPE_FLAGS ? values[BCSR_SPMM_SHAPE_FLAGS] : 0;
+    int64_t signature = values.size() > BCSR_SPMM_SHAPE_SIGNATURE ? values[BCSR_SPMM_SHAPE_SIGNATURE] : 0;
+    BcsrSpmmTuneConfig tune;
+    if ((flags & BCSR_SPMM_FLAG_TUNE) != 0 && values.size() > BCSR_SPMM_SHAPE_TUNE) {
+        tune = BcsrSpmmUnpackTune(values[BCSR_SPMM_SHAPE_TUNE]);
+    } else {
+        (void)BcsrSpmmLookupTune(BcsrSpmmTuneDbPath(), BcsrSpmmTuneKey(out->dims[0], b->dims[0], b->dims[1],
+            aclemu::ElementCount(col->dims), signature), tune);
+    }
+    return BcsrSpmmTuneValid(tune) ? tune : BcsrSpmmTuneConfig();
+}
+
+class BcsrSpmmExecutor : public aclOpExecutor {
+public:
+    BcsrSpmmExecutor(const aclIntArray *aShape, const aclTensor *rowPtr, const aclTensor *col,
+                     const aclTensor *val, const aclTensor *b, const aclTensor *out)
+        : out_(out), profile_(false), direct_(false), bCacheSlots_(0), scheduled_(false), dense_(false),
+          denseKTile_(0), denseMap_(nullptr), denseStore_(nullptr), mixNum_(0)
+    {
+        // same source of truth as TilingFunc: M from C, K and N from B, flags from a_shape
+        int64_t flags = aShape->values.size() > BCSR_SPMM_SHAPE_FLAGS ? aShape->values[BCSR_SPMM_SHAPE_FLAGS] : 0;
+        profile_ = (flags & BCSR_SPMM_FLAG_PROFILE) != 0;
+        tune_ = ResolveTune(aShape, col, b, out);
+        direct_ = (flags & BCSR_SPMM_FLAG_DIRECT_OUTPUT) != 0 || b->dims[1] < BCSR_SPMM_SMALL_N;
+        bCacheSlots_ = (flags & BCSR_SPMM_FLAG_B_CACHE) != 0 && b->dims[1] >= BCSR_SPMM_SMALL_N ?
+            BcsrSpmmBCacheSlots(EMU_L1_BYTES, tune_.mmadN) : 0;
+        int64_t windowNum = aclemu::ElementCount(rowPtr->dims) - 1;
+        int64_t denseNum = aShape->values.size() > BCSR_SPMM_SHAPE_DENSE ? aShape->values[BCSR_SPMM_SHAPE_DENSE] : 0;
+        int64_t mixNum = aShape->values.size() > BCSR_SPMM_SHAPE_MIX ? aShape->values[BCSR_SPMM_SHAPE_MIX] : 0;
+        layout_ = BcsrSpmmUserWorkspaceLayout(flags, b->dims[0], b->dims[1], windowNum, denseNum, mixNum);
+        scheduled_ = BcsrSpmmScheduleBytes(flags, b->dims[1], windowNum, mixNum) != 0;
+        mixNum_ = BcsrSpmmMixActive(flags, b->dims[1], mixNum) ? mixNum : 0;
+        dense_ = BcsrSpmmDenseActive(flags, b->dims[1], denseNum);
+        if (dense_) {
+            // 一条稠密行是一个块列齐全的单窗口 BCSR：块 c 的起始列为 16c
+            denseKTile_ = BcsrSpmmDenseKTile(EMU_L0B_BYTES, tune_.mmadN, b->dims[0]);
+            int64_t kBlocks = (b->dims[0] + EMU_TILE_K - 1) / EMU_TILE_K;
+            for (int64_t c = 0; c < kBlocks; ++c) {
+                denseCols_.push_back(static_cast<int64_t>(c * EMU_TILE_K));
+            }
+            denseRowPtr_[0] = 0;
+            denseRowPtr_[1] = kBlocks;
+        }
+        args_.m = out->dims[0];
+        args_.k = b->dims[0];
+        args_.n = b->dims[1];
+        args_.windowNum = aclemu::ElementCount(rowPtr->dims) - 1;
+        args_.rowPtr = rowPtr->data;
+        args_.rowPtrType = ToCpuIndexType(rowPtr->dataType);
+        args_.col = col->data;
+        args_.colType = ToCpuIndexType(col->dataType);
+        args_.val = static_cast<const uint16_t *>(val->data);
+        args_.b = static_cast<const uint16_t *>(b->data);
+    }
+
+    aclnnStatus Run(void *workspace, uint64_t workspaceSize) override
+    {
+        // 直写模式与向量 kernel 按窗口覆盖写 C，不依赖 C 已清零
+        if (direct_) {
+            std::memset(out_->data, 0, static_cast<size_t>(args_.m * args_.n) * sizeof(float));
+        }
+        if (dense_) {
+            if (workspace == nullptr || workspaceSize < layout_.bytes) {
+                return ACL_ERROR_INVALID_PARAM;
+            }
+            const char *user = static_cast<const char *>(workspace) + workspaceSize - layout_.bytes;
+            denseMap_ = reinterpret_cast<const uint32_t *>(user + layout_.denseMap);
+            denseStore_ = reinterpret_cast<const uint16_t *>(user + layout_.denseStore);
+        }
+        if (profile_) {
+            return RunProfiled(workspace, workspaceSize);
+        }
+        if (!dense_) {
+            return engine_.Run(args_, static_cast<float *>(out_->data)) ? ACL_SUCCESS : ACL_ERROR_INVALID_PARAM;
+        }
+        return RunRange(engine_, 0, args_.windowNum) ? ACL_SUCCESS : ACL_ERROR_INVALID_PARAM;
+    }
+
+private:
+    uint32_t DenseSlot(int64_t w) const
+    {
+        return dense_ ? denseMap_[w] : 0;
+    }
+
+    // 执行 [w0, w0 + length) 的窗口：相邻的 BCSR 窗口合成一段，稠密窗口按各自的稠密行计算
+    bool RunRange(const CpuSpmm &engine, int64_t w0, int64_t length) const
+    {
+        float *c = static_cast<float *>(out_->data);
+        int64_t begin = w0;
+        for (int64_t w = w0; w <= w0 + length; ++w) {
+            uint32_t slot = w < w0 + length ? DenseSlot(w) : 0;
+            if (w < w0 + length && slot == 0) {
+                continue;
+            }
+            if (w > begin) {
+                CpuSpmmArgs sub = args_;
+                sub.windowNum = w - begin;
+                sub.m = std::min(sub.windowNum * EMU_TILE_M, args_.m - begin * EMU_TILE_M);
+                sub.rowPtr = static_cast<const char *>(args_.rowPtr) + begin * IndexSize(args_.rowPtrType);
+                if (!engine.Run(sub, c + begin * EMU_TILE_M * args_.n)) {
+                    return false;
+                }
+            }
+            if (slot != 0) {
+                CpuSpmmArgs row = args_;
+                row.windowNum = 1;
+                row.m = std::min(EMU_TILE_M, args_.m - w * EMU_TILE_M);
+                row.rowPtr = denseRowPtr_;
+                row.rowPtrType = CPU_INDEX_INT64;
+                row.col = denseCols_.data();
+                row.colType = CPU_INDEX_INT64;
+                row.val = denseStore_ + static_cast<size_t>(slot - 1) * BcsrSpmmDenseRowElems(args_.k);
+                if (!engine.Run(row, c + w * EMU_TILE_M * args_.n)) {
+                    return false;
+                }
+            }
+            begin = w + 1;
+        }
+        return true;
+    }
+
+    // 单线程执行 [w0, w0 + length) 的窗口，累加块数与 B 搬运量；tags 为本 core 的 B 面板缓存，
+    // 按 kernel 的遍历顺序（直写时面板在外、块在内）模拟直接映射的命中
+    bool RunWindows(const CpuSpmm &single, int64_t w0, int64_t length, uint64_t *slot,
+                    std::vector<int64_t> &tags) const
+    {
+        // 向量 kernel 每块只搬 validRows x N 的 B，一次块乘向量
+        bool smallN = args_.n < BCSR_SPMM_SMALL_N;
+        int64_t mmadNum = smallN ? 1 : (args_.n + tune_.mmadN - 1) / tune_.mmadN;
+        int64_t panelN = smallN ? args_.n : tune_.mmadN * mmadNum;
+        if (!RunRange(single, w0, length)) {
+            return false;
+        }
+        int64_t blkBegin = LoadIndex(args_.rowPtr, args_.rowPtrType, w0);
+        int64_t blkEnd = LoadIndex(args_.rowPtr, args_.rowPtrType, w0 + length);
+        uint64_t mmads = 0;
+        for (int64_t w = w0; w < w0 + length; ++w) {
+            int64_t first = LoadIndex(args_.rowPtr, args_.rowPtrType, w);
+            int64_t last = LoadIndex(args_.rowPtr, args_.rowPtrType, w + 1);
+            if (DenseSlot(w) != 0) {
+                // 每个面板按 denseKTile 切 K，每段一次 Mmad；B 不经缓存，只搬 K 以内的行
+                int64_t kPad = (args_.k + EMU_TILE_K - 1) / EMU_TILE_K * EMU_TILE_K;
+                for (int64_t k0 = 0; k0 < kPad; k0 += denseKTile_) {
+                    int64_t validRows = std::min<int64_t>(denseKTile_, args_.k - k0);
+                    slot[BCSR_SPMM_CNT_B_BYTES] += static_cast<uint64_t>(validRows * tune_.mmadN * mmadNum) * sizeof(uint16_t);
+                    mmads += static_cast<uint64_t>(mmadNum);
+                }
+                ++slot[BCSR_SPMM_CNT_DENSE_WINDOWS];
+                continue;
+            }
+            mmads += static_cast<uint64_t>((last - first) * mmadNum);
+            if (tags.empty()) {
+                for (int64_t blk = first; blk < last; ++blk) {
+                    int64_t validRows = std::max<int64_t>(std::min(EMU_TILE_K, args_.k - LoadIndex(args_.col, args_.colType, blk)), 0);
+                    slot[BCSR_SPMM_CNT_B_BYTES] += static_cast<uint64_t>(validRows * panelN) * sizeof(uint16_t);
+                }
+                continue;
+            }
+            int64_t outer = direct_ ? mmadNum : last - first;
+            int64_t inner = direct_ ? last - first : mmadNum;
+            for (int64_t o = 0; o < outer; ++o) {
+                for (int64_t i = 0; i < inner; ++i) {
+                    int64_t blk = first + (direct_ ? i : o);
+                    int64_t j = direct_ ? o : i;
+                    int64_t col = LoadIndex(args_.col, args_.colType, blk);
+                    int64_t tag = col * mmadNum + j;
+                    size_t index = static_cast<size_t>((col / EMU_TILE_K * mmadNum + j) & (bCacheSlots_ - 1));
+                    if (tags[index] == tag) {
+                        ++slot[BCSR_SPMM_CNT_B_HITS];
+                        continue;
+                    }
+                    tags[index] = tag;
+                    int64_t validRows = std::max<int64_t>(std::min(EMU_TILE_K, args_.k - col), 0);
+                    slot[BCSR_SPMM_CNT_B_BYTES] += static_cast<uint64_t>(validRows * tune_.mmadN) * sizeof(uint16_t);
+                }
+            }
+        }
+        slot[BCSR_SPMM_CNT_WINDOWS] += static_cast<uint64_t>(length);
+        slot[BCSR_SPMM_CNT_BLOCKS] += static_cast<uint64_t>(blkEnd - blkBegin);
+        slot[BCSR_SPMM_CNT_MMADS] += mmads;
+        return true;
+    }
+
+    // 向量核逐非零元处理一个窗口：块内用到的 K 行每个 N 段搬一次，每个非零元每个 N 段一次 Axpy
+    bool RunGather(const CpuSpmm &single, int64_t w, uint64_t *slot) const
+    {
+        if (!RunRange(single, w, 1)) {
+            return false;
+        }
+        int64_t nTile = BcsrSpmmMixNTile(EMU_UB_BYTES, args_.n);
+        int64_t chunks = (args_.n + nTile - 1) / nTile;
+        int64_t first = LoadIndex(args_.rowPtr, args_.rowPtrType, w);
+        int64_t last = LoadIndex(args_.rowPtr, args_.rowPtrType, w + 1);
+        for (int64_t blk = first; blk < last; ++blk) {
+            int64_t validRows = std::min(EMU_TILE_K, args_.k - LoadIndex(args_.col, args_.colType, blk));
+            const uint16_t *block = args_.val + static_cast<size_t>(blk) * EMU_TILE_M * EMU_TILE_K;
+            uint32_t colBits = 0;
+            for (int64_t i = 0; i < EMU_TILE_M * EMU_TILE_K; ++i) {
+                if ((block[i] & 0x7fff) != 0 && i % EMU_TILE_K < validRows) {
+                    colBits |= 1u << (i % EMU_TILE_K);
+                    slot[BCSR_SPMM_CNT_MMADS] += static_cast<uint64_t>(chunks);
+                }
+            }
+            for (; colBits != 0; colBits &= colBits - 1) {
+                slot[BCSR_SPMM_CNT_B_BYTES] += static_cast<uint64_t>(args_.n) * sizeof(uint16_t);
+            }
+        }
+        slot[BCSR_SPMM_CNT_BLOCKS] += static_cast<uint64_t>(last - first);
+        ++slot[BCSR_SPMM_CNT_WINDOWS];
+        return true;
+    }
+
+    // 窗口在 core 间的分配与 TilingFunc 和 kernel 相同，每个 core 的窗口单线程执行并计时
+    aclnnStatus RunProfiled(void *workspace, uint64_t workspaceSize)
+    {
+        if (workspace == nullptr || workspaceSize < layout_.bytes) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+        // user workspace 在末尾，计数区在最前
+        char *user = static_cast<char *>(workspace) + workspaceSize - layout_.bytes;
+        uint64_t *slots = reinterpret_cast<uint64_t *>(user);
+        const uint32_t *order = reinterpret_cast<const uint32_t *>(user + layout_.schedule);
+        int64_t totalLength = args_.windowNum;
+        int64_t coreNum = args_.n < BCSR_SPMM_SMALL_N ? EMU_AIV_CORE_NUM : EMU_AIC_CORE_NUM;
+        int64_t blockDim = tune_.coreNum != 0 ? std::min<int64_t>(coreNum, tune_.coreNum) : coreNum;
+        blockDim = std::min(blockDim, totalLength);
+        if (blockDim <= 0) {
+            return ACL_SUCCESS;
+        }
+        int64_t formerNum = totalLength % blockDim == 0 ? blockDim : totalLength % blockDim;
+        int64_t formerLength = (totalLength + blockDim - 1) / blockDim;
+        int64_t tailLength = totalLength / blockDim;
+
+        CpuSpmm single(1);
+        int64_t w0 = 0;
+        // MIX 模式下 cube 只取调度表的前 cubeLength 项，其余按向量核编号交错分配
+        int64_t cubeLength = totalLength - mixNum_;
+        int64_t coreTypes = mixNum_ != 0 ? 3 : 1;
+        for (int64_t core = 0; core < blockDim * coreTypes; ++core) {
+            uint64_t *slot = slots + core * BCSR_SPMM_CNT_NUM;
+            std::memset(slot, 0, BCSR_SPMM_PROFILE_SLOT_BYTES);
+            std::vector<int64_t> tags(bCacheSlots_, -1);
+            auto start = std::chrono::steady_clock::now();
+            if (core >= blockDim) {
+                for (int64_t i = cubeLength + core - blockDim; i < totalLength; i += blockDim * (coreTypes - 1)) {
+                    if (!RunGather(single, order[i], slot)) {
+                        return ACL_ERROR_INVALID_PARAM;
+                    }
+                }
+                slot[BCSR_SPMM_CNT_VECTOR] = 1;
+            } else if (scheduled_) {
+                for (int64_t i = core; i < cubeLength; i += blockDim) {
+                    if (!RunWindows(single, order[i], 1, slot, tags)) {
+                        return ACL_ERROR_INVALID_PARAM;
+                    }
+                }
+            } else if (tune_.partition == BCSR_SPMM_PARTITION_CYCLIC) {
+                for (int64_t w = core; w < totalLength; w += blockDim) {
+                    if (!RunWindows(single, w, 1, slot, tags)) {
+                        return ACL_ERROR_INVALID_PARAM;
+                    }
+                }
+            } else {
+                int64_t length = core < formerNum ? formerLength : tailLength;
+                if (!RunWindows(single, w0, length, slot, tags)) {
+                    return ACL_ERROR_INVALID_PARAM;
+                }
+                w0 += length;
+            }
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            slot[BCSR_SPMM_CNT_MAGIC] = BCSR_SPMM_PROFILE_MAGIC;
+            slot[BCSR_SPMM_CNT_BLOCK_DIM] = static_cast<uint64_t>(blockDim * coreTypes);
+            slot[BCSR_SPMM_CNT_CYCLE_MHZ] = EMU_CYCLE_MHZ;
+            slot[BCSR_SPMM_CNT_CYCLES] = static_cast<uint64_t>(ns.count());
+        }
+        return ACL_SUCCESS;
+    }
+
+    const aclTensor *out_;
+    bool profile_;
+    bool direct_;
+    uint32_t bCacheSlots_;
+    BcsrSpmmUserLayout layout_;
+    bool scheduled_;
+    bool dense_;
+    uint32_t denseKTile_;
+    std::vector<int64_t> denseCols_;
+    int64_t denseRowPtr_[2] = {0, 0};
+    // 本次 Run 的 workspace 中的稠密窗口表与稠密行
+    const uint32_t *denseMap_;
+    const uint16_t *denseStore_;
+    int64_t mixNum_;    // 调度表最后 mixNum_ 项归向量核，0 为不启动向量核
+    BcsrSpmmTuneConfig tune_;
+    CpuSpmmArgs args_;
+    CpuSpmm engine_;
+};
+} // namespace
+
+extern "C" {
+aclnnStatus aclnnBcsrSpmmCustomGetWorkspaceSize(const aclIntArray *aShape, const aclTensor *rowPtr,
+                                                const aclTensor *col, const aclTensor *val, const aclTensor *b,
+                                                const aclTensor *out, uint64_t *workspaceSize,
+                                                aclOpExecutor **executor)
+{
+    if (aShape == nullptr || aShape->values.size() < 2 || rowPtr == nullptr || col == nullptr || val == nullptr ||
+        b == nullptr || b->dims.size() != 2 || out == nullptr || out->dims.size() != 2 || workspaceSize == nullptr || executor == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    int64_t flags = aShape->values.size() > BCSR_SPMM_SHAPE_FLAGS ? aShape->values[BCSR_SPMM_SHAPE_FLAGS] : 0;
+    int64_t denseNum = aShape->values.size() > BCSR_SPMM_SHAPE_DENSE ? aShape->values[BCSR_SPMM_SHAPE_DENSE] : 0;
+    int64_t mixNum = aShape->values.size() > BCSR_SPMM_SHAPE_MIX ? aShape->values[BCSR_SPMM_SHAPE_MIX] : 0;
+    *workspaceSize = BcsrSpmmUserWorkspaceLayout(flags, b->dims[0], b->dims[1],
+                                                 aclemu::ElementCount(rowPtr->dims) - 1, denseNum, mixNum).bytes;
+    *executor = new BcsrSpmmExecutor(aShape, rowPtr, col, val, b, out);
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnBcsrSpmmCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor,
+                                aclrtStream stream)
+{
+    return aclemu::LaunchExecutor(executor, workspace, workspaceSize, stream);
+}
+} // extern "C"
@@ -0,0 +1,126 @@
+/**
+ * @file coo_to_bcsr_emu.cpp
+ *
+ * CPU emulation of aclnnCooToBcsrCustom. Follows the device kernel: entries
+ * must be sorted by row, row_ptr is always written, and col / val only when
+ * the block count fits the capacity given in coo_shape. Entries outside
+ * M x K are dropped and a later duplicate overwrites an earlier one.
+ */
+#include "aclnn_coo_to_bcsr_custom.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "acl_emu_internal.h"
+#include "coo_to_bcsr_desc.h"
+
+namespace {
+class CooToBcsrExecutor : public aclOpExecutor {
+public:
+    CooToBcsrExecutor(const aclIntArray *cooShape, const aclTensor *row, const aclTensor *col,
+                      const aclTensor *value, const aclTensor *rowPtr, const aclTensor *bcsrCol,
+                      const aclTensor *bcsrVal)
+        : m_(cooShape->values[0]), k_(cooShape->values[1]),
+          capacity_(cooShape->values[COO_TO_BCSR_SHAPE_CAPACITY]), nnz_(aclemu::ElementCount(row->dims)),
+          row_(static_cast<const int32_t *>(row->data)), col_(static_cast<const int32_t *>(col->data)),
+          value_(static_cast<const uint16_t *>(value->data)), rowPtr_(static_cast<int32_t *>(rowPtr->data)),
+          bcsrCol_(static_cast<int32_t *>(bcsrCol->data)), bcsrVal_(static_cast<uint16_t *>(bcsrVal->data))
+    {
+    }
+
+    aclnnStatus Run(void *workspace, uint64_t workspaceSize) override
+    {
+        (void)workspace;
+        (void)workspaceSize;
+        const int64_t tile = COO_TO_BCSR_TILE;
+        int64_t windowNum = (m_ + tile - 1) / tile;
+        // 每个窗口的块列升序排列，与 kernel 按位图秩编号一致
+        std::vector<std::vector<int32_t>> windowCols(static_cast<size_t>(windowNum));
+        std::vector<int64_t> windowBegin(static_cast<size_t>(windowNum + 1), 0);
+        int64_t entry = std::lower_bound(row_, row_ + nnz_, 0) - row_;
+        rowPtr_[0] = 0;
+        for (int64_t w = 0; w < windowNum; ++w) {
+            int64_t rowEnd = std::min((w + 1) * tile, m_);
+            windowBegin[w] = entry;
+            std::vector<int32_t> &cols = windowCols[w];
+            for (; entry < nnz_ && row_[entry] < rowEnd; ++entry) {
+                if (col_[entry] >= 0 && col_[entry] < k_) {
+                    cols.push_back(static_cast<int32_t>(col_[entry] / tile));
+                }
+            }
+            std::sort(cols.begin(), cols.end());
+            cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+            rowPtr_[w + 1] = rowPtr_[w] + static_cast<int32_t>(cols.size());
+        }
+        windowBegin[windowNum] = entry;
+        if (rowPtr_[windowNum] > capacity_) {
+            return ACL_SUCCESS;
+        }
+
+        for (int64_t w = 0; w < windowNum; ++w) {
+            const std::vector<int32_t> &cols = windowCols[w];
+            int64_t base = rowPtr_[w];
+            std::memset(bcsrVal_ + base * tile * tile, 0, cols.size() * tile * tile * sizeof(uint16_t));
+            for (size_t i = 0; i < cols.size(); ++i) {
+                bcsrCol_[base + i] = static_cast<int32_t>(cols[i] * tile);
+            }
+            for (int64_t e = windowBegin[w]; e < windowBegin[w + 1]; ++e) {
+                if (col_[e] < 0 || col_[e] >= k_) {
+                    continue;
+                }
+                int64_t rank = std::lower_bound(cols.begin(), cols.end(), col_[e] / tile) - cols.begin();
+                bcsrVal_[(base + rank) * tile * tile + (row_[e] % tile) * tile + col_[e] % tile] = value_[e];
+            }
+        }
+        return ACL_SUCCESS;
+    }
+
+private:
+    int64_t m_;
+    int64_t k_;
+    int64_t capacity_;
+    int64_t nnz_;
+    const int32_t *row_;
+    const int32_t *col_;
+    const uint16_t *value_;
+    int32_t *rowPtr_;
+    int32_t *bcsrCol_;
+    uint16_t *bcsrVal_;
+};
+} // namespace
+
+extern "C" {
+aclnnStatus aclnnCooToBcsrCustomGetWorkspaceSize(const aclIntArray *cooShape, const aclTensor *row,
+                                                 const aclTensor *col, const aclTensor *value,
+                                                 const aclTensor *rowPtr, const aclTensor *bcsrCol,
+                                                 const aclTensor *bcsrVal, uint64_t *workspaceSize,
+                                                 aclOpExecutor **executor)
+{
+    if (cooShape == nullptr || cooShape->values.size() < COO_TO_BCSR_SHAPE_NUM || row == nullptr ||
+        col == nullptr || value == nullptr || rowPtr == nullptr || bcsrCol == nullptr || bcsrVal == nullptr ||
+        workspaceSize == nullptr || executor == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    // 与 TilingFunc 相同的限制：块列位图须放得进 UB
+    int64_t k = cooShape->values[1];
+    int64_t bitmapWords = ((k + COO_TO_BCSR_TILE - 1) / COO_TO_BCSR_TILE + 63) / 64;
+    int64_t windowNum = (cooShape->values[0] + COO_TO_BCSR_TILE - 1) / COO_TO_BCSR_TILE;
+    int64_t capacity = cooShape->values[COO_TO_BCSR_SHAPE_CAPACITY];
+    if (k < 0 || windowNum < 0 || capacity < 0 || bitmapWords > COO_TO_BCSR_MAX_BITMAP_WORDS ||
+        aclemu::ElementCount(rowPtr->dims) != windowNum + 1 || aclemu::ElementCount(bcsrCol->dims) < capacity ||
+        aclemu::ElementCount(bcsrVal->dims) < capacity * COO_TO_BCSR_TILE * COO_TO_BCSR_TILE ||
+        aclemu::ElementCount(col->dims) != aclemu::ElementCount(row->dims) ||
+        aclemu::ElementCount(value->dims) != aclemu::ElementCount(row->dims)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *workspaceSize = COO_TO_BCSR_MAX_CORES * COO_TO_BCSR_TOTAL_SLOT * sizeof(int32_t);
+    *executor = new CooToBcsrExecutor(cooShape, row, col, value, rowPtr, bcsrCol, bcsrVal);
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnCooToBcsrCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor,
+                                 aclrtStream stream)
+{
+    return aclemu::LaunchExecutor(executor, workspace, workspaceSize, stream);
+}
+} // extern "C"
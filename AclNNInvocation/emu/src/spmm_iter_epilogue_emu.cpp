@@ -0,0 +1,86 @@
+/**
+ * @file spmm_iter_epilogue_emu.cpp
+ *
+ * CPU emulation of aclnnSpmmIterEpilogueCustom. Runs as a single core: the
+ * partial sums go to norm slot 0 and the other slots are left untouched, so
+ * the host sum over all slots matches the device kernel.
+ */
+#include "aclnn_spmm_iter_epilogue_custom.h"
+
+#include "acl_emu_internal.h"
+#include "spmm_iter_desc.h"
+
+namespace {
+class SpmmIterEpilogueExecutor : public aclOpExecutor {
+public:
+    SpmmIterEpilogueExecutor(const aclTensor *c, const aclTensor *x, float scale, bool withNorm,
+                             const aclTensor *xNext, const aclTensor *norm)
+        : count_(aclemu::ElementCount(c->dims)), scale_(scale), withNorm_(withNorm),
+          c_(static_cast<const float *>(c->data)), x_(static_cast<const aclFloat16 *>(x->data)),
+          xNext_(static_cast<aclFloat16 *>(xNext->data)), norm_(static_cast<float *>(norm->data))
+    {
+    }
+
+    aclnnStatus Run(void *workspace, uint64_t workspaceSize) override
+    {
+        (void)workspace;
+        (void)workspaceSize;
+        // 与 kernel 一样以 fp32 累加
+        float newSum = 0.0f;
+        float deltaSum = 0.0f;
+        for (int64_t i = 0; i < count_; ++i) {
+            float value = c_[i] * scale_;
+            xNext_[i] = aclFloatToFloat16(value);
+            if (withNorm_) {
+                float delta = value - aclFloat16ToFloat(x_[i]);
+                newSum += value * value;
+                deltaSum += delta * delta;
+            }
+        }
+        if (withNorm_) {
+            for (uint32_t i = 0; i < SPMM_ITER_NORM_SLOT; ++i) {
+                norm_[i] = 0.0f;
+            }
+            norm_[SPMM_ITER_NORM_NEW] = newSum;
+            norm_[SPMM_ITER_NORM_DELTA] = deltaSum;
+        }
+        return ACL_SUCCESS;
+    }
+
+private:
+    int64_t count_;
+    float scale_;
+    bool withNorm_;
+    const float *c_;
+    const aclFloat16 *x_;
+    aclFloat16 *xNext_;
+    float *norm_;
+};
+} // namespace
+
+extern "C" {
+aclnnStatus aclnnSpmmIterEpilogueCustomGetWorkspaceSize(const aclTensor *c, const aclTensor *x, double scale,
+                                                        bool withNorm, const aclTensor *xNext,
+                                                        const aclTensor *norm, uint64_t *workspaceSize,
+                                                        aclOpExecutor **executor)
+{
+    if (c == nullptr || x == nullptr || xNext == nullptr || norm == nullptr || workspaceSize == nullptr ||
+        executor == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    int64_t count = aclemu::ElementCount(c->dims);
+    if (aclemu::ElementCount(x->dims) != count || aclemu::ElementCount(xNext->dims) != count ||
+        aclemu::ElementCount(norm->dims) < SPMM_ITER_NORM_NUM) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *workspaceSize = 0;
+    *executor = new SpmmIterEpilogueExecutor(c, x, static_cast<float>(scale), withNorm, xNext, norm);
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnSpmmIterEpilogueCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor,
+                                        aclrtStream stream)
+{
+    return aclemu::LaunchExecutor(executor, workspace, workspaceSize, stream);
+}
+} // extern "C"
@@ -0,0 +1,77 @@
+/**
+ * @file autotuner.h
+ *
+ * Offline autotuner for the tiling knobs of BcsrSpmmCustom: mmadN, the number
+ * of cube cores and the window partition. Every candidate is forced through
+ * a_shape with BCSR_SPMM_FLAG_TUNE, checked against the golden and timed with
+ * the benchmark harness; the fastest correct one is stored in the tuning
+ * database under the problem's sparsity signature, where TilingFunc looks it
+ * up on later runs (see op_host/bcsr_spmm_tune.h).
+ */
+#ifndef AUTOTUNER_H
+#define AUTOTUNER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bcsr_spmm_tune.h"
+#include "benchmark.h"
+#include "options.h"
+#include "spmm_session.h"
+
+struct TuneSpace {
+    std::vector<uint32_t> mmadN = {16, 32, 64};
+    std::vector<uint32_t> coreNum = {0, 8};     // 0: all cube cores
+    std::vector<uint32_t> partition = {BCSR_SPMM_PARTITION_CONTIGUOUS, BCSR_SPMM_PARTITION_CYCLIC};
+
+    /**
+     * @brief Read --tune-mmad-n=16,32,64 --tune-cores=0,8 --tune-partition=contiguous,cyclic
+     */
+    bool Parse(const Options &options);
+};
+
+struct TuneTrial {
+    BcsrSpmmTuneConfig config;
+    bool passed = false;
+    double medianMs = 0.0;      // device time of the kernel
+};
+
+struct TuneResult {
+    std::string key;
+    std::vector<TuneTrial> trials;
+    int64_t best = -1;          // index into trials, -1 when no candidate passed
+    int64_t baseline = -1;      // the default configuration, when it was swept
+};
+
+class Autotuner {
+public:
+    Autotuner(SpmmSession &session, const TuneSpace &space, const BenchConfig &bench);
+
+    /**
+     * @brief Sweep the space on problem; the session is left loaded with the
+     *        last candidate, reload the problem to run it untuned
+     * @param [in] golden: expected C, m * n elements
+     */
+    bool Tune(const SpmmProblem &problem, const float *golden, TuneResult &result);
+
+private:
+    SpmmSession &session_;
+    TuneSpace space_;
+    BenchConfig bench_;
+};
+
+/**
+ * @brief Database path: --tune-db, else where TilingFunc looks it up
+ *        ($BCSR_SPMM_TUNE_DB, then ../output/tune_db.txt)
+ */
+std::string GetTuneDbPath(const Options &options);
+
+/**
+ * @brief Replace the entry of result.key in the database with the winner
+ */
+bool SaveTuneResult(const std::string &path, const std::string &sample, const TuneResult &result);
+
+void PrintTuneResult(const std::string &sample, const TuneResult &result);
+
+#endif // AUTOTUNER_H
@@ -0,0 +1,96 @@
+/**
+ * @file batch_runner.h
+ *
+ * Single-process batch driver: every sample of a directory or manifest is
+ * converted, executed, verified and timed in-process with one initialized
+ * device context and one SpmmSession, instead of one execute_spmm_op and two
+ * Python processes per matrix.
+ */
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <string>
+#include <vector>
+
+#include "bcsr_matrix.h"
+#include "cpu_spmm.h"
+#include "options.h"
+#include "spmm_session.h"
+
+struct BatchSample {
+    std::string category;
+    std::string name;
+    std::string mtxPath;
+    std::string bPath;       // dense B, fp16 [K, N]
+    std::string goldenPath;  // fp32 C, computed by the CPU engine when the file is missing
+};
+
+struct BatchResult {
+    BatchSample sample;
+    SpmmProblem problem;     // shape only, host pointers are cleared
+    int64_t nnz = 0;
+    bool cpuGolden = false;
+    bool passed = false;
+    std::string status;
+    double errorRatio = 0.0;
+    float maxAbsError = 0.0f;
+    float maxRelError = 0.0f;
+    double convertMs = 0.0;
+    double loadMs = 0.0;
+    double runMs = 0.0;      // median over --repeat
+    double verifyMs = 0.0;
+    double refreshMs = 0.0;  // median scatter + value upload over --refresh steps
+    double iterateMs = 0.0;  // --iterate steps on the device with one synchronization
+    double streamMs = 0.0;   // chunked run under --stream-budget
+};
+
+/**
+ * @brief Collect samples from a directory (every *.mtx below it, with
+ *        <dir>/<name>/x2_gm.bin and golden.bin next to it as test.sh expects) or
+ *        from a manifest file with lines "<mtx> [<b.bin> [<golden.bin>]]",
+ *        relative to the manifest, '#' starting a comment
+ */
+bool CollectBatchSamples(const std::string &source, std::vector<BatchSample> &samples);
+
+class BatchRunner {
+public:
+    /**
+     * @param [in] options: --cpu, --threads, --repeat, --col=u16|i32|i64, --convert=host|device,
+     *        --kernel-profile, --direct-output, --b-cache, --schedule, --dense-windows, --mix, --refresh, --iterate,
+     *        --stream-budget, the --bench options and the --tune options
+     */
+    explicit BatchRunner(const Options &options);
+
+    /**
+     * @brief Run every sample; a failing sample is recorded and the batch goes on
+     * @return false only when the device context itself is unusable
+     */
+    bool Run(const std::vector<BatchSample> &samples);
+
+    /**
+     * @brief One CSV row per sample
+     */
+    bool WriteReport(const std::string &path) const;
+
+    void PrintSummary() const;
+
+    size_t GetFailedCount() const;
+
+private:
+    bool RunSample(const BatchSample &sample, BatchResult &result);
+    bool ReportKernelProfile(const std::string &name);
+    bool RefreshSample(const std::string &name, const CooMatrix &coo, const std::vector<int64_t> &valueMap,
+                       BcsrMatrix &matrix, const SpmmProblem &problem, double &refreshMs);
+    bool IterateSample(const std::string &name, const SpmmProblem &problem, double &iterateMs);
+    bool StreamSample(const std::string &name, const SpmmProblem &problem, const float *golden, double &streamMs);
+    bool TuneSample(const std::string &name, const SpmmProblem &problem, const float *golden);
+
+    const Options &options_;
+    bool useDevice_;
+    SpmmSession session_;
+    CpuSpmm cpu_;
+    std::vector<BatchResult> results_;
+    size_t benchWrites_;    // 本次批量已写出的基准结果数
+};
+
+#endif // BATCH_RUNNER_H
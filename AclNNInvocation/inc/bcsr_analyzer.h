@@ -0,0 +1,97 @@
+/**
+ * @file bcsr_analyzer.h
+ *
+ * Sparsity analysis of a BCSR matrix and a first-order cost model of the
+ * BcsrSpmmCustom kernel. The per-core split replays the formerNum /
+ * formerLength / tailNum / tailLength arithmetic of TilingFunc, and the
+ * traffic model follows the kernel loop: every (block, mmad column tile)
+ * reloads its 16 x 16 A block and a 16 x mmadN B panel and atomically adds a
+ * 16 x mmadN C tile. Reports are JSON or CSV rows so the dispatcher and the
+ * autotuner can read them back.
+ */
+#ifndef BCSR_ANALYZER_H
+#define BCSR_ANALYZER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bcsr_matrix.h"
+
+struct AnalyzerConfig {
+    int64_t coreNum = 24;           // GetCoreNumAic() of the target SoC
+    int64_t vectorCoreNum = 48;     // GetCoreNumAiv(), used by the kernel when N < BCSR_SPMM_SMALL_N
+    int64_t mmadN = 32;             // default mmadN of BcsrSpmmTuneConfig
+    int64_t colBytes = 2;           // 2 for the uint16 col encoding, 4 for int32, 8 for int64
+    int64_t rowPtrBytes = 4;        // 8 when row_ptr is int64
+    bool directOutput = false;      // BCSR_SPMM_FLAG_DIRECT_OUTPUT: one store per window, no memset of C
+    // 粗略的成本系数，可由 autotuner 按实测结果标定
+    double nsPerMmad = 120.0;       // one CopyIn / Split / Mmad / Fixpipe round on one core
+    double nsPerVectorBlock = 60.0; // one block times the B panel on one vector core
+    double gmGBps = 1200.0;         // sustained GM bandwidth shared by all cores
+};
+
+struct BcsrAnalysis {
+    int64_t m = 0;
+    int64_t k = 0;
+    int64_t n = 0;
+    int64_t windowNum = 0;
+    int64_t blockNum = 0;
+    int64_t nnz = 0;
+
+    // 块填充率：块内非零元个数 / 256
+    double fillMean = 0.0;
+    double fillMin = 0.0;
+    double fillMax = 0.0;
+    std::vector<int64_t> fillHistogram;     // 16 bins of 16 nonzeros: [1, 16], [17, 32], ...
+
+    // 每个行窗口的块数，bin 0 为空窗口，bin b 为 [2^(b-1), 2^b)
+    int64_t emptyWindows = 0;
+    int64_t maxWindowBlocks = 0;
+    double meanWindowBlocks = 0.0;
+    std::vector<int64_t> windowHistogram;
+
+    // TilingFunc 的 former / tail 切分
+    int64_t blockDim = 0;
+    int64_t formerNum = 0;
+    int64_t formerLength = 0;
+    int64_t tailNum = 0;
+    int64_t tailLength = 0;
+    std::vector<int64_t> coreBlocks;
+    double coreImbalance = 0.0;             // max / mean blocks per core
+
+    // kernel 的搬运量与 Mmad 次数
+    bool vectorKernel = false;              // N < BCSR_SPMM_SMALL_N runs on the vector cores
+    int64_t mmadNum = 0;                    // column tiles per block, ceil(N / mmadN), 1 for the vector kernel
+    int64_t mmadCount = 0;
+    double aBytes = 0.0;
+    double bBytes = 0.0;
+    double cBytes = 0.0;                    // atomic-add tiles written by Fixpipe, or one store per window
+    double cInitBytes = 0.0;                // memset of C before launch, 0 when the kernel writes C directly
+    double indexBytes = 0.0;
+    double flops = 0.0;                     // 2 * blocks * 16 * 16 * N
+    double predictedUs = 0.0;
+
+    double TotalBytes() const
+    {
+        return aBytes + bBytes + cBytes + cInitBytes + indexBytes;
+    }
+};
+
+/**
+ * @brief Analyze matrix for a dense B with n columns
+ */
+bool AnalyzeBcsr(const BcsrMatrix &matrix, int64_t n, const AnalyzerConfig &config, BcsrAnalysis &analysis);
+
+/**
+ * @brief Log a human readable summary
+ */
+void PrintAnalysis(const std::string &name, const BcsrAnalysis &analysis);
+
+/**
+ * @brief Write the analysis as one JSON object, or append a CSV row (header on
+ *        a new file) when path ends with ".csv"
+ */
+bool WriteAnalysis(const std::string &path, const std::string &name, const BcsrAnalysis &analysis);
+
+#endif // BCSR_ANALYZER_H
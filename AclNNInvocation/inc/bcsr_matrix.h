@@ -0,0 +1,103 @@
+/**
+ * @file bcsr_matrix.h
+ *
+ * In-process MatrixMarket reader and COO -> BCSR conversion producing the same
+ * row_ptr / col_idx / values layout as scripts/parse_matrix.py: 16x16 blocks,
+ * blocks of a row window ordered by column, zero padded, duplicate entries
+ * resolved by the last one in file order.
+ */
+#ifndef BCSR_MATRIX_H
+#define BCSR_MATRIX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Entries of a .mtx file, 0-based
+ */
+struct CooMatrix {
+    int64_t m = 0;
+    int64_t k = 0;
+    int64_t nnz = 0;              // entry count declared in the header
+    std::vector<int32_t> rows;
+    std::vector<int32_t> cols;
+    std::vector<float> values;
+};
+
+struct BcsrMatrix {
+    int64_t m = 0;
+    int64_t k = 0;
+    std::vector<int32_t> rowPtr;  // blocks per 16-row window, prefix summed
+    std::vector<int32_t> col;     // starting column of each block
+    std::vector<uint16_t> values; // fp16 bits, 16 x 16 row major per block
+
+    int64_t WindowNum() const
+    {
+        return rowPtr.empty() ? 0 : static_cast<int64_t>(rowPtr.size()) - 1;
+    }
+
+    int64_t BlockNum() const
+    {
+        return static_cast<int64_t>(col.size());
+    }
+
+    /**
+     * @brief Whether block columns fit the uint16 col encoding
+     */
+    bool FitsCompactCol() const;
+
+    /**
+     * @brief col as uint16 block-column units (col / 16)
+     */
+    std::vector<uint16_t> CompactCol() const;
+};
+
+/**
+ * @brief Read a MatrixMarket coordinate file. Lines starting with '%' are
+ *        skipped, entries without a value count as 1.0.
+ */
+bool ReadMtx(const std::string &path, CooMatrix &coo);
+
+/**
+ * @brief Stable sort of the entries by row, the order CooToBcsrCustom expects;
+ *        rows below 0 go first and rows past M last
+ */
+void SortCooByRow(CooMatrix &coo);
+
+/**
+ * @brief Convert COO entries to BCSR, entries outside M x K are dropped
+ * @param [out] valueMap: optional, for each COO entry the index of its value in
+ *        matrix.values; -1 for dropped entries and for duplicates overwritten
+ *        by a later one, so every index appears at most once
+ */
+bool BuildBcsr(const CooMatrix &coo, BcsrMatrix &matrix, std::vector<int64_t> *valueMap = nullptr);
+
+/**
+ * @brief Scatter values given in the COO order of BuildBcsr's input into the
+ *        values of the same BCSR structure, in parallel; padding is untouched
+ * @param [in] valueMap: the map produced by BuildBcsr
+ * @param [in] cooValues: valueMap.size() new values
+ * @param [out] values: valueNum fp16 values of the existing matrix
+ */
+bool ScatterBcsrValues(const std::vector<int64_t> &valueMap, const float *cooValues, uint16_t *values,
+                       size_t valueNum, size_t threadNum = 0);
+
+/**
+ * @brief Write row_ptr.bin, col_idx.bin, col_idx_u16.bin (when it fits),
+ *        values.bin and block_info.txt into dir, as parse_matrix.py does
+ */
+bool SaveBcsr(const std::string &dir, const BcsrMatrix &matrix);
+
+/**
+ * @brief Read a sample directory written by SaveBcsr or parse_matrix.py; the
+ *        shape comes from block_info.txt
+ */
+bool LoadBcsr(const std::string &dir, BcsrMatrix &matrix);
+
+/**
+ * @brief Write the nonzeros of a BCSR matrix as a MatrixMarket coordinate file
+ */
+bool WriteMtx(const std::string &path, const BcsrMatrix &matrix, const std::string &comment);
+
+#endif // BCSR_MATRIX_H
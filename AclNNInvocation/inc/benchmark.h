@@ -0,0 +1,73 @@
+/**
+ * @file benchmark.h
+ *
+ * Benchmark mode of execute_spmm_op: warmup launches, then timed launches on
+ * a loaded SpmmSession. The kernel is timed with device events around the op
+ * launch only (no copies, no output reset); the host time covers launch plus
+ * synchronization. Results go to a JSON file or a CSV row per sample.
+ */
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "spmm_session.h"
+
+struct BenchConfig {
+    int64_t warmup = 5;
+    int64_t iters = 20;
+};
+
+struct BenchStats {
+    size_t count = 0;
+    double min = 0.0;
+    double median = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+
+    /**
+     * @brief Nearest-rank statistics of samples in ms
+     */
+    static BenchStats From(std::vector<double> samples);
+};
+
+struct BenchResult {
+    std::string category;
+    std::string sample;
+    SpmmProblem problem;    // shape only, host pointers are cleared
+    int64_t nnz = 0;
+    BenchStats device;      // event time of the kernel launch
+    BenchStats host;        // wall-clock of launch + synchronize
+
+    // 2 * stored blocks * 16 * 16 * N, i.e. work the cube unit really does
+    double BlockFlops() const;
+    // 2 * nnz * N, work of the sparse product itself
+    double NnzFlops() const;
+    // compulsory traffic: row_ptr, col, values, B read once, C written once
+    double Bytes() const;
+};
+
+/**
+ * @brief Count nonzero fp16 values of the stored blocks
+ */
+int64_t CountNonzeros(const SpmmProblem &problem);
+
+/**
+ * @brief Warm up and time launches of the problem already loaded into session
+ */
+bool RunBenchmark(SpmmSession &session, const BenchConfig &config, BenchResult &result);
+
+/**
+ * @brief Write result as one JSON object, or append a CSV row (header on a new
+ *        file) when path ends with ".csv"
+ * @param [in] jsonLine: write the JSON object on a single line (JSON Lines)
+ * @param [in] append: with jsonLine, add the line after those already in the
+ *        file instead of replacing it
+ */
+bool WriteBenchResult(const std::string &path, const BenchResult &result, bool jsonLine = false,
+                      bool append = false);
+
+#endif // BENCHMARK_H
@@ -32,6 +32,14 @@
  */
 bool ReadFile(const std::string &filePath, size_t fileSize, void *buffer, size_t bufferSize);
 
+/**
+ * @brief Get size of a regular file
+ * @param [in] filePath: file path
+ * @param [out] fileSize: file size in bytes
+ * @return get result
+ */
+bool GetFileSize(const std::string &filePath, size_t &fileSize);
+
 /**
  * @brief Write data to file
  * @param [in] filePath: file path
@@ -0,0 +1,69 @@
+/**
+ * @file coo_converter.h
+ *
+ * Device-side COO to BCSR conversion with CooToBcsrCustom. COO entries sorted
+ * by row are staged on the device (10 bytes per nonzero) and converted
+ * straight into the buffers BcsrSpmmCustom reads, instead of converting on the
+ * host and uploading padded 512-byte blocks.
+ */
+#ifndef COO_CONVERTER_H
+#define COO_CONVERTER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "acl/acl.h"
+
+/**
+ * COO entries in host memory, sorted by row
+ */
+struct CooInput {
+    int64_t m = 0;
+    int64_t k = 0;
+    int64_t nnz = 0;
+    const int32_t *rows = nullptr;
+    const int32_t *cols = nullptr;
+    const uint16_t *values = nullptr;   // fp16
+};
+
+class CooConverter {
+public:
+    CooConverter();
+
+    virtual ~CooConverter();
+
+    /**
+     * @brief Stage the entries on the device, growing buffers only past their high-water mark
+     */
+    bool Upload(const CooInput &coo);
+
+    /**
+     * @brief Convert the staged entries on stream and wait; row_ptr is always
+     *        written, col and val only when the blocks fit capacity
+     * @param [in] rowPtr: device buffer of windowNum + 1 int32
+     * @param [in] col, val: device buffers with room for capacity blocks
+     * @param [out] hostRowPtr: copy of row_ptr, its last element is the block count
+     */
+    bool Convert(aclrtStream stream, void *rowPtr, void *col, void *val, int64_t capacity,
+                 std::vector<int32_t> &hostRowPtr);
+
+    /**
+     * @brief Bytes staged by the last Upload
+     */
+    size_t GetUploadBytes() const;
+
+private:
+    enum { COO_BUF_ROW = 0, COO_BUF_COL, COO_BUF_VALUE, COO_BUF_NUM };
+
+    bool Reserve(void *&buffer, size_t &capacity, size_t size);
+
+    int64_t m_;
+    int64_t k_;
+    int64_t nnz_;
+    void *buffers_[COO_BUF_NUM];
+    size_t capacities_[COO_BUF_NUM];
+    void *workspace_;
+    size_t workspaceCapacity_;
+};
+
+#endif // COO_CONVERTER_H
@@ -0,0 +1,81 @@
+/**
+ * @file cpu_spmm.h
+ *
+ * Multithreaded CPU BCSR SpMM over the same row_ptr / col / values layout the
+ * device kernel reads. Row windows are split across threads by block count and
+ * rebalanced by work stealing; fp16 blocks are widened with F16C / AVX2 on x86
+ * or NEON on aarch64 and accumulated in fp32 like the cube unit. Used as the
+ * golden generator and as the fallback path when no NPU is available.
+ */
+#ifndef CPU_SPMM_H
+#define CPU_SPMM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Element type of a BCSR index stream
+ */
+enum CpuIndexType {
+    CPU_INDEX_INT32 = 0,   // row_ptr offsets or starting columns
+    CPU_INDEX_INT64,       // same, 64 bit
+    CPU_INDEX_BLOCK_U16    // uint16 block-column units (starting column / 16)
+};
+
+/**
+ * One BCSR SpMM C[M, N] += A[M, K] * B[K, N] in host memory. val and b hold
+ * IEEE fp16 bit patterns.
+ */
+struct CpuSpmmArgs {
+    int64_t m = 0;
+    int64_t k = 0;
+    int64_t n = 0;
+    int64_t windowNum = 0;
+
+    const void *rowPtr = nullptr;
+    CpuIndexType rowPtrType = CPU_INDEX_INT32;
+    const void *col = nullptr;
+    CpuIndexType colType = CPU_INDEX_INT32;
+    const uint16_t *val = nullptr;
+    const uint16_t *b = nullptr;
+};
+
+class CpuSpmm {
+public:
+    /**
+     * @param [in] threadNum: worker threads, 0 uses all hardware threads
+     */
+    explicit CpuSpmm(size_t threadNum = 0);
+
+    /**
+     * @brief Accumulate A * B onto c (m * n floats, row major)
+     * @return false on inconsistent arguments
+     */
+    bool Run(const CpuSpmmArgs &args, float *c) const;
+
+    size_t GetThreadNum() const
+    {
+        return threadNum_;
+    }
+
+    /**
+     * @brief Name of the kernel selected for this host: "avx2", "neon" or "scalar"
+     */
+    static const char *GetIsaName();
+
+private:
+    size_t threadNum_;
+};
+
+/**
+ * @brief Convert an IEEE fp16 bit pattern to float
+ */
+float HalfToFloat(uint16_t value);
+
+/**
+ * @brief Convert a float to an IEEE fp16 bit pattern, rounding to nearest even
+ *        like numpy's astype(np.float16)
+ */
+uint16_t FloatToHalf(float value);
+
+#endif // CPU_SPMM_H
@@ -0,0 +1,60 @@
+/**
+ * @file dense_windows.h
+ *
+ * Host-side classification of row windows for BCSR_SPMM_FLAG_DENSE. A window
+ * whose blocks cover most block columns of A is copied into a zero-padded
+ * 16 x K dense row in the workspace, and the cube kernel runs it as a few
+ * Mmads over long contiguous K ranges instead of one 16-deep Mmad per block.
+ * The other windows keep the BCSR path.
+ */
+#ifndef DENSE_WINDOWS_H
+#define DENSE_WINDOWS_H
+
+#include <cstdint>
+#include <vector>
+
+struct SpmmProblem;
+
+// 窗口的块数达到块列数的这一百分比时走稠密行路径
+constexpr int64_t DENSE_WINDOW_FILL_PCT = 50;
+// 块数更少的窗口一次 Mmad 就能算完，不值得展开成稠密行
+constexpr int64_t DENSE_WINDOW_MIN_BLOCKS = 4;
+
+class DenseWindowPlan {
+public:
+    DenseWindowPlan();
+
+    /**
+     * @brief Classify the windows of problem; a window is dense when its blocks
+     *        reach DENSE_WINDOW_FILL_PCT percent of the block columns, start on
+     *        16-column boundaries and do not repeat a column
+     * @param [in] problem: host row_ptr and col must be set
+     */
+    bool Build(const SpmmProblem &problem);
+
+    void Clear();
+
+    int64_t GetDenseNum() const;
+
+    /**
+     * @brief One entry per row window: dense slot + 1, or 0 for a BCSR window
+     */
+    const std::vector<uint32_t> &GetMap() const;
+
+    /**
+     * @brief Scatter the blocks of the dense windows into their dense rows,
+     *        BcsrSpmmDenseRowElems(k) fp16 per dense window, missing blocks zero
+     * @param [in] val: fp16 blocks in the BCSR layout of the planned problem
+     */
+    void Fill(const void *val, std::vector<uint16_t> &store) const;
+
+private:
+    int64_t denseNum_;
+    uint64_t rowElems_;
+    std::vector<uint32_t> map_;
+    // 稠密窗口的每个块：块号与它在稠密行存储中的元素偏移
+    std::vector<int64_t> blocks_;
+    std::vector<uint64_t> offsets_;
+};
+
+#endif // DENSE_WINDOWS_H
@@ -0,0 +1,59 @@
+/**
+ * @file kernel_profile.h
+ *
+ * Per-core counters of the instrumented BcsrSpmmCustom kernel. A launch with
+ * BCSR_SPMM_FLAG_PROFILE makes every cube core fill its slot of the counter
+ * region at the end of the workspace; the session copies the region back and
+ * this module turns it into per-core rows, imbalance figures and a phase
+ * breakdown for spotting stragglers.
+ */
+#ifndef KERNEL_PROFILE_H
+#define KERNEL_PROFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bcsr_spmm_desc.h"
+
+enum KernelPhase {
+    KERNEL_PHASE_COPY_IN_A = 0,
+    KERNEL_PHASE_COPY_IN_B,
+    KERNEL_PHASE_SPLIT,
+    KERNEL_PHASE_COMPUTE,
+    KERNEL_PHASE_COPY_OUT,
+    KERNEL_PHASE_NUM
+};
+
+struct KernelCoreProfile {
+    int64_t core = 0;
+    uint64_t windows = 0;
+    uint64_t blocks = 0;
+    uint64_t mmads = 0;
+    uint64_t bBytes = 0;
+    uint64_t bHits = 0;                     // B panels served from the L1 cache, BCSR_SPMM_FLAG_B_CACHE
+    uint64_t denseWindows = 0;              // windows run from dense rows, BCSR_SPMM_FLAG_DENSE
+    bool vector = false;                    // slot of a vector core in MIX mode, BCSR_SPMM_FLAG_MIX
+    double us = 0.0;                        // Process time of the core
+    double phaseUs[KERNEL_PHASE_NUM] = {};  // 0 when the backend does not time phases
+};
+
+/**
+ * @brief Decode the counter region, one entry per slot written by the kernel
+ * @param [in] raw: BCSR_SPMM_PROFILE_MAX_CORES * BCSR_SPMM_CNT_NUM counters
+ */
+bool ParseKernelProfile(const uint64_t *raw, std::vector<KernelCoreProfile> &cores);
+
+/**
+ * @brief Log per-core rows, max / mean imbalance, the slowest core and the
+ *        phase breakdown
+ */
+void PrintKernelProfile(const std::string &name, const std::vector<KernelCoreProfile> &cores);
+
+/**
+ * @brief Append one CSV row per core (header on a new file)
+ */
+bool WriteKernelProfile(const std::string &path, const std::string &name,
+                        const std::vector<KernelCoreProfile> &cores);
+
+#endif // KERNEL_PROFILE_H
@@ -0,0 +1,111 @@
+/**
+ * @file mem_pool.h
+ *
+ * Size-class caching allocator for device memory and pinned host memory.
+ * Freed blocks stay cached in their size class and are handed out again, so
+ * serving a stream of differently sized problems reaches a steady state with
+ * no driver allocations at all. A request takes the smallest cached block
+ * that fits, so blocks left behind by grow-only buffers still serve smaller
+ * requests; the cache holds at most max(cache limit, bytes in use), the
+ * smallest blocks going back to the driver first.
+ */
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct MemPoolStats {
+    size_t bytesInUse = 0;     // handed out and not yet freed
+    size_t bytesCached = 0;    // freed into the pool, still held from the driver
+    size_t peakInUse = 0;      // high-water mark of bytesInUse
+    size_t peakReserved = 0;   // high-water mark of bytesInUse + bytesCached
+    size_t driverAllocs = 0;   // aclrtMalloc / aclrtMallocHost calls
+    size_t driverFrees = 0;    // aclrtFree / aclrtFreeHost calls
+    size_t hits = 0;           // allocations served from the cache
+    size_t misses = 0;         // allocations that went to the driver
+    size_t evictions = 0;      // cached blocks freed to stay under the cache limit
+};
+
+class MemPool {
+public:
+    /**
+     * @brief Pool of device memory
+     */
+    static MemPool &Device();
+
+    /**
+     * @brief Pool of pinned host memory (device memory when running on the device)
+     */
+    static MemPool &Host();
+
+    /**
+     * @brief Allocate a block of at least size bytes
+     * @return address, nullptr on failure
+     */
+    void *Alloc(size_t size);
+
+    /**
+     * @brief Return a block to its size class, nullptr is ignored
+     */
+    void Free(void *ptr);
+
+    /**
+     * @brief Make ptr hold at least size bytes: keep it when capacity already
+     *        covers size, otherwise free it and allocate a new block; the old
+     *        contents are not kept
+     * @param [in,out] ptr: block from this pool or nullptr
+     * @param [in,out] capacity: usable bytes of ptr, 0 after a failure
+     * @return false when the allocation failed, ptr is nullptr then
+     */
+    bool Grow(void *&ptr, size_t &capacity, size_t size);
+
+    /**
+     * @brief Give every cached block back to the driver
+     */
+    void Trim();
+
+    /**
+     * @brief Bytes the cache may always hold; it may grow up to the bytes in use beyond that
+     */
+    void SetCacheLimit(size_t bytes);
+
+    MemPoolStats GetStats() const;
+
+    /**
+     * @brief Print the statistics with INFO_LOG
+     */
+    void LogStats() const;
+
+    /**
+     * @brief Block size an allocation of size bytes is served with
+     */
+    static size_t SizeClass(size_t size);
+
+private:
+    enum Kind { DEVICE, HOST };
+
+    explicit MemPool(Kind kind);
+    // blocks are released by Trim(), never after aclFinalize
+    ~MemPool() = default;
+    MemPool(const MemPool &) = delete;
+    MemPool &operator=(const MemPool &) = delete;
+
+    void *DriverAlloc(size_t size);
+    void DriverFree(void *ptr);
+    // callers hold mutex_; blockSize is the size class of the block handed out
+    void *AllocLocked(size_t size, size_t &blockSize);
+    void EvictLocked();
+
+    Kind kind_;
+    mutable std::mutex mutex_;
+    std::map<size_t, std::vector<void *>> cache_;
+    std::unordered_map<void *, size_t> live_;
+    size_t cacheLimit_;
+    MemPoolStats stats_;
+};
+
+#endif // MEM_POOL_H
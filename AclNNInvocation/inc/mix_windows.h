@@ -0,0 +1,67 @@
+/**
+ * @file mix_windows.h
+ *
+ * Host-side split of the row windows between cube and vector cores for
+ * BCSR_SPMM_FLAG_MIX. Every window gets two cost estimates: the cube kernel
+ * pays for whole 16 x 16 blocks and full B panels whatever their fill, the
+ * vector gather kernel pays per block, per B row a block actually uses and per
+ * nonzero. Windows of very sparse blocks are moved to the vector cores,
+ * cheapest relative to the cube first, until both sides (two vector cores per
+ * cube core) are estimated to finish together. Dense windows stay on the cube.
+ */
+#ifndef MIX_WINDOWS_H
+#define MIX_WINDOWS_H
+
+#include <cstdint>
+#include <vector>
+
+struct SpmmProblem;
+
+// 块内非零元占比不超过这一百分比的窗口才考虑交给向量核
+constexpr int64_t MIX_WINDOW_MAX_FILL_PCT = 12;
+// KERNEL_TYPE_MIX_AIC_1_2：每个 cube core 带两个向量核
+constexpr int64_t MIX_VECTOR_PER_CUBE = 2;
+// 代价按 GM 搬运的字节计，向量核的比较、同步、标量读位图与 Axpy 折算成等价字节
+constexpr double MIX_VECTOR_BLOCK_COST = 2048.0;
+constexpr double MIX_VECTOR_AXPY_COST = 1.0;    // Axpy 的每个元素
+
+class MixWindowPlan {
+public:
+    MixWindowPlan();
+
+    /**
+     * @brief Estimate both costs of every window and pick the vector windows
+     * @param [in] problem: host row_ptr, col and val must be set
+     * @param [in] denseMap: dense window map of BCSR_SPMM_FLAG_DENSE, empty when
+     *        off; dense windows stay on the cube
+     * @param [in] mmadN: N of one cube Mmad, the cube reloads A once per panel
+     */
+    bool Build(const SpmmProblem &problem, const std::vector<uint32_t> &denseMap, uint32_t mmadN);
+
+    void Clear();
+
+    int64_t GetMixNum() const;
+
+    /**
+     * @brief Move the vector windows behind the cube windows, keeping the order
+     *        within each side; the kernel reads the last GetMixNum() entries
+     *        on the vector cores
+     */
+    void Split(std::vector<uint32_t> &order) const;
+
+    /**
+     * @brief Estimated cost of one cube core with every window on the cube, and
+     *        of the slower side after the split
+     */
+    double GetCubeOnlyCost() const;
+    double GetSplitCost() const;
+
+private:
+    int64_t mixNum_;
+    // 每个行窗口一项，1 为交给向量核
+    std::vector<uint8_t> map_;
+    double cubeOnlyCost_;
+    double splitCost_;
+};
+
+#endif // MIX_WINDOWS_H
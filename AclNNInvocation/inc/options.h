@@ -0,0 +1,41 @@
+/**
+ * @file options.h
+ *
+ * Parser for the --key=value options that follow the positional arguments.
+ */
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Command line options of the form --key=value or --flag
+ */
+class Options {
+public:
+    /**
+     * @brief Parse options
+     * @param [in] argc: argument count
+     * @param [in] argv: argument values
+     * @param [in] first: index of the first option in argv
+     * @return parse result, false on an argument that is not an option
+     */
+    bool Parse(int argc, char **argv, int first);
+
+    /**
+     * @brief Check whether an option is present
+     * @param [in] key: option name without the leading dashes
+     */
+    bool Has(const std::string &key) const;
+
+    std::string GetString(const std::string &key, const std::string &defaultValue) const;
+    int64_t GetInt(const std::string &key, int64_t defaultValue) const;
+    double GetDouble(const std::string &key, double defaultValue) const;
+
+private:
+    std::map<std::string, std::string> values_;
+};
+
+#endif // OPTIONS_H
@@ -0,0 +1,80 @@
+/**
+ * @file pipeline_runner.h
+ *
+ * Batch execution of independent SpMM problems over several streams. Every
+ * stream owns a slot with pinned staging buffers and device buffers, and all
+ * copies are asynchronous, so the upload of request i+1 and the download of
+ * request i-1 overlap the kernel of request i.
+ */
+#ifndef PIPELINE_RUNNER_H
+#define PIPELINE_RUNNER_H
+
+#include <vector>
+
+#include "acl/acl.h"
+#include "aclnn/acl_meta.h"
+#include "common.h"
+#include "spmm_session.h"
+
+class PipelineRunner {
+public:
+    /**
+     * @brief Constructor
+     * @param [in] streamNum: number of streams, i.e. requests in flight
+     */
+    explicit PipelineRunner(size_t streamNum);
+
+    virtual ~PipelineRunner();
+
+    /**
+     * @brief Create streams and events, must be called after the device is set
+     */
+    bool Init();
+
+    /**
+     * @brief Stage a problem into pinned memory and enqueue upload, kernel and
+     *        download. Blocks only while the slot it lands in is still busy.
+     * @param [in] problem: host inputs, only read during the call
+     * @param [out] c: host destination of C, written by the time the request
+     *                 completes, must stay valid until then
+     */
+    bool Submit(const SpmmProblem &problem, void *c);
+
+    /**
+     * @brief Wait for all submitted requests and hand their results back
+     */
+    bool Flush();
+
+    size_t GetCompleted() const;
+
+private:
+    struct Slot {
+        aclrtStream stream = nullptr;
+        aclrtEvent done = nullptr;
+
+        void *hostIn = nullptr;
+        size_t hostInCapacity = 0;
+        void *hostOut = nullptr;
+        size_t hostOutCapacity = 0;
+        void *devBuffers[SPMM_BUF_NUM] = {};
+        size_t devCapacities[SPMM_BUF_NUM] = {};
+        void *workspace = nullptr;
+        size_t workspaceCapacity = 0;
+
+        SpmmTensors tensors;
+        bool busy = false;
+        void *pendingOut = nullptr;
+        size_t pendingSize = 0;
+    };
+
+    bool Stage(Slot &slot, const SpmmProblem &problem, size_t (&offsets)[SPMM_BUF_C]);
+    bool Enqueue(Slot &slot, const SpmmProblem &problem, const size_t (&offsets)[SPMM_BUF_C]);
+    bool Complete(Slot &slot);
+    void Release(Slot &slot);
+
+    std::vector<Slot> slots_;
+    size_t next_;
+    size_t completed_;
+};
+
+#endif // PIPELINE_RUNNER_H
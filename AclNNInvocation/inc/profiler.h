@@ -0,0 +1,147 @@
+/**
+ * @file profiler.h
+ *
+ * Scoped, nestable, thread-safe profiler. Spans are written into slots
+ * preallocated by Enable, so recording is an atomic increment and two clock
+ * reads with no allocation or locking. Device spans bracket work enqueued on a
+ * stream with a pair of pooled aclrtEvents and are resolved to device time
+ * after the streams are synchronized. Everything can be exported as a
+ * Chrome-trace JSON (chrome://tracing, Perfetto) or aggregated per name for
+ * Log::Write.
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+
+enum ProfileKind { PROFILE_HOST = 0, PROFILE_DEVICE };
+
+struct ProfileRecord {
+    const char *name = nullptr;   // not copied, must outlive the profiler (string literals)
+    ProfileKind kind = PROFILE_HOST;
+    uint32_t tid = 0;             // small per-thread id
+    uint32_t depth = 0;           // nesting depth on the recording thread
+    int64_t startNs = 0;          // since the profiler epoch
+    int64_t endNs = -1;           // -1 while open or unresolved
+    aclrtStream stream = nullptr; // device spans only
+    size_t eventPair = 0;         // device spans only, index into the event pool
+};
+
+class Profiler {
+public:
+    static Profiler &Instance();
+
+    /**
+     * @brief Preallocate record slots and, for device spans, event pairs.
+     *        Event pairs need a current device, pass 0 without one.
+     */
+    bool Enable(size_t capacity = 65536, size_t devicePairs = 0);
+
+    /**
+     * @brief Destroy pooled events and stop recording; records are kept
+     */
+    void Disable();
+
+    bool IsEnabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Open a host span, returns the slot or -1 when disabled or full
+     */
+    int64_t BeginHost(const char *name);
+    void EndHost(int64_t slot);
+
+    /**
+     * @brief Record a start event on stream, returns the slot or -1 when disabled,
+     *        full or out of events
+     */
+    int64_t BeginDevice(const char *name, aclrtStream stream);
+    void EndDevice(int64_t slot);
+
+    /**
+     * @brief Convert device spans to the host timeline. Streams must be synchronized.
+     */
+    bool Resolve();
+
+    /**
+     * @brief Closed spans per name in ms; device spans are keyed "<name>[device]"
+     */
+    std::map<std::string, std::vector<double>> GetTimings() const;
+
+    bool WriteChromeTrace(const std::string &path) const;
+
+    /**
+     * @brief Drop all records and recycle the events. Enable, Disable and Clear
+     *        must not race with open spans.
+     */
+    void Clear();
+
+private:
+    Profiler();
+
+    int64_t Now() const;
+    int64_t Acquire(const char *name, ProfileKind kind);
+
+    std::atomic<bool> enabled_;
+    std::vector<ProfileRecord> records_;
+    std::atomic<size_t> next_;
+    std::atomic<size_t> dropped_;
+    std::vector<aclrtEvent> events_;   // start / end pairs
+    std::atomic<size_t> nextPair_;
+    int64_t epochNs_;
+};
+
+/**
+ * Host span over the enclosing scope
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(const char *name) : slot_(Profiler::Instance().BeginHost(name)) {}
+
+    ~ProfileScope()
+    {
+        Profiler::Instance().EndHost(slot_);
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    int64_t slot_;
+};
+
+/**
+ * Device span over the work the enclosing scope enqueues on stream
+ */
+class DeviceProfileScope {
+public:
+    DeviceProfileScope(const char *name, aclrtStream stream) : slot_(Profiler::Instance().BeginDevice(name, stream))
+    {
+    }
+
+    ~DeviceProfileScope()
+    {
+        Profiler::Instance().EndDevice(slot_);
+    }
+
+    DeviceProfileScope(const DeviceProfileScope &) = delete;
+    DeviceProfileScope &operator=(const DeviceProfileScope &) = delete;
+
+private:
+    int64_t slot_;
+};
+
+class Log {
+public:
+    static void Write(const std::string& category, const std::string& sampleName, const std::map<std::string, std::vector<double>>& timings);
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,68 @@
+/**
+ * @file sparse_gen.h
+ *
+ * Synthetic sparse workloads for scaling studies. Rows are generated window
+ * by window straight into the BCSR container from a counter-based RNG keyed by
+ * (seed, row), so a case is reproducible from its seed regardless of the
+ * thread count and never materializes COO triples or a dense A.
+ */
+#ifndef SPARSE_GEN_H
+#define SPARSE_GEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bcsr_matrix.h"
+
+enum SparseFamily {
+    FAMILY_UNIFORM = 0,    // columns uniform over [0, K)
+    FAMILY_RMAT,           // R-MAT power law: skewed row degrees and column popularity
+    FAMILY_BANDED,         // columns within +-band of the scaled diagonal
+    FAMILY_BLOCKDIAG,      // dense-ish diagonal blocks of blockSize rows
+    FAMILY_HOTROW,         // hotShare of the nonzeros in hotRows of the rows
+    FAMILY_CLUSTERED       // row groups sharing a column neighbourhood
+};
+
+struct GenConfig {
+    SparseFamily family = FAMILY_UNIFORM;
+    int64_t m = 0;
+    int64_t k = 0;
+    double nnzPerRow = 8.0;     // average over all rows
+    uint64_t seed = 20251213;
+    size_t threadNum = 0;       // 0 means hardware concurrency
+
+    // R-MAT quadrant probabilities, d = 1 - a - b - c
+    double rmatA = 0.57;
+    double rmatB = 0.19;
+    double rmatC = 0.19;
+    int64_t band = 64;          // banded: half width in columns
+    int64_t blockSize = 256;    // blockdiag: rows per diagonal block
+    double hotRows = 0.01;      // hotrow: fraction of hot rows
+    double hotShare = 0.5;      // hotrow: fraction of the nonzeros they hold
+    int64_t clusterRows = 64;   // clustered: rows sharing one neighbourhood
+    int64_t clusterWidth = 512; // clustered: columns in a neighbourhood
+    double locality = 0.9;      // clustered: probability a column lands in it
+};
+
+/**
+ * @brief Parse a family name: uniform, rmat, banded, blockdiag, hotrow, clustered
+ */
+bool ParseFamily(const std::string &name, SparseFamily &family);
+
+const char *GetFamilyName(SparseFamily family);
+
+/**
+ * @brief Generate A as BCSR with integer values in [1, 10] like
+ *        gen_sparse_mtx_cases.py
+ * @param [out] nnz: nonzeros actually generated
+ */
+bool GenerateBcsr(const GenConfig &config, BcsrMatrix &matrix, int64_t &nnz);
+
+/**
+ * @brief Dense fp16 B[K, N] with integer values in [1, 10]
+ */
+void GenerateDense(int64_t k, int64_t n, uint64_t seed, std::vector<uint16_t> &b);
+
+#endif // SPARSE_GEN_H
@@ -0,0 +1,92 @@
+/**
+ * @file spmm_iterator.h
+ *
+ * Chained SpMM X_{t+1} = scale * A * X_t for power iteration, PageRank-style
+ * updates and stacked layers. A stays in the buffers of a loaded SpmmSession,
+ * X ping-pongs between two fp16 device buffers, and SpmmIterEpilogueCustom
+ * casts each fp32 C into the next B and optionally reduces the step norms, so
+ * k steps are enqueued back to back with a single host synchronization.
+ */
+#ifndef SPMM_ITERATOR_H
+#define SPMM_ITERATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "acl/acl.h"
+#include "aclnn/acl_meta.h"
+#include "spmm_session.h"
+
+struct IterConfig {
+    float scale = 1.0f;     // 每步乘到 A * X 上，幂迭代时用它防止 fp16 溢出
+    bool norm = false;      // 每步统计范数
+};
+
+/**
+ * Norms of one step, computed on scale * A * X_t in fp32 before the cast
+ */
+struct IterNorm {
+    double norm = 0.0;      // ||X_{t+1}||_F
+    double delta = 0.0;     // ||X_{t+1} - X_t||_F
+};
+
+class SpmmIterator {
+public:
+    /**
+     * @param [in] session: holds A; its problem must be square and stay loaded
+     *        while the iterator is used
+     */
+    explicit SpmmIterator(SpmmSession &session);
+
+    virtual ~SpmmIterator();
+
+    /**
+     * @brief Start from the B of the loaded problem and build the executors
+     */
+    bool Init(const IterConfig &config);
+
+    /**
+     * @brief Enqueue steps iterations on the session stream and wait once
+     * @param [out] norms: when the config asks for norms, one entry per step is appended
+     */
+    bool Run(int64_t steps, std::vector<IterNorm> *norms = nullptr);
+
+    /**
+     * @brief Copy the current X (fp16, K x N) back to host memory
+     */
+    bool Download(void *x);
+
+    /**
+     * @brief Steps run since Init
+     */
+    int64_t GetStep() const;
+
+    size_t GetXSize() const;
+
+private:
+    enum { ITER_BUF_X0 = 0, ITER_BUF_X1, ITER_BUF_C, ITER_BUF_NORM, ITER_BUF_HISTORY, ITER_BUF_NUM };
+
+    bool Reserve(size_t index, size_t size);
+    bool BuildExecutors();
+    void DestroyExecutors();
+    bool EnqueueStep(int64_t index);
+
+    SpmmSession &session_;
+    SpmmProblem problem_;
+    IterConfig config_;
+    int64_t step_;
+
+    void *buffers_[ITER_BUF_NUM];
+    size_t capacities_[ITER_BUF_NUM];
+    void *workspace_;
+    size_t workspaceCapacity_;
+    uint64_t workspaceSize_;
+
+    // 下标为本步读取的 X 缓冲
+    SpmmTensors spmmTensors_[2];
+    aclTensor *epilogueTensors_[2][4];
+    aclOpExecutor *spmmExecutors_[2];
+    aclOpExecutor *epilogueExecutors_[2];
+};
+
+#endif // SPMM_ITERATOR_H
@@ -0,0 +1,251 @@
+/**
+ * @file spmm_session.h
+ *
+ * Long-lived execution context for BcsrSpmmCustom. Device buffers, stream and
+ * workspace are kept at their high-water size across problems, and the op
+ * executor is reused as long as the problem structure does not change, so a
+ * repeated SpMM only pays for the launch.
+ */
+#ifndef SPMM_SESSION_H
+#define SPMM_SESSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "aclnn/acl_meta.h"
+#include "bcsr_spmm_tune.h"
+#include "common.h"
+#include "coo_converter.h"
+#include "cpu_spmm.h"
+#include "dense_windows.h"
+#include "mix_windows.h"
+#include "kernel_profile.h"
+
+constexpr int64_t BCSR_TILE_M = 16;
+constexpr int64_t BCSR_TILE_K = 16;
+
+/**
+ * One BCSR SpMM problem C[M, N] = A[M, K] * B[K, N] in host memory
+ */
+struct SpmmProblem {
+    int64_t m = 0;
+    int64_t k = 0;
+    int64_t n = 0;
+    int64_t windowNum = 0;
+    int64_t blockNum = 0;
+    // ACL_INT32 或 ACL_INT64，块数超出 int32 时须用 int64
+    aclDataType rowPtrType = ACL_INT32;
+    // ACL_INT32 / ACL_INT64: starting column, ACL_UINT16: block-column units
+    aclDataType colType = ACL_INT32;
+    // BCSR_SPMM_FLAG_*，作为 a_shape[2] 传给 TilingFunc
+    int64_t flags = 0;
+    // 行窗口签名，Load 时由 row_ptr 计算，TilingFunc 用它查调优库
+    int64_t signature = 0;
+    // BcsrSpmmPackTune 打包的调优参数，flags 含 BCSR_SPMM_FLAG_TUNE 时生效
+    int64_t tune = 0;
+    // 稠密窗口数，flags 含 BCSR_SPMM_FLAG_DENSE 时由 session 在 Load 时分类得到，TilingFunc 据此申请 workspace
+    int64_t denseWindows = 0;
+    // 交给向量核的窗口数，flags 含 BCSR_SPMM_FLAG_MIX 时由 session 在 Load 时按代价估计得到
+    int64_t mixWindows = 0;
+
+    const void *rowPtr = nullptr;
+    const void *col = nullptr;
+    const void *val = nullptr;
+    const void *b = nullptr;
+
+    size_t RowPtrSize() const;
+    size_t ColSize() const;
+    size_t ValSize() const;
+    size_t BSize() const;
+    size_t CSize() const;
+
+    /**
+     * @brief Element w of row_ptr in either index type, rowPtr must be set
+     */
+    int64_t RowPtrAt(int64_t w) const;
+
+    /**
+     * @brief Starting column of block blk in either col encoding, col must be set
+     */
+    int64_t ColAt(int64_t blk) const;
+
+    /**
+     * @brief Window signature of row_ptr in either index type
+     */
+    int64_t WindowSignature() const;
+
+    /**
+     * @brief Whether the kernel writes every element of C itself, so no reset of
+     *        C is enqueued before a launch: BCSR_SPMM_FLAG_DIRECT_OUTPUT, or the
+     *        small-N vector kernel that always writes whole windows
+     */
+    bool DirectOutput() const;
+
+    /**
+     * @brief Whether two problems produce the same tensors and tiling
+     */
+    bool SameStructure(const SpmmProblem &other) const;
+
+    /**
+     * @brief View of the same host inputs for the CPU engine
+     */
+    CpuSpmmArgs ToCpuArgs() const;
+
+    /**
+     * @brief Key of the problem in the tuning database, signature must be set
+     */
+    std::string TuneKey() const;
+};
+
+/**
+ * Device buffers of one launch, in op input order followed by the output
+ */
+enum SpmmBufferIndex { SPMM_BUF_ROW_PTR = 0, SPMM_BUF_COL, SPMM_BUF_VAL, SPMM_BUF_B, SPMM_BUF_C, SPMM_BUF_NUM };
+
+/**
+ * @brief Byte size of buffer index of a problem
+ */
+size_t SpmmBufferSize(const SpmmProblem &problem, size_t index);
+
+/**
+ * @brief Name of a row_ptr / col index type in reports
+ */
+const char *IndexTypeName(aclDataType dataType);
+
+/**
+ * aclnn objects describing one launch over a set of device buffers
+ */
+struct SpmmTensors {
+    aclIntArray *aShape = nullptr;
+    aclTensor *tensors[SPMM_BUF_NUM] = {};
+
+    /**
+     * @brief Create a_shape and the tensors over devBuffers
+     * @param [in] problem: shapes and index type
+     * @param [in] devBuffers: SPMM_BUF_NUM device addresses
+     */
+    bool Create(const SpmmProblem &problem, void *const *devBuffers);
+
+    /**
+     * @brief Run the first phase of the two-phase op API
+     */
+    bool GetWorkspaceSize(uint64_t &workspaceSize, aclOpExecutor *&executor);
+
+    void Destroy();
+};
+
+class SpmmSession {
+public:
+    SpmmSession();
+
+    virtual ~SpmmSession();
+
+    /**
+     * @brief Create the stream, must be called after the device is set
+     */
+    bool Init();
+
+    /**
+     * @brief Upload a problem, growing buffers only past their high-water mark
+     *        and rebuilding the executor only when the structure changed;
+     *        waits for the stream first, a pending launch may still use the buffers
+     * @param [in] problem: host inputs, only read during the call
+     */
+    bool Load(const SpmmProblem &problem);
+
+    /**
+     * @brief Upload COO entries and B, convert the entries to BCSR on the device
+     *        with CooToBcsrCustom and load the result; only row_ptr comes back,
+     *        to size col and val and to compute the window signature
+     * @param [in] problem: m, k, n, flags, tune and b; the BCSR fields are filled in
+     * @param [in] coo: entries sorted by row, with the same m and k
+     */
+    bool LoadCoo(const SpmmProblem &problem, const CooInput &coo);
+
+    /**
+     * @brief Enqueue the output reset and the kernel on the session stream
+     * @param [in] kernelStart: optional event recorded between the reset and the kernel
+     */
+    bool Launch(aclrtEvent kernelStart = nullptr);
+
+    /**
+     * @brief Wait for everything enqueued on the session stream
+     */
+    bool Synchronize();
+
+    /**
+     * @brief Launch and wait
+     */
+    bool Run();
+
+    /**
+     * @brief Replace the values of the loaded problem and upload only val; row_ptr,
+     *        col, B, the tiling and the executor are kept. Waits for launches
+     *        still reading the old values.
+     * @param [in] val: ValSize() bytes of fp16 in the BCSR layout of the loaded problem
+     */
+    bool RefreshValues(const void *val);
+
+    /**
+     * @brief Copy the per-core counters of the last launch back, the problem
+     *        must have been loaded with BCSR_SPMM_FLAG_PROFILE
+     */
+    bool ReadKernelProfile(std::vector<KernelCoreProfile> &cores);
+
+    /**
+     * @brief Copy C of the loaded problem back to host memory
+     * @param [out] c: destination, at least GetOutputSize() bytes
+     */
+    bool Download(void *c);
+
+    /**
+     * @brief Shape of the loaded problem, host pointers are cleared
+     */
+    const SpmmProblem &GetProblem() const;
+
+    size_t GetOutputSize() const;
+    aclrtStream GetStream() const;
+
+    /**
+     * @brief Device address of buffer index, valid until the next Load or LoadCoo
+     */
+    void *GetDeviceBuffer(size_t index) const;
+
+    /**
+     * @brief Number of executors built so far, for checking reuse
+     */
+    size_t GetExecutorBuilds() const;
+
+private:
+    bool Reserve(size_t index, size_t size, bool &moved);
+    bool ReserveWorkspace(uint64_t size);
+    bool Upload(size_t index, const void *src, size_t size);
+    bool Bind(const SpmmProblem &problem, bool moved);
+    bool UploadSchedule(const SpmmProblem &problem);
+    bool UploadDense(const void *val);
+    BcsrSpmmUserLayout UserLayout() const;
+    char *UserWorkspace() const;
+    bool BuildExecutor();
+    void DestroyExecutor();
+
+    SpmmProblem problem_;
+    bool loaded_;
+    aclrtStream stream_;
+
+    void *devBuffers_[SPMM_BUF_NUM];
+    size_t capacities_[SPMM_BUF_NUM];
+    void *workspace_;
+    uint64_t workspaceCapacity_;
+    uint64_t workspaceSize_;
+
+    CooConverter converter_;
+    DenseWindowPlan densePlan_;
+    MixWindowPlan mixPlan_;
+    SpmmTensors tensors_;
+    aclOpExecutor *executor_;
+    size_t executorBuilds_;
+};
+
+#endif // SPMM_SESSION_H
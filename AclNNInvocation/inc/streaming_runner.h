@@ -0,0 +1,140 @@
+/**
+ * @file streaming_runner.h
+ *
+ * Out-of-core execution for matrices whose A and C do not fit device memory.
+ * Only B stays resident; A is cut into chunks of consecutive row windows sized
+ * to a memory budget, and two slots on their own streams alternate so the
+ * upload of chunk i+1 overlaps the kernel of chunk i while the C slice of
+ * chunk i-1 streams back to host memory, typically an mmapped output file.
+ */
+#ifndef STREAMING_RUNNER_H
+#define STREAMING_RUNNER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "aclnn/acl_meta.h"
+#include "spmm_session.h"
+
+/**
+ * File mapped into host memory, so inputs and C larger than RAM page through
+ * the page cache instead of being read or written as a whole
+ */
+class MappedFile {
+public:
+    MappedFile();
+
+    virtual ~MappedFile();
+
+    /**
+     * @brief Map the first size bytes of an existing file read-only
+     */
+    bool OpenRead(const std::string &path, size_t size);
+
+    /**
+     * @brief Create or truncate a file of size bytes and map it writable
+     */
+    bool Create(const std::string &path, size_t size);
+
+    void Close();
+
+    void *GetData() const;
+    size_t GetSize() const;
+
+private:
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Map(int fd, size_t size, bool writable);
+
+    void *data_;
+    size_t size_;
+};
+
+/**
+ * Consecutive row windows run as one launch
+ */
+struct StreamChunk {
+    int64_t firstWindow = 0;
+    int64_t windowNum = 0;
+    int64_t firstBlock = 0;
+    int64_t blockNum = 0;
+    size_t deviceBytes = 0;     // row_ptr + col + val + C of the chunk on the device
+};
+
+class StreamingRunner {
+public:
+    /**
+     * @param [in] budget: device bytes for B and both chunk slots together
+     */
+    explicit StreamingRunner(size_t budget);
+
+    virtual ~StreamingRunner();
+
+    /**
+     * @brief Create streams and events, must be called after the device is set
+     */
+    bool Init();
+
+    /**
+     * @brief Cut problem into chunks that fit the budget twice next to B
+     * @return false when B, or B with the largest single window, does not fit
+     */
+    bool Plan(const SpmmProblem &problem);
+
+    /**
+     * @brief Upload B, then stream every planned chunk through the two slots
+     * @param [in] problem: host inputs of the planned problem
+     * @param [out] c: host destination of the whole M x N fp32 C
+     */
+    bool Run(const SpmmProblem &problem, void *c);
+
+    const std::vector<StreamChunk> &GetChunks() const;
+
+    /**
+     * @brief Device bytes held at most during Run, B and workspaces included
+     */
+    size_t GetPeakBytes() const;
+
+private:
+    struct Slot {
+        aclrtStream stream = nullptr;
+        aclrtEvent done = nullptr;
+
+        void *hostIn = nullptr;
+        size_t hostInCapacity = 0;
+        void *hostOut = nullptr;
+        size_t hostOutCapacity = 0;
+        // row_ptr、col、val、C 依次放在一块 device 内存里，与 hostIn 的输入布局相同
+        void *arena = nullptr;
+        size_t arenaCapacity = 0;
+        void *devBuffers[SPMM_BUF_NUM] = {};
+        void *workspace = nullptr;
+        size_t workspaceCapacity = 0;
+
+        SpmmTensors tensors;
+        bool busy = false;
+        void *pendingOut = nullptr;
+        size_t pendingSize = 0;
+    };
+
+    SpmmProblem ChunkProblem(const SpmmProblem &problem, const StreamChunk &chunk) const;
+    size_t ChunkBytes(const SpmmProblem &problem, int64_t windowNum, int64_t blockNum) const;
+    bool Reserve(const SpmmProblem &problem);
+    void UpdatePeak();
+    bool Enqueue(Slot &slot, const SpmmProblem &problem, const StreamChunk &chunk, void *c);
+    bool Complete(Slot &slot);
+    bool Flush();
+    void Release(Slot &slot);
+
+    size_t budget_;
+    std::vector<StreamChunk> chunks_;
+    Slot slots_[2];
+    void *b_;
+    size_t bCapacity_;
+    size_t peakBytes_;
+};
+
+#endif // STREAMING_RUNNER_H
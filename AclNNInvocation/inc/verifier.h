@@ -0,0 +1,77 @@
+/**
+ * @file verifier.h
+ *
+ * Parallel streaming replacement for scripts/verify_result.py. Output and
+ * golden are compared chunk by chunk on all cores with AVX2 / NEON using the
+ * same float32 isclose(rtol, atol, equal_nan=True) test and error-ratio
+ * tolerance; files are mmapped instead of loaded. Besides the pass / fail
+ * verdict it reports max abs / rel error, mismatches per 16-row window and a
+ * capped list of example mismatches.
+ */
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct VerifyConfig {
+    // 与 verify_result.py 相同的 float32 容差
+    float rtol = 1e-4f;
+    float atol = 1e-6f;
+    double errorTol = 1e-4;
+    int64_t n = 0;              // row length of C, 0 disables the row-window histogram
+    size_t maxExamples = 100;
+    size_t threadNum = 0;       // 0 means hardware concurrency
+};
+
+struct VerifyMismatch {
+    size_t index = 0;
+    float expected = 0.0f;
+    float actual = 0.0f;
+};
+
+struct VerifyReport {
+    size_t count = 0;
+    size_t mismatches = 0;
+    double errorRatio = 0.0;
+    bool passed = false;
+
+    // NaN 不参与统计；golden 为 0 的元素不计相对误差
+    float maxAbsError = 0.0f;
+    size_t maxAbsIndex = 0;
+    float maxRelError = 0.0f;
+    size_t maxRelIndex = 0;
+
+    std::vector<size_t> windowMismatches;  // per 16-row window, empty when n is unknown
+    std::vector<VerifyMismatch> examples;  // first mismatches in index order
+};
+
+class Verifier {
+public:
+    explicit Verifier(const VerifyConfig &config = VerifyConfig());
+
+    /**
+     * @brief Compare count float32 elements
+     * @return false on invalid arguments; the verdict is report.passed
+     */
+    bool Compare(const float *output, const float *golden, size_t count, VerifyReport &report) const;
+
+    /**
+     * @brief mmap both files and compare them, sizes must match
+     */
+    bool CompareFiles(const std::string &outputPath, const std::string &goldenPath, VerifyReport &report) const;
+
+    /**
+     * @brief Log examples, statistics, the worst row windows and the verdict
+     */
+    void Print(const VerifyReport &report) const;
+
+    static const char *GetIsaName();
+
+private:
+    VerifyConfig config_;
+};
+
+#endif // VERIFIER_H
@@ -0,0 +1,26 @@
+/**
+ * @file window_schedule.h
+ *
+ * Host-side ordering of the row windows for BCSR_SPMM_FLAG_SCHEDULE. Windows
+ * are sorted by the mean starting column of their blocks and the kernel deals
+ * the sorted positions over the cores cyclically, so at every step the cores
+ * work on windows that read neighbouring B rows and share them in L2 instead
+ * of each core streaming a different part of B.
+ */
+#ifndef WINDOW_SCHEDULE_H
+#define WINDOW_SCHEDULE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "spmm_session.h"
+
+/**
+ * @brief Order the row windows of problem for the scheduled partition
+ * @param [in] problem: host row_ptr and col must be set
+ * @param [out] order: windowNum window indices, a permutation of 0 .. windowNum - 1;
+ *        windows without blocks come last
+ */
+bool BuildWindowSchedule(const SpmmProblem &problem, std::vector<uint32_t> &order);
+
+#endif // WINDOW_SCHEDULE_H
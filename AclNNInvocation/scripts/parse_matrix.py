@@ -2,6 +2,25 @@ import sys
 import os
 import numpy as np
 
+# uint16 block-column units cover K up to 65535 * BLOCK_K
+MAX_COMPACT_BLOCK_COLS = 65535
+
+
+def write_compact_col_idx(output_dir, col_idx, block_cols, BLOCK_K):
+    """
+    Writes col_idx_u16.bin: the starting column of each block stored as uint16
+    block-column units (col // BLOCK_K). The kernel decodes it back by
+    multiplying with BLOCK_K. Skipped when the block columns do not fit 16 bits.
+    """
+    path = os.path.join(output_dir, 'col_idx_u16.bin')
+    if block_cols > MAX_COMPACT_BLOCK_COLS:
+        if os.path.exists(path):
+            os.remove(path)
+        return False
+    (col_idx // BLOCK_K).astype(np.uint16).tofile(path)
+    return True
+
+
 def parse_mtx_to_bcsr(file_path, BLOCK_M=16, BLOCK_K=16):
     """
     Parses a .mtx file to extract matrix and convert to BCSR format.
@@ -16,6 +35,8 @@ def parse_mtx_to_bcsr(file_path, BLOCK_M=16, BLOCK_K=16):
     - row_ptr.bin (int32): Prefix sum of blocks per row window (size BLOCK_M)
     - col_idx.bin (int32): Starting column index for each block (multiple of BLOCK_K)
     - values.bin (float16): All elements in each block (BLOCK_M*BLOCK_K elements per block, row-major)
+    and, when the block columns fit in 16 bits, the compact index stream
+    - col_idx_u16.bin (uint16): Block-column index of each block (col // BLOCK_K)
     """
     # Read file lines and filter comments
     with open(file_path, 'r') as f:
@@ -49,6 +70,7 @@ def parse_mtx_to_bcsr(file_path, BLOCK_M=16, BLOCK_K=16):
         row_ptr.tofile(os.path.join(output_dir, 'row_ptr.bin'))
         col_idx.tofile(os.path.join(output_dir, 'col_idx.bin'))
         values.tofile(os.path.join(output_dir, 'values.bin'))
+        compact = write_compact_col_idx(output_dir, col_idx, (K + BLOCK_K - 1) // BLOCK_K, BLOCK_K)
         
         with open(os.path.join(output_dir, 'block_info.txt'), 'w') as f:
             f.write(f"BLOCK_M={BLOCK_M}\n")
@@ -59,6 +81,7 @@ def parse_mtx_to_bcsr(file_path, BLOCK_M=16, BLOCK_K=16):
             f.write(f"Block_cols={(K + BLOCK_K - 1) // BLOCK_K}\n")
             f.write(f"Num_blocks=0\n")
             f.write(f"Total_values_stored=0\n")
+            f.write(f"Col_encoding={'u16' if compact else 'i32'}\n")
         
         print(f"{M} {K} {N} {nnz} {block_rows} 0")
         return
@@ -154,6 +177,7 @@ def parse_mtx_to_bcsr(file_path, BLOCK_M=16, BLOCK_K=16):
     row_ptr_np.tofile(os.path.join(output_dir, 'row_ptr.bin'))
     col_idx_np.tofile(os.path.join(output_dir, 'col_idx.bin'))
     values_np.tofile(os.path.join(output_dir, 'values.bin'))
+    compact = write_compact_col_idx(output_dir, col_idx_np, block_cols, BLOCK_K)
     
     # Save metadata
     with open(os.path.join(output_dir, 'block_info.txt'), 'w') as f:
@@ -165,6 +189,7 @@ def parse_mtx_to_bcsr(file_path, BLOCK_M=16, BLOCK_K=16):
         f.write(f"Block_cols={block_cols}\n")
         f.write(f"Num_blocks={len(all_block_cols)}\n")
         f.write(f"Total_values_stored={len(values_np)}\n")
+        f.write(f"Col_encoding={'u16' if compact else 'i32'}\n")
     
     # Print dimensions for calling script
     print(f"{M} {K} {N} {nnz} {block_rows} {len(all_block_cols)}")
@@ -0,0 +1,107 @@
+/**
+ * @file analyze_main.cpp
+ *
+ * analyze_bcsr <sample_dir | matrix.mtx> [--n=N] [--cores=C] [--vector-cores=V] [--mmad-n=32] [--col=u16|i32|i64]
+ *              [--direct-output] [--ns-per-mmad=T] [--ns-per-vector-block=T] [--gbps=B] [--out=<file.json|file.csv>]
+ * N defaults to mnk.txt, then the size of x2_gm.bin, then K like parse_matrix.py.
+ */
+#include <algorithm>
+#include <fstream>
+
+#include "bcsr_analyzer.h"
+#include "bcsr_matrix.h"
+#include "common.h"
+#include "options.h"
+
+namespace {
+std::string BaseName(const std::string &path)
+{
+    std::string trimmed = path;
+    while (trimmed.size() > 1 && trimmed.back() == '/') {
+        trimmed.pop_back();
+    }
+    size_t pos = trimmed.find_last_of('/');
+    return pos == std::string::npos ? trimmed : trimmed.substr(pos + 1);
+}
+
+bool EndsWith(const std::string &text, const std::string &suffix)
+{
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// 与 test.sh 的目录约定一致：mnk.txt 记录 N，否则由 B 的大小推出
+int64_t SampleN(const std::string &dir, int64_t k)
+{
+    std::ifstream mnk(dir + "/mnk.txt");
+    std::string line;
+    while (std::getline(mnk, line)) {
+        if (line.compare(0, 2, "N=") == 0) {
+            return std::stoll(line.substr(2));
+        }
+    }
+    size_t bSize = 0;
+    std::ifstream b(dir + "/x2_gm.bin", std::ios::binary | std::ios::ate);
+    if (b.is_open() && k > 0) {
+        bSize = static_cast<size_t>(b.tellg());
+        if (bSize > 0 && bSize % (k * sizeof(uint16_t)) == 0) {
+            return static_cast<int64_t>(bSize / (k * sizeof(uint16_t)));
+        }
+    }
+    return k;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <sample_dir | matrix.mtx> [--n=N] [--cores=C] [--vector-cores=V]"
+                  << " [--mmad-n=32] [--col=u16|i32|i64] [--direct-output] [--ns-per-mmad=T] [--ns-per-vector-block=T] [--gbps=B]"
+                  << " [--out=<file.json|file.csv>]" << std::endl;
+        return FAILED;
+    }
+    Options options;
+    if (!options.Parse(argc, argv, 2)) {
+        return FAILED;
+    }
+    std::string source = argv[1];
+    std::string name = BaseName(source);
+    std::string sampleDir = source;
+    BcsrMatrix matrix;
+    if (EndsWith(source, ".mtx")) {
+        name = name.substr(0, name.size() - 4);
+        sampleDir = source.substr(0, source.size() - 4);
+        CooMatrix coo;
+        if (!ReadMtx(source, coo) || !BuildBcsr(coo, matrix)) {
+            return FAILED;
+        }
+    } else if (!LoadBcsr(source, matrix)) {
+        return FAILED;
+    }
+
+    AnalyzerConfig config;
+    config.coreNum = options.GetInt("cores", config.coreNum);
+    config.vectorCoreNum = options.GetInt("vector-cores", config.vectorCoreNum);
+    config.mmadN = options.GetInt("mmad-n", config.mmadN);
+    std::string col = options.GetString("col", matrix.FitsCompactCol() ? "u16" : "i32");
+    config.colBytes = col == "u16" ? 2 : (col == "i64" ? 8 : 4);
+    // i64 时 row_ptr 也按 int64 下发
+    config.rowPtrBytes = col == "i64" ? 8 : 4;
+    config.directOutput = options.Has("direct-output");
+    config.nsPerMmad = options.GetDouble("ns-per-mmad", config.nsPerMmad);
+    config.nsPerVectorBlock = options.GetDouble("ns-per-vector-block", config.nsPerVectorBlock);
+    config.gmGBps = options.GetDouble("gbps", config.gmGBps);
+    int64_t n = options.GetInt("n", 0);
+    if (n <= 0) {
+        n = SampleN(sampleDir, matrix.k);
+    }
+
+    BcsrAnalysis analysis;
+    if (!AnalyzeBcsr(matrix, n, config, analysis)) {
+        return FAILED;
+    }
+    PrintAnalysis(name, analysis);
+    if (options.Has("out") && !WriteAnalysis(options.GetString("out", ""), name, analysis)) {
+        return FAILED;
+    }
+    return SUCCESS;
+}
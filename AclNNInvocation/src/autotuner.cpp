@@ -0,0 +1,205 @@
+/**
+ * @file autotuner.cpp
+ */
+#include "autotuner.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "common.h"
+#include "verifier.h"
+
+namespace {
+bool ParseList(const Options &options, const std::string &name, std::vector<uint32_t> &values)
+{
+    if (!options.Has(name)) {
+        return true;
+    }
+    values.clear();
+    std::istringstream in(options.GetString(name, ""));
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        uint32_t value = 0;
+        if (name == "tune-partition") {
+            if (!BcsrSpmmParsePartition(item, value)) {
+                ERROR_LOG("Invalid --%s item %s", name.c_str(), item.c_str());
+                return false;
+            }
+        } else {
+            char *end = nullptr;
+            unsigned long number = std::strtoul(item.c_str(), &end, 10);
+            if (item.empty() || *end != '\0' || number > 0xffff) {
+                ERROR_LOG("Invalid --%s item %s", name.c_str(), item.c_str());
+                return false;
+            }
+            value = static_cast<uint32_t>(number);
+        }
+        values.push_back(value);
+    }
+    if (values.empty()) {
+        ERROR_LOG("Empty --%s", name.c_str());
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+bool TuneSpace::Parse(const Options &options)
+{
+    return ParseList(options, "tune-mmad-n", mmadN) && ParseList(options, "tune-cores", coreNum) &&
+           ParseList(options, "tune-partition", partition);
+}
+
+Autotuner::Autotuner(SpmmSession &session, const TuneSpace &space, const BenchConfig &bench)
+    : session_(session), space_(space), bench_(bench)
+{
+}
+
+bool Autotuner::Tune(const SpmmProblem &problem, const float *golden, TuneResult &result)
+{
+    result = TuneResult();
+    result.key = BcsrSpmmTuneKey(problem.m, problem.k, problem.n, problem.blockNum,
+        problem.WindowSignature());
+
+    VerifyConfig verifyConfig;
+    verifyConfig.n = problem.n;
+    Verifier verifier(verifyConfig);
+    std::vector<float> output(static_cast<size_t>(problem.m * problem.n));
+    const BcsrSpmmTuneConfig defaults;
+
+    for (uint32_t mmadN : space_.mmadN) {
+        // 向量 kernel 不使用 mmadN，按默认值只扫一遍
+        bool smallN = problem.n < BCSR_SPMM_SMALL_N;
+        if (smallN && mmadN != space_.mmadN.front()) {
+            continue;
+        }
+        for (uint32_t coreNum : space_.coreNum) {
+            for (uint32_t partition : space_.partition) {
+                TuneTrial trial;
+                trial.config.mmadN = smallN ? defaults.mmadN : mmadN;
+                trial.config.coreNum = coreNum;
+                trial.config.partition = partition;
+                if (!BcsrSpmmTuneValid(trial.config)) {
+                    WARN_LOG("Skip invalid tuning %s", BcsrSpmmFormatTune(trial.config).c_str());
+                    continue;
+                }
+                // 每个候选都重建 executor，TilingFunc 直接使用 a_shape 中的参数
+                SpmmProblem candidate = problem;
+                candidate.flags |= BCSR_SPMM_FLAG_TUNE;
+                candidate.tune = BcsrSpmmPackTune(trial.config);
+                VerifyReport report;
+                if (!session_.Load(candidate) || !session_.Run() || !session_.Download(output.data()) ||
+                    !verifier.Compare(output.data(), golden, output.size(), report)) {
+                    ERROR_LOG("Run tuning %s failed", BcsrSpmmFormatTune(trial.config).c_str());
+                    return false;
+                }
+                trial.passed = report.passed;
+                if (trial.passed) {
+                    BenchResult bench;
+                    bench.sample = BcsrSpmmFormatTune(trial.config);
+                    bench.problem = candidate;
+                    if (!RunBenchmark(session_, bench_, bench)) {
+                        return false;
+                    }
+                    trial.medianMs = bench.device.median;
+                } else {
+                    WARN_LOG("Tuning %s gives wrong results, error ratio %.4f",
+                        BcsrSpmmFormatTune(trial.config).c_str(), report.errorRatio);
+                }
+                int64_t index = static_cast<int64_t>(result.trials.size());
+                result.trials.push_back(trial);
+                if (trial.config.mmadN == defaults.mmadN && coreNum == defaults.coreNum && partition == defaults.partition) {
+                    result.baseline = index;
+                }
+                if (trial.passed && (result.best < 0 || trial.medianMs < result.trials[result.best].medianMs)) {
+                    result.best = index;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+std::string GetTuneDbPath(const Options &options)
+{
+    if (options.Has("tune-db")) {
+        return options.GetString("tune-db", "");
+    }
+    return BcsrSpmmTuneDbPath();
+}
+
+bool SaveTuneResult(const std::string &path, const std::string &sample, const TuneResult &result)
+{
+    if (result.best < 0) {
+        ERROR_LOG("No passing configuration for %s, tuning database unchanged", result.key.c_str());
+        return false;
+    }
+    // 同一 key 只保留最新一条，其他行（含注释）原样保留
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::string key;
+        BcsrSpmmTuneConfig config;
+        while (std::getline(in, line)) {
+            if (BcsrSpmmParseTuneLine(line, key, config) && key == result.key) {
+                continue;
+            }
+            lines.push_back(line);
+        }
+    }
+    if (lines.empty()) {
+        lines.push_back("# BcsrSpmmCustom tuning database, read by TilingFunc from $" +
+            std::string(BCSR_SPMM_TUNE_DB_ENV) + " or " + BCSR_SPMM_TUNE_DB_DEFAULT);
+    }
+    const TuneTrial &best = result.trials[result.best];
+    std::ostringstream entry;
+    entry << result.key << ' ' << BcsrSpmmFormatTune(best.config) << " us=" << best.medianMs * 1000.0
+          << " sample=" << sample;
+    lines.push_back(entry.str());
+
+    // 先写临时文件再改名，并发读取的 TilingFunc 不会读到半个文件
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        for (const auto &line : lines) {
+            out << line << '\n';
+        }
+        if (!out.good()) {
+            ERROR_LOG("Write tuning database %s failed", tmpPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ERROR_LOG("Replace tuning database %s failed", path.c_str());
+        return false;
+    }
+    INFO_LOG("Tuning database %s: %s", path.c_str(), entry.str().c_str());
+    // --tune-db 指向别处时 TilingFunc 查不到这条记录
+    if (path != BcsrSpmmTuneDbPath()) {
+        WARN_LOG("TilingFunc reads %s, set %s=%s to use this entry", BcsrSpmmTuneDbPath().c_str(),
+            BCSR_SPMM_TUNE_DB_ENV, path.c_str());
+    }
+    return true;
+}
+
+void PrintTuneResult(const std::string &sample, const TuneResult &result)
+{
+    INFO_LOG("Tune %s (%s): %zu configurations", sample.c_str(), result.key.c_str(), result.trials.size());
+    for (size_t i = 0; i < result.trials.size(); ++i) {
+        const TuneTrial &trial = result.trials[i];
+        if (trial.passed) {
+            INFO_LOG("  %-45s %10.3f us%s", BcsrSpmmFormatTune(trial.config).c_str(), trial.medianMs * 1000.0,
+                static_cast<int64_t>(i) == result.best ? "  <- best" : "");
+        } else {
+            INFO_LOG("  %-45s      wrong", BcsrSpmmFormatTune(trial.config).c_str());
+        }
+    }
+    if (result.best >= 0 && result.baseline >= 0 && result.trials[result.baseline].passed &&
+        result.trials[result.best].medianMs > 0.0) {
+        INFO_LOG("  speedup over default: %.3fx",
+            result.trials[result.baseline].medianMs / result.trials[result.best].medianMs);
+    }
+}
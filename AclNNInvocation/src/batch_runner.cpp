@@ -0,0 +1,728 @@
+/**
+ * @file batch_runner.cpp
+ */
+#include "batch_runner.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "autotuner.h"
+#include "benchmark.h"
+#include "common.h"
+#include "kernel_profile.h"
+#include "profiler.h"
+#include "spmm_iterator.h"
+#include "streaming_runner.h"
+#include "verifier.h"
+
+namespace {
+// 估计谱半径的幂迭代步数
+constexpr int64_t ITER_SCALE_STEPS = 32;
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string DirName(const std::string &path)
+{
+    size_t pos = path.find_last_of('/');
+    if (pos == std::string::npos) {
+        return ".";
+    }
+    return pos == 0 ? "/" : path.substr(0, pos);
+}
+
+std::string BaseName(const std::string &path)
+{
+    size_t pos = path.find_last_of('/');
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+bool IsDirectory(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool IsRegularFile(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+void FindMtx(const std::string &dir, std::vector<std::string> &paths)
+{
+    DIR *handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+        return;
+    }
+    while (struct dirent *entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        std::string path = dir + "/" + name;
+        if (IsDirectory(path)) {
+            FindMtx(path, paths);
+        } else if (name.size() > 4 && name.compare(name.size() - 4, 4, ".mtx") == 0) {
+            paths.push_back(path);
+        }
+    }
+    closedir(handle);
+}
+
+// 样例目录约定与 test.sh 一致：<dir>/<name>.mtx 旁的 <dir>/<name>/
+BatchSample MakeSample(const std::string &mtxPath)
+{
+    BatchSample sample;
+    std::string dir = DirName(mtxPath);
+    std::string base = BaseName(mtxPath);
+    sample.name = base.substr(0, base.size() - 4);
+    sample.category = BaseName(dir);
+    sample.mtxPath = mtxPath;
+    sample.bPath = dir + "/" + sample.name + "/x2_gm.bin";
+    sample.goldenPath = dir + "/" + sample.name + "/golden.bin";
+    return sample;
+}
+
+bool ReadBinary(const std::string &path, std::vector<char> &buffer)
+{
+    size_t fileSize = 0;
+    if (!GetFileSize(path, fileSize)) {
+        ERROR_LOG("Get size of %s failed", path.c_str());
+        return false;
+    }
+    buffer.resize(fileSize);
+    return fileSize == 0 || ReadFile(path, fileSize, buffer.data(), fileSize);
+}
+
+// 报告中只保留形状，host 指针在样例结束后失效
+SpmmProblem ShapeOf(const SpmmProblem &problem)
+{
+    SpmmProblem shape = problem;
+    shape.rowPtr = shape.col = shape.val = shape.b = nullptr;
+    return shape;
+}
+
+double Median(std::vector<double> samples)
+{
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[(samples.size() - 1) / 2];
+}
+} // namespace
+
+bool CollectBatchSamples(const std::string &source, std::vector<BatchSample> &samples)
+{
+    samples.clear();
+    if (IsDirectory(source)) {
+        std::vector<std::string> paths;
+        FindMtx(source, paths);
+        std::sort(paths.begin(), paths.end());
+        for (const std::string &path : paths) {
+            samples.push_back(MakeSample(path));
+        }
+        return true;
+    }
+    std::ifstream manifest(source);
+    if (!manifest.is_open()) {
+        ERROR_LOG("Batch source %s is neither a directory nor a readable manifest", source.c_str());
+        return false;
+    }
+    std::string root = DirName(source);
+    auto resolve = [&root](const std::string &path) {
+        return path.empty() || path[0] == '/' ? path : root + "/" + path;
+    };
+    std::string line;
+    while (std::getline(manifest, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string mtx;
+        std::string b;
+        std::string golden;
+        if (!(fields >> mtx)) {
+            continue;
+        }
+        fields >> b >> golden;
+        BatchSample sample = MakeSample(resolve(mtx));
+        if (!b.empty()) {
+            sample.bPath = resolve(b);
+        }
+        if (!golden.empty()) {
+            sample.goldenPath = resolve(golden);
+        }
+        samples.push_back(sample);
+    }
+    return true;
+}
+
+BatchRunner::BatchRunner(const Options &options)
+    : options_(options), useDevice_(!options.Has("cpu")),
+      cpu_(static_cast<size_t>(std::max<int64_t>(options.GetInt("threads", 0), 0))), benchWrites_(0)
+{
+}
+
+bool BatchRunner::Run(const std::vector<BatchSample> &samples)
+{
+    if (useDevice_ && !session_.Init()) {
+        ERROR_LOG("Init session failed");
+        return false;
+    }
+    results_.clear();
+    results_.reserve(samples.size());
+    benchWrites_ = 0;
+    for (const BatchSample &sample : samples) {
+        INFO_LOG("==================== Running batch sample %s ====================", sample.name.c_str());
+        BatchResult result;
+        result.sample = sample;
+        if (RunSample(sample, result)) {
+            result.status = result.passed ? "pass" : "fail";
+        }
+        INFO_LOG("[%s] %s: error ratio %.4f, convert %.3f ms, load %.3f ms, run %.3f ms, verify %.3f ms",
+            sample.name.c_str(), result.status.c_str(), result.errorRatio, result.convertMs, result.loadMs,
+            result.runMs, result.verifyMs);
+        results_.push_back(result);
+    }
+    return true;
+}
+
+// 计数来自最后一次 launch，--kernel-profile=<file.csv> 时每个 core 追加一行
+bool BatchRunner::ReportKernelProfile(const std::string &name)
+{
+    std::vector<KernelCoreProfile> cores;
+    if (!session_.ReadKernelProfile(cores)) {
+        return false;
+    }
+    PrintKernelProfile(name, cores);
+    std::string path = options_.GetString("kernel-profile", "");
+    return path.empty() || WriteKernelProfile(path, name, cores);
+}
+
+// 只调优结果正确的样例，golden 与校验用的是同一份
+bool BatchRunner::TuneSample(const std::string &name, const SpmmProblem &problem, const float *golden)
+{
+    TuneSpace space;
+    if (!space.Parse(options_)) {
+        return false;
+    }
+    BenchConfig bench;
+    bench.warmup = options_.GetInt("warmup", 3);
+    bench.iters = options_.GetInt("iters", 10);
+    Autotuner tuner(session_, space, bench);
+    TuneResult result;
+    if (!tuner.Tune(problem, golden, result)) {
+        return false;
+    }
+    PrintTuneResult(name, result);
+    return SaveTuneResult(GetTuneDbPath(options_), name, result);
+}
+
+// 结构固定、只换数值：每步缩放 COO 数值，经排列表散布到 BCSR values，只上传 val 后重跑，
+// 与 CPU 引擎在同一组数值上的结果比对，并确认 executor 没有重建
+bool BatchRunner::RefreshSample(const std::string &name, const CooMatrix &coo, const std::vector<int64_t> &valueMap,
+                                BcsrMatrix &matrix, const SpmmProblem &problem, double &refreshMs)
+{
+    int64_t steps = options_.GetInt("refresh", 1);
+    size_t builds = session_.GetExecutorBuilds();
+    VerifyConfig verifyConfig;
+    verifyConfig.n = problem.n;
+    verifyConfig.threadNum = cpu_.GetThreadNum();
+    Verifier verifier(verifyConfig);
+    std::vector<float> values(coo.values.size());
+    std::vector<float> output(static_cast<size_t>(problem.m * problem.n));
+    std::vector<float> golden(output.size());
+    std::vector<double> scatterTimes;
+    std::vector<double> uploadTimes;
+    std::vector<double> runTimes;
+    for (int64_t step = 1; step <= steps; ++step) {
+        float scale = 1.0f - 0.25f * static_cast<float>(step % 4);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = coo.values[i] * scale;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (!ScatterBcsrValues(valueMap, values.data(), matrix.values.data(), matrix.values.size(),
+            cpu_.GetThreadNum())) {
+            ERROR_LOG("Scatter values of %s failed", name.c_str());
+            return false;
+        }
+        scatterTimes.push_back(ElapsedMs(start));
+        start = std::chrono::steady_clock::now();
+        if (!session_.RefreshValues(matrix.values.data())) {
+            return false;
+        }
+        uploadTimes.push_back(ElapsedMs(start));
+        start = std::chrono::steady_clock::now();
+        if (!session_.Run() || !session_.Download(output.data())) {
+            return false;
+        }
+        runTimes.push_back(ElapsedMs(start));
+
+        std::fill(golden.begin(), golden.end(), 0.0f);
+        VerifyReport report;
+        if (!cpu_.Run(problem.ToCpuArgs(), golden.data()) ||
+            !verifier.Compare(output.data(), golden.data(), output.size(), report)) {
+            return false;
+        }
+        if (!report.passed) {
+            ERROR_LOG("Refresh step %ld of %s gives wrong results", static_cast<long>(step), name.c_str());
+            verifier.Print(report);
+            return false;
+        }
+    }
+    // 换回原始数值，之后的调优仍与原 golden 比对
+    if (!ScatterBcsrValues(valueMap, coo.values.data(), matrix.values.data(), matrix.values.size(),
+        cpu_.GetThreadNum()) || !session_.RefreshValues(matrix.values.data())) {
+        return false;
+    }
+    if (session_.GetExecutorBuilds() != builds) {
+        ERROR_LOG("Refreshing values of %s rebuilt the executor", name.c_str());
+        return false;
+    }
+    refreshMs = Median(scatterTimes) + Median(uploadTimes);
+    INFO_LOG("[%s] refresh %ld steps: scatter %.3f ms, upload %.3f ms (%zu bytes), run %.3f ms, executor reused",
+        name.c_str(), static_cast<long>(steps), Median(scatterTimes), Median(uploadTimes), problem.ValSize(),
+        Median(runTimes));
+    return true;
+}
+
+// 链式迭代 X_{t+1} = fp16(scale * A * X_t)：device 上连续执行 --iterate 步只同步一次，
+// 与 CPU 引擎逐步迭代的结果和每步范数比对
+bool BatchRunner::IterateSample(const std::string &name, const SpmmProblem &problem, double &iterateMs)
+{
+    int64_t steps = std::max<int64_t>(options_.GetInt("iterate", 8), 1);
+    if (problem.m != problem.k) {
+        INFO_LOG("[%s] skip iterate: A is %ld x %ld, not square", name.c_str(), static_cast<long>(problem.m),
+            static_cast<long>(problem.k));
+        return true;
+    }
+    // scale 默认取谱半径估计的倒数，X 的量级大致保持不变，不在 fp16 中上溢或下溢；
+    // 估计用 B 的第一列在 host 上做归一化的幂迭代
+    SpmmProblem column = problem;
+    column.n = 1;
+    std::vector<uint16_t> v(static_cast<size_t>(problem.k));
+    std::vector<float> av(v.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+        v[i] = static_cast<const uint16_t *>(problem.b)[i * problem.n];
+    }
+    double radius = 0.0;
+    for (int64_t i = 0; i < ITER_SCALE_STEPS; ++i) {
+        column.b = v.data();
+        std::fill(av.begin(), av.end(), 0.0f);
+        if (!cpu_.Run(column.ToCpuArgs(), av.data())) {
+            return false;
+        }
+        double vSum = 0.0;
+        double avSum = 0.0;
+        for (size_t j = 0; j < v.size(); ++j) {
+            double value = HalfToFloat(v[j]);
+            vSum += value * value;
+            avSum += static_cast<double>(av[j]) * av[j];
+        }
+        if (vSum == 0.0 || avSum == 0.0) {
+            break;
+        }
+        radius = std::sqrt(avSum / vSum);
+        for (size_t j = 0; j < v.size(); ++j) {
+            v[j] = FloatToHalf(static_cast<float>(av[j] / std::sqrt(avSum)));
+        }
+    }
+    IterConfig config;
+    config.norm = true;
+    config.scale = static_cast<float>(options_.GetDouble("iter-scale", radius > 0.0 ? 1.0 / radius : 1.0));
+
+    SpmmIterator iterator(session_);
+    std::vector<IterNorm> norms;
+    std::vector<uint16_t> x(static_cast<size_t>(problem.k * problem.n));
+    if (!iterator.Init(config)) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!iterator.Run(steps, &norms)) {
+        return false;
+    }
+    iterateMs = ElapsedMs(start);
+    if (!iterator.Download(x.data())) {
+        return false;
+    }
+
+    // CPU 参考：同样在每步把 fp32 结果乘 scale 后舍入到 fp16
+    std::vector<uint16_t> reference(static_cast<const uint16_t *>(problem.b),
+                                    static_cast<const uint16_t *>(problem.b) + x.size());
+    std::vector<float> c(static_cast<size_t>(problem.m * problem.n));
+    double maxNormError = 0.0;
+    for (int64_t step = 0; step < steps; ++step) {
+        SpmmProblem current = problem;
+        current.b = reference.data();
+        std::fill(c.begin(), c.end(), 0.0f);
+        if (!cpu_.Run(current.ToCpuArgs(), c.data())) {
+            return false;
+        }
+        double newSum = 0.0;
+        for (size_t i = 0; i < c.size(); ++i) {
+            float value = c[i] * config.scale;
+            newSum += static_cast<double>(value) * value;
+            reference[i] = FloatToHalf(value);
+        }
+        double norm = std::sqrt(newSum);
+        maxNormError = std::max(maxNormError, std::fabs(norms[step].norm - norm) / std::max(norm, 1e-30));
+    }
+
+    std::vector<float> actual(x.size());
+    std::vector<float> expected(x.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+        actual[i] = HalfToFloat(x[i]);
+        expected[i] = HalfToFloat(reference[i]);
+    }
+    // X 是 fp16，device 与 CPU 的累加顺序不同时会差一个 fp16 ulp
+    VerifyConfig verifyConfig;
+    verifyConfig.rtol = 1e-3f;
+    verifyConfig.n = problem.n;
+    verifyConfig.threadNum = cpu_.GetThreadNum();
+    Verifier verifier(verifyConfig);
+    VerifyReport report;
+    if (!verifier.Compare(actual.data(), expected.data(), actual.size(), report)) {
+        return false;
+    }
+    if (!report.passed || !(maxNormError <= 1e-3)) {
+        ERROR_LOG("Iterating %s for %ld steps gives wrong results, norm error %.3g", name.c_str(),
+            static_cast<long>(steps), maxNormError);
+        verifier.Print(report);
+        return false;
+    }
+    INFO_LOG("[%s] iterate %ld steps, scale %g: %.3f ms with one synchronization, ||X|| %.6g, last ||dX|| %.6g",
+        name.c_str(), static_cast<long>(steps), config.scale, iterateMs, norms.back().norm, norms.back().delta);
+    return true;
+}
+
+// 分块流式执行：按 --stream-budget 切分行窗口，结果与同一份 golden 比对
+bool BatchRunner::StreamSample(const std::string &name, const SpmmProblem &problem, const float *golden,
+                               double &streamMs)
+{
+    size_t budget = static_cast<size_t>(options_.GetDouble("stream-budget", 0.0) * 1024.0 * 1024.0);
+    StreamingRunner runner(budget);
+    std::vector<float> output(static_cast<size_t>(problem.m * problem.n), 0.0f);
+    if (!runner.Init() || !runner.Plan(problem)) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!runner.Run(problem, output.data())) {
+        return false;
+    }
+    streamMs = ElapsedMs(start);
+
+    VerifyConfig config;
+    config.n = problem.n;
+    config.threadNum = cpu_.GetThreadNum();
+    Verifier verifier(config);
+    VerifyReport report;
+    if (!verifier.Compare(output.data(), golden, output.size(), report)) {
+        return false;
+    }
+    if (!report.passed) {
+        ERROR_LOG("Streaming %s in %zu chunks gives wrong results", name.c_str(), runner.GetChunks().size());
+        verifier.Print(report);
+        return false;
+    }
+    INFO_LOG("[%s] stream %zu chunks: %.3f ms, peak device memory %zu of %zu bytes", name.c_str(),
+        runner.GetChunks().size(), streamMs, runner.GetPeakBytes(), budget);
+    return true;
+}
+
+bool BatchRunner::RunSample(const BatchSample &sample, BatchResult &result)
+{
+    ProfileScope scope("batch.Sample");
+    // 1. 转换：.mtx -> BCSR，与 parse_matrix.py 输出一致；--refresh 时顺带记录 COO -> values 的排列表。
+    //    --convert=device 时 host 只按行排序，BCSR 由 CooToBcsrCustom 在 device 上生成
+    auto start = std::chrono::steady_clock::now();
+    CooMatrix coo;
+    BcsrMatrix matrix;
+    std::vector<int64_t> valueMap;
+    std::vector<uint16_t> cooValues;
+    bool refresh = useDevice_ && options_.Has("refresh");
+    bool deviceConvert = useDevice_ && options_.GetString("convert", "host") == "device";
+    if (!ReadMtx(sample.mtxPath, coo) || (!deviceConvert && !BuildBcsr(coo, matrix, refresh ? &valueMap : nullptr))) {
+        result.status = "error: convert";
+        return false;
+    }
+    if (deviceConvert) {
+        SortCooByRow(coo);
+        cooValues.resize(coo.values.size());
+        for (size_t i = 0; i < cooValues.size(); ++i) {
+            cooValues[i] = FloatToHalf(coo.values[i]);
+        }
+    }
+    result.convertMs = ElapsedMs(start);
+    result.nnz = coo.nnz;
+    // device 转换时 host BCSR 只给 CPU 真值、--refresh、--iterate、--stream-budget 和 --tune 用，也用来核对块数
+    bool iterate = useDevice_ && options_.Has("iterate");
+    bool hostBcsr = !deviceConvert || refresh || iterate || options_.Has("stream-budget") || options_.Has("tune") ||
+                    !IsRegularFile(sample.goldenPath);
+    if (deviceConvert && hostBcsr && !BuildBcsr(coo, matrix, refresh ? &valueMap : nullptr)) {
+        result.status = "error: convert";
+        return false;
+    }
+
+    std::vector<char> b;
+    if (!ReadBinary(sample.bPath, b)) {
+        result.status = "error: read b";
+        return false;
+    }
+    SpmmProblem problem;
+    problem.m = coo.m;
+    problem.k = coo.k;
+    // test.sh 约定 N = K；B 文件大小与之不符时按文件推出 N
+    problem.n = coo.k == 0 ? 0 : static_cast<int64_t>(b.size() / sizeof(uint16_t)) / coo.k;
+    if (problem.BSize() != b.size()) {
+        ERROR_LOG("B of %s has %zu bytes, not a multiple of K = %ld fp16 rows", sample.name.c_str(), b.size(),
+            static_cast<long>(coo.k));
+        result.status = "error: b shape";
+        return false;
+    }
+    problem.windowNum = matrix.WindowNum();
+    problem.blockNum = matrix.BlockNum();
+    std::vector<uint16_t> compactCol;
+    // CooToBcsrCustom 只输出 int32 起始列；--col=i64 把 row_ptr 与 col 都放宽为 int64，走 64 位索引的 kernel
+    std::string colOption = options_.GetString("col", "u16");
+    bool compact = !deviceConvert && colOption == "u16" && matrix.FitsCompactCol();
+    bool wide = !deviceConvert && colOption == "i64";
+    std::vector<int64_t> wideRowPtr;
+    std::vector<int64_t> wideCol;
+    if (compact) {
+        compactCol = matrix.CompactCol();
+    } else if (wide) {
+        wideRowPtr.assign(matrix.rowPtr.begin(), matrix.rowPtr.end());
+        wideCol.assign(matrix.col.begin(), matrix.col.end());
+    }
+    problem.rowPtrType = wide ? ACL_INT64 : ACL_INT32;
+    problem.colType = compact ? ACL_UINT16 : (wide ? ACL_INT64 : ACL_INT32);
+    problem.rowPtr = wide ? static_cast<const void *>(wideRowPtr.data()) :
+                            static_cast<const void *>(matrix.rowPtr.data());
+    if (compact) {
+        problem.col = compactCol.data();
+    } else {
+        problem.col = wide ? static_cast<const void *>(wideCol.data()) : static_cast<const void *>(matrix.col.data());
+    }
+    problem.val = matrix.values.data();
+    problem.b = b.data();
+    problem.flags = options_.Has("kernel-profile") ? BCSR_SPMM_FLAG_PROFILE : 0;
+    if (options_.Has("direct-output")) {
+        problem.flags |= BCSR_SPMM_FLAG_DIRECT_OUTPUT;
+    }
+    if (options_.Has("b-cache")) {
+        problem.flags |= BCSR_SPMM_FLAG_B_CACHE;
+    }
+    if (options_.Has("schedule")) {
+        problem.flags |= BCSR_SPMM_FLAG_SCHEDULE;
+    }
+    if (options_.Has("dense-windows")) {
+        problem.flags |= BCSR_SPMM_FLAG_DENSE;
+    }
+    if (options_.Has("mix")) {
+        problem.flags |= BCSR_SPMM_FLAG_MIX;
+    }
+    // 之后的步骤失败时报告里也要有形状
+    result.problem = ShapeOf(problem);
+
+    // 2. 执行：device 上复用同一个 session，或走 CPU 引擎
+    std::vector<float> output(static_cast<size_t>(problem.m * problem.n), 0.0f);
+    std::vector<double> runTimes;
+    int64_t repeat = std::max<int64_t>(options_.GetInt("repeat", 1), 1);
+    if (useDevice_) {
+        start = std::chrono::steady_clock::now();
+        if (deviceConvert) {
+            CooInput input;
+            input.m = coo.m;
+            input.k = coo.k;
+            input.nnz = static_cast<int64_t>(coo.rows.size());
+            input.rows = coo.rows.data();
+            input.cols = coo.cols.data();
+            input.values = cooValues.data();
+            if (!session_.LoadCoo(problem, input)) {
+                result.status = "error: load";
+                return false;
+            }
+            problem.windowNum = session_.GetProblem().windowNum;
+            problem.blockNum = session_.GetProblem().blockNum;
+            result.problem = ShapeOf(problem);
+            if (hostBcsr && problem.blockNum != matrix.BlockNum()) {
+                ERROR_LOG("Device conversion of %s gives %ld blocks, host conversion %ld", sample.name.c_str(),
+                    static_cast<long>(problem.blockNum), static_cast<long>(matrix.BlockNum()));
+                result.status = "error: device convert";
+                return false;
+            }
+        } else if (!session_.Load(problem)) {
+            result.status = "error: load";
+            return false;
+        }
+        result.loadMs = ElapsedMs(start);
+        for (int64_t i = 0; i < repeat; ++i) {
+            start = std::chrono::steady_clock::now();
+            if (!session_.Run()) {
+                result.status = "error: run";
+                return false;
+            }
+            runTimes.push_back(ElapsedMs(start));
+        }
+        if (!session_.Download(output.data())) {
+            result.status = "error: download";
+            return false;
+        }
+        if ((problem.flags & BCSR_SPMM_FLAG_PROFILE) != 0 && !ReportKernelProfile(sample.name)) {
+            result.status = "error: kernel profile";
+            return false;
+        }
+        if (options_.Has("bench")) {
+            BenchConfig config;
+            config.warmup = options_.GetInt("warmup", config.warmup);
+            config.iters = options_.GetInt("iters", config.iters);
+            BenchResult bench;
+            bench.category = sample.category;
+            bench.sample = sample.name;
+            bench.problem = problem;
+            bench.problem.rowPtr = bench.problem.col = bench.problem.val = bench.problem.b = nullptr;
+            bench.nnz = result.nnz;
+            // JSON 每个样例写一行，批量中第一个样例清空文件，之后追加
+            if (!RunBenchmark(session_, config, bench) ||
+                !WriteBenchResult(options_.GetString("bench-out", "../output/bench.csv"), bench, true,
+                    benchWrites_ != 0)) {
+                result.status = "error: bench";
+                return false;
+            }
+            ++benchWrites_;
+        }
+    } else {
+        for (int64_t i = 0; i < repeat; ++i) {
+            std::fill(output.begin(), output.end(), 0.0f);
+            start = std::chrono::steady_clock::now();
+            if (!cpu_.Run(problem.ToCpuArgs(), output.data())) {
+                result.status = "error: run";
+                return false;
+            }
+            runTimes.push_back(ElapsedMs(start));
+        }
+    }
+    result.runMs = Median(runTimes);
+
+    // 3. 校验：没有 golden.bin 时由 CPU 引擎生成
+    start = std::chrono::steady_clock::now();
+    std::vector<float> golden;
+    std::vector<char> goldenBytes;
+    if (IsRegularFile(sample.goldenPath)) {
+        if (!ReadBinary(sample.goldenPath, goldenBytes)) {
+            result.status = "error: read golden";
+            return false;
+        }
+        golden.resize(goldenBytes.size() / sizeof(float));
+        std::copy(goldenBytes.begin(), goldenBytes.begin() + golden.size() * sizeof(float),
+            reinterpret_cast<char *>(golden.data()));
+    } else {
+        golden.assign(output.size(), 0.0f);
+        if (!cpu_.Run(problem.ToCpuArgs(), golden.data())) {
+            result.status = "error: cpu golden";
+            return false;
+        }
+        result.cpuGolden = true;
+    }
+    if (golden.size() != output.size()) {
+        ERROR_LOG("Golden of %s has %zu elements, output has %zu", sample.name.c_str(), golden.size(), output.size());
+        result.status = "error: golden shape";
+        return false;
+    }
+    VerifyConfig config;
+    config.n = problem.n;
+    config.threadNum = cpu_.GetThreadNum();
+    Verifier verifier(config);
+    VerifyReport report;
+    if (!verifier.Compare(output.data(), golden.data(), output.size(), report)) {
+        result.status = "error: verify";
+        return false;
+    }
+    result.verifyMs = ElapsedMs(start);
+    result.errorRatio = report.errorRatio;
+    result.maxAbsError = report.maxAbsError;
+    result.maxRelError = report.maxRelError;
+    result.passed = report.passed;
+    if (!report.passed) {
+        verifier.Print(report);
+    }
+    // 校验之后的子步骤失败时样例计为失败，批量运行据此返回非 0
+    if (refresh && report.passed && !RefreshSample(sample.name, coo, valueMap, matrix, problem, result.refreshMs)) {
+        result.status = "error: refresh";
+        result.passed = false;
+        return false;
+    }
+    if (iterate && report.passed && !IterateSample(sample.name, problem, result.iterateMs)) {
+        result.status = "error: iterate";
+        result.passed = false;
+        return false;
+    }
+    if (useDevice_ && report.passed && options_.Has("stream-budget") &&
+        !StreamSample(sample.name, problem, golden.data(), result.streamMs)) {
+        result.status = "error: stream";
+        result.passed = false;
+        return false;
+    }
+    if (useDevice_ && report.passed && options_.Has("tune") && !TuneSample(sample.name, problem, golden.data())) {
+        result.status = "error: tune";
+        result.passed = false;
+        return false;
+    }
+    return true;
+}
+
+bool BatchRunner::WriteReport(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        ERROR_LOG("Failed to open batch report: %s", path.c_str());
+        return false;
+    }
+    out << "category,sample,m,k,n,nnz,window_num,block_num,col_type,golden,"
+           "convert_ms,load_ms,run_ms,verify_ms,refresh_ms,iterate_ms,stream_ms,"
+           "error_ratio,max_abs_error,max_rel_error,status\n";
+    for (const BatchResult &result : results_) {
+        const SpmmProblem &p = result.problem;
+        out << result.sample.category << ',' << result.sample.name << ',' << p.m << ',' << p.k << ',' << p.n << ','
+            << result.nnz << ',' << p.windowNum << ',' << p.blockNum << ','
+            << IndexTypeName(p.colType) << ',' << (result.cpuGolden ? "cpu" : "file") << ','
+            << result.convertMs << ',' << result.loadMs << ',' << result.runMs << ',' << result.verifyMs << ','
+            << result.refreshMs << ',' << result.iterateMs << ',' << result.streamMs << ','
+            << result.errorRatio << ',' << result.maxAbsError << ',' << result.maxRelError << ',' << result.status
+            << '\n';
+    }
+    return out.good();
+}
+
+void BatchRunner::PrintSummary() const
+{
+    double convertMs = 0.0;
+    double runMs = 0.0;
+    for (const BatchResult &result : results_) {
+        convertMs += result.convertMs;
+        runMs += result.runMs;
+        if (!result.passed) {
+            ERROR_LOG("[%s/%s] %s", result.sample.category.c_str(), result.sample.name.c_str(),
+                result.status.c_str());
+        }
+    }
+    INFO_LOG("Batch: %zu samples, %zu passed, %zu failed, convert %.3f ms, run %.3f ms in total", results_.size(),
+        results_.size() - GetFailedCount(), GetFailedCount(), convertMs, runMs);
+}
+
+size_t BatchRunner::GetFailedCount() const
+{
+    size_t failed = 0;
+    for (const BatchResult &result : results_) {
+        failed += result.passed ? 0 : 1;
+    }
+    return failed;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file bcsr_analyzer.cpp
+ */
+#include "bcsr_analyzer.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "bcsr_spmm_desc.h"
+#include "common.h"
+
+namespace {
+constexpr int64_t BLOCK_M = 16;
+constexpr int64_t BLOCK_K = 16;
+constexpr int64_t BLOCK_SIZE = BLOCK_M * BLOCK_K;
+constexpr int64_t FILL_BINS = 16;
+
+int64_t WindowBin(int64_t blocks)
+{
+    int64_t bin = 0;
+    while (blocks > 0) {
+        ++bin;
+        blocks >>= 1;
+    }
+    return bin;
+}
+
+template <typename T>
+void WriteArrayJson(std::ofstream &out, const char *name, const std::vector<T> &values)
+{
+    out << "  \"" << name << "\": [";
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i == 0 ? "" : ", ") << values[i];
+    }
+    out << "]";
+}
+} // namespace
+
+bool AnalyzeBcsr(const BcsrMatrix &matrix, int64_t n, const AnalyzerConfig &config, BcsrAnalysis &analysis)
+{
+    if (n <= 0 || config.coreNum <= 0 || config.mmadN <= 0 ||
+        static_cast<int64_t>(matrix.values.size()) != matrix.BlockNum() * BLOCK_SIZE) {
+        ERROR_LOG("Invalid analysis input");
+        return false;
+    }
+    analysis = BcsrAnalysis();
+    analysis.m = matrix.m;
+    analysis.k = matrix.k;
+    analysis.n = n;
+    analysis.windowNum = matrix.WindowNum();
+    analysis.blockNum = matrix.BlockNum();
+
+    // 1. 块填充率
+    analysis.fillHistogram.assign(FILL_BINS, 0);
+    int64_t minFill = BLOCK_SIZE;
+    int64_t maxFill = 0;
+    for (int64_t blk = 0; blk < analysis.blockNum; ++blk) {
+        const uint16_t *block = matrix.values.data() + blk * BLOCK_SIZE;
+        int64_t count = 0;
+        for (int64_t i = 0; i < BLOCK_SIZE; ++i) {
+            count += (block[i] & 0x7fff) != 0 ? 1 : 0;
+        }
+        analysis.nnz += count;
+        minFill = std::min(minFill, count);
+        maxFill = std::max(maxFill, count);
+        analysis.fillHistogram[std::max<int64_t>(count - 1, 0) / (BLOCK_SIZE / FILL_BINS)]++;
+    }
+    if (analysis.blockNum > 0) {
+        analysis.fillMean = static_cast<double>(analysis.nnz) / (analysis.blockNum * BLOCK_SIZE);
+        analysis.fillMin = static_cast<double>(minFill) / BLOCK_SIZE;
+        analysis.fillMax = static_cast<double>(maxFill) / BLOCK_SIZE;
+    }
+
+    // 2. 每个行窗口的块数
+    for (int64_t w = 0; w < analysis.windowNum; ++w) {
+        int64_t blocks = matrix.rowPtr[w + 1] - matrix.rowPtr[w];
+        int64_t bin = WindowBin(blocks);
+        if (static_cast<int64_t>(analysis.windowHistogram.size()) <= bin) {
+            analysis.windowHistogram.resize(static_cast<size_t>(bin + 1), 0);
+        }
+        analysis.windowHistogram[bin]++;
+        analysis.emptyWindows += blocks == 0 ? 1 : 0;
+        analysis.maxWindowBlocks = std::max(analysis.maxWindowBlocks, blocks);
+    }
+    if (analysis.windowNum > 0) {
+        analysis.meanWindowBlocks = static_cast<double>(analysis.blockNum) / analysis.windowNum;
+    }
+
+    // 3. 与 TilingFunc 相同的 former / tail 切分，N 很小时用 Vector core
+    int64_t total = analysis.windowNum;
+    analysis.vectorKernel = n < BCSR_SPMM_SMALL_N;
+    analysis.blockDim = std::min(analysis.vectorKernel ? config.vectorCoreNum : config.coreNum, total);
+    if (analysis.blockDim > 0) {
+        analysis.formerNum = total % analysis.blockDim;
+        if (analysis.formerNum == 0) {
+            analysis.formerNum = analysis.blockDim;
+        }
+        analysis.formerLength = (total + analysis.blockDim - 1) / analysis.blockDim;
+        analysis.tailNum = analysis.blockDim - analysis.formerNum;
+        analysis.tailLength = total / analysis.blockDim;
+    }
+    int64_t window = 0;
+    for (int64_t core = 0; core < analysis.blockDim; ++core) {
+        int64_t length = core < analysis.formerNum ? analysis.formerLength : analysis.tailLength;
+        int64_t end = std::min(total, window + length);
+        analysis.coreBlocks.push_back(matrix.rowPtr[end] - matrix.rowPtr[window]);
+        window = end;
+    }
+    if (!analysis.coreBlocks.empty() && analysis.blockNum > 0) {
+        int64_t maxBlocks = *std::max_element(analysis.coreBlocks.begin(), analysis.coreBlocks.end());
+        analysis.coreImbalance = static_cast<double>(maxBlocks) * analysis.blockDim / analysis.blockNum;
+    }
+
+    // 4. kernel 搬运量：每个 (块, mmad 列块) 重新搬 A 块、B 面板，并原子累加 C 块；
+    //    直写模式每个窗口在 L0C 中累加完只写一次 C；
+    //    向量 kernel 每块只搬一次 A 块和 validRows x N 的 B，每个窗口直接写一次 C
+    analysis.mmadNum = analysis.vectorKernel ? 1 : (n + config.mmadN - 1) / config.mmadN;
+    analysis.mmadCount = analysis.blockNum * analysis.mmadNum;
+    int64_t panelN = analysis.vectorKernel ? n : config.mmadN * analysis.mmadNum;
+    for (int64_t blk = 0; blk < analysis.blockNum; ++blk) {
+        // K 不对齐时越界的 B 行以 Duplicate 补零，不产生搬运
+        int64_t validRows = std::max<int64_t>(std::min<int64_t>(BLOCK_K, matrix.k - matrix.col[blk]), 0);
+        analysis.bBytes += static_cast<double>(validRows) * panelN * sizeof(uint16_t);
+    }
+    analysis.aBytes = static_cast<double>(analysis.mmadCount) * BLOCK_SIZE * sizeof(uint16_t);
+    bool direct = analysis.vectorKernel || config.directOutput;
+    analysis.cBytes = direct ? static_cast<double>(analysis.m) * n * sizeof(float) :
+        static_cast<double>(analysis.blockNum) * BLOCK_M * n * sizeof(float);
+    analysis.cInitBytes = direct ? 0.0 : static_cast<double>(analysis.m) * n * sizeof(float);
+    analysis.indexBytes = static_cast<double>(matrix.rowPtr.size()) * config.rowPtrBytes +
+        static_cast<double>(analysis.blockNum) * config.colBytes;
+    analysis.flops = 2.0 * analysis.blockNum * BLOCK_SIZE * n;
+
+    // 5. 预测耗时：最慢 core 的串行 Mmad 轮次与共享带宽二者取大，不含 C 清零
+    double coreNs = 0.0;
+    for (int64_t blocks : analysis.coreBlocks) {
+        double nsPerBlock = analysis.vectorKernel ? config.nsPerVectorBlock : analysis.mmadNum * config.nsPerMmad;
+        coreNs = std::max(coreNs, static_cast<double>(blocks) * nsPerBlock);
+    }
+    double kernelBytes = analysis.aBytes + analysis.bBytes + analysis.cBytes + analysis.indexBytes;
+    double bandwidthNs = config.gmGBps > 0.0 ? kernelBytes / config.gmGBps : 0.0;
+    analysis.predictedUs = std::max(coreNs, bandwidthNs) / 1000.0;
+    return true;
+}
+
+void PrintAnalysis(const std::string &name, const BcsrAnalysis &a)
+{
+    INFO_LOG("%s: M = %ld, K = %ld, N = %ld, %ld windows, %ld blocks, nnz = %ld", name.c_str(),
+        static_cast<long>(a.m), static_cast<long>(a.k), static_cast<long>(a.n), static_cast<long>(a.windowNum),
+        static_cast<long>(a.blockNum), static_cast<long>(a.nnz));
+    INFO_LOG("  block fill: mean %.4f, min %.4f, max %.4f", a.fillMean, a.fillMin, a.fillMax);
+    for (size_t bin = 0; bin < a.fillHistogram.size(); ++bin) {
+        if (a.fillHistogram[bin] != 0) {
+            INFO_LOG("    nnz %3zu-%3zu: %ld", bin * 16 + 1, bin * 16 + 16, static_cast<long>(a.fillHistogram[bin]));
+        }
+    }
+    INFO_LOG("  blocks per window: mean %.2f, max %ld, empty windows %ld", a.meanWindowBlocks,
+        static_cast<long>(a.maxWindowBlocks), static_cast<long>(a.emptyWindows));
+    for (size_t bin = 0; bin < a.windowHistogram.size(); ++bin) {
+        if (a.windowHistogram[bin] == 0) {
+            continue;
+        }
+        if (bin == 0) {
+            INFO_LOG("    0 blocks: %ld", static_cast<long>(a.windowHistogram[bin]));
+        } else {
+            INFO_LOG("    %ld-%ld blocks: %ld", 1L << (bin - 1), (1L << bin) - 1, static_cast<long>(a.windowHistogram[bin]));
+        }
+    }
+    INFO_LOG("  split: %s blockDim %ld, former %ld x %ld windows, tail %ld x %ld windows, core imbalance %.3f",
+        a.vectorKernel ? "vector" : "cube", static_cast<long>(a.blockDim), static_cast<long>(a.formerNum), static_cast<long>(a.formerLength),
+        static_cast<long>(a.tailNum), static_cast<long>(a.tailLength), a.coreImbalance);
+    INFO_LOG("  traffic: A %.3f MB, B %.3f MB, C %.3f MB (+ %.3f MB memset), index %.3f MB", a.aBytes / 1e6,
+        a.bBytes / 1e6, a.cBytes / 1e6, a.cInitBytes / 1e6, a.indexBytes / 1e6);
+    INFO_LOG("  mmad: %ld (%ld per block), %.3f GFLOP, predicted %.3f us", static_cast<long>(a.mmadCount),
+        static_cast<long>(a.mmadNum), a.flops / 1e9, a.predictedUs);
+}
+
+bool WriteAnalysis(const std::string &path, const std::string &name, const BcsrAnalysis &a)
+{
+    int64_t maxCore = a.coreBlocks.empty() ? 0 : *std::max_element(a.coreBlocks.begin(), a.coreBlocks.end());
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        struct stat st;
+        bool exists = stat(path.c_str(), &st) == 0 && st.st_size > 0;
+        std::ofstream out(path, std::ios::app);
+        if (!out.is_open()) {
+            ERROR_LOG("Failed to open analysis file: %s", path.c_str());
+            return false;
+        }
+        if (!exists) {
+            out << "sample,m,k,n,window_num,block_num,nnz,fill_mean,fill_min,fill_max,"
+                   "empty_windows,max_window_blocks,mean_window_blocks,block_dim,max_core_blocks,core_imbalance,"
+                   "mmad_num,mmad_count,a_bytes,b_bytes,c_bytes,c_init_bytes,index_bytes,flops,predicted_us\n";
+        }
+        out << std::setprecision(6) << name << ',' << a.m << ',' << a.k << ',' << a.n << ',' << a.windowNum << ','
+            << a.blockNum << ',' << a.nnz << ',' << a.fillMean << ',' << a.fillMin << ',' << a.fillMax << ','
+            << a.emptyWindows << ',' << a.maxWindowBlocks << ',' << a.meanWindowBlocks << ',' << a.blockDim << ','
+            << maxCore << ',' << a.coreImbalance << ',' << a.mmadNum << ',' << a.mmadCount << ','
+            << std::setprecision(12) << a.aBytes << ',' << a.bBytes << ',' << a.cBytes << ',' << a.cInitBytes
+            << ',' << a.indexBytes << ',' << a.flops << ',' << std::setprecision(6) << a.predictedUs << '\n';
+        return out.good();
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        ERROR_LOG("Failed to open analysis file: %s", path.c_str());
+        return false;
+    }
+    out << std::setprecision(6) << "{\n"
+        << "  \"sample\": \"" << name << "\",\n"
+        << "  \"m\": " << a.m << ", \"k\": " << a.k << ", \"n\": " << a.n << ",\n"
+        << "  \"window_num\": " << a.windowNum << ", \"block_num\": " << a.blockNum << ", \"nnz\": " << a.nnz
+        << ",\n"
+        << "  \"fill\": {\"mean\": " << a.fillMean << ", \"min\": " << a.fillMin << ", \"max\": " << a.fillMax
+        << "},\n";
+    WriteArrayJson(out, "fill_histogram", a.fillHistogram);
+    out << ",\n"
+        << "  \"window_blocks\": {\"mean\": " << a.meanWindowBlocks << ", \"max\": " << a.maxWindowBlocks
+        << ", \"empty\": " << a.emptyWindows << "},\n";
+    WriteArrayJson(out, "window_histogram", a.windowHistogram);
+    out << ",\n"
+        << "  \"split\": {\"block_dim\": " << a.blockDim << ", \"former_num\": " << a.formerNum
+        << ", \"former_length\": " << a.formerLength << ", \"tail_num\": " << a.tailNum
+        << ", \"tail_length\": " << a.tailLength << ", \"max_core_blocks\": " << maxCore
+        << ", \"imbalance\": " << a.coreImbalance << "},\n";
+    WriteArrayJson(out, "core_blocks", a.coreBlocks);
+    out << ",\n" << std::setprecision(12)
+        << "  \"mmad_num\": " << a.mmadNum << ", \"mmad_count\": " << a.mmadCount << ",\n"
+        << "  \"bytes\": {\"a\": " << a.aBytes << ", \"b\": " << a.bBytes << ", \"c\": " << a.cBytes
+        << ", \"c_init\": " << a.cInitBytes << ", \"index\": " << a.indexBytes << ", \"total\": "
+        << a.TotalBytes() << "},\n"
+        << "  \"flops\": " << a.flops << ",\n"
+        << std::setprecision(6) << "  \"predicted_us\": " << a.predictedUs << "\n"
+        << "}\n";
+    return out.good();
+}
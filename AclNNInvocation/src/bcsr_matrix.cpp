@@ -0,0 +1,370 @@
+/**
+ * @file bcsr_matrix.cpp
+ */
+#include "bcsr_matrix.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "common.h"
+#include "cpu_spmm.h"
+
+namespace {
+constexpr int64_t BLOCK_M = 16;
+constexpr int64_t BLOCK_K = 16;
+constexpr int64_t MAX_COMPACT_BLOCK_COLS = 65535;
+// 少于这么多元素时单线程 scatter，线程创建的开销比搬运还大
+constexpr size_t SCATTER_ENTRIES_PER_THREAD = 1 << 16;
+
+bool IsBlank(const char *begin, const char *end)
+{
+    for (const char *p = begin; p < end; ++p) {
+        if (*p != ' ' && *p != '\t' && *p != '\r') {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+bool BcsrMatrix::FitsCompactCol() const
+{
+    return (k + BLOCK_K - 1) / BLOCK_K <= MAX_COMPACT_BLOCK_COLS;
+}
+
+std::vector<uint16_t> BcsrMatrix::CompactCol() const
+{
+    std::vector<uint16_t> compact(col.size());
+    for (size_t i = 0; i < col.size(); ++i) {
+        compact[i] = static_cast<uint16_t>(col[i] / BLOCK_K);
+    }
+    return compact;
+}
+
+bool ReadMtx(const std::string &path, CooMatrix &coo)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        ERROR_LOG("Open matrix file %s failed", path.c_str());
+        return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    const std::string text = content.str();
+
+    coo = CooMatrix();
+    bool header = false;
+    const char *p = text.c_str();
+    const char *textEnd = p + text.size();
+    while (p < textEnd) {
+        const char *lineEnd = std::find(p, textEnd, '\n');
+        if (*p == '%' || IsBlank(p, lineEnd)) {
+            p = lineEnd + 1;
+            continue;
+        }
+        // strtod / strtoll 遇到换行前的非数字字符即停止，行尾由 lineEnd 保证
+        char *next = nullptr;
+        if (!header) {
+            int64_t dims[3] = {0, 0, 0};
+            const char *q = p;
+            for (int i = 0; i < 3; ++i) {
+                dims[i] = std::strtoll(q, &next, 10);
+                if (next == q || next > lineEnd) {
+                    ERROR_LOG("Invalid header in matrix file %s", path.c_str());
+                    return false;
+                }
+                q = next;
+            }
+            coo.m = dims[0];
+            coo.k = dims[1];
+            coo.nnz = dims[2];
+            coo.rows.reserve(static_cast<size_t>(std::max<int64_t>(coo.nnz, 0)));
+            coo.cols.reserve(static_cast<size_t>(std::max<int64_t>(coo.nnz, 0)));
+            coo.values.reserve(static_cast<size_t>(std::max<int64_t>(coo.nnz, 0)));
+            header = true;
+        } else {
+            const char *q = p;
+            double row = std::strtod(q, &next);
+            bool valid = next != q && next <= lineEnd;
+            q = next;
+            double col = std::strtod(q, &next);
+            valid = valid && next != q && next <= lineEnd;
+            q = next;
+            double value = std::strtod(q, &next);
+            if (next == q || next > lineEnd) {
+                value = 1.0;
+            }
+            if (!valid) {
+                ERROR_LOG("Invalid entry in matrix file %s", path.c_str());
+                return false;
+            }
+            coo.rows.push_back(static_cast<int32_t>(row) - 1);
+            coo.cols.push_back(static_cast<int32_t>(col) - 1);
+            coo.values.push_back(static_cast<float>(value));
+        }
+        p = lineEnd + 1;
+    }
+    if (!header) {
+        ERROR_LOG("Empty matrix file or only comments found: %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void SortCooByRow(CooMatrix &coo)
+{
+    // 计数排序，桶 0 放负行号，桶 M + 1 放越界行号
+    size_t count = coo.rows.size();
+    std::vector<size_t> offsets(static_cast<size_t>(coo.m) + 3, 0);
+    auto bucket = [&coo](int32_t row) {
+        return row < 0 ? 0 : (row >= coo.m ? static_cast<size_t>(coo.m) + 1 : static_cast<size_t>(row) + 1);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        ++offsets[bucket(coo.rows[i]) + 1];
+    }
+    for (size_t b = 1; b < offsets.size(); ++b) {
+        offsets[b] += offsets[b - 1];
+    }
+    std::vector<int32_t> rows(count);
+    std::vector<int32_t> cols(count);
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t pos = offsets[bucket(coo.rows[i])]++;
+        rows[pos] = coo.rows[i];
+        cols[pos] = coo.cols[i];
+        values[pos] = coo.values[i];
+    }
+    coo.rows.swap(rows);
+    coo.cols.swap(cols);
+    coo.values.swap(values);
+}
+
+bool BuildBcsr(const CooMatrix &coo, BcsrMatrix &matrix, std::vector<int64_t> *valueMap)
+{
+    if (coo.m < 0 || coo.k < 0 || coo.rows.size() != coo.cols.size() || coo.rows.size() != coo.values.size()) {
+        ERROR_LOG("Invalid coo matrix");
+        return false;
+    }
+    if (valueMap != nullptr) {
+        valueMap->assign(coo.rows.size(), -1);
+    }
+    matrix = BcsrMatrix();
+    matrix.m = coo.m;
+    matrix.k = coo.k;
+    int64_t windowNum = (coo.m + BLOCK_M - 1) / BLOCK_M;
+    matrix.rowPtr.assign(static_cast<size_t>(windowNum + 1), 0);
+
+    // 按行窗口做计数排序，保持文件顺序，重复元素后写覆盖前写
+    std::vector<int64_t> windowStart(static_cast<size_t>(windowNum + 1), 0);
+    for (size_t i = 0; i < coo.rows.size(); ++i) {
+        if (coo.rows[i] >= 0 && coo.rows[i] < coo.m && coo.cols[i] >= 0 && coo.cols[i] < coo.k) {
+            ++windowStart[coo.rows[i] / BLOCK_M + 1];
+        }
+    }
+    for (int64_t w = 0; w < windowNum; ++w) {
+        windowStart[w + 1] += windowStart[w];
+    }
+    std::vector<int64_t> order(static_cast<size_t>(windowStart[windowNum]));
+    std::vector<int64_t> fill(windowStart.begin(), windowStart.end() - 1);
+    for (size_t i = 0; i < coo.rows.size(); ++i) {
+        if (coo.rows[i] >= 0 && coo.rows[i] < coo.m && coo.cols[i] >= 0 && coo.cols[i] < coo.k) {
+            order[fill[coo.rows[i] / BLOCK_M]++] = static_cast<int64_t>(i);
+        }
+    }
+
+    for (int64_t w = 0; w < windowNum; ++w) {
+        auto begin = order.begin() + windowStart[w];
+        auto end = order.begin() + windowStart[w + 1];
+        std::stable_sort(begin, end, [&coo](int64_t a, int64_t b) {
+            return coo.cols[a] / BLOCK_K < coo.cols[b] / BLOCK_K;
+        });
+        int64_t blockCol = -1;
+        uint16_t *block = nullptr;
+        // 块内每个位置最后写入的元素，被覆盖的重复元素在 valueMap 中记为 -1
+        int64_t writer[BLOCK_M * BLOCK_K];
+        for (auto it = begin; it != end; ++it) {
+            int64_t entry = *it;
+            if (coo.cols[entry] / BLOCK_K != blockCol) {
+                blockCol = coo.cols[entry] / BLOCK_K;
+                matrix.col.push_back(static_cast<int32_t>(blockCol * BLOCK_K));
+                matrix.values.resize(matrix.values.size() + BLOCK_M * BLOCK_K, 0);
+                block = matrix.values.data() + matrix.values.size() - BLOCK_M * BLOCK_K;
+                std::fill(writer, writer + BLOCK_M * BLOCK_K, -1);
+            }
+            int64_t offset = (coo.rows[entry] % BLOCK_M) * BLOCK_K + coo.cols[entry] % BLOCK_K;
+            block[offset] = FloatToHalf(coo.values[entry]);
+            if (valueMap != nullptr) {
+                if (writer[offset] >= 0) {
+                    (*valueMap)[writer[offset]] = -1;
+                }
+                writer[offset] = entry;
+                (*valueMap)[entry] = static_cast<int64_t>(block - matrix.values.data()) + offset;
+            }
+        }
+        matrix.rowPtr[w + 1] = static_cast<int32_t>(matrix.col.size());
+    }
+    return true;
+}
+
+bool ScatterBcsrValues(const std::vector<int64_t> &valueMap, const float *cooValues, uint16_t *values,
+                       size_t valueNum, size_t threadNum)
+{
+    size_t count = valueMap.size();
+    if (count != 0 && (cooValues == nullptr || values == nullptr)) {
+        return false;
+    }
+    // 每个位置至多一个元素写入，按元素区间切分即可无锁并行
+    bool valid = true;
+    auto scatter = [&](size_t begin, size_t end, bool &ok) {
+        for (size_t i = begin; i < end; ++i) {
+            int64_t pos = valueMap[i];
+            if (pos < 0) {
+                continue;
+            }
+            if (static_cast<size_t>(pos) >= valueNum) {
+                ok = false;
+                return;
+            }
+            values[pos] = FloatToHalf(cooValues[i]);
+        }
+    };
+    if (threadNum == 0) {
+        threadNum = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadNum = std::max<size_t>(std::min(threadNum, count / SCATTER_ENTRIES_PER_THREAD), 1);
+    if (threadNum == 1) {
+        scatter(0, count, valid);
+        return valid;
+    }
+    std::vector<std::thread> threads;
+    std::vector<char> results(threadNum, 1);
+    size_t chunk = (count + threadNum - 1) / threadNum;
+    for (size_t t = 0; t < threadNum; ++t) {
+        threads.emplace_back([&, t]() {
+            bool ok = true;
+            scatter(std::min(t * chunk, count), std::min((t + 1) * chunk, count), ok);
+            results[t] = ok ? 1 : 0;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return std::find(results.begin(), results.end(), 0) == results.end();
+}
+
+bool SaveBcsr(const std::string &dir, const BcsrMatrix &matrix)
+{
+    bool compact = matrix.FitsCompactCol();
+    std::string compactPath = dir + "/col_idx_u16.bin";
+    if (!WriteFile(dir + "/row_ptr.bin", matrix.rowPtr.data(), matrix.rowPtr.size() * sizeof(int32_t)) ||
+        !WriteFile(dir + "/col_idx.bin", matrix.col.data(), matrix.col.size() * sizeof(int32_t)) ||
+        !WriteFile(dir + "/values.bin", matrix.values.data(), matrix.values.size() * sizeof(uint16_t))) {
+        return false;
+    }
+    if (compact) {
+        std::vector<uint16_t> compactCol = matrix.CompactCol();
+        if (!WriteFile(compactPath, compactCol.data(), compactCol.size() * sizeof(uint16_t))) {
+            return false;
+        }
+    } else {
+        (void)std::remove(compactPath.c_str());
+    }
+
+    std::ofstream info(dir + "/block_info.txt", std::ios::trunc);
+    info << "BLOCK_M=" << BLOCK_M << "\n"
+         << "BLOCK_K=" << BLOCK_K << "\n"
+         << "Original_M=" << matrix.m << "\n"
+         << "Original_K=" << matrix.k << "\n"
+         << "Block_rows=" << matrix.WindowNum() << "\n"
+         << "Block_cols=" << (matrix.k + BLOCK_K - 1) / BLOCK_K << "\n"
+         << "Num_blocks=" << matrix.BlockNum() << "\n"
+         << "Total_values_stored=" << matrix.values.size() << "\n"
+         << "Col_encoding=" << (compact ? "u16" : "i32") << "\n";
+    return info.good();
+}
+
+bool LoadBcsr(const std::string &dir, BcsrMatrix &matrix)
+{
+    matrix = BcsrMatrix();
+    std::ifstream info(dir + "/block_info.txt");
+    if (!info.is_open()) {
+        ERROR_LOG("Open file failed. path = %s/block_info.txt", dir.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(info, line)) {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, eq);
+        if (key == "Original_M") {
+            matrix.m = std::strtoll(line.c_str() + eq + 1, nullptr, 10);
+        } else if (key == "Original_K") {
+            matrix.k = std::strtoll(line.c_str() + eq + 1, nullptr, 10);
+        }
+    }
+    int64_t windowNum = (matrix.m + BLOCK_M - 1) / BLOCK_M;
+    matrix.rowPtr.resize(static_cast<size_t>(windowNum + 1));
+    size_t fileSize = 0;
+    if (!ReadFile(dir + "/row_ptr.bin", fileSize, matrix.rowPtr.data(), matrix.rowPtr.size() * sizeof(int32_t))) {
+        return false;
+    }
+    int64_t blockNum = matrix.rowPtr.back();
+    matrix.col.resize(static_cast<size_t>(blockNum));
+    matrix.values.resize(static_cast<size_t>(blockNum * BLOCK_M * BLOCK_K));
+    if (blockNum == 0) {
+        return true;
+    }
+    if (std::ifstream(dir + "/col_idx.bin").good()) {
+        if (!ReadFile(dir + "/col_idx.bin", fileSize, matrix.col.data(), matrix.col.size() * sizeof(int32_t))) {
+            return false;
+        }
+    } else {
+        // 只有紧凑索引时按块列号还原起始列
+        std::vector<uint16_t> compact(static_cast<size_t>(blockNum));
+        if (!ReadFile(dir + "/col_idx_u16.bin", fileSize, compact.data(), compact.size() * sizeof(uint16_t))) {
+            return false;
+        }
+        for (size_t i = 0; i < compact.size(); ++i) {
+            matrix.col[i] = static_cast<int32_t>(compact[i]) * BLOCK_K;
+        }
+    }
+    return ReadFile(dir + "/values.bin", fileSize, matrix.values.data(), matrix.values.size() * sizeof(uint16_t));
+}
+
+bool WriteMtx(const std::string &path, const BcsrMatrix &matrix, const std::string &comment)
+{
+    int64_t nnz = 0;
+    for (uint16_t value : matrix.values) {
+        nnz += (value & 0x7fff) != 0 ? 1 : 0;
+    }
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        ERROR_LOG("Open file failed. path = %s", path.c_str());
+        return false;
+    }
+    fprintf(file, "%%%%MatrixMarket matrix coordinate real general\n%% %s\n%ld %ld %ld\n", comment.c_str(),
+        static_cast<long>(matrix.m), static_cast<long>(matrix.k), static_cast<long>(nnz));
+    for (int64_t w = 0; w < matrix.WindowNum(); ++w) {
+        for (int32_t blk = matrix.rowPtr[w]; blk < matrix.rowPtr[w + 1]; ++blk) {
+            const uint16_t *block = matrix.values.data() + static_cast<size_t>(blk) * BLOCK_M * BLOCK_K;
+            for (int64_t i = 0; i < BLOCK_M * BLOCK_K; ++i) {
+                if ((block[i] & 0x7fff) != 0) {
+                    fprintf(file, "%ld %ld %.6f\n", static_cast<long>(w * BLOCK_M + i / BLOCK_K + 1),
+                        static_cast<long>(matrix.col[blk] + i % BLOCK_K + 1), HalfToFloat(block[i]));
+                }
+            }
+        }
+    }
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        ERROR_LOG("Write file Failed.");
+    }
+    return ok;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file benchmark.cpp
+ */
+#include "benchmark.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+double Percentile(const std::vector<double> &sorted, double p)
+{
+    // nearest rank: smallest sample with at least p of the samples at or below it
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// 单位换算：flops / ms -> GFLOP/s，bytes / ms -> GB/s
+double PerSecond(double amount, double ms)
+{
+    return ms > 0.0 ? amount / (ms * 1.0e6) : 0.0;
+}
+
+void WriteStatsJson(std::ostream &out, const char *name, const BenchStats &stats)
+{
+    out << "\"" << name << "\": {\"count\": " << stats.count << ", \"min_ms\": " << stats.min
+        << ", \"median_ms\": " << stats.median << ", \"p90_ms\": " << stats.p90 << ", \"p99_ms\": " << stats.p99
+        << ", \"mean_ms\": " << stats.mean << "}";
+}
+
+class EventPair {
+public:
+    EventPair() : start_(nullptr), end_(nullptr) {}
+
+    ~EventPair()
+    {
+        if (start_ != nullptr) {
+            (void)aclrtDestroyEvent(start_);
+        }
+        if (end_ != nullptr) {
+            (void)aclrtDestroyEvent(end_);
+        }
+    }
+
+    bool Create()
+    {
+        return aclrtCreateEvent(&start_) == ACL_SUCCESS && aclrtCreateEvent(&end_) == ACL_SUCCESS;
+    }
+
+    aclrtEvent Start() const
+    {
+        return start_;
+    }
+
+    aclrtEvent End() const
+    {
+        return end_;
+    }
+
+private:
+    aclrtEvent start_;
+    aclrtEvent end_;
+};
+} // namespace
+
+BenchStats BenchStats::From(std::vector<double> samples)
+{
+    BenchStats stats;
+    stats.count = samples.size();
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+    stats.min = samples.front();
+    stats.median = Percentile(samples, 0.5);
+    stats.p90 = Percentile(samples, 0.9);
+    stats.p99 = Percentile(samples, 0.99);
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    stats.mean = sum / samples.size();
+    return stats;
+}
+
+double BenchResult::BlockFlops() const
+{
+    return 2.0 * problem.blockNum * BCSR_TILE_M * BCSR_TILE_K * problem.n;
+}
+
+double BenchResult::NnzFlops() const
+{
+    return 2.0 * nnz * problem.n;
+}
+
+double BenchResult::Bytes() const
+{
+    return static_cast<double>(problem.RowPtrSize() + problem.ColSize() + problem.ValSize() + problem.BSize() +
+                               problem.CSize());
+}
+
+int64_t CountNonzeros(const SpmmProblem &problem)
+{
+    const uint16_t *val = static_cast<const uint16_t *>(problem.val);
+    size_t count = problem.ValSize() / sizeof(uint16_t);
+    int64_t nnz = 0;
+    for (size_t i = 0; i < count; ++i) {
+        // +0 与 -0 都不计入
+        nnz += (val[i] & 0x7fffu) != 0;
+    }
+    return nnz;
+}
+
+bool RunBenchmark(SpmmSession &session, const BenchConfig &config, BenchResult &result)
+{
+    if (config.warmup < 0 || config.iters <= 0) {
+        ERROR_LOG("Invalid --warmup=%ld or --iters=%ld", static_cast<long>(config.warmup),
+            static_cast<long>(config.iters));
+        return false;
+    }
+    for (int64_t i = 0; i < config.warmup; ++i) {
+        if (!session.Run()) {
+            return false;
+        }
+    }
+
+    EventPair events;
+    if (!events.Create()) {
+        ERROR_LOG("Create benchmark events failed");
+        return false;
+    }
+    std::vector<double> deviceTimes;
+    std::vector<double> hostTimes;
+    deviceTimes.reserve(config.iters);
+    hostTimes.reserve(config.iters);
+    for (int64_t i = 0; i < config.iters; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (!session.Launch(events.Start())) {
+            return false;
+        }
+        if (aclrtRecordEvent(events.End(), session.GetStream()) != ACL_SUCCESS ||
+            aclrtSynchronizeEvent(events.End()) != ACL_SUCCESS) {
+            ERROR_LOG("Record or synchronize benchmark event failed");
+            return false;
+        }
+        std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+        float deviceMs = 0.0f;
+        if (aclrtEventElapsedTime(&deviceMs, events.Start(), events.End()) != ACL_SUCCESS) {
+            ERROR_LOG("Get benchmark event elapsed time failed");
+            return false;
+        }
+        deviceTimes.push_back(deviceMs);
+        hostTimes.push_back(duration.count());
+    }
+    result.device = BenchStats::From(deviceTimes);
+    result.host = BenchStats::From(hostTimes);
+
+    INFO_LOG("Bench %s: kernel min %.4f / median %.4f / p90 %.4f / p99 %.4f ms, host median %.4f ms",
+        result.sample.c_str(), result.device.min, result.device.median, result.device.p90, result.device.p99,
+        result.host.median);
+    INFO_LOG("Bench %s: %.2f GFLOP/s (blocks), %.2f GFLOP/s (nnz), %.2f GB/s at median", result.sample.c_str(),
+        PerSecond(result.BlockFlops(), result.device.median), PerSecond(result.NnzFlops(), result.device.median),
+        PerSecond(result.Bytes(), result.device.median));
+    return true;
+}
+
+bool WriteBenchResult(const std::string &path, const BenchResult &result, bool jsonLine, bool append)
+{
+    const SpmmProblem &p = result.problem;
+    double median = result.device.median;
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        struct stat st;
+        bool exists = stat(path.c_str(), &st) == 0 && st.st_size > 0;
+        std::ofstream out(path, std::ios::app);
+        if (!out.is_open()) {
+            ERROR_LOG("Failed to open bench file: %s", path.c_str());
+            return false;
+        }
+        if (!exists) {
+            out << "category,sample,m,k,n,window_num,block_num,nnz,col_type,iters,"
+                   "kernel_min_ms,kernel_median_ms,kernel_p90_ms,kernel_p99_ms,kernel_mean_ms,"
+                   "host_min_ms,host_median_ms,host_p90_ms,host_p99_ms,"
+                   "gflops_blocks,gflops_nnz,gbps,flags\n";
+        }
+        out << std::setprecision(6) << result.category << ',' << result.sample << ',' << p.m << ',' << p.k << ','
+            << p.n << ',' << p.windowNum << ',' << p.blockNum << ',' << result.nnz << ',' << IndexTypeName(p.colType)
+            << ',' << result.device.count << ',' << result.device.min << ',' << result.device.median << ','
+            << result.device.p90 << ',' << result.device.p99 << ',' << result.device.mean << ','
+            << result.host.min << ',' << result.host.median << ',' << result.host.p90 << ',' << result.host.p99
+            << ',' << PerSecond(result.BlockFlops(), median) << ',' << PerSecond(result.NnzFlops(), median) << ','
+            << PerSecond(result.Bytes(), median) << ',' << p.flags << '\n';
+        return out.good();
+    }
+
+    // JSON Lines 每个对象占一行，追加在已有的行之后
+    std::ofstream out(path, jsonLine && append ? std::ios::app : std::ios::trunc);
+    if (!out.is_open()) {
+        ERROR_LOG("Failed to open bench file: %s", path.c_str());
+        return false;
+    }
+    const char *open = jsonLine ? "{" : "{\n  ";
+    const char *next = jsonLine ? ", " : ",\n  ";
+    const char *close = jsonLine ? "}\n" : "\n}\n";
+    out << std::setprecision(6) << open
+        << "\"category\": \"" << result.category << "\"" << next
+        << "\"sample\": \"" << result.sample << "\"" << next
+        << "\"m\": " << p.m << ", \"k\": " << p.k << ", \"n\": " << p.n << next
+        << "\"window_num\": " << p.windowNum << ", \"block_num\": " << p.blockNum << ", \"nnz\": " << result.nnz
+        << next
+        << "\"col_type\": \"" << IndexTypeName(p.colType) << "\"" << next;
+    WriteStatsJson(out, "kernel", result.device);
+    out << next;
+    WriteStatsJson(out, "host", result.host);
+    out << next
+        << "\"gflops_blocks\": " << PerSecond(result.BlockFlops(), median) << next
+        << "\"gflops_nnz\": " << PerSecond(result.NnzFlops(), median) << next
+        << "\"gbps\": " << PerSecond(result.Bytes(), median) << next
+        << "\"flags\": " << p.flags << close;
+    return out.good();
+}
@@ -56,9 +56,20 @@ bool ReadFile(const std::string &filePath, size_t fileSize, void *buffer, size_t
     return true;
 }
 
+bool GetFileSize(const std::string &filePath, size_t &fileSize)
+{
+    struct stat sBuf;
+    if (stat(filePath.data(), &sBuf) == -1 || S_ISREG(sBuf.st_mode) == 0) {
+        ERROR_LOG("failed to get file %s", filePath.c_str());
+        return false;
+    }
+    fileSize = static_cast<size_t>(sBuf.st_size);
+    return true;
+}
+
 bool WriteFile(const std::string &filePath, const void *buffer, size_t size)
 {
-    if (buffer == nullptr) {
+    if (buffer == nullptr && size != 0) {
         ERROR_LOG("Write file failed. buffer is nullptr");
         return false;
     }
@@ -69,7 +80,16 @@ bool WriteFile(const std::string &filePath, const void *buffer, size_t size)
         return false;
     }
 
-    size_t writeSize = write(fd, buffer, size);
+    // 单次 write 最多写入约 2 GB，大文件分多次写完
+    const char *data = static_cast<const char *>(buffer);
+    size_t writeSize = 0;
+    while (writeSize < size) {
+        ssize_t ret = write(fd, data + writeSize, size - writeSize);
+        if (ret <= 0) {
+            break;
+        }
+        writeSize += static_cast<size_t>(ret);
+    }
     (void)close(fd);
     if (writeSize != size) {
         ERROR_LOG("Write file Failed.");
@@ -0,0 +1,155 @@
+/**
+ * @file coo_converter.cpp
+ */
+#include "coo_converter.h"
+
+#include "aclnn_coo_to_bcsr_custom.h"
+#include "common.h"
+#include "coo_to_bcsr_desc.h"
+#include "mem_pool.h"
+#include "profiler.h"
+
+extern bool g_isDevice;
+
+CooConverter::CooConverter() : m_(0), k_(0), nnz_(0), workspace_(nullptr), workspaceCapacity_(0)
+{
+    for (size_t i = 0; i < COO_BUF_NUM; ++i) {
+        buffers_[i] = nullptr;
+        capacities_[i] = 0;
+    }
+}
+
+CooConverter::~CooConverter()
+{
+    for (size_t i = 0; i < COO_BUF_NUM; ++i) {
+        MemPool::Device().Free(buffers_[i]);
+    }
+    MemPool::Device().Free(workspace_);
+}
+
+bool CooConverter::Reserve(void *&buffer, size_t &capacity, size_t size)
+{
+    // device buffers must not be empty even for matrices without entries
+    size = size == 0 ? 32 : size;
+    if (size <= capacity) {
+        return true;
+    }
+    MemPool::Device().Free(buffer);
+    capacity = 0;
+    buffer = MemPool::Device().Alloc(size);
+    if (buffer == nullptr) {
+        ERROR_LOG("Malloc device memory for coo buffer failed, size %zu", size);
+        return false;
+    }
+    capacity = MemPool::SizeClass(size);
+    return true;
+}
+
+bool CooConverter::Upload(const CooInput &coo)
+{
+    ProfileScope scope("coo.Upload");
+    if (coo.m < 0 || coo.k < 0 || coo.nnz < 0 || (coo.nnz > 0 && (coo.rows == nullptr || coo.cols == nullptr ||
+        coo.values == nullptr))) {
+        ERROR_LOG("Invalid coo input");
+        return false;
+    }
+    const void *inputs[COO_BUF_NUM] = {coo.rows, coo.cols, coo.values};
+    const size_t sizes[COO_BUF_NUM] = {coo.nnz * sizeof(int32_t), coo.nnz * sizeof(int32_t),
+                                       coo.nnz * sizeof(uint16_t)};
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    for (size_t i = 0; i < COO_BUF_NUM; ++i) {
+        if (!Reserve(buffers_[i], capacities_[i], sizes[i])) {
+            return false;
+        }
+        if (sizes[i] != 0 && aclrtMemcpy(buffers_[i], capacities_[i], inputs[i], sizes[i], kind) != ACL_SUCCESS) {
+            ERROR_LOG("Copy coo buffer[%zu] failed", i);
+            return false;
+        }
+    }
+    m_ = coo.m;
+    k_ = coo.k;
+    nnz_ = coo.nnz;
+    return true;
+}
+
+bool CooConverter::Convert(aclrtStream stream, void *rowPtr, void *col, void *val, int64_t capacity,
+                           std::vector<int32_t> &hostRowPtr)
+{
+    ProfileScope scope("coo.Convert");
+    int64_t windowNum = (m_ + COO_TO_BCSR_TILE - 1) / COO_TO_BCSR_TILE;
+    int64_t shapeValue[COO_TO_BCSR_SHAPE_NUM] = {m_, k_, capacity};
+    int64_t entryShape[1] = {nnz_};
+    int64_t rowPtrShape[1] = {windowNum + 1};
+    int64_t colShape[1] = {capacity};
+    int64_t valShape[1] = {capacity * COO_TO_BCSR_TILE * COO_TO_BCSR_TILE};
+
+    // 转换只执行一次，executor 不设为可重复
+    aclIntArray *cooShape = aclCreateIntArray(shapeValue, COO_TO_BCSR_SHAPE_NUM);
+    aclTensor *tensors[6] = {
+        aclCreateTensor(entryShape, 1, ACL_INT32, nullptr, 0, ACL_FORMAT_ND, entryShape, 1, buffers_[COO_BUF_ROW]),
+        aclCreateTensor(entryShape, 1, ACL_INT32, nullptr, 0, ACL_FORMAT_ND, entryShape, 1, buffers_[COO_BUF_COL]),
+        aclCreateTensor(entryShape, 1, ACL_FLOAT16, nullptr, 0, ACL_FORMAT_ND, entryShape, 1,
+            buffers_[COO_BUF_VALUE]),
+        aclCreateTensor(rowPtrShape, 1, ACL_INT32, nullptr, 0, ACL_FORMAT_ND, rowPtrShape, 1, rowPtr),
+        aclCreateTensor(colShape, 1, ACL_INT32, nullptr, 0, ACL_FORMAT_ND, colShape, 1, col),
+        aclCreateTensor(valShape, 1, ACL_FLOAT16, nullptr, 0, ACL_FORMAT_ND, valShape, 1, val),
+    };
+    auto destroy = [&]() {
+        for (aclTensor *tensor : tensors) {
+            if (tensor != nullptr) {
+                (void)aclDestroyTensor(tensor);
+            }
+        }
+        if (cooShape != nullptr) {
+            (void)aclDestroyIntArray(cooShape);
+        }
+    };
+    for (aclTensor *tensor : tensors) {
+        if (tensor == nullptr || cooShape == nullptr) {
+            ERROR_LOG("Create tensors for CooToBcsrCustom failed");
+            destroy();
+            return false;
+        }
+    }
+
+    uint64_t workspaceSize = 0;
+    aclOpExecutor *executor = nullptr;
+    auto ret = aclnnCooToBcsrCustomGetWorkspaceSize(cooShape, tensors[0], tensors[1], tensors[2], tensors[3],
+                                                    tensors[4], tensors[5], &workspaceSize, &executor);
+    if (ret != ACL_SUCCESS || executor == nullptr) {
+        ERROR_LOG("Get CooToBcsrCustom workspace failed. error code is %d", static_cast<int32_t>(ret));
+        destroy();
+        return false;
+    }
+    if (!Reserve(workspace_, workspaceCapacity_, workspaceSize)) {
+        destroy();
+        return false;
+    }
+    {
+        DeviceProfileScope kernelScope("CooToBcsr kernel", stream);
+        ret = aclnnCooToBcsrCustom(workspaceSize != 0 ? workspace_ : nullptr, workspaceSize, executor, stream);
+    }
+    if (ret == ACL_SUCCESS) {
+        ret = aclrtSynchronizeStreamWithTimeout(stream, 5000);
+    }
+    destroy();
+    if (ret != ACL_SUCCESS) {
+        ERROR_LOG("Execute CooToBcsrCustom failed. error code is %d", static_cast<int32_t>(ret));
+        return false;
+    }
+
+    // row_ptr 只有 windowNum + 1 项，取回它来确定块数和行窗口签名
+    hostRowPtr.resize(static_cast<size_t>(windowNum + 1));
+    size_t size = hostRowPtr.size() * sizeof(int32_t);
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (aclrtMemcpy(hostRowPtr.data(), size, rowPtr, size, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy converted row_ptr failed");
+        return false;
+    }
+    return true;
+}
+
+size_t CooConverter::GetUploadBytes() const
+{
+    return static_cast<size_t>(nnz_) * (2 * sizeof(int32_t) + sizeof(uint16_t));
+}
@@ -0,0 +1,456 @@
+/**
+ * @file cpu_spmm.cpp
+ */
+#include "cpu_spmm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_SPMM_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CPU_SPMM_NEON 1
+#endif
+
+namespace {
+constexpr int64_t TILE_M = 16;
+constexpr int64_t TILE_K = 16;
+constexpr int64_t TILE_SIZE = TILE_M * TILE_K;
+// N 方向分段，16 行 fp32 累加器常驻 L1
+constexpr int64_t CHUNK_N = 256;
+
+int64_t LoadIndex(const void *data, CpuIndexType type, int64_t i)
+{
+    switch (type) {
+        case CPU_INDEX_INT64:
+            return static_cast<const int64_t *>(data)[i];
+        case CPU_INDEX_BLOCK_U16:
+            return static_cast<int64_t>(static_cast<const uint16_t *>(data)[i]) * TILE_K;
+        default:
+            return static_cast<const int32_t *>(data)[i];
+    }
+}
+
+/**
+ * ISA specific pieces: widen fp16 to fp32, and acc[16][CHUNK_N] += a[16][16] * b[kValid][jn]
+ * where b rows are ldb apart
+ */
+struct KernelOps {
+    const char *name;
+    void (*widen)(const uint16_t *src, float *dst, int64_t count);
+    void (*block)(const float *a, const uint16_t *b, int64_t ldb, int64_t kValid, int64_t jn, float *acc);
+};
+
+void WidenScalar(const uint16_t *src, float *dst, int64_t count)
+{
+    for (int64_t i = 0; i < count; ++i) {
+        dst[i] = HalfToFloat(src[i]);
+    }
+}
+
+void BlockScalar(const float *a, const uint16_t *b, int64_t ldb, int64_t kValid, int64_t jn, float *acc)
+{
+    float bRow[CHUNK_N];
+    for (int64_t kk = 0; kk < kValid; ++kk) {
+        WidenScalar(b + kk * ldb, bRow, jn);
+        for (int64_t r = 0; r < TILE_M; ++r) {
+            float av = a[r * TILE_K + kk];
+            if (av == 0.0f) {
+                continue;
+            }
+            float *dst = acc + r * CHUNK_N;
+            for (int64_t j = 0; j < jn; ++j) {
+                dst[j] += av * bRow[j];
+            }
+        }
+    }
+}
+
+// 向量宽度之外的 N 尾部
+void BlockTail(const float *a, const uint16_t *b, int64_t ldb, int64_t kValid, int64_t jBegin, int64_t jn,
+               float *acc)
+{
+    for (int64_t kk = 0; kk < kValid; ++kk) {
+        for (int64_t j = jBegin; j < jn; ++j) {
+            float bv = HalfToFloat(b[kk * ldb + j]);
+            for (int64_t r = 0; r < TILE_M; ++r) {
+                acc[r * CHUNK_N + j] += a[r * TILE_K + kk] * bv;
+            }
+        }
+    }
+}
+
+#ifdef CPU_SPMM_X86
+__attribute__((target("avx2,fma,f16c"))) void WidenAvx2(const uint16_t *src, float *dst, int64_t count)
+{
+    int64_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    WidenScalar(src + i, dst + i, count - i);
+}
+
+// 每 8 列一个向量，8 行累加器驻留寄存器，B 行转换一次供 8 行复用
+__attribute__((target("avx2,fma,f16c"))) void BlockAvx2(const float *a, const uint16_t *b, int64_t ldb,
+                                                         int64_t kValid, int64_t jn, float *acc)
+{
+    int64_t jVec = jn & ~static_cast<int64_t>(7);
+    for (int64_t j = 0; j < jVec; j += 8) {
+        for (int64_t r0 = 0; r0 < TILE_M; r0 += 8) {
+            float *dst = acc + r0 * CHUNK_N + j;
+            __m256 c0 = _mm256_loadu_ps(dst);
+            __m256 c1 = _mm256_loadu_ps(dst + CHUNK_N);
+            __m256 c2 = _mm256_loadu_ps(dst + 2 * CHUNK_N);
+            __m256 c3 = _mm256_loadu_ps(dst + 3 * CHUNK_N);
+            __m256 c4 = _mm256_loadu_ps(dst + 4 * CHUNK_N);
+            __m256 c5 = _mm256_loadu_ps(dst + 5 * CHUNK_N);
+            __m256 c6 = _mm256_loadu_ps(dst + 6 * CHUNK_N);
+            __m256 c7 = _mm256_loadu_ps(dst + 7 * CHUNK_N);
+            const float *aCol = a + r0 * TILE_K;
+            for (int64_t kk = 0; kk < kValid; ++kk) {
+                __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + kk * ldb + j));
+                __m256 bv = _mm256_cvtph_ps(h);
+                c0 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + kk), bv, c0);
+                c1 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + TILE_K + kk), bv, c1);
+                c2 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + 2 * TILE_K + kk), bv, c2);
+                c3 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + 3 * TILE_K + kk), bv, c3);
+                c4 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + 4 * TILE_K + kk), bv, c4);
+                c5 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + 5 * TILE_K + kk), bv, c5);
+                c6 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + 6 * TILE_K + kk), bv, c6);
+                c7 = _mm256_fmadd_ps(_mm256_broadcast_ss(aCol + 7 * TILE_K + kk), bv, c7);
+            }
+            _mm256_storeu_ps(dst, c0);
+            _mm256_storeu_ps(dst + CHUNK_N, c1);
+            _mm256_storeu_ps(dst + 2 * CHUNK_N, c2);
+            _mm256_storeu_ps(dst + 3 * CHUNK_N, c3);
+            _mm256_storeu_ps(dst + 4 * CHUNK_N, c4);
+            _mm256_storeu_ps(dst + 5 * CHUNK_N, c5);
+            _mm256_storeu_ps(dst + 6 * CHUNK_N, c6);
+            _mm256_storeu_ps(dst + 7 * CHUNK_N, c7);
+        }
+    }
+    BlockTail(a, b, ldb, kValid, jVec, jn, acc);
+}
+
+const KernelOps AVX2_OPS = {"avx2", WidenAvx2, BlockAvx2};
+#endif
+
+#ifdef CPU_SPMM_NEON
+void WidenNeon(const uint16_t *src, float *dst, int64_t count)
+{
+    int64_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+    WidenScalar(src + i, dst + i, count - i);
+}
+
+void BlockNeon(const float *a, const uint16_t *b, int64_t ldb, int64_t kValid, int64_t jn, float *acc)
+{
+    int64_t jVec = jn & ~static_cast<int64_t>(3);
+    for (int64_t j = 0; j < jVec; j += 4) {
+        for (int64_t r0 = 0; r0 < TILE_M; r0 += 8) {
+            float *dst = acc + r0 * CHUNK_N + j;
+            float32x4_t c[8];
+            for (int64_t r = 0; r < 8; ++r) {
+                c[r] = vld1q_f32(dst + r * CHUNK_N);
+            }
+            const float *aCol = a + r0 * TILE_K;
+            for (int64_t kk = 0; kk < kValid; ++kk) {
+                float32x4_t bv = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(b + kk * ldb + j)));
+                for (int64_t r = 0; r < 8; ++r) {
+                    c[r] = vfmaq_n_f32(c[r], bv, aCol[r * TILE_K + kk]);
+                }
+            }
+            for (int64_t r = 0; r < 8; ++r) {
+                vst1q_f32(dst + r * CHUNK_N, c[r]);
+            }
+        }
+    }
+    BlockTail(a, b, ldb, kValid, jVec, jn, acc);
+}
+
+const KernelOps NEON_OPS = {"neon", WidenNeon, BlockNeon};
+#endif
+
+const KernelOps SCALAR_OPS = {"scalar", WidenScalar, BlockScalar};
+
+const KernelOps &SelectKernel()
+{
+#ifdef CPU_SPMM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+        return AVX2_OPS;
+    }
+#endif
+#ifdef CPU_SPMM_NEON
+    return NEON_OPS;
+#endif
+    return SCALAR_OPS;
+}
+
+const KernelOps &Kernel()
+{
+    static const KernelOps &ops = SelectKernel();
+    return ops;
+}
+
+/**
+ * Windows [begin, end) still owned by one worker. The owner pops from the
+ * front, thieves take the back half.
+ */
+struct WorkRange {
+    std::mutex lock;
+    int64_t begin = 0;
+    int64_t end = 0;
+};
+
+class SpmmWorker {
+public:
+    SpmmWorker(const CpuSpmmArgs &args, float *c, std::vector<WorkRange> &ranges)
+        : args_(args), c_(c), ranges_(ranges), ops_(Kernel())
+    {
+    }
+
+    void Run(size_t self)
+    {
+        std::vector<float> acc(TILE_M * CHUNK_N);
+        float aBlock[TILE_SIZE];
+        int64_t w = 0;
+        while (PopFront(self, w) || (Steal(self) && PopFront(self, w))) {
+            ProcessWindow(w, acc.data(), aBlock);
+        }
+    }
+
+private:
+    bool PopFront(size_t self, int64_t &w)
+    {
+        WorkRange &range = ranges_[self];
+        std::lock_guard<std::mutex> guard(range.lock);
+        if (range.begin >= range.end) {
+            return false;
+        }
+        w = range.begin++;
+        return true;
+    }
+
+    // 从剩余最多的 worker 尾部偷一半；所有区间都空时结束
+    bool Steal(size_t self)
+    {
+        for (;;) {
+            size_t victim = ranges_.size();
+            int64_t most = 0;
+            for (size_t i = 0; i < ranges_.size(); ++i) {
+                if (i == self) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> guard(ranges_[i].lock);
+                if (ranges_[i].end - ranges_[i].begin > most) {
+                    most = ranges_[i].end - ranges_[i].begin;
+                    victim = i;
+                }
+            }
+            if (victim == ranges_.size()) {
+                return false;
+            }
+            int64_t begin = 0;
+            int64_t end = 0;
+            {
+                std::lock_guard<std::mutex> guard(ranges_[victim].lock);
+                int64_t remain = ranges_[victim].end - ranges_[victim].begin;
+                if (remain <= 0) {
+                    continue;
+                }
+                end = ranges_[victim].end;
+                begin = end - (remain + 1) / 2;
+                ranges_[victim].end = begin;
+            }
+            std::lock_guard<std::mutex> guard(ranges_[self].lock);
+            ranges_[self].begin = begin;
+            ranges_[self].end = end;
+            return true;
+        }
+    }
+
+    void ProcessWindow(int64_t w, float *acc, float *aBlock)
+    {
+        int64_t rowBegin = w * TILE_M;
+        int64_t rows = std::min(TILE_M, args_.m - rowBegin);
+        int64_t blkBegin = LoadIndex(args_.rowPtr, args_.rowPtrType, w);
+        int64_t blkEnd = LoadIndex(args_.rowPtr, args_.rowPtrType, w + 1);
+        if (rows <= 0 || blkBegin >= blkEnd) {
+            return;
+        }
+        for (int64_t j0 = 0; j0 < args_.n; j0 += CHUNK_N) {
+            int64_t jn = std::min(CHUNK_N, args_.n - j0);
+            for (int64_t r = 0; r < TILE_M; ++r) {
+                std::fill(acc + r * CHUNK_N, acc + r * CHUNK_N + jn, 0.0f);
+            }
+            for (int64_t blk = blkBegin; blk < blkEnd; ++blk) {
+                int64_t colStart = LoadIndex(args_.col, args_.colType, blk);
+                int64_t kValid = std::min(TILE_K, args_.k - colStart);
+                if (colStart < 0 || kValid <= 0) {
+                    continue;
+                }
+                ops_.widen(args_.val + blk * TILE_SIZE, aBlock, TILE_SIZE);
+                ops_.block(aBlock, args_.b + colStart * args_.n + j0, args_.n, kValid, jn, acc);
+            }
+            for (int64_t r = 0; r < rows; ++r) {
+                float *dst = c_ + (rowBegin + r) * args_.n + j0;
+                const float *src = acc + r * CHUNK_N;
+                for (int64_t j = 0; j < jn; ++j) {
+                    dst[j] += src[j];
+                }
+            }
+        }
+    }
+
+    const CpuSpmmArgs &args_;
+    float *c_;
+    std::vector<WorkRange> &ranges_;
+    const KernelOps &ops_;
+};
+
+// 第一个 row_ptr 不小于 target 的窗口
+int64_t LowerBoundWindow(const CpuSpmmArgs &args, int64_t target)
+{
+    int64_t lo = 0;
+    int64_t hi = args.windowNum;
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (LoadIndex(args.rowPtr, args.rowPtrType, mid) < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+} // namespace
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // 非规格化数规格化为 fp32
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+    } else if (exponent == 0x1fu) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    uint32_t absBits = bits & 0x7fffffffu;
+    if (absBits >= 0x7f800000u) {
+        // inf 保持 inf，NaN 保持为 quiet NaN
+        return sign | (absBits > 0x7f800000u ? 0x7e00u : 0x7c00u);
+    }
+    int32_t exponent = static_cast<int32_t>(absBits >> 23) - 127 + 15;
+    uint32_t mantissa = absBits & 0x7fffffu;
+    if (exponent >= 0x1f) {
+        return sign | 0x7c00u;
+    }
+    if (exponent <= 0) {
+        // 非规格化结果，小于最小非规格化数一半的值舍入为 0
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000u;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1u))) {
+            ++half;
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fffu;
+    // 进位可以一直传到指数，溢出时正好得到 inf
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return sign | static_cast<uint16_t>(half);
+}
+
+CpuSpmm::CpuSpmm(size_t threadNum) : threadNum_(threadNum)
+{
+    if (threadNum_ == 0) {
+        threadNum_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+const char *CpuSpmm::GetIsaName()
+{
+    return Kernel().name;
+}
+
+bool CpuSpmm::Run(const CpuSpmmArgs &args, float *c) const
+{
+    if (args.m < 0 || args.k < 0 || args.n < 0 || args.windowNum < 0) {
+        return false;
+    }
+    if (args.windowNum == 0 || args.m == 0 || args.n == 0) {
+        return true;
+    }
+    if (args.rowPtr == nullptr || args.col == nullptr || args.val == nullptr || args.b == nullptr ||
+        c == nullptr) {
+        return false;
+    }
+
+    // 按块数而非窗口数切分初始区间，负载不均时再靠窃取补齐
+    size_t workerNum = static_cast<size_t>(std::min<int64_t>(static_cast<int64_t>(threadNum_), args.windowNum));
+    std::vector<WorkRange> ranges(workerNum);
+    int64_t blockNum = LoadIndex(args.rowPtr, args.rowPtrType, args.windowNum);
+    int64_t begin = 0;
+    for (size_t i = 0; i < workerNum; ++i) {
+        int64_t end = args.windowNum;
+        if (i + 1 < workerNum) {
+            int64_t target = blockNum * static_cast<int64_t>(i + 1) / static_cast<int64_t>(workerNum);
+            end = std::max(begin, LowerBoundWindow(args, target));
+        }
+        ranges[i].begin = begin;
+        ranges[i].end = end;
+        begin = end;
+    }
+
+    SpmmWorker worker(args, c, ranges);
+    std::vector<std::thread> threads;
+    threads.reserve(workerNum - 1);
+    for (size_t i = 1; i < workerNum; ++i) {
+        threads.emplace_back(&SpmmWorker::Run, &worker, i);
+    }
+    worker.Run(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file dense_windows.cpp
+ */
+#include "dense_windows.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "bcsr_spmm_tune.h"
+#include "common.h"
+#include "spmm_session.h"
+
+DenseWindowPlan::DenseWindowPlan() : denseNum_(0), rowElems_(0) {}
+
+bool DenseWindowPlan::Build(const SpmmProblem &problem)
+{
+    Clear();
+    if (problem.windowNum > static_cast<int64_t>(std::numeric_limits<uint32_t>::max())) {
+        ERROR_LOG("Dense window map supports at most %u windows, got %ld", std::numeric_limits<uint32_t>::max(),
+            static_cast<long>(problem.windowNum));
+        return false;
+    }
+    if (problem.windowNum > 0 && (problem.rowPtr == nullptr || (problem.blockNum > 0 && problem.col == nullptr))) {
+        ERROR_LOG("Dense window classification needs the host row_ptr and col");
+        return false;
+    }
+    int64_t kBlocks = (problem.k + BCSR_TILE_K - 1) / BCSR_TILE_K;
+    rowElems_ = BcsrSpmmDenseRowElems(problem.k);
+    map_.assign(static_cast<size_t>(problem.windowNum), 0);
+    // 每个块列最后出现在哪个窗口，用来发现窗口内重复的列
+    std::vector<int64_t> seen(static_cast<size_t>(kBlocks), -1);
+    for (int64_t w = 0; w < problem.windowNum; ++w) {
+        int64_t first = problem.RowPtrAt(w);
+        int64_t last = problem.RowPtrAt(w + 1);
+        int64_t blocks = last - first;
+        if (blocks < DENSE_WINDOW_MIN_BLOCKS || blocks * 100 < DENSE_WINDOW_FILL_PCT * kBlocks) {
+            continue;
+        }
+        // 稠密行按 16 列对齐存放，起始列不对齐或重复的块留在 BCSR 路径
+        bool aligned = true;
+        for (int64_t blk = first; blk < last && aligned; ++blk) {
+            int64_t col = problem.ColAt(blk);
+            int64_t unit = col / BCSR_TILE_K;
+            aligned = col >= 0 && col % BCSR_TILE_K == 0 && unit < kBlocks && seen[unit] != w;
+            if (aligned) {
+                seen[unit] = w;
+            }
+        }
+        if (!aligned) {
+            continue;
+        }
+        uint64_t base = static_cast<uint64_t>(denseNum_) * rowElems_;
+        for (int64_t blk = first; blk < last; ++blk) {
+            blocks_.push_back(blk);
+            offsets_.push_back(base + static_cast<uint64_t>(problem.ColAt(blk) / BCSR_TILE_K) * BCSR_TILE_M * BCSR_TILE_K);
+        }
+        map_[w] = static_cast<uint32_t>(++denseNum_);
+    }
+    return true;
+}
+
+void DenseWindowPlan::Clear()
+{
+    denseNum_ = 0;
+    rowElems_ = 0;
+    map_.clear();
+    blocks_.clear();
+    offsets_.clear();
+}
+
+int64_t DenseWindowPlan::GetDenseNum() const
+{
+    return denseNum_;
+}
+
+const std::vector<uint32_t> &DenseWindowPlan::GetMap() const
+{
+    return map_;
+}
+
+void DenseWindowPlan::Fill(const void *val, std::vector<uint16_t> &store) const
+{
+    // 稠密行的第 c 个 16 x 16 分块就是 BCSR 中起始列为 16c 的块，布局不变，整块拷贝
+    const size_t blockElems = BCSR_TILE_M * BCSR_TILE_K;
+    store.assign(static_cast<size_t>(denseNum_) * rowElems_, 0);
+    const uint16_t *src = static_cast<const uint16_t *>(val);
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        std::memcpy(store.data() + offsets_[i], src + static_cast<size_t>(blocks_[i]) * blockElems,
+                    blockElems * sizeof(uint16_t));
+    }
+}
@@ -0,0 +1,169 @@
+/**
+ * @file gen_main.cpp
+ *
+ * gen_spmm_case --family=<uniform|rmat|banded|blockdiag|hotrow|clustered> --m=M [--k=K] [--n=N]
+ *               [--nnz-per-row=D] [--seed=S] [--out=DIR] [--name=NAME] [--threads=T]
+ *               [--golden=cpu|none] [--mtx] [family options]
+ * Writes <out>/<name>/ in the layout of parse_matrix.py plus x2_gm.bin,
+ * golden.bin and mnk.txt; --mtx also writes <out>/<name>.mtx for --batch.
+ */
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "bcsr_matrix.h"
+#include "common.h"
+#include "cpu_spmm.h"
+#include "options.h"
+#include "sparse_gen.h"
+
+namespace {
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool MakeDirs(const std::string &path)
+{
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string prefix = path.substr(0, pos);
+        struct stat st;
+        if (stat(prefix.c_str(), &st) != 0 && mkdir(prefix.c_str(), 0755) != 0) {
+            ERROR_LOG("Make directory %s fail", prefix.c_str());
+            return false;
+        }
+        if (pos == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+bool ParseRmat(const std::string &text, GenConfig &config)
+{
+    char comma1 = 0;
+    char comma2 = 0;
+    std::istringstream in(text);
+    if (!(in >> config.rmatA >> comma1 >> config.rmatB >> comma2 >> config.rmatC) || comma1 != ',' ||
+        comma2 != ',' || config.rmatA + config.rmatB + config.rmatC > 1.0) {
+        ERROR_LOG("Invalid --rmat=%s, expected a,b,c with a + b + c <= 1", text.c_str());
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!options.Parse(argc, argv, 1) || !options.Has("m")) {
+        std::cerr << "Usage: " << argv[0] << " --family=<uniform|rmat|banded|blockdiag|hotrow|clustered> --m=M"
+                  << " [--k=K] [--n=N] [--nnz-per-row=D] [--seed=S] [--out=DIR] [--name=NAME] [--threads=T]"
+                  << " [--golden=cpu|none] [--mtx] [--rmat=a,b,c] [--band=W] [--block=B] [--hot-rows=F]"
+                  << " [--hot-share=F] [--cluster-rows=R] [--cluster-width=W] [--locality=P]" << std::endl;
+        return FAILED;
+    }
+
+    GenConfig config;
+    if (!ParseFamily(options.GetString("family", "uniform"), config.family)) {
+        return FAILED;
+    }
+    config.m = options.GetInt("m", 0);
+    config.k = options.GetInt("k", config.m);
+    config.nnzPerRow = options.GetDouble("nnz-per-row", config.nnzPerRow);
+    config.seed = static_cast<uint64_t>(options.GetInt("seed", static_cast<int64_t>(config.seed)));
+    config.threadNum = static_cast<size_t>(std::max<int64_t>(options.GetInt("threads", 0), 0));
+    if (options.Has("rmat") && !ParseRmat(options.GetString("rmat", ""), config)) {
+        return FAILED;
+    }
+    config.band = options.GetInt("band", config.band);
+    config.blockSize = options.GetInt("block", config.blockSize);
+    config.hotRows = options.GetDouble("hot-rows", config.hotRows);
+    config.hotShare = options.GetDouble("hot-share", config.hotShare);
+    config.clusterRows = options.GetInt("cluster-rows", config.clusterRows);
+    config.clusterWidth = options.GetInt("cluster-width", config.clusterWidth);
+    config.locality = options.GetDouble("locality", config.locality);
+    int64_t n = options.GetInt("n", std::min<int64_t>(config.k, 128));
+    if (n <= 0) {
+        ERROR_LOG("Invalid N = %ld", static_cast<long>(n));
+        return FAILED;
+    }
+
+    std::string name = options.GetString("name", std::string(GetFamilyName(config.family)) + "_" +
+        std::to_string(config.m));
+    std::string outRoot = options.GetString("out", "../inputs/synthetic");
+    std::string sampleDir = outRoot + "/" + name;
+    if (!MakeDirs(sampleDir)) {
+        return FAILED;
+    }
+
+    // 1. A：逐行窗口直接生成 BCSR
+    auto start = std::chrono::steady_clock::now();
+    BcsrMatrix matrix;
+    int64_t nnz = 0;
+    if (!GenerateBcsr(config, matrix, nnz)) {
+        return FAILED;
+    }
+    double genMs = ElapsedMs(start);
+    int32_t maxWindowBlocks = 0;
+    for (int64_t w = 0; w < matrix.WindowNum(); ++w) {
+        maxWindowBlocks = std::max(maxWindowBlocks, matrix.rowPtr[w + 1] - matrix.rowPtr[w]);
+    }
+    INFO_LOG("%s: M = %ld, K = %ld, N = %ld, nnz = %ld, %ld blocks in %ld windows (max %d per window), "
+        "block fill %.4f, generated in %.3f ms", name.c_str(), static_cast<long>(config.m),
+        static_cast<long>(config.k), static_cast<long>(n), static_cast<long>(nnz),
+        static_cast<long>(matrix.BlockNum()), static_cast<long>(matrix.WindowNum()), maxWindowBlocks,
+        matrix.BlockNum() == 0 ? 0.0 : static_cast<double>(nnz) / (matrix.BlockNum() * 256.0), genMs);
+    if (!SaveBcsr(sampleDir, matrix)) {
+        return FAILED;
+    }
+
+    // 2. B 与 golden：golden 由 CPU 引擎直接从 BCSR 计算
+    std::vector<uint16_t> b;
+    GenerateDense(config.k, n, config.seed ^ 0x5eedULL, b);
+    if (!WriteFile(sampleDir + "/x2_gm.bin", b.data(), b.size() * sizeof(uint16_t))) {
+        return FAILED;
+    }
+    std::string goldenPath = sampleDir + "/golden.bin";
+    if (options.GetString("golden", "cpu") == "cpu") {
+        start = std::chrono::steady_clock::now();
+        CpuSpmmArgs args;
+        args.m = matrix.m;
+        args.k = matrix.k;
+        args.n = n;
+        args.windowNum = matrix.WindowNum();
+        args.rowPtr = matrix.rowPtr.data();
+        args.col = matrix.col.data();
+        args.val = matrix.values.data();
+        args.b = b.data();
+        std::vector<float> golden(static_cast<size_t>(matrix.m * n), 0.0f);
+        CpuSpmm cpu(config.threadNum);
+        if (!cpu.Run(args, golden.data()) ||
+            !WriteFile(goldenPath, golden.data(), golden.size() * sizeof(float))) {
+            ERROR_LOG("Generate golden for %s failed", name.c_str());
+            return FAILED;
+        }
+        INFO_LOG("golden: %s, %zu threads (%s), %.3f ms", goldenPath.c_str(), cpu.GetThreadNum(),
+            CpuSpmm::GetIsaName(), ElapsedMs(start));
+    } else {
+        (void)std::remove(goldenPath.c_str());
+    }
+
+    std::ofstream mnk(sampleDir + "/mnk.txt", std::ios::trunc);
+    mnk << "M=" << config.m << "\nK=" << config.k << "\nN=" << n << "\n";
+    if (!mnk.good()) {
+        return FAILED;
+    }
+    if (options.Has("mtx")) {
+        std::ostringstream comment;
+        comment << "generated by gen_spmm_case --family=" << GetFamilyName(config.family) << " --seed="
+                << config.seed << " --nnz-per-row=" << config.nnzPerRow;
+        if (!WriteMtx(outRoot + "/" + name + ".mtx", matrix, comment.str())) {
+            return FAILED;
+        }
+    }
+    return SUCCESS;
+}
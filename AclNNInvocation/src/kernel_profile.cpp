@@ -0,0 +1,176 @@
+/**
+ * @file kernel_profile.cpp
+ */
+#include "kernel_profile.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "common.h"
+
+namespace {
+const char *const PHASE_NAMES[KERNEL_PHASE_NUM] = {"CopyInA", "CopyInB", "Split", "Compute", "CopyOut"};
+
+// max / mean，空或全 0 时为 0
+template <typename T, typename Get>
+double Imbalance(const std::vector<T> &items, Get get)
+{
+    double total = 0.0;
+    double peak = 0.0;
+    for (const auto &item : items) {
+        double value = static_cast<double>(get(item));
+        total += value;
+        peak = std::max(peak, value);
+    }
+    return total > 0.0 ? peak * items.size() / total : 0.0;
+}
+} // namespace
+
+bool ParseKernelProfile(const uint64_t *raw, std::vector<KernelCoreProfile> &cores)
+{
+    cores.clear();
+    uint64_t blockDim = 0;
+    for (uint32_t i = 0; i < BCSR_SPMM_PROFILE_MAX_CORES; ++i) {
+        const uint64_t *slot = raw + static_cast<size_t>(i) * BCSR_SPMM_CNT_NUM;
+        if (slot[BCSR_SPMM_CNT_MAGIC] != BCSR_SPMM_PROFILE_MAGIC) {
+            continue;
+        }
+        blockDim = slot[BCSR_SPMM_CNT_BLOCK_DIM];
+        double mhz = slot[BCSR_SPMM_CNT_CYCLE_MHZ] == 0 ? 1.0 : static_cast<double>(slot[BCSR_SPMM_CNT_CYCLE_MHZ]);
+        KernelCoreProfile core;
+        core.core = i;
+        core.windows = slot[BCSR_SPMM_CNT_WINDOWS];
+        core.blocks = slot[BCSR_SPMM_CNT_BLOCKS];
+        core.mmads = slot[BCSR_SPMM_CNT_MMADS];
+        core.bBytes = slot[BCSR_SPMM_CNT_B_BYTES];
+        core.bHits = slot[BCSR_SPMM_CNT_B_HITS];
+        core.denseWindows = slot[BCSR_SPMM_CNT_DENSE_WINDOWS];
+        core.vector = slot[BCSR_SPMM_CNT_VECTOR] != 0;
+        core.us = slot[BCSR_SPMM_CNT_CYCLES] / mhz;
+        for (int p = 0; p < KERNEL_PHASE_NUM; ++p) {
+            core.phaseUs[p] = slot[BCSR_SPMM_CNT_COPY_IN_A + p] / mhz;
+        }
+        cores.push_back(core);
+    }
+    if (cores.empty()) {
+        ERROR_LOG("Kernel profile region holds no counters");
+        return false;
+    }
+    if (cores.size() != blockDim) {
+        WARN_LOG("Kernel profile: %zu of %lu cores wrote counters", cores.size(), static_cast<unsigned long>(blockDim));
+    }
+    return true;
+}
+
+void PrintKernelProfile(const std::string &name, const std::vector<KernelCoreProfile> &cores)
+{
+    if (cores.empty()) {
+        return;
+    }
+    INFO_LOG("Kernel profile %s: %zu cores", name.c_str(), cores.size());
+    INFO_LOG("  core  windows     blocks      mmads     B MB         us");
+    const KernelCoreProfile *slowest = &cores[0];
+    double phaseTotal[KERNEL_PHASE_NUM] = {};
+    double busyTotal = 0.0;
+    uint64_t mmadTotal = 0;
+    uint64_t hitTotal = 0;
+    uint64_t denseTotal = 0;
+    uint64_t windowTotal = 0;
+    // MIX 模式下 cube 与向量核分开统计：两边最慢的 core 接近时整个芯片才都在忙
+    size_t sideCores[2] = {};
+    uint64_t sideWindows[2] = {};
+    double sideSlowest[2] = {};
+    for (const auto &core : cores) {
+        INFO_LOG("  %4ld %8lu %10lu %10lu %8.3f %10.3f", static_cast<long>(core.core),
+            static_cast<unsigned long>(core.windows), static_cast<unsigned long>(core.blocks),
+            static_cast<unsigned long>(core.mmads), core.bBytes / 1e6, core.us);
+        if (core.us > slowest->us) {
+            slowest = &core;
+        }
+        for (int p = 0; p < KERNEL_PHASE_NUM; ++p) {
+            phaseTotal[p] += core.phaseUs[p];
+        }
+        busyTotal += core.us;
+        mmadTotal += core.mmads;
+        hitTotal += core.bHits;
+        denseTotal += core.denseWindows;
+        windowTotal += core.windows;
+        int side = core.vector ? 1 : 0;
+        ++sideCores[side];
+        sideWindows[side] += core.windows;
+        sideSlowest[side] = std::max(sideSlowest[side], core.us);
+    }
+
+    // 窗口数均分时块数仍可能失衡，最慢的 core 决定 kernel 耗时
+    INFO_LOG("  imbalance (max / mean): windows %.3f, blocks %.3f, B bytes %.3f, time %.3f",
+        Imbalance(cores, [](const KernelCoreProfile &c) { return c.windows; }),
+        Imbalance(cores, [](const KernelCoreProfile &c) { return c.blocks; }),
+        Imbalance(cores, [](const KernelCoreProfile &c) { return c.bBytes; }),
+        Imbalance(cores, [](const KernelCoreProfile &c) { return c.us; }));
+    INFO_LOG("  slowest core %ld: %.3f us, %lu blocks; mean %.3f us", static_cast<long>(slowest->core), slowest->us,
+        static_cast<unsigned long>(slowest->blocks), busyTotal / cores.size());
+    // 每次 Mmad 取一个 B 面板，命中率 = 命中次数 / Mmad 次数
+    if (hitTotal != 0) {
+        INFO_LOG("  B panel cache: %lu of %lu panels hit, %.1f%%", static_cast<unsigned long>(hitTotal),
+            static_cast<unsigned long>(mmadTotal), hitTotal * 100.0 / mmadTotal);
+    }
+    if (denseTotal != 0) {
+        INFO_LOG("  dense windows: %lu of %lu windows, %.1f%%", static_cast<unsigned long>(denseTotal),
+            static_cast<unsigned long>(windowTotal), denseTotal * 100.0 / windowTotal);
+    }
+    if (sideCores[1] != 0) {
+        INFO_LOG("  mixed split: cube %lu windows on %zu cores, slowest %.3f us; vector %lu windows on %zu cores, "
+            "slowest %.3f us", static_cast<unsigned long>(sideWindows[0]), sideCores[0], sideSlowest[0],
+            static_cast<unsigned long>(sideWindows[1]), sideCores[1], sideSlowest[1]);
+    }
+
+    double phaseSum = 0.0;
+    for (int p = 0; p < KERNEL_PHASE_NUM; ++p) {
+        phaseSum += phaseTotal[p];
+    }
+    if (phaseSum <= 0.0) {
+        INFO_LOG("  phases: not timed by this backend");
+        return;
+    }
+    for (int p = 0; p < KERNEL_PHASE_NUM; ++p) {
+        INFO_LOG("  phase %-8s %10.3f us total, %5.1f%%, slowest core %.3f us", PHASE_NAMES[p], phaseTotal[p],
+            phaseTotal[p] * 100.0 / phaseSum, slowest->phaseUs[p]);
+    }
+}
+
+bool WriteKernelProfile(const std::string &path, const std::string &name,
+                        const std::vector<KernelCoreProfile> &cores)
+{
+    struct stat st;
+    bool exists = stat(path.c_str(), &st) == 0 && st.st_size > 0;
+    std::ofstream out(path, std::ios::app);
+    if (!out.is_open()) {
+        ERROR_LOG("Failed to open kernel profile file: %s", path.c_str());
+        return false;
+    }
+    if (!exists) {
+        out << "sample,core,windows,blocks,mmads,b_bytes,b_hits,dense_windows,vector,us";
+        for (int p = 0; p < KERNEL_PHASE_NUM; ++p) {
+            out << ',' << PHASE_NAMES[p] << "_us";
+        }
+        out << '\n';
+    }
+    out << std::setprecision(6);
+    for (const auto &core : cores) {
+        out << name << ',' << core.core << ',' << core.windows << ',' << core.blocks << ',' << core.mmads << ','
+            << core.bBytes << ',' << core.bHits << ',' << core.denseWindows << ',' << (core.vector ? 1 : 0) << ','
+            << core.us;
+        for (int p = 0; p < KERNEL_PHASE_NUM; ++p) {
+            out << ',' << core.phaseUs[p];
+        }
+        out << '\n';
+    }
+    if (!out.good()) {
+        ERROR_LOG("Write kernel profile file %s failed", path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -11,77 +11,106 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "acl/acl.h"
+#include "autotuner.h"
+#include "batch_runner.h"
+#include "benchmark.h"
 #include "common.h"
-#include "op_runner.h"
-#include "timer.h"
+#include "cpu_spmm.h"
+#include "kernel_profile.h"
+#include "mem_pool.h"
+#include "options.h"
+#include "pipeline_runner.h"
+#include "profiler.h"
+#include "spmm_session.h"
+#include "streaming_runner.h"
 
 bool g_isDevice = false;
 int deviceId = 0;
 
-const int64_t TILE_M = 16;
-const int64_t TILE_K = 16;
-
-OperatorDesc CreateOpDesc(int64_t m, int64_t k, int64_t n, int64_t windowNum, int64_t blockNum)
+// col 索引编码：int32 / int64 起始列，或 uint16 块列号（起始列 / BCSR_TILE_K），按文件大小区分
+aclDataType GetColDataType(const std::string &colPath, int64_t blockNum)
 {
-    // define operator
-    std::vector<int64_t> shapeRowPtr{windowNum + 1};
-    std::vector<int64_t> shapeCol{blockNum};
-    std::vector<int64_t> shapeValues{blockNum * TILE_M * TILE_K};
-    std::vector<int64_t> shapeAShape{2};
-    std::vector<int64_t> shapeB{k, n};
-    std::vector<int64_t> shapeC{m, n};
-
-    aclDataType dataTypeIndices = ACL_INT32;
-    aclDataType dataTypeValues = ACL_FLOAT16;
-    aclDataType dataTypeAShape = ACL_INT64;
-    aclDataType dataTypeB = ACL_FLOAT16;
-    aclDataType dataTypeC = ACL_FLOAT;
-
-    aclFormat format = ACL_FORMAT_ND;
-
-    OperatorDesc opDesc;
-    opDesc.SetInputArrayNum(1);
-    opDesc.AddInputTensorDesc(dataTypeAShape, shapeAShape.size(), shapeAShape.data(), format);
-    opDesc.AddInputTensorDesc(dataTypeIndices, shapeRowPtr.size(), shapeRowPtr.data(), format);
-    opDesc.AddInputTensorDesc(dataTypeIndices, shapeCol.size(), shapeCol.data(), format);
-    opDesc.AddInputTensorDesc(dataTypeValues, shapeValues.size(), shapeValues.data(), format);
-    opDesc.AddInputTensorDesc(dataTypeB, shapeB.size(), shapeB.data(), format);
-    opDesc.AddOutputTensorDesc(dataTypeC, shapeC.size(), shapeC.data(), format);
-
-    return opDesc;
+    size_t fileSize = 0;
+    if (blockNum > 0 && GetFileSize(colPath, fileSize)) {
+        if (fileSize == static_cast<size_t>(blockNum) * sizeof(uint16_t)) {
+            return ACL_UINT16;
+        }
+        if (fileSize == static_cast<size_t>(blockNum) * sizeof(int64_t)) {
+            return ACL_INT64;
+        }
+    }
+    return ACL_INT32;
 }
 
-bool SetInputData(OpRunner &runner, int64_t m, int64_t k, const std::string& rowPtrPath, const std::string& colPath, const std::string& valuesPath, const std::string& bPath)
+// row_ptr 为 int32，块数超出 int32 的矩阵为 int64，同样按文件大小区分
+aclDataType GetRowPtrDataType(const std::string &rowPtrPath, int64_t windowNum)
 {
-    // set a_shape
-    auto aShapePtr = runner.GetInputBuffer<int64_t>(0); // int64_t *
-    aShapePtr[0] = m;
-    aShapePtr[1] = k;
+    size_t fileSize = 0;
+    if (GetFileSize(rowPtrPath, fileSize) && fileSize == static_cast<size_t>(windowNum + 1) * sizeof(int64_t)) {
+        return ACL_INT64;
+    }
+    return ACL_INT32;
+}
 
+bool ReadInput(const std::string &path, size_t size, std::vector<char> &buffer)
+{
+    buffer.resize(size);
+    if (size == 0) {
+        return true;
+    }
     size_t fileSize = 0;
-    ReadFile(rowPtrPath.c_str(), fileSize, runner.GetInputBuffer<void>(1), runner.GetInputSize(1));
-    ReadFile(colPath.c_str(), fileSize, runner.GetInputBuffer<void>(2), runner.GetInputSize(2));
-    ReadFile(valuesPath.c_str(), fileSize, runner.GetInputBuffer<void>(3), runner.GetInputSize(3));
-    ReadFile(bPath.c_str(), fileSize, runner.GetInputBuffer<void>(4), runner.GetInputSize(4));
+    return ReadFile(path, fileSize, buffer.data(), size);
+}
+
+// host 侧输入缓存，problem 中的指针指向这里
+struct HostInputs {
+    std::vector<char> rowPtr;
+    std::vector<char> col;
+    std::vector<char> values;
+    std::vector<char> b;
+};
+
+bool SetInputData(SpmmProblem &problem, HostInputs &inputs, const std::string& rowPtrPath, const std::string& colPath, const std::string& valuesPath, const std::string& bPath)
+{
+    if (!ReadInput(rowPtrPath, problem.RowPtrSize(), inputs.rowPtr) ||
+        !ReadInput(colPath, problem.ColSize(), inputs.col) ||
+        !ReadInput(valuesPath, problem.ValSize(), inputs.values) ||
+        !ReadInput(bPath, problem.BSize(), inputs.b)) {
+        return false;
+    }
+    problem.rowPtr = inputs.rowPtr.data();
+    problem.col = inputs.col.data();
+    problem.val = inputs.values.data();
+    problem.b = inputs.b.data();
     // INFO_LOG("Set input success");
     return true;
 }
 
-bool ProcessOutputData(OpRunner &runner, const std::string& outputCPath)
+bool ProcessOutputData(SpmmSession &session, const std::string& outputCPath)
 {
-    WriteFile(outputCPath.c_str(), runner.GetOutputBuffer<void>(0), runner.GetOutputSize(0));
+    std::vector<char> output(session.GetOutputSize());
+    if (!session.Download(output.data())) {
+        return false;
+    }
+    WriteFile(outputCPath.c_str(), output.data(), output.size());
     // INFO_LOG("Write output success");
     return true;
 }
 
 void DestroyResource()
 {
+    // 池中缓存的内存须在 aclFinalize 之前归还
+    MemPool::Device().Trim();
+    MemPool::Host().Trim();
+
     bool flag = false;
     if (aclrtResetDevice(deviceId) != ACL_SUCCESS) {
         ERROR_LOG("Reset device %d failed", deviceId);
@@ -99,7 +128,7 @@ void DestroyResource()
     }
 }
 
-bool InitResource()
+bool MakeOutputDir()
 {
     std::string output = "../output";
     if (access(output.c_str(), 0) == -1) {
@@ -111,6 +140,14 @@ bool InitResource()
             return false;
         }
     }
+    return true;
+}
+
+bool InitResource()
+{
+    if (!MakeOutputDir()) {
+        return false;
+    }
 
     if (aclInit(nullptr) != ACL_SUCCESS) {
         ERROR_LOG("acl init failed");
@@ -138,36 +175,266 @@ bool InitResource()
     return true;
 }
 
-bool RunOp(int64_t m, int64_t k, int64_t n, int64_t windowNum, int64_t blockNum, const std::string& rowPtr, const std::string& col, const std::string& values, const std::string& b, const std::string& c)
+// 吞吐模式：同一问题重复提交到多 stream 流水线，H2D / kernel / D2H 相互重叠
+bool RunThroughput(const SpmmProblem &problem, const std::string& c, const Options &options)
+{
+    int64_t requestNum = options.GetInt("throughput", 1);
+    int64_t streamNum = options.GetInt("streams", 3);
+    if (requestNum <= 0 || streamNum <= 0) {
+        ERROR_LOG("Invalid --throughput=%ld or --streams=%ld", static_cast<long>(requestNum),
+            static_cast<long>(streamNum));
+        return false;
+    }
+
+    PipelineRunner runner(static_cast<size_t>(streamNum));
+    if (!runner.Init()) {
+        ERROR_LOG("Init pipeline runner failed");
+        return false;
+    }
+    // 每个 stream 一份输出，slot 复用前一定已完成
+    std::vector<std::vector<char>> outputs(static_cast<size_t>(streamNum), std::vector<char>(problem.CSize()));
+
+    ProfileScope scope("pipeline.Total");
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int64_t i = 0; i < requestNum; ++i) {
+        if (!runner.Submit(problem, outputs[i % streamNum].data())) {
+            ERROR_LOG("Submit request %ld failed", static_cast<long>(i));
+            return false;
+        }
+    }
+    if (!runner.Flush()) {
+        ERROR_LOG("Flush pipeline failed");
+        return false;
+    }
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    INFO_LOG("Pipeline throughput: %ld requests on %ld streams in %.3f ms, %.2f requests/s",
+        static_cast<long>(requestNum), static_cast<long>(streamNum), duration.count(),
+        duration.count() > 0 ? requestNum * 1000.0 / duration.count() : 0.0);
+
+    WriteFile(c.c_str(), outputs[(requestNum - 1) % streamNum].data(), problem.CSize());
+    return true;
+}
+
+// CPU 回退路径：不占用 NPU，结果同样可作为真值
+bool RunCpu(const SpmmProblem &problem, const std::string& c, const Options &options)
 {
-    // create op desc
-    OperatorDesc opDesc = CreateOpDesc(m, k, n, windowNum, blockNum);
+    int64_t threadNum = options.GetInt("threads", 0);
+    if (threadNum < 0) {
+        ERROR_LOG("Invalid --threads=%ld", static_cast<long>(threadNum));
+        return false;
+    }
+    CpuSpmm engine(static_cast<size_t>(threadNum));
+    std::vector<float> output(static_cast<size_t>(problem.m * problem.n), 0.0f);
+    int64_t repeat = options.GetInt("repeat", 1);
+    for (int64_t i = 0; i < repeat; ++i) {
+        std::fill(output.begin(), output.end(), 0.0f);
+        ProfileScope scope("cpu.Run");
+        if (!engine.Run(problem.ToCpuArgs(), output.data())) {
+            ERROR_LOG("Run cpu spmm failed");
+            return false;
+        }
+    }
+    INFO_LOG("Cpu spmm: %zu threads, %s kernel", engine.GetThreadNum(), CpuSpmm::GetIsaName());
+    WriteFile(c.c_str(), output.data(), problem.CSize());
+    return true;
+}
+
+// 分块流式模式：输入与 C 都映射为文件，device 上只常驻 B 和两个分块槽位，峰值显存受 --stream-budget 限制
+bool RunStreaming(SpmmProblem &problem, const std::string& rowPtr, const std::string& col, const std::string& values, const std::string& b, const std::string& c, const Options &options)
+{
+    double budgetMb = options.GetDouble("stream-budget", 0.0);
+    if (!(budgetMb > 0.0)) {
+        ERROR_LOG("Invalid --stream-budget=%s, expect device megabytes", options.GetString("stream-budget", "").c_str());
+        return false;
+    }
+    MappedFile files[SPMM_BUF_C];
+    const std::string *paths[SPMM_BUF_C] = {&rowPtr, &col, &values, &b};
+    for (size_t i = 0; i < SPMM_BUF_C; ++i) {
+        if (!files[i].OpenRead(*paths[i], SpmmBufferSize(problem, i))) {
+            return false;
+        }
+    }
+    problem.rowPtr = files[SPMM_BUF_ROW_PTR].GetData();
+    problem.col = files[SPMM_BUF_COL].GetData();
+    problem.val = files[SPMM_BUF_VAL].GetData();
+    problem.b = files[SPMM_BUF_B].GetData();
+    MappedFile output;
+    if (!output.Create(c, problem.CSize())) {
+        return false;
+    }
+
+    StreamingRunner runner(static_cast<size_t>(budgetMb * 1024.0 * 1024.0));
+    if (!runner.Init() || !runner.Plan(problem)) {
+        ERROR_LOG("Plan streaming run failed");
+        return false;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!runner.Run(problem, output.GetData())) {
+        ERROR_LOG("Streaming run failed");
+        return false;
+    }
+    std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    INFO_LOG("Streaming run: %zu chunks in %.3f ms, peak device memory %zu of %zu bytes, C %zu bytes",
+        runner.GetChunks().size(), duration.count(), runner.GetPeakBytes(),
+        static_cast<size_t>(budgetMb * 1024.0 * 1024.0), problem.CSize());
+    return true;
+}
+
+// 基准模式：预热后按 device event 统计 kernel 耗时，结果写成 JSON 或追加一行 CSV
+bool RunBench(SpmmSession &session, const SpmmProblem &problem, const std::string& category, const std::string& sampleName, const Options &options)
+{
+    BenchConfig config;
+    config.warmup = options.GetInt("warmup", config.warmup);
+    config.iters = options.GetInt("iters", config.iters);
+
+    BenchResult result;
+    result.category = category;
+    result.sample = sampleName;
+    result.problem = problem;
+    result.problem.rowPtr = result.problem.col = result.problem.val = result.problem.b = nullptr;
+    result.nnz = options.Has("nnz") ? options.GetInt("nnz", 0) : CountNonzeros(problem);
+    if (!RunBenchmark(session, config, result)) {
+        ERROR_LOG("Run benchmark failed");
+        return false;
+    }
+    std::string path = options.GetString("bench-out", "../output/" + category + "_" + sampleName + "_bench.json");
+    if (!WriteBenchResult(path, result)) {
+        return false;
+    }
+    return true;
+}
 
-    // create Runner
-    OpRunner opRunner(&opDesc);
-    if (!opRunner.Init()) {
-        ERROR_LOG("Init OpRunner failed");
+// 调优模式：扫描 tiling 参数，最快且结果正确的一组按稀疏签名写入调优库
+bool RunTune(SpmmSession &session, const SpmmProblem &problem, const std::string& sampleName, const Options &options)
+{
+    TuneSpace space;
+    if (!space.Parse(options)) {
+        return false;
+    }
+    BenchConfig bench;
+    bench.warmup = options.GetInt("warmup", 3);
+    bench.iters = options.GetInt("iters", 10);
+
+    std::vector<float> golden(static_cast<size_t>(problem.m * problem.n), 0.0f);
+    CpuSpmm cpu(static_cast<size_t>(std::max<int64_t>(options.GetInt("threads", 0), 0)));
+    if (!cpu.Run(problem.ToCpuArgs(), golden.data())) {
+        ERROR_LOG("Run cpu golden for tuning failed");
+        return false;
+    }
+    Autotuner tuner(session, space, bench);
+    TuneResult result;
+    if (!tuner.Tune(problem, golden.data(), result)) {
+        return false;
+    }
+    PrintTuneResult(sampleName, result);
+    if (!SaveTuneResult(GetTuneDbPath(options), sampleName, result)) {
         return false;
     }
+    // 恢复未指定调优参数的问题，后续运行走调优库查找
+    return session.Load(problem);
+}
+
+bool RunOp(int64_t m, int64_t k, int64_t n, int64_t windowNum, int64_t blockNum, const std::string& rowPtr, const std::string& col, const std::string& values, const std::string& b, const std::string& c, const std::string& category, const std::string& sampleName, const Options &options)
+{
+    SpmmProblem problem;
+    problem.m = m;
+    problem.k = k;
+    problem.n = n;
+    problem.windowNum = windowNum;
+    problem.blockNum = blockNum;
+    problem.rowPtrType = GetRowPtrDataType(rowPtr, windowNum);
+    problem.colType = GetColDataType(col, blockNum);
+    problem.flags = options.Has("kernel-profile") ? BCSR_SPMM_FLAG_PROFILE : 0;
+    if (options.Has("direct-output")) {
+        problem.flags |= BCSR_SPMM_FLAG_DIRECT_OUTPUT;
+    }
+    if (options.Has("b-cache")) {
+        problem.flags |= BCSR_SPMM_FLAG_B_CACHE;
+    }
+    if (options.Has("schedule")) {
+        problem.flags |= BCSR_SPMM_FLAG_SCHEDULE;
+    }
+    if (options.Has("dense-windows")) {
+        problem.flags |= BCSR_SPMM_FLAG_DENSE;
+    }
+    if (options.Has("mix")) {
+        problem.flags |= BCSR_SPMM_FLAG_MIX;
+    }
+
+    if (options.Has("stream-budget")) {
+        if (!RunStreaming(problem, rowPtr, col, values, b, c, options)) {
+            return false;
+        }
+        INFO_LOG("Run op success");
+        return true;
+    }
 
     // Load inputs
-    if (!SetInputData(opRunner, m, k, rowPtr, col, values, b)) {
+    HostInputs inputs;
+    if (!SetInputData(problem, inputs, rowPtr, col, values, b)) {
         ERROR_LOG("Set input data failed");
         return false;
     }
 
-    // Run op
-    Timer::Start("opRunner.RunOp");
-    bool result = opRunner.RunOp();
-    Timer::Stop("opRunner.RunOp");
+    if (options.Has("cpu")) {
+        if (!RunCpu(problem, c, options)) {
+            return false;
+        }
+        INFO_LOG("Run op success");
+        return true;
+    }
+
+    if (options.Has("throughput")) {
+        if (!RunThroughput(problem, c, options)) {
+            return false;
+        }
+        INFO_LOG("Run op success");
+        return true;
+    }
+
+    SpmmSession session;
+    if (!session.Init()) {
+        ERROR_LOG("Init session failed");
+        return false;
+    }
+
+    if (!session.Load(problem)) {
+        ERROR_LOG("Load problem failed");
+        return false;
+    }
+
+    if (options.Has("tune") && !RunTune(session, problem, sampleName, options)) {
+        return false;
+    }
 
-    if (!result) {
-        ERROR_LOG("Run op failed");
+    if (options.Has("bench") && !RunBench(session, problem, category, sampleName, options)) {
         return false;
     }
 
+    // 重复执行只付出 launch 的开销：buffer、stream 与 executor 都在 session 中复用
+    int64_t repeat = options.GetInt("repeat", 1);
+    for (int64_t i = 0; i < repeat; ++i) {
+        if (!session.Run()) {
+            ERROR_LOG("Run op failed");
+            return false;
+        }
+    }
+
+    // 插桩版 kernel 的每 core 计数，来自最后一次 launch
+    if ((problem.flags & BCSR_SPMM_FLAG_PROFILE) != 0) {
+        std::vector<KernelCoreProfile> cores;
+        if (!session.ReadKernelProfile(cores)) {
+            return false;
+        }
+        PrintKernelProfile(category + "/" + sampleName, cores);
+        std::string profilePath = options.GetString("kernel-profile", "");
+        if (!profilePath.empty() && !WriteKernelProfile(profilePath, sampleName, cores)) {
+            return false;
+        }
+    }
+
     // process output data
-    if (!ProcessOutputData(opRunner, c)) {
+    if (!ProcessOutputData(session, c)) {
         ERROR_LOG("Process output data failed");
         return false;
     }
@@ -176,43 +443,101 @@ bool RunOp(int64_t m, int64_t k, int64_t n, int64_t windowNum, int64_t blockNum,
     return true;
 }
 
+// 批处理模式：一个进程、一次 device 初始化处理目录或清单中的全部样例
+bool RunBatch(const Options &options)
+{
+    std::vector<BatchSample> samples;
+    if (!CollectBatchSamples(options.GetString("batch", ""), samples)) {
+        return false;
+    }
+    BatchRunner runner(options);
+    if (!runner.Run(samples)) {
+        return false;
+    }
+    runner.PrintSummary();
+    if (!runner.WriteReport(options.GetString("report", "../output/batch_report.csv"))) {
+        return false;
+    }
+    return runner.GetFailedCount() == 0;
+}
+
 int main(int argc, char **argv)
 {
-    if (argc != 13) {
+    bool batch = argc >= 2 && std::string(argv[1]).compare(0, 8, "--batch=") == 0;
+    if (!batch && argc < 13) {
         // std::cerr << "Usage: " << argv[0] << " <M> <K> <N> <NNZ> <row_ptr.bin> <col.bin> <values.bin> <b.bin> <c.bin> <category> <sample_name>" << std::endl;
-        std::cerr << "Usage: " << argv[0] << " <M> <K> <N> <WINDOW_NUM> <BLOCK_NUM> <row_ptr.bin> <col.bin> <values.bin> <b.bin> <c.bin> <category> <sample_name>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <M> <K> <N> <WINDOW_NUM> <BLOCK_NUM> <row_ptr.bin> <col.bin> <values.bin> <b.bin> <c.bin> <category> <sample_name> [--repeat=N] [--throughput=N [--streams=S]] [--stream-budget=MB] [--pool-stats] [--cpu [--threads=T]] [--bench [--warmup=W] [--iters=I] [--nnz=NNZ] [--bench-out=<file.json|file.csv>]] [--trace[=<file.json>] [--trace-events=E]] [--kernel-profile[=<file.csv>]] [--direct-output] [--b-cache] [--schedule] [--dense-windows] [--mix] [--tune [--tune-db=<file>] [--tune-mmad-n=16,32,64] [--tune-cores=0,8] [--tune-partition=contiguous,cyclic]]" << std::endl;
+        std::cerr << "       " << argv[0] << " --batch=<dir|manifest> [--report=<file.csv>] [--col=u16|i32|i64] [--convert=host|device] [--repeat=N] [--cpu [--threads=T]] [--bench ...] [--trace[=<file.json>]] [--kernel-profile[=<file.csv>]] [--direct-output] [--b-cache] [--schedule] [--dense-windows] [--mix] [--refresh[=S]] [--iterate[=K] [--iter-scale=S]] [--stream-budget=MB] [--tune ...]" << std::endl;
         return FAILED;
     }
 
-    int64_t m = std::stoll(argv[1]);
-    int64_t k = std::stoll(argv[2]);
-    int64_t n = std::stoll(argv[3]);
-    int64_t windowNum = std::stoll(argv[4]);
-    int64_t blockNum = std::stoll(argv[5]);
-    std::string rowPtr = argv[6];
-    std::string col = argv[7];
-    std::string values = argv[8];
-    std::string b = argv[9];
-    std::string c = argv[10];
-    std::string category = argv[11];
-    std::string sampleName = argv[12];
-
-    if (!InitResource()) {
+    Options options;
+    std::string category = "batch";
+    std::string sampleName = "batch";
+    if (batch) {
+        if (!options.Parse(argc, argv, 1)) {
+            return FAILED;
+        }
+    } else {
+        category = argv[11];
+        sampleName = argv[12];
+        if (!options.Parse(argc, argv, 13)) {
+            return FAILED;
+        }
+    }
+
+    // --cpu 只走 host 侧引擎，不需要 device
+    bool useDevice = !options.Has("cpu");
+    if (useDevice ? !InitResource() : !MakeOutputDir()) {
         ERROR_LOG("Init resource failed");
         return FAILED;
     }
+    // 只有 --trace 时才预建 device span 所需的事件
+    int64_t traceEvents = options.Has("trace") && useDevice ? options.GetInt("trace-events", 4096) : 0;
+    if (!Profiler::Instance().Enable(options.GetInt("profile-slots", 65536), static_cast<size_t>(std::max<int64_t>(traceEvents, 0)))) {
+        WARN_LOG("Enable profiler failed, continue without profiling");
+    }
     // INFO_LOG("Init resource success");
 
-    if (!RunOp(m, k, n, windowNum, blockNum, rowPtr, col, values, b, c)) {
-        DestroyResource();
+    bool result = false;
+    if (batch) {
+        result = RunBatch(options);
+    } else {
+        result = RunOp(std::stoll(argv[1]), std::stoll(argv[2]), std::stoll(argv[3]), std::stoll(argv[4]),
+            std::stoll(argv[5]), argv[6], argv[7], argv[8], argv[9], argv[10], category, sampleName, options);
+    }
+    if (!result && !batch) {
+        Profiler::Instance().Disable();
+        if (useDevice) {
+            DestroyResource();
+        }
         return FAILED;
     }
+    if (options.Has("pool-stats")) {
+        MemPool::Device().LogStats();
+        MemPool::Host().LogStats();
+    }
 
-    DestroyResource();
+    // device span 的事件须在复位 device 之前解析并销毁
+    Profiler &profiler = Profiler::Instance();
+    if (!profiler.Resolve()) {
+        WARN_LOG("Resolve device spans failed");
+    }
+    if (options.Has("trace")) {
+        std::string tracePath = options.GetString("trace", "");
+        if (tracePath.empty()) {
+            tracePath = "../output/" + category + "_" + sampleName + "_trace.json";
+        }
+        (void)profiler.WriteChromeTrace(tracePath);
+    }
+    profiler.Disable();
+
+    if (useDevice) {
+        DestroyResource();
+    }
 
-    Timer::CalculateAndRecordAll();
-    Log::Write(category, sampleName, Timer::GetTimings());
-    Timer::Clear();
+    Log::Write(category, sampleName, profiler.GetTimings());
+    profiler.Clear();
 
-    return SUCCESS;
+    return result ? SUCCESS : FAILED;
 }
@@ -0,0 +1,211 @@
+/**
+ * @file mem_pool.cpp
+ */
+#include "mem_pool.h"
+
+#include <algorithm>
+
+#include "acl/acl.h"
+#include "common.h"
+
+extern bool g_isDevice;
+
+namespace {
+constexpr size_t MIN_SIZE_CLASS = 512;
+// each power of two is split into this many classes, bounding waste to 25%
+constexpr size_t CLASSES_PER_POWER = 4;
+constexpr size_t DEFAULT_CACHE_LIMIT = 256UL * 1024 * 1024;
+} // namespace
+
+MemPool &MemPool::Device()
+{
+    static MemPool *pool = new MemPool(DEVICE);
+    return *pool;
+}
+
+MemPool &MemPool::Host()
+{
+    static MemPool *pool = new MemPool(HOST);
+    return *pool;
+}
+
+MemPool::MemPool(Kind kind) : kind_(kind), cacheLimit_(DEFAULT_CACHE_LIMIT) {}
+
+size_t MemPool::SizeClass(size_t size)
+{
+    if (size <= MIN_SIZE_CLASS) {
+        return MIN_SIZE_CLASS;
+    }
+    size_t power = MIN_SIZE_CLASS;
+    while (power * 2 < size) {
+        power *= 2;
+    }
+    size_t step = power / CLASSES_PER_POWER;
+    return (size + step - 1) / step * step;
+}
+
+void *MemPool::DriverAlloc(size_t size)
+{
+    void *ptr = nullptr;
+    aclError ret;
+    if (kind_ == DEVICE || g_isDevice) {
+        ret = aclrtMalloc(&ptr, size, ACL_MEM_MALLOC_HUGE_FIRST);
+    } else {
+        ret = aclrtMallocHost(&ptr, size);
+    }
+    if (ret != ACL_SUCCESS) {
+        return nullptr;
+    }
+    ++stats_.driverAllocs;
+    return ptr;
+}
+
+void MemPool::DriverFree(void *ptr)
+{
+    if (kind_ == DEVICE || g_isDevice) {
+        (void)aclrtFree(ptr);
+    } else {
+        (void)aclrtFreeHost(ptr);
+    }
+    ++stats_.driverFrees;
+}
+
+void *MemPool::Alloc(size_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t blockSize = 0;
+    return AllocLocked(size, blockSize);
+}
+
+void *MemPool::AllocLocked(size_t size, size_t &blockSize)
+{
+    size_t sizeClass = SizeClass(size);
+    void *ptr = nullptr;
+    // smallest cached class that fits; empty classes are erased, so lower_bound lands on a block
+    auto it = cache_.lower_bound(sizeClass);
+    if (it != cache_.end()) {
+        sizeClass = it->first;
+        ptr = it->second.back();
+        it->second.pop_back();
+        if (it->second.empty()) {
+            cache_.erase(it);
+        }
+        stats_.bytesCached -= sizeClass;
+        ++stats_.hits;
+    } else {
+        ptr = DriverAlloc(sizeClass);
+        if (ptr == nullptr && stats_.bytesCached != 0) {
+            // out of memory: drop the cache and retry once
+            for (auto &bucket : cache_) {
+                for (void *block : bucket.second) {
+                    DriverFree(block);
+                }
+            }
+            cache_.clear();
+            stats_.bytesCached = 0;
+            ptr = DriverAlloc(sizeClass);
+        }
+        if (ptr == nullptr) {
+            ERROR_LOG("%s pool failed to allocate %zu bytes", kind_ == DEVICE ? "Device" : "Host", sizeClass);
+            return nullptr;
+        }
+        ++stats_.misses;
+    }
+    live_[ptr] = sizeClass;
+    blockSize = sizeClass;
+    stats_.bytesInUse += sizeClass;
+    if (stats_.bytesInUse > stats_.peakInUse) {
+        stats_.peakInUse = stats_.bytesInUse;
+    }
+    if (stats_.bytesInUse + stats_.bytesCached > stats_.peakReserved) {
+        stats_.peakReserved = stats_.bytesInUse + stats_.bytesCached;
+    }
+    return ptr;
+}
+
+void MemPool::Free(void *ptr)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = live_.find(ptr);
+    if (it == live_.end()) {
+        ERROR_LOG("%s pool does not own %p", kind_ == DEVICE ? "Device" : "Host", ptr);
+        return;
+    }
+    size_t sizeClass = it->second;
+    live_.erase(it);
+    cache_[sizeClass].push_back(ptr);
+    stats_.bytesInUse -= sizeClass;
+    stats_.bytesCached += sizeClass;
+    EvictLocked();
+}
+
+void MemPool::EvictLocked()
+{
+    // small blocks left behind by grow-only buffers go first, large ones still serve any smaller request
+    size_t limit = std::max(cacheLimit_, stats_.bytesInUse);
+    while (stats_.bytesCached > limit && !cache_.empty()) {
+        auto it = cache_.begin();
+        DriverFree(it->second.back());
+        it->second.pop_back();
+        stats_.bytesCached -= it->first;
+        ++stats_.evictions;
+        if (it->second.empty()) {
+            cache_.erase(it);
+        }
+    }
+}
+
+bool MemPool::Grow(void *&ptr, size_t &capacity, size_t size)
+{
+    if (size <= capacity && ptr != nullptr) {
+        return true;
+    }
+    Free(ptr);
+    capacity = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t blockSize = 0;
+    ptr = AllocLocked(size, blockSize);
+    if (ptr == nullptr) {
+        return false;
+    }
+    // a cached block may be of a larger class than requested, report what it really holds
+    capacity = blockSize;
+    return true;
+}
+
+void MemPool::Trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &bucket : cache_) {
+        for (void *block : bucket.second) {
+            DriverFree(block);
+        }
+    }
+    cache_.clear();
+    stats_.bytesCached = 0;
+}
+
+void MemPool::SetCacheLimit(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cacheLimit_ = bytes;
+    EvictLocked();
+}
+
+MemPoolStats MemPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void MemPool::LogStats() const
+{
+    MemPoolStats stats = GetStats();
+    INFO_LOG("%s pool: in use %zu B, cached %zu B, peak in use %zu B, peak reserved %zu B, "
+             "driver allocs %zu, driver frees %zu, hits %zu, misses %zu, evictions %zu",
+             kind_ == DEVICE ? "Device" : "Host", stats.bytesInUse, stats.bytesCached, stats.peakInUse,
+             stats.peakReserved, stats.driverAllocs, stats.driverFrees, stats.hits, stats.misses, stats.evictions);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file mix_windows.cpp
+ */
+#include "mix_windows.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "common.h"
+#include "spmm_session.h"
+
+MixWindowPlan::MixWindowPlan() : mixNum_(0), cubeOnlyCost_(0.0), splitCost_(0.0) {}
+
+bool MixWindowPlan::Build(const SpmmProblem &problem, const std::vector<uint32_t> &denseMap, uint32_t mmadN)
+{
+    Clear();
+    if (problem.windowNum > static_cast<int64_t>(std::numeric_limits<uint32_t>::max())) {
+        ERROR_LOG("Mixed split supports at most %u windows, got %ld", std::numeric_limits<uint32_t>::max(),
+            static_cast<long>(problem.windowNum));
+        return false;
+    }
+    if (problem.windowNum > 0 && (problem.rowPtr == nullptr ||
+                                  (problem.blockNum > 0 && (problem.col == nullptr || problem.val == nullptr)))) {
+        ERROR_LOG("Mixed split needs the host row_ptr, col and val");
+        return false;
+    }
+    const int64_t blockElems = BCSR_TILE_M * BCSR_TILE_K;
+    const double aBytes = static_cast<double>(blockElems * sizeof(uint16_t));
+    int64_t mmadNum = mmadN == 0 ? 1 : (problem.n + mmadN - 1) / mmadN;
+    // cube 每块每个面板搬一次 A 与 16 x mmadN 的 B，与块内有几个非零元无关
+    double cubeBlock = static_cast<double>(mmadNum) * (aBytes + BCSR_TILE_K * mmadN * sizeof(uint16_t));
+    const uint16_t *val = static_cast<const uint16_t *>(problem.val);
+
+    std::vector<double> cube(static_cast<size_t>(problem.windowNum), 0.0);
+    std::vector<double> vector(static_cast<size_t>(problem.windowNum), 0.0);
+    std::vector<uint32_t> candidates;
+    double cubeTotal = 0.0;
+    for (int64_t w = 0; w < problem.windowNum; ++w) {
+        int64_t first = problem.RowPtrAt(w);
+        int64_t last = problem.RowPtrAt(w + 1);
+        cube[w] = static_cast<double>(last - first) * cubeBlock;
+        cubeTotal += cube[w];
+        if (first == last || (!denseMap.empty() && denseMap[w] != 0)) {
+            continue;
+        }
+        // 向量核只搬块内有非零元的 K 行，每个非零元一次 N 长的 Axpy
+        int64_t nnz = 0;
+        int64_t usedRows = 0;
+        for (int64_t blk = first; blk < last; ++blk) {
+            const uint16_t *block = val + static_cast<size_t>(blk) * blockElems;
+            uint32_t colBits = 0;
+            for (int64_t i = 0; i < blockElems; ++i) {
+                if ((block[i] & 0x7fff) != 0) {
+                    ++nnz;
+                    colBits |= 1u << (i % BCSR_TILE_K);
+                }
+            }
+            for (; colBits != 0; colBits &= colBits - 1) {
+                ++usedRows;
+            }
+        }
+        vector[w] = static_cast<double>(last - first) * (aBytes + MIX_VECTOR_BLOCK_COST) +
+                    static_cast<double>(usedRows * problem.n) * sizeof(uint16_t) +
+                    static_cast<double>(nnz * problem.n) * MIX_VECTOR_AXPY_COST;
+        // 比 cube 慢一倍以上的窗口交给向量核不会缩短总时间
+        if (nnz * 100 <= MIX_WINDOW_MAX_FILL_PCT * (last - first) * blockElems &&
+            vector[w] < cube[w] * MIX_VECTOR_PER_CUBE) {
+            candidates.push_back(static_cast<uint32_t>(w));
+        }
+    }
+
+    // 按向量核与 cube 的代价比从小到大逐个移走，取两边中较慢一侧最快的前缀
+    std::stable_sort(candidates.begin(), candidates.end(), [&cube, &vector](uint32_t a, uint32_t b) {
+        return vector[a] * cube[b] < vector[b] * cube[a];
+    });
+    size_t best = 0;
+    double bestCost = cubeTotal;
+    double moved = 0.0;
+    double vectorTotal = 0.0;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        moved += cube[candidates[i]];
+        vectorTotal += vector[candidates[i]];
+        double cost = std::max(cubeTotal - moved, vectorTotal / MIX_VECTOR_PER_CUBE);
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = i + 1;
+        }
+    }
+    map_.assign(static_cast<size_t>(problem.windowNum), 0);
+    for (size_t i = 0; i < best; ++i) {
+        map_[candidates[i]] = 1;
+    }
+    mixNum_ = static_cast<int64_t>(best);
+    cubeOnlyCost_ = cubeTotal;
+    splitCost_ = bestCost;
+    return true;
+}
+
+void MixWindowPlan::Clear()
+{
+    mixNum_ = 0;
+    map_.clear();
+    cubeOnlyCost_ = 0.0;
+    splitCost_ = 0.0;
+}
+
+int64_t MixWindowPlan::GetMixNum() const
+{
+    return mixNum_;
+}
+
+void MixWindowPlan::Split(std::vector<uint32_t> &order) const
+{
+    std::stable_partition(order.begin(), order.end(),
+        [this](uint32_t w) { return static_cast<size_t>(w) >= map_.size() || map_[w] == 0; });
+}
+
+double MixWindowPlan::GetCubeOnlyCost() const
+{
+    return cubeOnlyCost_;
+}
+
+double MixWindowPlan::GetSplitCost() const
+{
+    return splitCost_;
+}
@@ -15,7 +15,8 @@
 #include "acl/acl_op_compiler.h"
 #include "aclnn_bcsr_spmm_custom.h"
 #include "common.h"
-#include "timer.h"
+#include "mem_pool.h"
+#include "profiler.h"
 
 using namespace std;
 
@@ -31,9 +32,7 @@ OpRunner::OpRunner(OperatorDesc *opDesc) : opDesc_(opDesc)
 
 OpRunner::~OpRunner()
 {
-    if (workspace_!= nullptr) {
-        (void)aclrtFree(workspace_);
-    }
+    MemPool::Device().Free(workspace_);
 
     for (size_t i = 0; i < numInputsArray_; ++i) {
         (void)aclDestroyIntArray(inputArray_[i]);
@@ -43,23 +42,15 @@ OpRunner::~OpRunner()
     }
     for (size_t i = 0; i < numInputs_; ++i) {
         (void)aclDestroyDataBuffer(inputBuffers_[i]);
-        (void)aclrtFree(devInputs_[i]);
-        if (g_isDevice) {
-            (void)aclrtFree(hostInputs_[i]);
-        } else {
-            (void)aclrtFreeHost(hostInputs_[i]);
-        }
+        MemPool::Device().Free(devInputs_[i]);
+        MemPool::Host().Free(hostInputs_[i]);
     }
 
     for (size_t i = 0; i < numOutputs_; ++i) {
         (void)aclDestroyTensor(outputTensor_[i]);
         (void)aclDestroyDataBuffer(outputBuffers_[i]);
-        (void)aclrtFree(devOutputs_[i]);
-        if (g_isDevice) {
-            (void)aclrtFree(hostOutputs_[i]);
-        } else {
-            (void)aclrtFreeHost(hostOutputs_[i]);
-        }
+        MemPool::Device().Free(devOutputs_[i]);
+        MemPool::Host().Free(hostOutputs_[i]);
     }
 }
 
@@ -67,26 +58,15 @@ bool OpRunner::Init()
 {
     for (size_t i = 0; i < numInputs_; ++i) {
         auto size = GetInputSize(i);
-        void *devMem = nullptr;
-        if (aclrtMalloc(&devMem, size, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
+        void *devMem = MemPool::Device().Alloc(size);
+        if (devMem == nullptr) {
             ERROR_LOG("Malloc device memory for input[%zu] failed", i);
             return false;
         }
         devInputs_.emplace_back(devMem);
         inputBuffers_.emplace_back(aclCreateDataBuffer(devMem, size));
 
-        void *hostInput = nullptr;
-        if (g_isDevice) {
-            if (aclrtMalloc(&hostInput, size, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
-                ERROR_LOG("Malloc device memory for input[%zu] failed", i);
-                return false;
-            }
-        } else {
-            if (aclrtMallocHost(&hostInput, size) != ACL_SUCCESS) {
-                ERROR_LOG("Malloc device memory for input[%zu] failed", i);
-                return false;
-            }
-        }
+        void *hostInput = MemPool::Host().Alloc(size);
         if (hostInput == nullptr) {
             ERROR_LOG("Malloc memory for input[%zu] failed", i);
             return false;
@@ -115,8 +95,8 @@ bool OpRunner::Init()
 
     for (size_t i = 0; i < numOutputs_; ++i) {
         auto size = GetOutputSize(i);
-        void *devMem = nullptr;
-        if (aclrtMalloc(&devMem, size, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
+        void *devMem = MemPool::Device().Alloc(size);
+        if (devMem == nullptr) {
             ERROR_LOG("Malloc device memory for output[%zu] failed", i);
             return false;
         }
@@ -127,18 +107,7 @@ bool OpRunner::Init()
         devOutputs_.emplace_back(devMem);
         outputBuffers_.emplace_back(aclCreateDataBuffer(devMem, size));
 
-        void *hostOutput = nullptr;
-        if (g_isDevice) {
-            if (aclrtMalloc(&hostOutput, size, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
-                ERROR_LOG("Malloc device memory for output[%zu] failed", i);
-                return false;
-            }
-        } else {
-            if (aclrtMallocHost(&hostOutput, size) != ACL_SUCCESS) {
-                ERROR_LOG("Malloc device memory for output[%zu] failed", i);
-                return false;
-            }
-        }
+        void *hostOutput = MemPool::Host().Alloc(size);
         if (hostOutput == nullptr) {
             ERROR_LOG("Malloc host memory for output[%zu] failed", i);
             return false;
@@ -346,26 +315,29 @@ bool OpRunner::RunOp()
     // INFO_LOG("Execute aclnnBcsrSpmmCustomGetWorkspaceSize success, workspace size %lu", workspaceSize);
 
     if (workspaceSize != 0) {
-        if (aclrtMalloc(&workspace_, workspaceSize, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
+        MemPool::Device().Free(workspace_);
+        workspace_ = MemPool::Device().Alloc(workspaceSize);
+        if (workspace_ == nullptr) {
             ERROR_LOG("Malloc device memory failed");
         }
     }
 
-    Timer::Start("aclnnBcsrSpmmCustom");
-    ret = aclnnBcsrSpmmCustom(workspace_, workspaceSize, handle, stream);
-    if (ret != ACL_SUCCESS) {
-        (void)aclrtDestroyStream(stream);
-        ERROR_LOG("Execute Operator failed. error code is %d", static_cast<int32_t>(ret));
-        return false;
-    }
-    INFO_LOG("Execute aclnnBcsrSpmmCustom success");
+    {
+        ProfileScope scope("aclnnBcsrSpmmCustom");
+        ret = aclnnBcsrSpmmCustom(workspace_, workspaceSize, handle, stream);
+        if (ret != ACL_SUCCESS) {
+            (void)aclrtDestroyStream(stream);
+            ERROR_LOG("Execute Operator failed. error code is %d", static_cast<int32_t>(ret));
+            return false;
+        }
+        INFO_LOG("Execute aclnnBcsrSpmmCustom success");
 
-    ret = aclrtSynchronizeStreamWithTimeout(stream, 5000);
-    Timer::Stop("aclnnBcsrSpmmCustom");
-    if (ret != SUCCESS) {
-        ERROR_LOG("Synchronize stream failed. error code is %d", static_cast<int32_t>(ret));
-        (void)aclrtDestroyStream(stream);
-        return false;
+        ret = aclrtSynchronizeStreamWithTimeout(stream, 5000);
+        if (ret != SUCCESS) {
+            ERROR_LOG("Synchronize stream failed. error code is %d", static_cast<int32_t>(ret));
+            (void)aclrtDestroyStream(stream);
+            return false;
+        }
     }
     // INFO_LOG("Synchronize stream success");
 
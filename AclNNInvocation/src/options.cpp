@@ -0,0 +1,55 @@
+/**
+ * @file options.cpp
+ */
+#include "options.h"
+
+#include <cstdlib>
+
+#include "common.h"
+
+bool Options::Parse(int argc, char **argv, int first)
+{
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.size() < 3 || arg.compare(0, 2, "--") != 0) {
+            ERROR_LOG("Unknown argument %s, options look like --key=value", arg.c_str());
+            return false;
+        }
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            values_[arg.substr(2)] = "";
+        } else {
+            values_[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+    return true;
+}
+
+bool Options::Has(const std::string &key) const
+{
+    return values_.count(key) != 0;
+}
+
+std::string Options::GetString(const std::string &key, const std::string &defaultValue) const
+{
+    auto it = values_.find(key);
+    return it == values_.end() ? defaultValue : it->second;
+}
+
+int64_t Options::GetInt(const std::string &key, int64_t defaultValue) const
+{
+    auto it = values_.find(key);
+    if (it == values_.end() || it->second.empty()) {
+        return defaultValue;
+    }
+    return std::strtoll(it->second.c_str(), nullptr, 10);
+}
+
+double Options::GetDouble(const std::string &key, double defaultValue) const
+{
+    auto it = values_.find(key);
+    if (it == values_.end() || it->second.empty()) {
+        return defaultValue;
+    }
+    return std::strtod(it->second.c_str(), nullptr);
+}
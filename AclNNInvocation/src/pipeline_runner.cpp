@@ -0,0 +1,221 @@
+/**
+ * @file pipeline_runner.cpp
+ */
+#include "pipeline_runner.h"
+
+#include <cstring>
+
+#include "aclnn_bcsr_spmm_custom.h"
+#include "mem_pool.h"
+#include "profiler.h"
+
+extern bool g_isDevice;
+
+namespace {
+// keep each staged input on a 32B boundary, as DataCopy expects in GM
+constexpr size_t STAGE_ALIGN = 32;
+
+size_t AlignUp(size_t size)
+{
+    return (size + STAGE_ALIGN - 1) / STAGE_ALIGN * STAGE_ALIGN;
+}
+} // namespace
+
+PipelineRunner::PipelineRunner(size_t streamNum) : slots_(streamNum == 0 ? 1 : streamNum), next_(0), completed_(0)
+{
+}
+
+PipelineRunner::~PipelineRunner()
+{
+    (void)Flush();
+    for (Slot &slot : slots_) {
+        Release(slot);
+    }
+}
+
+bool PipelineRunner::Init()
+{
+    for (Slot &slot : slots_) {
+        if (slot.stream == nullptr && aclrtCreateStream(&slot.stream) != ACL_SUCCESS) {
+            ERROR_LOG("Create stream failed");
+            return false;
+        }
+        if (slot.done == nullptr && aclrtCreateEvent(&slot.done) != ACL_SUCCESS) {
+            ERROR_LOG("Create event failed");
+            return false;
+        }
+    }
+    return true;
+}
+
+void PipelineRunner::Release(Slot &slot)
+{
+    slot.tensors.Destroy();
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        MemPool::Device().Free(slot.devBuffers[i]);
+        slot.devBuffers[i] = nullptr;
+    }
+    MemPool::Device().Free(slot.workspace);
+    MemPool::Host().Free(slot.hostIn);
+    MemPool::Host().Free(slot.hostOut);
+    slot.workspace = slot.hostIn = slot.hostOut = nullptr;
+    if (slot.done != nullptr) {
+        (void)aclrtDestroyEvent(slot.done);
+        slot.done = nullptr;
+    }
+    if (slot.stream != nullptr) {
+        (void)aclrtDestroyStream(slot.stream);
+        slot.stream = nullptr;
+    }
+}
+
+bool PipelineRunner::Stage(Slot &slot, const SpmmProblem &problem, size_t (&offsets)[SPMM_BUF_C])
+{
+    ProfileScope scope("pipeline.Stage");
+    // all inputs share one pinned buffer, C has its own
+    const void *inputs[SPMM_BUF_C] = {problem.rowPtr, problem.col, problem.val, problem.b};
+    size_t total = 0;
+    for (size_t i = 0; i < SPMM_BUF_C; ++i) {
+        offsets[i] = total;
+        total += AlignUp(SpmmBufferSize(problem, i));
+    }
+    if (!MemPool::Host().Grow(slot.hostIn, slot.hostInCapacity, total) ||
+        !MemPool::Host().Grow(slot.hostOut, slot.hostOutCapacity, problem.CSize())) {
+        return false;
+    }
+    for (size_t i = 0; i < SPMM_BUF_C; ++i) {
+        size_t size = SpmmBufferSize(problem, i);
+        if (size != 0) {
+            memcpy(static_cast<char *>(slot.hostIn) + offsets[i], inputs[i], size);
+        }
+    }
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        if (!MemPool::Device().Grow(slot.devBuffers[i], slot.devCapacities[i], SpmmBufferSize(problem, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PipelineRunner::Enqueue(Slot &slot, const SpmmProblem &problem, const size_t (&offsets)[SPMM_BUF_C])
+{
+    aclrtMemcpyKind h2d = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    {
+        DeviceProfileScope h2dScope("H2D", slot.stream);
+        for (size_t i = 0; i < SPMM_BUF_C; ++i) {
+            size_t size = SpmmBufferSize(problem, i);
+            if (size != 0 && aclrtMemcpyAsync(slot.devBuffers[i], slot.devCapacities[i],
+                                              static_cast<char *>(slot.hostIn) + offsets[i], size, h2d,
+                                              slot.stream) != ACL_SUCCESS) {
+                ERROR_LOG("Copy input buffer[%zu] failed", i);
+                return false;
+            }
+        }
+    }
+    size_t cSize = problem.CSize();
+    // the kernel accumulates into C with atomic adds unless it writes C directly
+    if (!problem.DirectOutput() && cSize != 0) {
+        if (aclrtMemsetAsync(slot.devBuffers[SPMM_BUF_C], slot.devCapacities[SPMM_BUF_C], 0, cSize, slot.stream) !=
+            ACL_SUCCESS) {
+            ERROR_LOG("Memset output failed");
+            return false;
+        }
+    }
+
+    // 与 SpmmSession 一样带上行窗口签名，TilingFunc 据此查调优库
+    SpmmProblem keyed = problem;
+    keyed.signature = problem.WindowSignature();
+    // 调度表、稠密行与向量核的窗口划分由 SpmmSession 写入 workspace，流水线按窗口原序只用 cube
+    keyed.flags &= ~(BCSR_SPMM_FLAG_SCHEDULE | BCSR_SPMM_FLAG_DENSE | BCSR_SPMM_FLAG_MIX);
+    uint64_t workspaceSize = 0;
+    aclOpExecutor *executor = nullptr;
+    if (!slot.tensors.Create(keyed, slot.devBuffers) || !slot.tensors.GetWorkspaceSize(workspaceSize, executor)) {
+        return false;
+    }
+    if (workspaceSize != 0 && !MemPool::Device().Grow(slot.workspace, slot.workspaceCapacity, workspaceSize)) {
+        (void)aclDestroyAclOpExecutor(executor);
+        return false;
+    }
+    {
+        DeviceProfileScope kernelScope("BcsrSpmm kernel", slot.stream);
+        auto ret = aclnnBcsrSpmmCustom(workspaceSize != 0 ? slot.workspace : nullptr, workspaceSize, executor,
+                                       slot.stream);
+        if (ret != ACL_SUCCESS) {
+            ERROR_LOG("Execute Operator failed. error code is %d", static_cast<int32_t>(ret));
+            (void)aclDestroyAclOpExecutor(executor);
+            return false;
+        }
+    }
+
+    aclrtMemcpyKind d2h = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (cSize != 0) {
+        DeviceProfileScope d2hScope("D2H", slot.stream);
+        if (aclrtMemcpyAsync(slot.hostOut, slot.hostOutCapacity, slot.devBuffers[SPMM_BUF_C], cSize, d2h,
+                             slot.stream) != ACL_SUCCESS) {
+            ERROR_LOG("Copy output failed");
+            return false;
+        }
+    }
+    if (aclrtRecordEvent(slot.done, slot.stream) != ACL_SUCCESS) {
+        ERROR_LOG("Record event failed");
+        return false;
+    }
+    return true;
+}
+
+bool PipelineRunner::Submit(const SpmmProblem &problem, void *c)
+{
+    ProfileScope scope("pipeline.Submit");
+    Slot &slot = slots_[next_];
+    next_ = (next_ + 1) % slots_.size();
+    if (slot.busy && !Complete(slot)) {
+        return false;
+    }
+
+    size_t offsets[SPMM_BUF_C] = {};
+    if (!Stage(slot, problem, offsets) || !Enqueue(slot, problem, offsets)) {
+        // 已排入的异步拷贝可能仍在读 hostIn、写 device buffer，等它们结束后槽位才能复用
+        (void)aclrtSynchronizeStream(slot.stream);
+        slot.tensors.Destroy();
+        return false;
+    }
+    slot.busy = true;
+    slot.pendingOut = c;
+    slot.pendingSize = problem.CSize();
+    return true;
+}
+
+bool PipelineRunner::Complete(Slot &slot)
+{
+    ProfileScope scope("pipeline.Complete");
+    slot.busy = false;
+    if (aclrtSynchronizeEvent(slot.done) != ACL_SUCCESS) {
+        ERROR_LOG("Synchronize event failed");
+        slot.tensors.Destroy();
+        return false;
+    }
+    slot.tensors.Destroy();
+    if (slot.pendingSize != 0) {
+        memcpy(slot.pendingOut, slot.hostOut, slot.pendingSize);
+    }
+    ++completed_;
+    return true;
+}
+
+bool PipelineRunner::Flush()
+{
+    bool result = true;
+    // complete in submission order, starting from the oldest slot
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        Slot &slot = slots_[(next_ + i) % slots_.size()];
+        if (slot.busy && !Complete(slot)) {
+            result = false;
+        }
+    }
+    return result;
+}
+
+size_t PipelineRunner::GetCompleted() const
+{
+    return completed_;
+}
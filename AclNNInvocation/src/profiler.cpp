@@ -0,0 +1,276 @@
+/**
+ * @file profiler.cpp
+ */
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "common.h"
+
+namespace {
+thread_local uint32_t t_depth = 0;
+
+uint32_t ThreadId()
+{
+    static std::atomic<uint32_t> nextId(0);
+    thread_local uint32_t id = nextId.fetch_add(1);
+    return id;
+}
+
+void WriteJsonString(std::ostream &out, const char *text)
+{
+    out << '"';
+    for (const char *p = text; *p != '\0'; ++p) {
+        if (*p == '"' || *p == '\\') {
+            out << '\\';
+        }
+        out << *p;
+    }
+    out << '"';
+}
+} // namespace
+
+Profiler &Profiler::Instance()
+{
+    // 与内存池一样不析构，避免静态对象析构顺序问题
+    static Profiler *profiler = new Profiler();
+    return *profiler;
+}
+
+Profiler::Profiler() : enabled_(false), next_(0), dropped_(0), nextPair_(0), epochNs_(0)
+{
+    epochNs_ = Now();
+}
+
+int64_t Profiler::Now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count() - epochNs_;
+}
+
+bool Profiler::Enable(size_t capacity, size_t devicePairs)
+{
+    Disable();
+    records_.assign(capacity, ProfileRecord());
+    events_.assign(devicePairs * 2, nullptr);
+    for (size_t i = 0; i < events_.size(); ++i) {
+        if (aclrtCreateEvent(&events_[i]) != ACL_SUCCESS) {
+            ERROR_LOG("Create profiler event failed");
+            events_[i] = nullptr;
+            Disable();
+            return false;
+        }
+    }
+    next_ = 0;
+    dropped_ = 0;
+    nextPair_ = 0;
+    enabled_ = true;
+    return true;
+}
+
+void Profiler::Disable()
+{
+    enabled_ = false;
+    for (aclrtEvent event : events_) {
+        if (event != nullptr) {
+            (void)aclrtDestroyEvent(event);
+        }
+    }
+    events_.clear();
+    nextPair_ = 0;
+}
+
+int64_t Profiler::Acquire(const char *name, ProfileKind kind)
+{
+    if (!IsEnabled()) {
+        return -1;
+    }
+    size_t slot = next_.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= records_.size()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+    ProfileRecord &record = records_[slot];
+    record.name = name;
+    record.kind = kind;
+    record.tid = ThreadId();
+    record.depth = t_depth;
+    record.endNs = -1;
+    record.startNs = Now();
+    return static_cast<int64_t>(slot);
+}
+
+int64_t Profiler::BeginHost(const char *name)
+{
+    int64_t slot = Acquire(name, PROFILE_HOST);
+    if (slot >= 0) {
+        ++t_depth;
+    }
+    return slot;
+}
+
+void Profiler::EndHost(int64_t slot)
+{
+    if (slot < 0) {
+        return;
+    }
+    --t_depth;
+    records_[slot].endNs = Now();
+}
+
+int64_t Profiler::BeginDevice(const char *name, aclrtStream stream)
+{
+    if (!IsEnabled() || events_.empty()) {
+        return -1;
+    }
+    size_t pair = nextPair_.fetch_add(1, std::memory_order_relaxed);
+    if (pair * 2 >= events_.size()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+    int64_t slot = Acquire(name, PROFILE_DEVICE);
+    if (slot < 0) {
+        return -1;
+    }
+    ProfileRecord &record = records_[slot];
+    record.stream = stream;
+    record.eventPair = pair;
+    if (aclrtRecordEvent(events_[pair * 2], stream) != ACL_SUCCESS) {
+        record.name = nullptr;
+        return -1;
+    }
+    return slot;
+}
+
+void Profiler::EndDevice(int64_t slot)
+{
+    if (slot < 0) {
+        return;
+    }
+    ProfileRecord &record = records_[slot];
+    if (aclrtRecordEvent(events_[record.eventPair * 2 + 1], record.stream) != ACL_SUCCESS) {
+        record.name = nullptr;
+    }
+}
+
+bool Profiler::Resolve()
+{
+    // device 时间轴锚定在第一个 device span 入队时的 host 时间
+    size_t used = std::min(next_.load(), records_.size());
+    const ProfileRecord *anchor = nullptr;
+    bool result = true;
+    for (size_t i = 0; i < used; ++i) {
+        ProfileRecord &record = records_[i];
+        if (record.kind != PROFILE_DEVICE || record.name == nullptr || record.endNs >= 0) {
+            continue;
+        }
+        aclrtEvent start = events_[record.eventPair * 2];
+        aclrtEvent end = events_[record.eventPair * 2 + 1];
+        if (anchor == nullptr) {
+            anchor = &record;
+        }
+        float offsetMs = 0.0f;
+        float durationMs = 0.0f;
+        if (aclrtSynchronizeEvent(end) != ACL_SUCCESS ||
+            aclrtEventElapsedTime(&offsetMs, events_[anchor->eventPair * 2], start) != ACL_SUCCESS ||
+            aclrtEventElapsedTime(&durationMs, start, end) != ACL_SUCCESS) {
+            result = false;
+            continue;
+        }
+        record.startNs = anchor->startNs + static_cast<int64_t>(offsetMs * 1.0e6);
+        record.endNs = record.startNs + static_cast<int64_t>(durationMs * 1.0e6);
+    }
+    return result;
+}
+
+std::map<std::string, std::vector<double>> Profiler::GetTimings() const
+{
+    std::map<std::string, std::vector<double>> timings;
+    size_t used = std::min(next_.load(), records_.size());
+    for (size_t i = 0; i < used; ++i) {
+        const ProfileRecord &record = records_[i];
+        if (record.name == nullptr || record.endNs < 0) {
+            continue;
+        }
+        std::string key = record.kind == PROFILE_DEVICE ? std::string(record.name) + "[device]" : record.name;
+        timings[key].push_back((record.endNs - record.startNs) / 1.0e6);
+    }
+    return timings;
+}
+
+bool Profiler::WriteChromeTrace(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        ERROR_LOG("Failed to open trace file: %s", path.c_str());
+        return false;
+    }
+    // pid 0: host 线程，pid 1: 每个 stream 一条 device 轨道
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+        << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"host\"}},\n"
+        << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"device\"}}";
+    std::vector<aclrtStream> streams;
+    size_t used = std::min(next_.load(), records_.size());
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < used; ++i) {
+        const ProfileRecord &record = records_[i];
+        if (record.name == nullptr || record.endNs < 0) {
+            continue;
+        }
+        size_t tid = record.tid;
+        if (record.kind == PROFILE_DEVICE) {
+            tid = std::find(streams.begin(), streams.end(), record.stream) - streams.begin();
+            if (tid == streams.size()) {
+                streams.push_back(record.stream);
+            }
+        }
+        out << ",\n{\"name\": ";
+        WriteJsonString(out, record.name);
+        out << ", \"ph\": \"X\", \"pid\": " << (record.kind == PROFILE_DEVICE ? 1 : 0) << ", \"tid\": " << tid
+            << ", \"ts\": " << record.startNs / 1.0e3 << ", \"dur\": " << (record.endNs - record.startNs) / 1.0e3
+            << ", \"args\": {\"depth\": " << record.depth << "}}";
+    }
+    for (size_t i = 0; i < streams.size(); ++i) {
+        out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+            << ", \"args\": {\"name\": \"stream " << i << "\"}}";
+    }
+    out << "\n]}\n";
+    if (dropped_.load() != 0) {
+        WARN_LOG("Profiler dropped %zu spans, raise the slot or event capacity", dropped_.load());
+    }
+    return out.good();
+}
+
+void Profiler::Clear()
+{
+    size_t used = std::min(next_.load(), records_.size());
+    for (size_t i = 0; i < used; ++i) {
+        records_[i] = ProfileRecord();
+    }
+    next_ = 0;
+    dropped_ = 0;
+    nextPair_ = 0;
+}
+
+void Log::Write(const std::string& category, const std::string& sampleName, const std::map<std::string, std::vector<double>>& timings) {
+    std::string filePath = "../output/" + category + ".txt";
+    std::ofstream outFile(filePath, std::ios::app);
+    if (!outFile.is_open()) {
+        ERROR_LOG("Failed to open log file: %s", filePath.c_str());
+        return;
+    }
+
+    outFile << "Sample: " << sampleName << std::endl;
+    for (const auto& pair : timings) {
+        outFile << "  " << pair.first << ":" << std::endl;
+        for (size_t i = 0; i < pair.second.size(); ++i) {
+            outFile << "    Run " << i + 1 << ": " << std::fixed << std::setprecision(6) << pair.second[i] << " ms" << std::endl;
+        }
+    }
+    outFile << "----------------------------------------" << std::endl;
+    outFile.close();
+}
@@ -0,0 +1,408 @@
+/**
+ * @file sparse_gen.cpp
+ */
+#include "sparse_gen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "common.h"
+#include "cpu_spmm.h"
+
+namespace {
+constexpr int64_t BLOCK_M = 16;
+constexpr int64_t BLOCK_K = 16;
+constexpr int64_t BLOCK_SIZE = BLOCK_M * BLOCK_K;
+// 每个任务 1024 个行窗口，结果按任务号拼接
+constexpr int64_t WINDOWS_PER_TASK = 1024;
+constexpr int VALUE_NUM = 10;
+
+// 不同用途的随机流互不相关
+constexpr uint64_t SALT_ROW = 1;
+constexpr uint64_t SALT_HOT = 2;
+constexpr uint64_t SALT_CLUSTER = 3;
+constexpr uint64_t SALT_DENSE = 4;
+
+uint64_t Mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * splitmix64 stream keyed by (seed, index, salt): a row draws the same
+ * numbers whichever thread generates it
+ */
+class Rng {
+public:
+    Rng(uint64_t seed, uint64_t index, uint64_t salt) : state_(Mix(seed ^ Mix(index * 8 + salt))) {}
+
+    uint64_t Next()
+    {
+        state_ += 0x9e3779b97f4a7c15ULL;
+        return Mix(state_);
+    }
+
+    double Uniform()
+    {
+        return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    int64_t Below(int64_t n)
+    {
+        return n <= 0 ? 0 : static_cast<int64_t>(Next() % static_cast<uint64_t>(n));
+    }
+
+private:
+    uint64_t state_;
+};
+
+// 期望值随机取整，总 nnz 的期望保持不变
+int64_t StochasticRound(double expected, Rng &rng)
+{
+    if (expected <= 0.0) {
+        return 0;
+    }
+    double base = std::floor(expected);
+    return static_cast<int64_t>(base) + (rng.Uniform() < expected - base ? 1 : 0);
+}
+
+int Levels(int64_t n)
+{
+    int levels = 0;
+    while ((int64_t(1) << levels) < n) {
+        ++levels;
+    }
+    return levels;
+}
+
+/**
+ * Columns of one row for the configured family, sorted and unique
+ */
+class RowSampler {
+public:
+    explicit RowSampler(const GenConfig &config) : config_(config)
+    {
+        rmatD_ = std::max(0.0, 1.0 - config.rmatA - config.rmatB - config.rmatC);
+        rowLevels_ = Levels(config.m);
+        colLevels_ = Levels(config.k);
+        // R-MAT 行边缘分布：第 i 层行号位为 0 取 a + b，为 1 取 c + d；rowMass_ 为 [0, M) 上的总质量
+        double top = config.rmatA + config.rmatB;
+        double prefix = 1.0;
+        rowMass_ = 0.0;
+        for (int level = 0; level < rowLevels_; ++level) {
+            if ((config.m >> (rowLevels_ - 1 - level)) & 1) {
+                rowMass_ += prefix * top;
+                prefix *= 1.0 - top;
+            } else {
+                prefix *= top;
+            }
+        }
+        if (config.m == (int64_t(1) << rowLevels_)) {
+            rowMass_ = 1.0;
+        }
+    }
+
+    void Sample(int64_t row, std::vector<int32_t> &cols) const
+    {
+        cols.clear();
+        Rng rng(config_.seed, static_cast<uint64_t>(row), SALT_ROW);
+        const int64_t k = config_.k;
+        switch (config_.family) {
+            case FAMILY_UNIFORM:
+                SampleRange(0, k, StochasticRound(config_.nnzPerRow, rng), rng, cols);
+                break;
+            case FAMILY_RMAT:
+                SampleRmat(row, rng, cols);
+                break;
+            case FAMILY_BANDED: {
+                int64_t center = config_.m == 0 ? 0 : row * k / config_.m;
+                SampleRange(std::max<int64_t>(0, center - config_.band), std::min(k, center + config_.band + 1),
+                    StochasticRound(config_.nnzPerRow, rng), rng, cols);
+                break;
+            }
+            case FAMILY_BLOCKDIAG: {
+                int64_t bs = std::max<int64_t>(config_.blockSize, 1);
+                int64_t rowBegin = row / bs * bs;
+                int64_t rowEnd = std::min(config_.m, rowBegin + bs);
+                int64_t begin = std::min(k - 1, rowBegin * k / config_.m);
+                int64_t end = std::max(begin + 1, std::min(k, rowEnd * k / config_.m));
+                SampleRange(begin, end, StochasticRound(config_.nnzPerRow, rng), rng, cols);
+                break;
+            }
+            case FAMILY_HOTROW: {
+                double hot = std::min(std::max(config_.hotRows, 1e-9), 1.0);
+                double share = std::min(std::max(config_.hotShare, 0.0), 1.0);
+                Rng hotRng(config_.seed, static_cast<uint64_t>(row), SALT_HOT);
+                double expected = hotRng.Uniform() < hot ? config_.nnzPerRow * share / hot :
+                    (hot < 1.0 ? config_.nnzPerRow * (1.0 - share) / (1.0 - hot) : 0.0);
+                SampleRange(0, k, StochasticRound(expected, rng), rng, cols);
+                break;
+            }
+            case FAMILY_CLUSTERED:
+                SampleClustered(row, rng, cols);
+                break;
+            default:
+                break;
+        }
+    }
+
+private:
+    // 区间 [begin, end) 内不放回抽 count 列：稠密时顺序选取，稀疏时拒绝重复
+    static void SampleRange(int64_t begin, int64_t end, int64_t count, Rng &rng, std::vector<int32_t> &cols)
+    {
+        int64_t range = end - begin;
+        count = std::min(count, std::max<int64_t>(range, 0));
+        if (count <= 0) {
+            return;
+        }
+        if (count * 4 >= range) {
+            int64_t needed = count;
+            for (int64_t c = begin; c < end && needed > 0; ++c) {
+                if (rng.Below(end - c) < needed) {
+                    cols.push_back(static_cast<int32_t>(c));
+                    --needed;
+                }
+            }
+            return;
+        }
+        FillUnique(count, cols, [&]() { return begin + rng.Below(range); });
+    }
+
+    template <typename Draw>
+    static void FillUnique(int64_t count, std::vector<int32_t> &cols, Draw draw)
+    {
+        // 重复或越界的候选会被丢弃，限制轮数防止极端参数下不收敛
+        for (int round = 0; round < 16 && static_cast<int64_t>(cols.size()) < count; ++round) {
+            int64_t missing = count - static_cast<int64_t>(cols.size());
+            for (int64_t i = 0; i < missing; ++i) {
+                int64_t c = draw();
+                if (c >= 0) {
+                    cols.push_back(static_cast<int32_t>(c));
+                }
+            }
+            std::sort(cols.begin(), cols.end());
+            cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+        }
+    }
+
+    void SampleRmat(int64_t row, Rng &rng, std::vector<int32_t> &cols) const
+    {
+        const double top = config_.rmatA + config_.rmatB;
+        double mass = 1.0;
+        for (int level = 0; level < rowLevels_; ++level) {
+            mass *= ((row >> (rowLevels_ - 1 - level)) & 1) ? 1.0 - top : top;
+        }
+        double expected = config_.nnzPerRow * static_cast<double>(config_.m) * mass / rowMass_;
+        int64_t count = std::min(StochasticRound(expected, rng), config_.k);
+        // 给定行号逐层选列：行位为 0 时列位取 1 的概率为 b / (a + b)，否则为 d / (c + d)
+        double right0 = top > 0.0 ? config_.rmatB / top : 0.5;
+        double right1 = 1.0 - top > 0.0 ? rmatD_ / (1.0 - top) : 0.5;
+        FillUnique(count, cols, [&]() -> int64_t {
+            int64_t col = 0;
+            for (int level = 0; level < colLevels_; ++level) {
+                bool rowBit = level < rowLevels_ && ((row >> (rowLevels_ - 1 - level)) & 1);
+                col = (col << 1) | (rng.Uniform() < (rowBit ? right1 : right0) ? 1 : 0);
+            }
+            return col < config_.k ? col : -1;
+        });
+    }
+
+    void SampleClustered(int64_t row, Rng &rng, std::vector<int32_t> &cols) const
+    {
+        const int64_t k = config_.k;
+        int64_t group = row / std::max<int64_t>(config_.clusterRows, 1);
+        int64_t width = std::min(std::max<int64_t>(config_.clusterWidth, 1), k);
+        Rng groupRng(config_.seed, static_cast<uint64_t>(group), SALT_CLUSTER);
+        int64_t begin = groupRng.Below(k - width + 1);
+        int64_t count = std::min(StochasticRound(config_.nnzPerRow, rng), k);
+        FillUnique(count, cols, [&]() {
+            return rng.Uniform() < config_.locality ? begin + rng.Below(width) : rng.Below(k);
+        });
+    }
+
+    const GenConfig &config_;
+    double rmatD_ = 0.0;
+    int rowLevels_ = 0;
+    int colLevels_ = 0;
+    double rowMass_ = 1.0;
+};
+
+/**
+ * Blocks of a contiguous range of row windows
+ */
+struct TaskOutput {
+    std::vector<int32_t> windowBlocks;
+    std::vector<int32_t> col;
+    std::vector<uint16_t> values;
+    int64_t nnz = 0;
+};
+
+// 1..10 的 fp16 位模式
+struct HalfTable {
+    uint16_t values[VALUE_NUM + 1];
+
+    HalfTable()
+    {
+        for (int i = 0; i <= VALUE_NUM; ++i) {
+            values[i] = FloatToHalf(static_cast<float>(i));
+        }
+    }
+};
+
+uint16_t HalfOfInt(int value)
+{
+    static const HalfTable table;
+    return table.values[value];
+}
+
+void GenerateTask(const GenConfig &config, const RowSampler &sampler, int64_t windowBegin, int64_t windowEnd,
+    TaskOutput &out)
+{
+    std::vector<int32_t> cols;
+    // 行窗口内的元素打包为 col << 8 | 行内偏移 << 4 | (值 - 1)，一次排序即按块列分组
+    std::vector<uint64_t> entries;
+    for (int64_t w = windowBegin; w < windowEnd; ++w) {
+        entries.clear();
+        int64_t rowEnd = std::min(config.m, (w + 1) * BLOCK_M);
+        for (int64_t row = w * BLOCK_M; row < rowEnd; ++row) {
+            sampler.Sample(row, cols);
+            Rng valueRng(config.seed, static_cast<uint64_t>(row), SALT_DENSE + 1);
+            for (int32_t c : cols) {
+                uint64_t value = static_cast<uint64_t>(valueRng.Below(VALUE_NUM));
+                entries.push_back((static_cast<uint64_t>(c) << 8) | (static_cast<uint64_t>(row % BLOCK_M) << 4) |
+                    value);
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        out.nnz += static_cast<int64_t>(entries.size());
+
+        int64_t blockCol = -1;
+        int32_t blocks = 0;
+        uint16_t *block = nullptr;
+        for (uint64_t entry : entries) {
+            int64_t c = static_cast<int64_t>(entry >> 8);
+            if (c / BLOCK_K != blockCol) {
+                blockCol = c / BLOCK_K;
+                out.col.push_back(static_cast<int32_t>(blockCol * BLOCK_K));
+                out.values.resize(out.values.size() + BLOCK_SIZE, 0);
+                block = out.values.data() + out.values.size() - BLOCK_SIZE;
+                ++blocks;
+            }
+            int64_t localRow = static_cast<int64_t>((entry >> 4) & 0xf);
+            block[localRow * BLOCK_K + c % BLOCK_K] = HalfOfInt(static_cast<int>(entry & 0xf) + 1);
+        }
+        out.windowBlocks.push_back(blocks);
+    }
+}
+} // namespace
+
+bool ParseFamily(const std::string &name, SparseFamily &family)
+{
+    static const SparseFamily FAMILIES[] = {FAMILY_UNIFORM, FAMILY_RMAT, FAMILY_BANDED, FAMILY_BLOCKDIAG,
+        FAMILY_HOTROW, FAMILY_CLUSTERED};
+    for (SparseFamily candidate : FAMILIES) {
+        if (name == GetFamilyName(candidate)) {
+            family = candidate;
+            return true;
+        }
+    }
+    ERROR_LOG("Unknown family %s, expected uniform, rmat, banded, blockdiag, hotrow or clustered", name.c_str());
+    return false;
+}
+
+const char *GetFamilyName(SparseFamily family)
+{
+    switch (family) {
+        case FAMILY_UNIFORM:
+            return "uniform";
+        case FAMILY_RMAT:
+            return "rmat";
+        case FAMILY_BANDED:
+            return "banded";
+        case FAMILY_BLOCKDIAG:
+            return "blockdiag";
+        case FAMILY_HOTROW:
+            return "hotrow";
+        case FAMILY_CLUSTERED:
+            return "clustered";
+        default:
+            return "unknown";
+    }
+}
+
+bool GenerateBcsr(const GenConfig &config, BcsrMatrix &matrix, int64_t &nnz)
+{
+    if (config.m <= 0 || config.k <= 0 || config.k > std::numeric_limits<int32_t>::max() ||
+        config.nnzPerRow < 0.0) {
+        ERROR_LOG("Invalid generator shape M = %ld, K = %ld", static_cast<long>(config.m),
+            static_cast<long>(config.k));
+        return false;
+    }
+    RowSampler sampler(config);
+    int64_t windowNum = (config.m + BLOCK_M - 1) / BLOCK_M;
+    size_t taskNum = static_cast<size_t>((windowNum + WINDOWS_PER_TASK - 1) / WINDOWS_PER_TASK);
+    std::vector<TaskOutput> tasks(taskNum);
+    std::atomic<size_t> nextTask(0);
+    auto work = [&]() {
+        for (size_t task = nextTask++; task < taskNum; task = nextTask++) {
+            int64_t begin = static_cast<int64_t>(task) * WINDOWS_PER_TASK;
+            GenerateTask(config, sampler, begin, std::min(windowNum, begin + WINDOWS_PER_TASK), tasks[task]);
+        }
+    };
+    size_t threadNum = config.threadNum == 0 ? std::max(1u, std::thread::hardware_concurrency()) : config.threadNum;
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(threadNum, taskNum); ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // 按任务顺序拼接，结果与线程数无关
+    matrix = BcsrMatrix();
+    matrix.m = config.m;
+    matrix.k = config.k;
+    size_t blockNum = 0;
+    nnz = 0;
+    for (const TaskOutput &task : tasks) {
+        blockNum += task.col.size();
+        nnz += task.nnz;
+    }
+    if (blockNum > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        ERROR_LOG("%zu blocks overflow the int32 row_ptr", blockNum);
+        return false;
+    }
+    matrix.rowPtr.reserve(static_cast<size_t>(windowNum + 1));
+    matrix.col.reserve(blockNum);
+    matrix.values.reserve(blockNum * BLOCK_SIZE);
+    matrix.rowPtr.push_back(0);
+    for (TaskOutput &task : tasks) {
+        for (int32_t blocks : task.windowBlocks) {
+            matrix.rowPtr.push_back(matrix.rowPtr.back() + blocks);
+        }
+        matrix.col.insert(matrix.col.end(), task.col.begin(), task.col.end());
+        matrix.values.insert(matrix.values.end(), task.values.begin(), task.values.end());
+        TaskOutput().col.swap(task.col);
+        TaskOutput().values.swap(task.values);
+    }
+    return true;
+}
+
+void GenerateDense(int64_t k, int64_t n, uint64_t seed, std::vector<uint16_t> &b)
+{
+    b.resize(static_cast<size_t>(std::max<int64_t>(k, 0) * std::max<int64_t>(n, 0)));
+    for (int64_t row = 0; row < k; ++row) {
+        Rng rng(seed, static_cast<uint64_t>(row), SALT_DENSE);
+        uint16_t *dst = b.data() + row * n;
+        for (int64_t j = 0; j < n; ++j) {
+            dst[j] = HalfOfInt(static_cast<int>(rng.Below(VALUE_NUM)) + 1);
+        }
+    }
+}
@@ -0,0 +1,298 @@
+/**
+ * @file spmm_iterator.cpp
+ */
+#include "spmm_iterator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "aclnn_bcsr_spmm_custom.h"
+#include "aclnn_spmm_iter_epilogue_custom.h"
+#include "common.h"
+#include "mem_pool.h"
+#include "profiler.h"
+#include "spmm_iter_desc.h"
+
+extern bool g_isDevice;
+
+namespace {
+constexpr size_t NORM_BYTES = SPMM_ITER_NORM_NUM * sizeof(float);
+} // namespace
+
+SpmmIterator::SpmmIterator(SpmmSession &session)
+    : session_(session), step_(0), workspace_(nullptr), workspaceCapacity_(0), workspaceSize_(0)
+{
+    for (size_t i = 0; i < ITER_BUF_NUM; ++i) {
+        buffers_[i] = nullptr;
+        capacities_[i] = 0;
+    }
+    for (size_t p = 0; p < 2; ++p) {
+        for (aclTensor *&tensor : epilogueTensors_[p]) {
+            tensor = nullptr;
+        }
+        spmmExecutors_[p] = nullptr;
+        epilogueExecutors_[p] = nullptr;
+    }
+}
+
+SpmmIterator::~SpmmIterator()
+{
+    DestroyExecutors();
+    for (size_t i = 0; i < ITER_BUF_NUM; ++i) {
+        MemPool::Device().Free(buffers_[i]);
+    }
+    MemPool::Device().Free(workspace_);
+}
+
+bool SpmmIterator::Reserve(size_t index, size_t size)
+{
+    // device buffers must not be empty even for empty problems
+    size = size == 0 ? 32 : size;
+    if (size <= capacities_[index]) {
+        return true;
+    }
+    MemPool::Device().Free(buffers_[index]);
+    capacities_[index] = 0;
+    buffers_[index] = MemPool::Device().Alloc(size);
+    if (buffers_[index] == nullptr) {
+        ERROR_LOG("Malloc device memory for iteration buffer[%zu] failed, size %zu", index, size);
+        return false;
+    }
+    capacities_[index] = MemPool::SizeClass(size);
+    return true;
+}
+
+bool SpmmIterator::Init(const IterConfig &config)
+{
+    ProfileScope scope("iterator.Init");
+    const SpmmProblem &problem = session_.GetProblem();
+    if (session_.GetDeviceBuffer(SPMM_BUF_B) == nullptr || problem.m != problem.k || problem.n <= 0) {
+        ERROR_LOG("Iteration needs a loaded square problem, got %ld x %ld, N = %ld", static_cast<long>(problem.m),
+            static_cast<long>(problem.k), static_cast<long>(problem.n));
+        return false;
+    }
+    DestroyExecutors();
+    problem_ = problem;
+    // 插桩版的计数区只对单次 launch 有意义；调度表、稠密行与 MIX 的窗口划分只写在 session 的 workspace 里
+    problem_.flags &= ~(BCSR_SPMM_FLAG_PROFILE | BCSR_SPMM_FLAG_SCHEDULE | BCSR_SPMM_FLAG_DENSE | BCSR_SPMM_FLAG_MIX);
+    problem_.denseWindows = 0;
+    problem_.mixWindows = 0;
+    config_ = config;
+    step_ = 0;
+    if (!Reserve(ITER_BUF_X0, problem_.BSize()) || !Reserve(ITER_BUF_X1, problem_.BSize()) ||
+        !Reserve(ITER_BUF_C, problem_.CSize()) || !Reserve(ITER_BUF_NORM, NORM_BYTES)) {
+        return false;
+    }
+    // X_0 为已加载的 B；未运行的 core 的范数槽位一直保持 0
+    if ((problem_.BSize() != 0 && aclrtMemcpy(buffers_[ITER_BUF_X0], capacities_[ITER_BUF_X0],
+        session_.GetDeviceBuffer(SPMM_BUF_B), problem_.BSize(), ACL_MEMCPY_DEVICE_TO_DEVICE) != ACL_SUCCESS) ||
+        aclrtMemset(buffers_[ITER_BUF_NORM], capacities_[ITER_BUF_NORM], 0, NORM_BYTES) != ACL_SUCCESS) {
+        ERROR_LOG("Initialize iteration buffers failed");
+        return false;
+    }
+    return BuildExecutors();
+}
+
+bool SpmmIterator::BuildExecutors()
+{
+    ProfileScope scope("iterator.BuildExecutors");
+    int64_t xShape[2] = {problem_.m, problem_.n};
+    int64_t normShape[1] = {SPMM_ITER_NORM_NUM};
+    uint64_t required = 0;
+    for (size_t p = 0; p < 2; ++p) {
+        void *x = buffers_[ITER_BUF_X0 + p];
+        void *xNext = buffers_[ITER_BUF_X0 + 1 - p];
+        void *devBuffers[SPMM_BUF_NUM] = {session_.GetDeviceBuffer(SPMM_BUF_ROW_PTR),
+                                          session_.GetDeviceBuffer(SPMM_BUF_COL),
+                                          session_.GetDeviceBuffer(SPMM_BUF_VAL), x, buffers_[ITER_BUF_C]};
+        uint64_t workspaceSize = 0;
+        if (!spmmTensors_[p].Create(problem_, devBuffers) ||
+            !spmmTensors_[p].GetWorkspaceSize(workspaceSize, spmmExecutors_[p])) {
+            return false;
+        }
+        required = std::max(required, workspaceSize);
+
+        aclTensor **tensors = epilogueTensors_[p];
+        tensors[0] = aclCreateTensor(xShape, 2, ACL_FLOAT, nullptr, 0, ACL_FORMAT_ND, xShape, 2, buffers_[ITER_BUF_C]);
+        tensors[1] = aclCreateTensor(xShape, 2, ACL_FLOAT16, nullptr, 0, ACL_FORMAT_ND, xShape, 2, x);
+        tensors[2] = aclCreateTensor(xShape, 2, ACL_FLOAT16, nullptr, 0, ACL_FORMAT_ND, xShape, 2, xNext);
+        tensors[3] = aclCreateTensor(normShape, 1, ACL_FLOAT, nullptr, 0, ACL_FORMAT_ND, normShape, 1,
+                                     buffers_[ITER_BUF_NORM]);
+        for (size_t i = 0; i < 4; ++i) {
+            if (tensors[i] == nullptr) {
+                ERROR_LOG("Create tensors for SpmmIterEpilogueCustom failed");
+                return false;
+            }
+        }
+        auto ret = aclnnSpmmIterEpilogueCustomGetWorkspaceSize(tensors[0], tensors[1], config_.scale, config_.norm,
+                                                               tensors[2], tensors[3], &workspaceSize,
+                                                               &epilogueExecutors_[p]);
+        if (ret != ACL_SUCCESS || epilogueExecutors_[p] == nullptr) {
+            ERROR_LOG("Get SpmmIterEpilogueCustom workspace failed. error code is %d", static_cast<int32_t>(ret));
+            epilogueExecutors_[p] = nullptr;
+            return false;
+        }
+        required = std::max(required, workspaceSize);
+        if (aclSetAclOpExecutorRepeatable(spmmExecutors_[p]) != ACL_SUCCESS ||
+            aclSetAclOpExecutorRepeatable(epilogueExecutors_[p]) != ACL_SUCCESS) {
+            ERROR_LOG("Set iteration executors repeatable failed");
+            return false;
+        }
+    }
+
+    // 同一 stream 上顺序执行，四个 executor 共用一块 workspace
+    workspaceSize_ = required;
+    if (required > workspaceCapacity_) {
+        MemPool::Device().Free(workspace_);
+        workspaceCapacity_ = 0;
+        workspace_ = MemPool::Device().Alloc(required);
+        if (workspace_ == nullptr) {
+            ERROR_LOG("Malloc iteration workspace failed, size %lu", static_cast<unsigned long>(required));
+            return false;
+        }
+        workspaceCapacity_ = MemPool::SizeClass(required);
+    }
+    return true;
+}
+
+void SpmmIterator::DestroyExecutors()
+{
+    for (size_t p = 0; p < 2; ++p) {
+        if (spmmExecutors_[p] != nullptr) {
+            (void)aclDestroyAclOpExecutor(spmmExecutors_[p]);
+            spmmExecutors_[p] = nullptr;
+        }
+        if (epilogueExecutors_[p] != nullptr) {
+            (void)aclDestroyAclOpExecutor(epilogueExecutors_[p]);
+            epilogueExecutors_[p] = nullptr;
+        }
+        spmmTensors_[p].Destroy();
+        for (aclTensor *&tensor : epilogueTensors_[p]) {
+            if (tensor != nullptr) {
+                (void)aclDestroyTensor(tensor);
+                tensor = nullptr;
+            }
+        }
+    }
+}
+
+bool SpmmIterator::EnqueueStep(int64_t index)
+{
+    aclrtStream stream = session_.GetStream();
+    size_t p = static_cast<size_t>(step_ % 2);
+    void *workspace = workspaceSize_ != 0 ? workspace_ : nullptr;
+    // cube kernel 默认原子累加到 C；直写模式与向量 kernel 自己写满 C，不需要清零
+    if (!problem_.DirectOutput() && problem_.CSize() != 0) {
+        DeviceProfileScope memsetScope("memset C", stream);
+        if (aclrtMemsetAsync(buffers_[ITER_BUF_C], capacities_[ITER_BUF_C], 0, problem_.CSize(), stream) !=
+            ACL_SUCCESS) {
+            ERROR_LOG("Memset output failed");
+            return false;
+        }
+    }
+    {
+        DeviceProfileScope kernelScope("BcsrSpmm kernel", stream);
+        auto ret = aclnnBcsrSpmmCustom(workspace, workspaceSize_, spmmExecutors_[p], stream);
+        if (ret != ACL_SUCCESS) {
+            ERROR_LOG("Execute BcsrSpmmCustom of step %ld failed. error code is %d", static_cast<long>(step_),
+                static_cast<int32_t>(ret));
+            return false;
+        }
+    }
+    {
+        DeviceProfileScope epilogueScope("IterEpilogue kernel", stream);
+        auto ret = aclnnSpmmIterEpilogueCustom(workspace, workspaceSize_, epilogueExecutors_[p], stream);
+        if (ret != ACL_SUCCESS) {
+            ERROR_LOG("Execute SpmmIterEpilogueCustom of step %ld failed. error code is %d",
+                static_cast<long>(step_), static_cast<int32_t>(ret));
+            return false;
+        }
+    }
+    // 范数槽位每步被覆盖，在 stream 上拷到历史区，结束后一次取回
+    if (config_.norm) {
+        void *dst = static_cast<char *>(buffers_[ITER_BUF_HISTORY]) + index * NORM_BYTES;
+        if (aclrtMemcpyAsync(dst, NORM_BYTES, buffers_[ITER_BUF_NORM], NORM_BYTES, ACL_MEMCPY_DEVICE_TO_DEVICE,
+            stream) != ACL_SUCCESS) {
+            ERROR_LOG("Copy norms of step %ld failed", static_cast<long>(step_));
+            return false;
+        }
+    }
+    ++step_;
+    return true;
+}
+
+bool SpmmIterator::Run(int64_t steps, std::vector<IterNorm> *norms)
+{
+    if (spmmExecutors_[0] == nullptr) {
+        ERROR_LOG("Iterate before Init");
+        return false;
+    }
+    if (steps <= 0) {
+        return true;
+    }
+    ProfileScope scope("iterator.Run");
+    if (config_.norm && !Reserve(ITER_BUF_HISTORY, static_cast<size_t>(steps) * NORM_BYTES)) {
+        return false;
+    }
+    for (int64_t i = 0; i < steps; ++i) {
+        if (!EnqueueStep(i)) {
+            return false;
+        }
+    }
+    if (!session_.Synchronize()) {
+        return false;
+    }
+    if (!config_.norm || norms == nullptr) {
+        return true;
+    }
+
+    std::vector<float> history(static_cast<size_t>(steps) * SPMM_ITER_NORM_NUM);
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (aclrtMemcpy(history.data(), history.size() * sizeof(float), buffers_[ITER_BUF_HISTORY],
+        history.size() * sizeof(float), kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy iteration norms failed");
+        return false;
+    }
+    for (int64_t i = 0; i < steps; ++i) {
+        const float *slots = history.data() + i * SPMM_ITER_NORM_NUM;
+        double newSum = 0.0;
+        double deltaSum = 0.0;
+        for (uint32_t core = 0; core < SPMM_ITER_MAX_CORES; ++core) {
+            newSum += slots[core * SPMM_ITER_NORM_SLOT + SPMM_ITER_NORM_NEW];
+            deltaSum += slots[core * SPMM_ITER_NORM_SLOT + SPMM_ITER_NORM_DELTA];
+        }
+        IterNorm norm;
+        norm.norm = std::sqrt(newSum);
+        norm.delta = std::sqrt(deltaSum);
+        norms->push_back(norm);
+    }
+    return true;
+}
+
+bool SpmmIterator::Download(void *x)
+{
+    if (spmmExecutors_[0] == nullptr) {
+        ERROR_LOG("Download before Init");
+        return false;
+    }
+    size_t size = GetXSize();
+    if (size == 0) {
+        return true;
+    }
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (aclrtMemcpy(x, size, buffers_[ITER_BUF_X0 + step_ % 2], size, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy iteration X failed");
+        return false;
+    }
+    return true;
+}
+
+int64_t SpmmIterator::GetStep() const
+{
+    return step_;
+}
+
+size_t SpmmIterator::GetXSize() const
+{
+    return problem_.BSize();
+}
@@ -0,0 +1,678 @@
+/**
+ * @file spmm_session.cpp
+ */
+#include "spmm_session.h"
+
+#include <algorithm>
+
+#include "aclnn_bcsr_spmm_custom.h"
+#include "bcsr_spmm_tune.h"
+#include "mem_pool.h"
+#include "profiler.h"
+#include "window_schedule.h"
+
+extern bool g_isDevice;
+
+namespace {
+size_t IndexTypeSize(aclDataType dataType)
+{
+    switch (dataType) {
+        case ACL_UINT16:
+            return sizeof(uint16_t);
+        case ACL_INT64:
+            return sizeof(int64_t);
+        default:
+            return sizeof(int32_t);
+    }
+}
+
+CpuIndexType ToCpuIndexType(aclDataType dataType)
+{
+    switch (dataType) {
+        case ACL_UINT16:
+            return CPU_INDEX_BLOCK_U16;
+        case ACL_INT64:
+            return CPU_INDEX_INT64;
+        default:
+            return CPU_INDEX_INT32;
+    }
+}
+} // namespace
+
+size_t SpmmProblem::RowPtrSize() const
+{
+    return static_cast<size_t>(windowNum + 1) * IndexTypeSize(rowPtrType);
+}
+
+size_t SpmmProblem::ColSize() const
+{
+    return static_cast<size_t>(blockNum) * IndexTypeSize(colType);
+}
+
+size_t SpmmProblem::ValSize() const
+{
+    return static_cast<size_t>(blockNum * BCSR_TILE_M * BCSR_TILE_K) * sizeof(aclFloat16);
+}
+
+size_t SpmmProblem::BSize() const
+{
+    return static_cast<size_t>(k * n) * sizeof(aclFloat16);
+}
+
+size_t SpmmProblem::CSize() const
+{
+    return static_cast<size_t>(m * n) * sizeof(float);
+}
+
+int64_t SpmmProblem::RowPtrAt(int64_t w) const
+{
+    if (rowPtrType == ACL_INT64) {
+        return static_cast<const int64_t *>(rowPtr)[w];
+    }
+    return static_cast<const int32_t *>(rowPtr)[w];
+}
+
+int64_t SpmmProblem::ColAt(int64_t blk) const
+{
+    switch (colType) {
+        case ACL_UINT16:
+            return static_cast<int64_t>(static_cast<const uint16_t *>(col)[blk]) * BCSR_TILE_K;
+        case ACL_INT64:
+            return static_cast<const int64_t *>(col)[blk];
+        default:
+            return static_cast<const int32_t *>(col)[blk];
+    }
+}
+
+int64_t SpmmProblem::WindowSignature() const
+{
+    if (rowPtrType == ACL_INT64) {
+        return BcsrSpmmWindowSignature(static_cast<const int64_t *>(rowPtr), windowNum);
+    }
+    return BcsrSpmmWindowSignature(static_cast<const int32_t *>(rowPtr), windowNum);
+}
+
+bool SpmmProblem::DirectOutput() const
+{
+    return (flags & BCSR_SPMM_FLAG_DIRECT_OUTPUT) != 0 || n < BCSR_SPMM_SMALL_N;
+}
+
+bool SpmmProblem::SameStructure(const SpmmProblem &other) const
+{
+    return m == other.m && k == other.k && n == other.n && windowNum == other.windowNum &&
+           blockNum == other.blockNum && rowPtrType == other.rowPtrType && colType == other.colType &&
+           flags == other.flags &&
+           signature == other.signature && tune == other.tune && denseWindows == other.denseWindows &&
+           mixWindows == other.mixWindows;
+}
+
+CpuSpmmArgs SpmmProblem::ToCpuArgs() const
+{
+    CpuSpmmArgs args;
+    args.m = m;
+    args.k = k;
+    args.n = n;
+    args.windowNum = windowNum;
+    args.rowPtr = rowPtr;
+    args.rowPtrType = ToCpuIndexType(rowPtrType);
+    args.col = col;
+    args.colType = ToCpuIndexType(colType);
+    args.val = static_cast<const uint16_t *>(val);
+    args.b = static_cast<const uint16_t *>(b);
+    return args;
+}
+
+std::string SpmmProblem::TuneKey() const
+{
+    return BcsrSpmmTuneKey(m, k, n, blockNum, signature);
+}
+
+size_t SpmmBufferSize(const SpmmProblem &problem, size_t index)
+{
+    switch (index) {
+        case SPMM_BUF_ROW_PTR:
+            return problem.RowPtrSize();
+        case SPMM_BUF_COL:
+            return problem.ColSize();
+        case SPMM_BUF_VAL:
+            return problem.ValSize();
+        case SPMM_BUF_B:
+            return problem.BSize();
+        case SPMM_BUF_C:
+            return problem.CSize();
+        default:
+            return 0;
+    }
+}
+
+const char *IndexTypeName(aclDataType dataType)
+{
+    switch (dataType) {
+        case ACL_UINT16:
+            return "uint16";
+        case ACL_INT64:
+            return "int64";
+        default:
+            return "int32";
+    }
+}
+
+bool SpmmTensors::Create(const SpmmProblem &problem, void *const *devBuffers)
+{
+    // 没有附加字段时保持 [M, K]
+    int64_t aShapeValue[BCSR_SPMM_SHAPE_NUM] = {problem.m, problem.k, problem.flags, problem.signature, problem.tune,
+                                                problem.denseWindows, problem.mixWindows};
+    bool extended = problem.flags != 0 || problem.signature != 0 || problem.tune != 0 || problem.denseWindows != 0 ||
+                    problem.mixWindows != 0;
+    aShape = aclCreateIntArray(aShapeValue, extended ? BCSR_SPMM_SHAPE_NUM : 2);
+    if (aShape == nullptr) {
+        ERROR_LOG("Create IntArray for a_shape failed");
+        return false;
+    }
+
+    int64_t rowPtrShape[1] = {problem.windowNum + 1};
+    int64_t colShape[1] = {problem.blockNum};
+    int64_t valShape[1] = {problem.blockNum * BCSR_TILE_M * BCSR_TILE_K};
+    int64_t bShape[2] = {problem.k, problem.n};
+    int64_t cShape[2] = {problem.m, problem.n};
+    const int64_t *shapes[SPMM_BUF_NUM] = {rowPtrShape, colShape, valShape, bShape, cShape};
+    const uint64_t dimNums[SPMM_BUF_NUM] = {1, 1, 1, 2, 2};
+    const aclDataType dataTypes[SPMM_BUF_NUM] = {problem.rowPtrType, problem.colType, ACL_FLOAT16, ACL_FLOAT16,
+                                                 ACL_FLOAT};
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        tensors[i] = aclCreateTensor(shapes[i], dimNums[i], dataTypes[i], nullptr, 0, ACL_FORMAT_ND, shapes[i],
+                                     dimNums[i], devBuffers[i]);
+        if (tensors[i] == nullptr) {
+            ERROR_LOG("Create Tensor for buffer[%zu] failed", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SpmmTensors::GetWorkspaceSize(uint64_t &workspaceSize, aclOpExecutor *&executor)
+{
+    executor = nullptr;
+    auto ret = aclnnBcsrSpmmCustomGetWorkspaceSize(aShape, tensors[SPMM_BUF_ROW_PTR], tensors[SPMM_BUF_COL],
+                                                   tensors[SPMM_BUF_VAL], tensors[SPMM_BUF_B], tensors[SPMM_BUF_C],
+                                                   &workspaceSize, &executor);
+    if (ret != ACL_SUCCESS || executor == nullptr) {
+        ERROR_LOG("Get Operator Workspace failed. error code is %d", static_cast<int32_t>(ret));
+        executor = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void SpmmTensors::Destroy()
+{
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        if (tensors[i] != nullptr) {
+            (void)aclDestroyTensor(tensors[i]);
+            tensors[i] = nullptr;
+        }
+    }
+    if (aShape != nullptr) {
+        (void)aclDestroyIntArray(aShape);
+        aShape = nullptr;
+    }
+}
+
+SpmmSession::SpmmSession()
+    : loaded_(false), stream_(nullptr), workspace_(nullptr), workspaceCapacity_(0), workspaceSize_(0),
+      executor_(nullptr), executorBuilds_(0)
+{
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        devBuffers_[i] = nullptr;
+        capacities_[i] = 0;
+    }
+}
+
+SpmmSession::~SpmmSession()
+{
+    DestroyExecutor();
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        MemPool::Device().Free(devBuffers_[i]);
+    }
+    MemPool::Device().Free(workspace_);
+    if (stream_ != nullptr) {
+        (void)aclrtDestroyStream(stream_);
+    }
+}
+
+bool SpmmSession::Init()
+{
+    if (stream_ != nullptr) {
+        return true;
+    }
+    if (aclrtCreateStream(&stream_) != ACL_SUCCESS) {
+        ERROR_LOG("Create stream failed");
+        return false;
+    }
+    return true;
+}
+
+bool SpmmSession::Reserve(size_t index, size_t size, bool &moved)
+{
+    // device buffers must not be empty even for matrices without blocks
+    size = size == 0 ? 32 : size;
+    if (size <= capacities_[index]) {
+        return true;
+    }
+    MemPool::Device().Free(devBuffers_[index]);
+    capacities_[index] = 0;
+    devBuffers_[index] = MemPool::Device().Alloc(size);
+    if (devBuffers_[index] == nullptr) {
+        ERROR_LOG("Malloc device memory for buffer[%zu] failed, size %zu", index, size);
+        return false;
+    }
+    capacities_[index] = MemPool::SizeClass(size);
+    moved = true;
+    return true;
+}
+
+bool SpmmSession::ReserveWorkspace(uint64_t size)
+{
+    if (size <= workspaceCapacity_) {
+        return true;
+    }
+    MemPool::Device().Free(workspace_);
+    workspaceCapacity_ = 0;
+    workspace_ = MemPool::Device().Alloc(size);
+    if (workspace_ == nullptr) {
+        ERROR_LOG("Malloc workspace failed, size %lu", static_cast<unsigned long>(size));
+        return false;
+    }
+    workspaceCapacity_ = MemPool::SizeClass(size);
+    return true;
+}
+
+bool SpmmSession::Upload(size_t index, const void *src, size_t size)
+{
+    if (size == 0) {
+        return true;
+    }
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    if (aclrtMemcpy(devBuffers_[index], capacities_[index], src, size, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy input buffer[%zu] failed", index);
+        return false;
+    }
+    return true;
+}
+
+bool SpmmSession::Load(const SpmmProblem &problem)
+{
+    ProfileScope scope("session.Load");
+    if (stream_ == nullptr && !Init()) {
+        return false;
+    }
+    // 上一次异步启动的核函数可能仍在读写这些 buffer，释放或覆盖前先等它结束
+    if (!Synchronize()) {
+        loaded_ = false;
+        return false;
+    }
+
+    bool moved = false;
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        if (!Reserve(i, SpmmBufferSize(problem, i), moved)) {
+            loaded_ = false;
+            return false;
+        }
+    }
+
+    const void *inputs[SPMM_BUF_C] = {problem.rowPtr, problem.col, problem.val, problem.b};
+    {
+        ProfileScope uploadScope("session.Upload");
+        for (size_t i = 0; i < SPMM_BUF_C; ++i) {
+            if (!Upload(i, inputs[i], SpmmBufferSize(problem, i))) {
+                loaded_ = false;
+                return false;
+            }
+        }
+    }
+
+    return Bind(problem, moved);
+}
+
+bool SpmmSession::LoadCoo(const SpmmProblem &problem, const CooInput &coo)
+{
+    ProfileScope scope("session.LoadCoo");
+    if (stream_ == nullptr && !Init()) {
+        return false;
+    }
+    // 与 Load 相同，转换会覆盖 row_ptr / col / val
+    if (!Synchronize()) {
+        loaded_ = false;
+        return false;
+    }
+    if (coo.m != problem.m || coo.k != problem.k) {
+        ERROR_LOG("COO input is %ld x %ld, problem is %ld x %ld", static_cast<long>(coo.m), static_cast<long>(coo.k),
+            static_cast<long>(problem.m), static_cast<long>(problem.k));
+        loaded_ = false;
+        return false;
+    }
+    SpmmProblem next = problem;
+    // col 与 val 只在 device 上，host 无法排调度表、拼出稠密行，也无法估计窗口代价
+    next.flags &= ~(BCSR_SPMM_FLAG_SCHEDULE | BCSR_SPMM_FLAG_DENSE | BCSR_SPMM_FLAG_MIX);
+    next.windowNum = (problem.m + BCSR_TILE_M - 1) / BCSR_TILE_M;
+    next.blockNum = 0;
+    next.rowPtrType = ACL_INT32;
+    next.colType = ACL_INT32;
+    bool moved = false;
+    const size_t fixed[] = {SPMM_BUF_ROW_PTR, SPMM_BUF_B, SPMM_BUF_C};
+    for (size_t index : fixed) {
+        if (!Reserve(index, SpmmBufferSize(next, index), moved)) {
+            loaded_ = false;
+            return false;
+        }
+    }
+    if (!converter_.Upload(coo) || !Upload(SPMM_BUF_B, problem.b, next.BSize())) {
+        loaded_ = false;
+        return false;
+    }
+
+    // 先按 col / val 现有容量转换，块数超出时扩容后再转一次
+    const size_t blockBytes = BCSR_TILE_M * BCSR_TILE_K * sizeof(aclFloat16);
+    int64_t capacity = static_cast<int64_t>(std::min(capacities_[SPMM_BUF_COL] / sizeof(int32_t),
+                                                     capacities_[SPMM_BUF_VAL] / blockBytes));
+    std::vector<int32_t> rowPtr;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!converter_.Convert(stream_, devBuffers_[SPMM_BUF_ROW_PTR], devBuffers_[SPMM_BUF_COL],
+                                devBuffers_[SPMM_BUF_VAL], capacity, rowPtr)) {
+            loaded_ = false;
+            return false;
+        }
+        next.blockNum = rowPtr.back();
+        if (next.blockNum <= capacity) {
+            break;
+        }
+        if (!Reserve(SPMM_BUF_COL, next.ColSize(), moved) || !Reserve(SPMM_BUF_VAL, next.ValSize(), moved)) {
+            loaded_ = false;
+            return false;
+        }
+        capacity = next.blockNum;
+    }
+    INFO_LOG("Converted %ld COO entries on the device: %zu bytes uploaded instead of %zu bytes of BCSR",
+        static_cast<long>(coo.nnz), converter_.GetUploadBytes(),
+        next.RowPtrSize() + next.ColSize() + next.ValSize());
+    next.rowPtr = rowPtr.data();
+    return Bind(next, moved);
+}
+
+bool SpmmSession::Bind(const SpmmProblem &problem, bool moved)
+{
+    // the executor captures tensor addresses and the tiling, keep it while both hold;
+    // the tiling also depends on the tuning entry picked by the window signature
+    SpmmProblem next = problem;
+    next.signature = problem.WindowSignature();
+    // 稠密窗口的数目决定 workspace 的大小，属于结构的一部分
+    densePlan_.Clear();
+    next.denseWindows = 0;
+    if ((problem.flags & BCSR_SPMM_FLAG_DENSE) != 0 && problem.n >= BCSR_SPMM_SMALL_N) {
+        if (!densePlan_.Build(problem)) {
+            loaded_ = false;
+            return false;
+        }
+        next.denseWindows = densePlan_.GetDenseNum();
+    }
+    // 向量核的窗口数同样决定 tiling；划分按 Load 时的 val 估计，RefreshValues 不重新划分
+    mixPlan_.Clear();
+    next.mixWindows = 0;
+    if ((problem.flags & BCSR_SPMM_FLAG_MIX) != 0 && problem.n >= BCSR_SPMM_SMALL_N) {
+        BcsrSpmmTuneConfig tune = (problem.flags & BCSR_SPMM_FLAG_TUNE) != 0 ? BcsrSpmmUnpackTune(problem.tune) :
+                                                                              BcsrSpmmTuneConfig();
+        if (!mixPlan_.Build(problem, densePlan_.GetMap(), tune.mmadN)) {
+            loaded_ = false;
+            return false;
+        }
+        next.mixWindows = mixPlan_.GetMixNum();
+        INFO_LOG("Mixed split: %ld of %ld windows on the vector cores, estimated cost %.4g -> %.4g",
+            static_cast<long>(next.mixWindows), static_cast<long>(problem.windowNum), mixPlan_.GetCubeOnlyCost(),
+            mixPlan_.GetSplitCost());
+    }
+    bool reuse = executor_ != nullptr && !moved && loaded_ && problem_.SameStructure(next);
+    problem_ = next;
+    problem_.rowPtr = problem_.col = problem_.val = problem_.b = nullptr;
+    loaded_ = true;
+    if (!reuse) {
+        DestroyExecutor();
+        if (!BuildExecutor()) {
+            loaded_ = false;
+            return false;
+        }
+    }
+    // 同一结构下 col 与 val 也可能变化，调度表与稠密行每次 Load 都重新写入
+    if (!UploadSchedule(problem) || !UploadDense(problem.val)) {
+        loaded_ = false;
+        return false;
+    }
+    return true;
+}
+
+bool SpmmSession::UploadSchedule(const SpmmProblem &problem)
+{
+    uint64_t scheduleBytes = BcsrSpmmScheduleBytes(problem_.flags, problem_.n, problem_.windowNum,
+                                                   problem_.mixWindows);
+    if (scheduleBytes == 0) {
+        return true;
+    }
+    ProfileScope scope("session.UploadSchedule");
+    if (workspaceSize_ < UserLayout().bytes) {
+        ERROR_LOG("Workspace of %lu bytes has no window schedule region", static_cast<unsigned long>(workspaceSize_));
+        return false;
+    }
+    std::vector<uint32_t> order;
+    if ((problem_.flags & BCSR_SPMM_FLAG_SCHEDULE) != 0) {
+        if (!BuildWindowSchedule(problem, order)) {
+            return false;
+        }
+    } else {
+        order.resize(static_cast<size_t>(problem_.windowNum));
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+    }
+    // MIX 模式下向量核的窗口排在表尾
+    if (BcsrSpmmMixActive(problem_.flags, problem_.n, problem_.mixWindows)) {
+        mixPlan_.Split(order);
+    }
+    char *region = UserWorkspace() + UserLayout().schedule;
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    if (aclrtMemcpy(region, scheduleBytes, order.data(), scheduleBytes, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy window schedule failed");
+        return false;
+    }
+    return true;
+}
+
+bool SpmmSession::UploadDense(const void *val)
+{
+    BcsrSpmmUserLayout layout = UserLayout();
+    if (!BcsrSpmmDenseActive(problem_.flags, problem_.n, problem_.denseWindows)) {
+        return true;
+    }
+    ProfileScope scope("session.UploadDense");
+    if (workspaceSize_ < layout.bytes) {
+        ERROR_LOG("Workspace of %lu bytes has no dense-row region", static_cast<unsigned long>(workspaceSize_));
+        return false;
+    }
+    std::vector<uint16_t> store;
+    densePlan_.Fill(val, store);
+    const std::vector<uint32_t> &map = densePlan_.GetMap();
+    char *user = UserWorkspace();
+    size_t mapBytes = map.size() * sizeof(uint32_t);
+    size_t storeBytes = store.size() * sizeof(uint16_t);
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    if (aclrtMemcpy(user + layout.denseMap, mapBytes, map.data(), mapBytes, kind) != ACL_SUCCESS ||
+        aclrtMemcpy(user + layout.denseStore, storeBytes, store.data(), storeBytes, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy dense windows failed");
+        return false;
+    }
+    return true;
+}
+
+BcsrSpmmUserLayout SpmmSession::UserLayout() const
+{
+    return BcsrSpmmUserWorkspaceLayout(problem_.flags, problem_.k, problem_.n, problem_.windowNum,
+                                       problem_.denseWindows, problem_.mixWindows);
+}
+
+char *SpmmSession::UserWorkspace() const
+{
+    return static_cast<char *>(workspace_) + workspaceSize_ - UserLayout().bytes;
+}
+
+bool SpmmSession::BuildExecutor()
+{
+    ProfileScope scope("session.BuildExecutor");
+    uint64_t workspaceSize = 0;
+    if (!tensors_.Create(problem_, devBuffers_) || !tensors_.GetWorkspaceSize(workspaceSize, executor_)) {
+        return false;
+    }
+    auto ret = aclSetAclOpExecutorRepeatable(executor_);
+    if (ret != ACL_SUCCESS) {
+        ERROR_LOG("Set executor repeatable failed. error code is %d", static_cast<int32_t>(ret));
+        return false;
+    }
+    ++executorBuilds_;
+    workspaceSize_ = workspaceSize;
+    return ReserveWorkspace(workspaceSize);
+}
+
+void SpmmSession::DestroyExecutor()
+{
+    if (executor_ != nullptr) {
+        (void)aclDestroyAclOpExecutor(executor_);
+        executor_ = nullptr;
+    }
+    tensors_.Destroy();
+}
+
+bool SpmmSession::Launch(aclrtEvent kernelStart)
+{
+    if (!loaded_ || executor_ == nullptr) {
+        ERROR_LOG("Launch before a problem was loaded");
+        return false;
+    }
+    ProfileScope scope("session.Launch");
+    // the kernel accumulates into C with atomic adds unless it writes C directly
+    if (problem_.CSize() != 0 && !problem_.DirectOutput()) {
+        DeviceProfileScope memsetScope("memset C", stream_);
+        if (aclrtMemsetAsync(devBuffers_[SPMM_BUF_C], capacities_[SPMM_BUF_C], 0, problem_.CSize(), stream_) !=
+            ACL_SUCCESS) {
+            ERROR_LOG("Memset output failed");
+            return false;
+        }
+    }
+    // 计数区在 workspace 末尾，先清零，未运行的 core 不会留下上一次的槽位
+    if ((problem_.flags & BCSR_SPMM_FLAG_PROFILE) != 0) {
+        if (workspaceSize_ < UserLayout().bytes) {
+            ERROR_LOG("Workspace of %lu bytes has no kernel profile region", static_cast<unsigned long>(workspaceSize_));
+            return false;
+        }
+        void *region = UserWorkspace();
+        if (aclrtMemsetAsync(region, BCSR_SPMM_PROFILE_BYTES, 0, BCSR_SPMM_PROFILE_BYTES, stream_) != ACL_SUCCESS) {
+            ERROR_LOG("Memset kernel profile region failed");
+            return false;
+        }
+    }
+    if (kernelStart != nullptr && aclrtRecordEvent(kernelStart, stream_) != ACL_SUCCESS) {
+        ERROR_LOG("Record kernel start event failed");
+        return false;
+    }
+    DeviceProfileScope kernelScope("BcsrSpmm kernel", stream_);
+    auto ret = aclnnBcsrSpmmCustom(workspaceSize_ != 0 ? workspace_ : nullptr, workspaceSize_, executor_, stream_);
+    if (ret != ACL_SUCCESS) {
+        ERROR_LOG("Execute Operator failed. error code is %d", static_cast<int32_t>(ret));
+        return false;
+    }
+    return true;
+}
+
+bool SpmmSession::Synchronize()
+{
+    auto ret = aclrtSynchronizeStreamWithTimeout(stream_, 5000);
+    if (ret != ACL_SUCCESS) {
+        ERROR_LOG("Synchronize stream failed. error code is %d", static_cast<int32_t>(ret));
+        return false;
+    }
+    return true;
+}
+
+bool SpmmSession::Run()
+{
+    ProfileScope scope("session.Run");
+    return Launch() && Synchronize();
+}
+
+bool SpmmSession::RefreshValues(const void *val)
+{
+    if (!loaded_ || executor_ == nullptr) {
+        ERROR_LOG("Refresh values before a problem was loaded");
+        return false;
+    }
+    ProfileScope scope("session.RefreshValues");
+    // 结构不变，executor 里的 tensor 地址仍然有效，只需覆盖 val 的内容；稠密行是 val 的副本，一并重写
+    return Synchronize() && Upload(SPMM_BUF_VAL, val, problem_.ValSize()) && UploadDense(val);
+}
+
+bool SpmmSession::ReadKernelProfile(std::vector<KernelCoreProfile> &cores)
+{
+    if (!loaded_ || (problem_.flags & BCSR_SPMM_FLAG_PROFILE) == 0 ||
+        workspaceSize_ < UserLayout().bytes) {
+        ERROR_LOG("Kernel profile read without a profiled problem");
+        return false;
+    }
+    std::vector<uint64_t> raw(BCSR_SPMM_PROFILE_BYTES / sizeof(uint64_t));
+    const void *region = UserWorkspace();
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (aclrtMemcpy(raw.data(), BCSR_SPMM_PROFILE_BYTES, region, BCSR_SPMM_PROFILE_BYTES, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy kernel profile region failed");
+        return false;
+    }
+    return ParseKernelProfile(raw.data(), cores);
+}
+
+bool SpmmSession::Download(void *c)
+{
+    if (!loaded_) {
+        ERROR_LOG("Download before a problem was loaded");
+        return false;
+    }
+    size_t size = problem_.CSize();
+    if (size == 0) {
+        return true;
+    }
+    ProfileScope scope("session.Download");
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (aclrtMemcpy(c, size, devBuffers_[SPMM_BUF_C], size, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy output failed");
+        return false;
+    }
+    return true;
+}
+
+const SpmmProblem &SpmmSession::GetProblem() const
+{
+    return problem_;
+}
+
+size_t SpmmSession::GetOutputSize() const
+{
+    return loaded_ ? problem_.CSize() : 0;
+}
+
+aclrtStream SpmmSession::GetStream() const
+{
+    return stream_;
+}
+
+void *SpmmSession::GetDeviceBuffer(size_t index) const
+{
+    return index < SPMM_BUF_NUM ? devBuffers_[index] : nullptr;
+}
+
+size_t SpmmSession::GetExecutorBuilds() const
+{
+    return executorBuilds_;
+}
@@ -0,0 +1,441 @@
+/**
+ * @file streaming_runner.cpp
+ */
+#include "streaming_runner.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "aclnn_bcsr_spmm_custom.h"
+#include "common.h"
+#include "mem_pool.h"
+#include "profiler.h"
+
+extern bool g_isDevice;
+
+namespace {
+// 与 PipelineRunner 一样，每段输入按 32B 对齐
+constexpr size_t STREAM_ALIGN = 32;
+
+size_t AlignUp(size_t size)
+{
+    return (size + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+}
+
+// hostIn 与 arena 中 row_ptr、col、val 的偏移，C 紧跟在 val 之后
+void ChunkOffsets(const SpmmProblem &chunk, size_t (&offsets)[SPMM_BUF_NUM])
+{
+    offsets[SPMM_BUF_ROW_PTR] = 0;
+    offsets[SPMM_BUF_COL] = AlignUp(chunk.RowPtrSize());
+    offsets[SPMM_BUF_VAL] = offsets[SPMM_BUF_COL] + AlignUp(chunk.ColSize());
+    offsets[SPMM_BUF_B] = 0;
+    offsets[SPMM_BUF_C] = offsets[SPMM_BUF_VAL] + AlignUp(chunk.ValSize());
+}
+} // namespace
+
+MappedFile::MappedFile() : data_(nullptr), size_(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Map(int fd, size_t size, bool writable)
+{
+    if (size != 0) {
+        void *data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            (void)close(fd);
+            return false;
+        }
+        data_ = data;
+    }
+    size_ = size;
+    // 映射建立后文件描述符可以关闭
+    (void)close(fd);
+    return true;
+}
+
+bool MappedFile::OpenRead(const std::string &path, size_t size)
+{
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        ERROR_LOG("Open file %s failed", path.c_str());
+        return false;
+    }
+    struct stat sBuf;
+    if (fstat(fd, &sBuf) != 0 || static_cast<size_t>(sBuf.st_size) < size) {
+        ERROR_LOG("File %s is smaller than the %zu bytes expected", path.c_str(), size);
+        (void)close(fd);
+        return false;
+    }
+    if (!Map(fd, size, false)) {
+        ERROR_LOG("Map file %s failed", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::Create(const std::string &path, size_t size)
+{
+    Close();
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        ERROR_LOG("Create file %s failed", path.c_str());
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ERROR_LOG("Resize file %s to %zu bytes failed", path.c_str(), size);
+        (void)close(fd);
+        return false;
+    }
+    if (!Map(fd, size, true)) {
+        ERROR_LOG("Map file %s failed", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr) {
+        (void)munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void *MappedFile::GetData() const
+{
+    return data_;
+}
+
+size_t MappedFile::GetSize() const
+{
+    return size_;
+}
+
+StreamingRunner::StreamingRunner(size_t budget) : budget_(budget), b_(nullptr), bCapacity_(0), peakBytes_(0)
+{
+}
+
+StreamingRunner::~StreamingRunner()
+{
+    (void)Flush();
+    for (Slot &slot : slots_) {
+        Release(slot);
+    }
+    MemPool::Device().Free(b_);
+}
+
+bool StreamingRunner::Init()
+{
+    for (Slot &slot : slots_) {
+        if (slot.stream == nullptr && aclrtCreateStream(&slot.stream) != ACL_SUCCESS) {
+            ERROR_LOG("Create stream failed");
+            return false;
+        }
+        if (slot.done == nullptr && aclrtCreateEvent(&slot.done) != ACL_SUCCESS) {
+            ERROR_LOG("Create event failed");
+            return false;
+        }
+    }
+    return true;
+}
+
+void StreamingRunner::Release(Slot &slot)
+{
+    slot.tensors.Destroy();
+    MemPool::Device().Free(slot.arena);
+    MemPool::Device().Free(slot.workspace);
+    MemPool::Host().Free(slot.hostIn);
+    MemPool::Host().Free(slot.hostOut);
+    slot.arena = slot.workspace = slot.hostIn = slot.hostOut = nullptr;
+    slot.arenaCapacity = slot.workspaceCapacity = slot.hostInCapacity = slot.hostOutCapacity = 0;
+    if (slot.done != nullptr) {
+        (void)aclrtDestroyEvent(slot.done);
+        slot.done = nullptr;
+    }
+    if (slot.stream != nullptr) {
+        (void)aclrtDestroyStream(slot.stream);
+        slot.stream = nullptr;
+    }
+}
+
+SpmmProblem StreamingRunner::ChunkProblem(const SpmmProblem &problem, const StreamChunk &chunk) const
+{
+    SpmmProblem sub = problem;
+    int64_t firstRow = chunk.firstWindow * BCSR_TILE_M;
+    sub.m = std::min(chunk.windowNum * BCSR_TILE_M, problem.m - firstRow);
+    sub.windowNum = chunk.windowNum;
+    sub.blockNum = chunk.blockNum;
+    // 分块执行不读回计数，不用插桩版 kernel；各块窗口不多，不排调度表、不展开稠密行，也不划分给向量核
+    sub.flags = problem.flags &
+                ~(BCSR_SPMM_FLAG_PROFILE | BCSR_SPMM_FLAG_SCHEDULE | BCSR_SPMM_FLAG_DENSE | BCSR_SPMM_FLAG_MIX);
+    sub.rowPtr = static_cast<const char *>(problem.rowPtr) + static_cast<size_t>(chunk.firstWindow) *
+                 (problem.RowPtrSize() / static_cast<size_t>(problem.windowNum + 1));
+    sub.col = static_cast<const char *>(problem.col) + static_cast<size_t>(chunk.firstBlock) *
+              (problem.blockNum == 0 ? 0 : problem.ColSize() / static_cast<size_t>(problem.blockNum));
+    sub.val = static_cast<const char *>(problem.val) + static_cast<size_t>(chunk.firstBlock) *
+              BCSR_TILE_M * BCSR_TILE_K * sizeof(aclFloat16);
+    return sub;
+}
+
+size_t StreamingRunner::ChunkBytes(const SpmmProblem &problem, int64_t windowNum, int64_t blockNum) const
+{
+    // 行数按整窗口估计，最后一个分块只会更小
+    SpmmProblem sub = problem;
+    sub.m = windowNum * BCSR_TILE_M;
+    sub.windowNum = windowNum;
+    sub.blockNum = blockNum;
+    size_t offsets[SPMM_BUF_NUM] = {};
+    ChunkOffsets(sub, offsets);
+    return MemPool::SizeClass(offsets[SPMM_BUF_C] + sub.CSize());
+}
+
+bool StreamingRunner::Plan(const SpmmProblem &problem)
+{
+    ProfileScope scope("stream.Plan");
+    chunks_.clear();
+    size_t bBytes = MemPool::SizeClass(problem.BSize());
+    if (bBytes >= budget_) {
+        ERROR_LOG("B needs %zu bytes on the device, more than the budget of %zu bytes", bBytes, budget_);
+        return false;
+    }
+    // 两个 slot 交替执行，各占 B 之外预算的一半
+    size_t slotBudget = (budget_ - bBytes) / 2;
+    int64_t window = 0;
+    while (window < problem.windowNum) {
+        int64_t first = problem.RowPtrAt(window);
+        int64_t end = window;
+        while (end < problem.windowNum &&
+               ChunkBytes(problem, end + 1 - window, problem.RowPtrAt(end + 1) - first) <= slotBudget) {
+            ++end;
+        }
+        if (end == window) {
+            ERROR_LOG("Row window %ld alone needs %zu bytes, more than the %zu bytes per slot",
+                static_cast<long>(window), ChunkBytes(problem, 1, problem.RowPtrAt(window + 1) - first), slotBudget);
+            chunks_.clear();
+            return false;
+        }
+        StreamChunk chunk;
+        chunk.firstWindow = window;
+        chunk.windowNum = end - window;
+        chunk.firstBlock = first;
+        chunk.blockNum = problem.RowPtrAt(end) - first;
+        chunk.deviceBytes = ChunkBytes(problem, chunk.windowNum, chunk.blockNum);
+        chunks_.push_back(chunk);
+        window = end;
+    }
+    return true;
+}
+
+void StreamingRunner::UpdatePeak()
+{
+    size_t bytes = bCapacity_;
+    for (const Slot &slot : slots_) {
+        bytes += slot.arenaCapacity + slot.workspaceCapacity;
+    }
+    peakBytes_ = std::max(peakBytes_, bytes);
+}
+
+bool StreamingRunner::Reserve(const SpmmProblem &problem)
+{
+    size_t arenaSize = 0;
+    for (const StreamChunk &chunk : chunks_) {
+        arenaSize = std::max(arenaSize, chunk.deviceBytes);
+    }
+    if (!MemPool::Device().Grow(b_, bCapacity_, std::max<size_t>(problem.BSize(), STREAM_ALIGN))) {
+        ERROR_LOG("Malloc device memory for B failed");
+        return false;
+    }
+    // 只有一个分块时第二个 slot 用不上
+    size_t slotNum = std::min<size_t>(chunks_.size(), 2);
+    for (size_t i = 0; i < slotNum; ++i) {
+        if (!MemPool::Device().Grow(slots_[i].arena, slots_[i].arenaCapacity, arenaSize)) {
+            ERROR_LOG("Malloc device memory for chunk slot %zu failed, size %zu", i, arenaSize);
+            return false;
+        }
+    }
+    UpdatePeak();
+
+    size_t bSize = problem.BSize();
+    aclrtMemcpyKind h2d = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    if (bSize != 0 && aclrtMemcpy(b_, bCapacity_, problem.b, bSize, h2d) != ACL_SUCCESS) {
+        ERROR_LOG("Copy B failed");
+        return false;
+    }
+    return true;
+}
+
+bool StreamingRunner::Enqueue(Slot &slot, const SpmmProblem &problem, const StreamChunk &chunk, void *c)
+{
+    ProfileScope scope("stream.Enqueue");
+    SpmmProblem sub = ChunkProblem(problem, chunk);
+    size_t offsets[SPMM_BUF_NUM] = {};
+    ChunkOffsets(sub, offsets);
+    size_t inSize = offsets[SPMM_BUF_C];
+    size_t cSize = sub.CSize();
+    if (!MemPool::Host().Grow(slot.hostIn, slot.hostInCapacity, inSize) ||
+        !MemPool::Host().Grow(slot.hostOut, slot.hostOutCapacity, std::max<size_t>(cSize, STREAM_ALIGN))) {
+        ERROR_LOG("Malloc pinned memory for chunk staging failed");
+        return false;
+    }
+
+    // row_ptr 减去分块首块号，kernel 看到的是一个独立的小问题
+    char *hostIn = static_cast<char *>(slot.hostIn);
+    void *rowPtr = hostIn + offsets[SPMM_BUF_ROW_PTR];
+    for (int64_t w = 0; w <= sub.windowNum; ++w) {
+        int64_t value = sub.RowPtrAt(w) - chunk.firstBlock;
+        if (sub.rowPtrType == ACL_INT64) {
+            static_cast<int64_t *>(rowPtr)[w] = value;
+        } else {
+            static_cast<int32_t *>(rowPtr)[w] = static_cast<int32_t>(value);
+        }
+    }
+    if (sub.ColSize() != 0) {
+        memcpy(hostIn + offsets[SPMM_BUF_COL], sub.col, sub.ColSize());
+        memcpy(hostIn + offsets[SPMM_BUF_VAL], sub.val, sub.ValSize());
+    }
+    sub.rowPtr = rowPtr;
+    sub.signature = sub.WindowSignature();
+
+    for (size_t i = 0; i < SPMM_BUF_NUM; ++i) {
+        slot.devBuffers[i] = static_cast<char *>(slot.arena) + offsets[i];
+    }
+    slot.devBuffers[SPMM_BUF_B] = b_;
+
+    // 三段输入在 hostIn 与 arena 中布局相同，一次拷贝上传
+    aclrtMemcpyKind h2d = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    {
+        DeviceProfileScope h2dScope("H2D", slot.stream);
+        if (aclrtMemcpyAsync(slot.arena, slot.arenaCapacity, slot.hostIn, inSize, h2d, slot.stream) !=
+            ACL_SUCCESS) {
+            ERROR_LOG("Copy chunk at window %ld failed", static_cast<long>(chunk.firstWindow));
+            return false;
+        }
+    }
+    // the kernel accumulates into C with atomic adds unless it writes C directly
+    if (!sub.DirectOutput() && cSize != 0) {
+        if (aclrtMemsetAsync(slot.devBuffers[SPMM_BUF_C], slot.arenaCapacity - offsets[SPMM_BUF_C], 0, cSize,
+                             slot.stream) != ACL_SUCCESS) {
+            ERROR_LOG("Memset output failed");
+            return false;
+        }
+    }
+
+    uint64_t workspaceSize = 0;
+    aclOpExecutor *executor = nullptr;
+    if (!slot.tensors.Create(sub, slot.devBuffers) || !slot.tensors.GetWorkspaceSize(workspaceSize, executor)) {
+        return false;
+    }
+    if (workspaceSize != 0) {
+        if (!MemPool::Device().Grow(slot.workspace, slot.workspaceCapacity, workspaceSize)) {
+            (void)aclDestroyAclOpExecutor(executor);
+            return false;
+        }
+        UpdatePeak();
+    }
+    {
+        DeviceProfileScope kernelScope("BcsrSpmm kernel", slot.stream);
+        auto ret = aclnnBcsrSpmmCustom(workspaceSize != 0 ? slot.workspace : nullptr, workspaceSize, executor,
+                                       slot.stream);
+        if (ret != ACL_SUCCESS) {
+            ERROR_LOG("Execute Operator failed. error code is %d", static_cast<int32_t>(ret));
+            (void)aclDestroyAclOpExecutor(executor);
+            return false;
+        }
+    }
+
+    aclrtMemcpyKind d2h = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (cSize != 0) {
+        DeviceProfileScope d2hScope("D2H", slot.stream);
+        if (aclrtMemcpyAsync(slot.hostOut, slot.hostOutCapacity, slot.devBuffers[SPMM_BUF_C], cSize, d2h,
+                             slot.stream) != ACL_SUCCESS) {
+            ERROR_LOG("Copy output failed");
+            return false;
+        }
+    }
+    if (aclrtRecordEvent(slot.done, slot.stream) != ACL_SUCCESS) {
+        ERROR_LOG("Record event failed");
+        return false;
+    }
+    slot.busy = true;
+    slot.pendingOut = static_cast<char *>(c) + static_cast<size_t>(chunk.firstWindow * BCSR_TILE_M * problem.n) *
+                      sizeof(float);
+    slot.pendingSize = cSize;
+    return true;
+}
+
+bool StreamingRunner::Complete(Slot &slot)
+{
+    ProfileScope scope("stream.Complete");
+    slot.busy = false;
+    if (aclrtSynchronizeEvent(slot.done) != ACL_SUCCESS) {
+        ERROR_LOG("Synchronize event failed");
+        slot.tensors.Destroy();
+        return false;
+    }
+    slot.tensors.Destroy();
+    // 写入映射的输出文件时由页缓存写回磁盘
+    if (slot.pendingSize != 0) {
+        memcpy(slot.pendingOut, slot.hostOut, slot.pendingSize);
+    }
+    return true;
+}
+
+bool StreamingRunner::Flush()
+{
+    bool result = true;
+    for (Slot &slot : slots_) {
+        if (slot.busy && !Complete(slot)) {
+            result = false;
+        }
+    }
+    return result;
+}
+
+bool StreamingRunner::Run(const SpmmProblem &problem, void *c)
+{
+    ProfileScope scope("stream.Run");
+    if (chunks_.empty() && problem.windowNum != 0) {
+        ERROR_LOG("Streaming run without a plan");
+        return false;
+    }
+    if (!Reserve(problem)) {
+        return false;
+    }
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        Slot &slot = slots_[i % 2];
+        if (slot.busy && !Complete(slot)) {
+            (void)Flush();
+            return false;
+        }
+        if (!Enqueue(slot, problem, chunks_[i], c)) {
+            // 失败的分块不标记 busy，Flush 不会等它；先等已排入的拷贝结束再复用或释放 arena
+            (void)aclrtSynchronizeStream(slot.stream);
+            slot.tensors.Destroy();
+            (void)Flush();
+            return false;
+        }
+    }
+    return Flush();
+}
+
+const std::vector<StreamChunk> &StreamingRunner::GetChunks() const
+{
+    return chunks_;
+}
+
+size_t StreamingRunner::GetPeakBytes() const
+{
+    return peakBytes_;
+}
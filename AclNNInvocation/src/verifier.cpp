@@ -0,0 +1,427 @@
+/**
+ * @file verifier.cpp
+ */
+#include "verifier.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "common.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VERIFIER_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define VERIFIER_NEON 1
+#endif
+
+namespace {
+// 每个任务 64K 个元素（256 KB），线程间按原子计数领取
+constexpr size_t CHUNK = 1 << 16;
+constexpr int64_t WINDOW_ROWS = 16;
+
+/**
+ * Mismatches found while scanning one chunk
+ */
+struct ScanSink {
+    size_t mismatches = 0;
+    size_t maxExamples = 0;
+    std::vector<size_t> *examples = nullptr;
+    size_t *windows = nullptr;     // per-thread histogram, nullptr when disabled
+    size_t windowSize = 1;         // elements per row window
+
+    void Mismatch(size_t index)
+    {
+        ++mismatches;
+        if (examples->size() < maxExamples) {
+            examples->push_back(index);
+        }
+        if (windows != nullptr) {
+            ++windows[index / windowSize];
+        }
+    }
+};
+
+/**
+ * Scan [begin, end): report mismatches to the sink and return the largest
+ * abs / rel error. Every kernel evaluates isclose in float32 exactly like
+ * numpy, |out - ref| <= atol + rtol * |ref| without contraction.
+ */
+using ScanFunc = void (*)(const float *out, const float *ref, size_t begin, size_t end, float rtol, float atol,
+    ScanSink &sink, float &maxAbs, float &maxRel);
+
+void ScanScalar(const float *out, const float *ref, size_t begin, size_t end, float rtol, float atol,
+    ScanSink &sink, float &maxAbs, float &maxRel)
+{
+    for (size_t i = begin; i < end; ++i) {
+        float o = out[i];
+        float g = ref[i];
+        float ag = std::fabs(g);
+        float d = std::fabs(o - g);
+        bool close = d <= atol + rtol * ag || o == g || (std::isnan(o) && std::isnan(g));
+        if (!close) {
+            sink.Mismatch(i);
+        }
+        // NaN 的比较恒为 false，不会更新最大值
+        if (d > maxAbs) {
+            maxAbs = d;
+        }
+        if (ag != 0.0f) {
+            float rel = d / ag;
+            if (rel > maxRel) {
+                maxRel = rel;
+            }
+        }
+    }
+}
+
+#ifdef VERIFIER_X86
+__attribute__((target("avx2"))) void ScanAvx2(const float *out, const float *ref, size_t begin, size_t end,
+    float rtol, float atol, ScanSink &sink, float &maxAbs, float &maxRel)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 vrtol = _mm256_set1_ps(rtol);
+    const __m256 vatol = _mm256_set1_ps(atol);
+    __m256 vmaxAbs = _mm256_set1_ps(maxAbs);
+    __m256 vmaxRel = _mm256_set1_ps(maxRel);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 o = _mm256_loadu_ps(out + i);
+        __m256 g = _mm256_loadu_ps(ref + i);
+        __m256 ag = _mm256_and_ps(g, absMask);
+        __m256 d = _mm256_and_ps(_mm256_sub_ps(o, g), absMask);
+        __m256 tol = _mm256_add_ps(vatol, _mm256_mul_ps(vrtol, ag));
+        __m256 close = _mm256_or_ps(_mm256_cmp_ps(d, tol, _CMP_LE_OQ), _mm256_cmp_ps(o, g, _CMP_EQ_OQ));
+        close = _mm256_or_ps(close,
+            _mm256_and_ps(_mm256_cmp_ps(o, o, _CMP_UNORD_Q), _mm256_cmp_ps(g, g, _CMP_UNORD_Q)));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_ps(close)) & 0xffu;
+        while (mask != 0) {
+            sink.Mismatch(i + static_cast<size_t>(__builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+        // 任一操作数为 NaN 时 max_ps 返回第二个操作数，与标量的 > 比较一致
+        vmaxAbs = _mm256_max_ps(d, vmaxAbs);
+        __m256 rel = _mm256_and_ps(_mm256_div_ps(d, ag), _mm256_cmp_ps(ag, zero, _CMP_NEQ_OQ));
+        vmaxRel = _mm256_max_ps(rel, vmaxRel);
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, vmaxAbs);
+    maxAbs = *std::max_element(lanes, lanes + 8);
+    _mm256_storeu_ps(lanes, vmaxRel);
+    maxRel = *std::max_element(lanes, lanes + 8);
+    ScanScalar(out, ref, i, end, rtol, atol, sink, maxAbs, maxRel);
+}
+#endif
+
+#ifdef VERIFIER_NEON
+void ScanNeon(const float *out, const float *ref, size_t begin, size_t end, float rtol, float atol,
+    ScanSink &sink, float &maxAbs, float &maxRel)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t vrtol = vdupq_n_f32(rtol);
+    const float32x4_t vatol = vdupq_n_f32(atol);
+    float32x4_t vmaxAbs = vdupq_n_f32(maxAbs);
+    float32x4_t vmaxRel = vdupq_n_f32(maxRel);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        float32x4_t o = vld1q_f32(out + i);
+        float32x4_t g = vld1q_f32(ref + i);
+        float32x4_t ag = vabsq_f32(g);
+        float32x4_t d = vabdq_f32(o, g);
+        float32x4_t tol = vaddq_f32(vatol, vmulq_f32(vrtol, ag));
+        uint32x4_t close = vorrq_u32(vcleq_f32(d, tol), vceqq_f32(o, g));
+        close = vorrq_u32(close, vmvnq_u32(vorrq_u32(vceqq_f32(o, o), vceqq_f32(g, g))));
+        if (vminvq_u32(close) == 0) {
+            uint32_t lanes[4];
+            vst1q_u32(lanes, close);
+            for (size_t lane = 0; lane < 4; ++lane) {
+                if (lanes[lane] == 0) {
+                    sink.Mismatch(i + lane);
+                }
+            }
+        }
+        // vmaxq 会传播 NaN，改用比较 + 选择保持与标量一致
+        vmaxAbs = vbslq_f32(vcgtq_f32(d, vmaxAbs), d, vmaxAbs);
+        float32x4_t rel = vbslq_f32(vceqq_f32(ag, zero), zero, vdivq_f32(d, ag));
+        vmaxRel = vbslq_f32(vcgtq_f32(rel, vmaxRel), rel, vmaxRel);
+    }
+    maxAbs = vmaxvq_f32(vmaxAbs);
+    maxRel = vmaxvq_f32(vmaxRel);
+    ScanScalar(out, ref, i, end, rtol, atol, sink, maxAbs, maxRel);
+}
+#endif
+
+struct ScanOps {
+    const char *name;
+    ScanFunc scan;
+};
+
+const ScanOps &SelectScan()
+{
+#ifdef VERIFIER_X86
+    static const ScanOps AVX2_OPS = {"avx2", ScanAvx2};
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return AVX2_OPS;
+    }
+#endif
+#ifdef VERIFIER_NEON
+    static const ScanOps NEON_OPS = {"neon", ScanNeon};
+    return NEON_OPS;
+#endif
+    static const ScanOps SCALAR_OPS = {"scalar", ScanScalar};
+    return SCALAR_OPS;
+}
+
+const ScanOps &Scan()
+{
+    static const ScanOps &ops = SelectScan();
+    return ops;
+}
+
+// 块内第一个取得最大误差的元素，只在线程内最大值被刷新时调用
+size_t FindError(const float *out, const float *ref, size_t begin, size_t end, float value, bool relative)
+{
+    for (size_t i = begin; i < end; ++i) {
+        float ag = std::fabs(ref[i]);
+        float d = std::fabs(out[i] - ref[i]);
+        if (relative ? (ag != 0.0f && d / ag == value) : d == value) {
+            return i;
+        }
+    }
+    return begin;
+}
+
+struct WorkerState {
+    size_t mismatches = 0;
+    float maxAbs = 0.0f;
+    size_t maxAbsIndex = 0;
+    float maxRel = 0.0f;
+    size_t maxRelIndex = 0;
+    std::vector<size_t> windows;
+};
+
+// 取较大值，相等时取较小下标，结果与线程数无关
+void MergeMax(float value, size_t index, float &best, size_t &bestIndex)
+{
+    if (value > best || (value == best && value > 0.0f && index < bestIndex)) {
+        best = value;
+        bestIndex = index;
+    }
+}
+
+/**
+ * Read-only mapping of a whole file
+ */
+class MappedFile {
+public:
+    ~MappedFile()
+    {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool Open(const std::string &path)
+    {
+        fd_ = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd_ < 0 || fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ERROR_LOG("Open file failed. path = %s", path.c_str());
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ == 0) {
+            return true;
+        }
+        void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data == MAP_FAILED) {
+            ERROR_LOG("mmap %s failed", path.c_str());
+            return false;
+        }
+        data_ = data;
+        (void)madvise(data_, size_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    const float *Floats() const
+    {
+        return static_cast<const float *>(data_);
+    }
+
+    size_t Size() const
+    {
+        return size_;
+    }
+
+private:
+    int fd_ = -1;
+    void *data_ = nullptr;
+    size_t size_ = 0;
+};
+} // namespace
+
+Verifier::Verifier(const VerifyConfig &config) : config_(config)
+{
+    if (config_.threadNum == 0) {
+        config_.threadNum = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+const char *Verifier::GetIsaName()
+{
+    return Scan().name;
+}
+
+bool Verifier::Compare(const float *output, const float *golden, size_t count, VerifyReport &report) const
+{
+    report = VerifyReport();
+    if (count == 0 || output == nullptr || golden == nullptr) {
+        ERROR_LOG("Nothing to verify");
+        return false;
+    }
+    report.count = count;
+
+    size_t windowSize = 0;
+    size_t windowNum = 0;
+    if (config_.n > 0) {
+        windowSize = static_cast<size_t>(config_.n * WINDOW_ROWS);
+        windowNum = (count + windowSize - 1) / windowSize;
+    }
+    size_t chunkNum = (count + CHUNK - 1) / CHUNK;
+    size_t workerNum = std::min(config_.threadNum, chunkNum);
+    std::vector<WorkerState> states(workerNum);
+    std::vector<std::vector<size_t>> chunkExamples(chunkNum);
+    std::atomic<size_t> nextChunk(0);
+    ScanFunc scan = Scan().scan;
+
+    auto work = [&](size_t worker) {
+        WorkerState &state = states[worker];
+        state.windows.assign(windowNum, 0);
+        for (size_t chunk = nextChunk++; chunk < chunkNum; chunk = nextChunk++) {
+            size_t begin = chunk * CHUNK;
+            size_t end = std::min(count, begin + CHUNK);
+            ScanSink sink;
+            sink.maxExamples = config_.maxExamples;
+            sink.examples = &chunkExamples[chunk];
+            sink.windows = windowNum == 0 ? nullptr : state.windows.data();
+            sink.windowSize = std::max<size_t>(windowSize, 1);
+            float maxAbs = 0.0f;
+            float maxRel = 0.0f;
+            scan(output, golden, begin, end, config_.rtol, config_.atol, sink, maxAbs, maxRel);
+            state.mismatches += sink.mismatches;
+            // 每个线程领取的块号递增，严格大于即保留最早的下标
+            if (maxAbs > state.maxAbs) {
+                state.maxAbs = maxAbs;
+                state.maxAbsIndex = FindError(output, golden, begin, end, maxAbs, false);
+            }
+            if (maxRel > state.maxRel) {
+                state.maxRel = maxRel;
+                state.maxRelIndex = FindError(output, golden, begin, end, maxRel, true);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workerNum - 1);
+    for (size_t i = 1; i < workerNum; ++i) {
+        threads.emplace_back(work, i);
+    }
+    work(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    report.windowMismatches.assign(windowNum, 0);
+    for (const WorkerState &state : states) {
+        report.mismatches += state.mismatches;
+        MergeMax(state.maxAbs, state.maxAbsIndex, report.maxAbsError, report.maxAbsIndex);
+        MergeMax(state.maxRel, state.maxRelIndex, report.maxRelError, report.maxRelIndex);
+        for (size_t w = 0; w < windowNum; ++w) {
+            report.windowMismatches[w] += state.windows[w];
+        }
+    }
+    for (const std::vector<size_t> &examples : chunkExamples) {
+        for (size_t index : examples) {
+            if (report.examples.size() >= config_.maxExamples) {
+                break;
+            }
+            VerifyMismatch mismatch;
+            mismatch.index = index;
+            mismatch.expected = golden[index];
+            mismatch.actual = output[index];
+            report.examples.push_back(mismatch);
+        }
+    }
+    report.errorRatio = static_cast<double>(report.mismatches) / static_cast<double>(count);
+    report.passed = report.errorRatio <= config_.errorTol;
+    return true;
+}
+
+bool Verifier::CompareFiles(const std::string &outputPath, const std::string &goldenPath,
+    VerifyReport &report) const
+{
+    MappedFile output;
+    MappedFile golden;
+    if (!output.Open(outputPath) || !golden.Open(goldenPath)) {
+        return false;
+    }
+    if (output.Size() != golden.Size() || output.Size() % sizeof(float) != 0) {
+        ERROR_LOG("Output %s has %zu bytes, golden %s has %zu bytes", outputPath.c_str(), output.Size(),
+            goldenPath.c_str(), golden.Size());
+        return false;
+    }
+    return Compare(output.Floats(), golden.Floats(), output.Size() / sizeof(float), report);
+}
+
+void Verifier::Print(const VerifyReport &report) const
+{
+    for (const VerifyMismatch &mismatch : report.examples) {
+        float rdiff = mismatch.expected == 0.0f ? std::numeric_limits<float>::infinity() :
+            std::fabs(mismatch.actual - mismatch.expected) / std::fabs(mismatch.expected);
+        INFO_LOG("[%06zu] expected: %-.9f, actual: %-.9f, rdiff: %-.6f", mismatch.index, mismatch.expected,
+            mismatch.actual, rdiff);
+    }
+    if (report.mismatches > report.examples.size()) {
+        INFO_LOG("... %zu more mismatches not shown", report.mismatches - report.examples.size());
+    }
+    INFO_LOG("mismatches: %zu / %zu, max abs error: %.6g at [%zu], max rel error: %.6g at [%zu]", report.mismatches,
+        report.count, report.maxAbsError, report.maxAbsIndex, report.maxRelError, report.maxRelIndex);
+
+    // 误差集中的行窗口，按失配数降序列出前 10 个
+    std::vector<size_t> windows;
+    for (size_t w = 0; w < report.windowMismatches.size(); ++w) {
+        if (report.windowMismatches[w] != 0) {
+            windows.push_back(w);
+        }
+    }
+    if (!windows.empty()) {
+        std::stable_sort(windows.begin(), windows.end(), [&report](size_t a, size_t b) {
+            return report.windowMismatches[a] > report.windowMismatches[b];
+        });
+        INFO_LOG("mismatches in %zu of %zu row windows, worst:", windows.size(), report.windowMismatches.size());
+        for (size_t i = 0; i < std::min<size_t>(windows.size(), 10); ++i) {
+            size_t w = windows[i];
+            INFO_LOG("  window %zu (rows %zu-%zu): %zu", w, w * WINDOW_ROWS, (w + 1) * WINDOW_ROWS - 1,
+                report.windowMismatches[w]);
+        }
+    }
+    INFO_LOG("error ratio: %.4f, tolerance: %.4f", report.errorRatio, config_.errorTol);
+    if (report.passed) {
+        INFO_LOG("test pass");
+    } else {
+        ERROR_LOG("result error");
+    }
+}
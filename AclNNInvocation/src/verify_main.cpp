@@ -0,0 +1,41 @@
+/**
+ * @file verify_main.cpp
+ *
+ * verify_result <output.bin> <golden.bin> [--n=N] [--examples=E] [--threads=T]
+ *               [--rtol=R] [--atol=A] [--error-tol=E]
+ * Drop-in replacement for scripts/verify_result.py, exit code 0 on pass.
+ */
+#include <algorithm>
+
+#include "common.h"
+#include "options.h"
+#include "verifier.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output.bin> <golden.bin> [--n=N] [--examples=E] [--threads=T]"
+                  << " [--rtol=R] [--atol=A] [--error-tol=E]" << std::endl;
+        return FAILED;
+    }
+    Options options;
+    if (!options.Parse(argc, argv, 3)) {
+        return FAILED;
+    }
+
+    VerifyConfig config;
+    config.rtol = static_cast<float>(options.GetDouble("rtol", config.rtol));
+    config.atol = static_cast<float>(options.GetDouble("atol", config.atol));
+    config.errorTol = options.GetDouble("error-tol", config.errorTol);
+    config.n = options.GetInt("n", 0);
+    config.maxExamples = static_cast<size_t>(std::max<int64_t>(options.GetInt("examples", 100), 0));
+    config.threadNum = static_cast<size_t>(std::max<int64_t>(options.GetInt("threads", 0), 0));
+
+    Verifier verifier(config);
+    VerifyReport report;
+    if (!verifier.CompareFiles(argv[1], argv[2], report)) {
+        return FAILED;
+    }
+    verifier.Print(report);
+    return report.passed ? SUCCESS : FAILED;
+}
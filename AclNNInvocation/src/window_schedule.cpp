@@ -0,0 +1,47 @@
+/**
+ * @file window_schedule.cpp
+ */
+#include "window_schedule.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "common.h"
+
+bool BuildWindowSchedule(const SpmmProblem &problem, std::vector<uint32_t> &order)
+{
+    order.clear();
+    if (problem.windowNum > static_cast<int64_t>(std::numeric_limits<uint32_t>::max())) {
+        ERROR_LOG("Window schedule supports at most %u windows, got %ld", std::numeric_limits<uint32_t>::max(),
+            static_cast<long>(problem.windowNum));
+        return false;
+    }
+    if (problem.windowNum > 0 && (problem.rowPtr == nullptr || (problem.blockNum > 0 && problem.col == nullptr))) {
+        ERROR_LOG("Window schedule needs the host row_ptr and col");
+        return false;
+    }
+
+    // 键为窗口内块起始列的均值，空窗口排在最后
+    std::vector<double> key(static_cast<size_t>(problem.windowNum));
+    for (int64_t w = 0; w < problem.windowNum; ++w) {
+        int64_t first = problem.RowPtrAt(w);
+        int64_t last = problem.RowPtrAt(w + 1);
+        if (first == last) {
+            key[w] = std::numeric_limits<double>::infinity();
+            continue;
+        }
+        double sum = 0.0;
+        for (int64_t blk = first; blk < last; ++blk) {
+            sum += static_cast<double>(problem.ColAt(blk));
+        }
+        key[w] = sum / static_cast<double>(last - first);
+    }
+
+    order.resize(static_cast<size_t>(problem.windowNum));
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    // 稳定排序，键相同的窗口保持原来的行序
+    std::stable_sort(order.begin(), order.end(), [&key](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+    return true;
+}
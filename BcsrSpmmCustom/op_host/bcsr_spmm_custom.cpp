@@ -2,8 +2,8 @@
 #include "bcsr_spmm_custom_tiling.h"
 #include "register/op_def_registry.h"
 #include "tiling/platform/platform_ascendc.h"
-
-constexpr uint32_t MAX_MMAD_N = 32;
+#include "bcsr_spmm_tune.h"
+#include "../op_kernel/bcsr_spmm_desc.h"
 
 namespace optiling {
 static ge::graphStatus TilingFunc(gert::TilingContext* context)
@@ -21,17 +21,63 @@ static ge::graphStatus TilingFunc(gert::TilingContext* context)
     // 备用实现
     // auto shape_b = context->GetInputTensor(4)->GetOriginShape();
     auto shape_c = context->GetOutputShape(0)->GetOriginShape();
-    int32_t M = shape_c.GetDim(0);
-    int32_t K = shape_b.GetDim(0);
-    int32_t N = shape_b.GetDim(1);
+    // M、K、N 各自须放得进 tiling 的 int32 字段；它们的乘积（块号 * 256、起始列 * N）在 kernel 中按 64 位计算
+    int64_t dimM = shape_c.GetDim(0);
+    int64_t dimK = shape_b.GetDim(0);
+    int64_t dimN = shape_b.GetDim(1);
+    if (dimM < 0 || dimM > INT32_MAX || dimK < 0 || dimK > INT32_MAX || dimN < 0 || dimN > INT32_MAX) {
+        printf("BcsrSpmmCustom Tiling: M=%ld, K=%ld, N=%ld exceed int32\n", static_cast<long>(dimM),
+            static_cast<long>(dimK), static_cast<long>(dimN));
+        return ge::GRAPH_FAILED;
+    }
+    int32_t M = static_cast<int32_t>(dimM);
+    int32_t K = static_cast<int32_t>(dimK);
+    int32_t N = static_cast<int32_t>(dimN);
 
     tiling.set_M(M);
     tiling.set_N(N);
     tiling.set_K(K);
 
+    // a_shape[2..6] 为可选的 flags、行窗口签名、调优参数、稠密窗口数与向量核窗口数
+    int64_t shapeNum = context->GetInputTensor(0)->GetShapeSize();
+    int64_t flags = shapeNum > BCSR_SPMM_SHAPE_FLAGS ? shape_a_addr[BCSR_SPMM_SHAPE_FLAGS] : 0;
+    int64_t signature = shapeNum > BCSR_SPMM_SHAPE_SIGNATURE ? shape_a_addr[BCSR_SPMM_SHAPE_SIGNATURE] : 0;
+    int64_t blockNum = context->GetInputShape(2)->GetOriginShape().GetShapeSize();
+
+    // 调优参数：autotuner 扫描时由 a_shape 显式给出，否则按稀疏签名查调优库
+    BcsrSpmmTuneConfig tune;
+    if ((flags & BCSR_SPMM_FLAG_TUNE) != 0 && shapeNum > BCSR_SPMM_SHAPE_TUNE) {
+        tune = BcsrSpmmUnpackTune(shape_a_addr[BCSR_SPMM_SHAPE_TUNE]);
+    } else {
+        (void)BcsrSpmmLookupTune(BcsrSpmmTuneDbPath(), BcsrSpmmTuneKey(M, K, N, blockNum, signature), tune);
+    }
+    if (!BcsrSpmmTuneValid(tune)) {
+        printf("BcsrSpmmCustom Tiling: invalid tuning %s, using defaults\n", BcsrSpmmFormatTune(tune).c_str());
+        tune = BcsrSpmmTuneConfig();
+    }
+
     // totalLength 行窗口数
-    uint32_t totalLength = context->GetInputShape(1)->GetOriginShape().GetShapeSize() - 1;
-    uint32_t blockDim = ascendcPlatform.GetCoreNumAic();    // Cube core 数量
+    int64_t windowNum = context->GetInputShape(1)->GetOriginShape().GetShapeSize() - 1;
+    if (windowNum < 0 || windowNum > UINT32_MAX) {
+        printf("BcsrSpmmCustom Tiling: %ld row windows exceed uint32\n", static_cast<long>(windowNum));
+        return ge::GRAPH_FAILED;
+    }
+    uint32_t totalLength = static_cast<uint32_t>(windowNum);
+    // N 很小时 Cube 算力大半浪费在补零的列上，改用数量更多的 Vector core
+    bool smallN = N < BCSR_SPMM_SMALL_N;
+    // MIX 模式的窗口划分由 host 按每个窗口在两种核上的代价估计得出，这里只拿到向量核的窗口数；
+    // blockDim 是 cube core 数，每个 cube core 带两个向量核
+    int64_t mixNum = shapeNum > BCSR_SPMM_SHAPE_MIX ? shape_a_addr[BCSR_SPMM_SHAPE_MIX] : 0;
+    if (mixNum < 0 || mixNum > windowNum) {
+        printf("BcsrSpmmCustom Tiling: %ld vector windows out of %ld\n", static_cast<long>(mixNum),
+            static_cast<long>(windowNum));
+        return ge::GRAPH_FAILED;
+    }
+    bool mix = BcsrSpmmMixActive(flags, N, mixNum);
+    uint32_t blockDim = smallN ? ascendcPlatform.GetCoreNumAiv() : ascendcPlatform.GetCoreNumAic();
+    if (tune.coreNum != 0 && tune.coreNum < blockDim) {
+        blockDim = tune.coreNum;
+    }
     blockDim = blockDim > totalLength ? totalLength : blockDim;
     context->SetBlockDim(blockDim);
     // context->SetBlockDim(1);
@@ -48,14 +94,19 @@ static ge::graphStatus TilingFunc(gert::TilingContext* context)
     tiling.set_formerLength(formerLength);
     tiling.set_tailNum(tailNum);
     tiling.set_tailLength(tailLength);
+    // 调度表由 host 写在 workspace 中，小 N 的向量 kernel 不读取；MIX 模式下 cube 取表的前段
+    bool scheduled = ((flags & BCSR_SPMM_FLAG_SCHEDULE) != 0 || mix) && !smallN;
+    tiling.set_partition(scheduled ? BCSR_SPMM_PARTITION_SCHEDULED : tune.partition);
+    // 向量 kernel 本来就逐窗口覆盖写 C
+    tiling.set_directOutput((flags & BCSR_SPMM_FLAG_DIRECT_OUTPUT) != 0 || smallN ? 1 : 0);
 
-    printf("BcsrSpmmCustom Tiling: M=%d, K=%d, N=%d, totalLength=%d, blockDim=%d, formerNum=%d, formerLength=%d, tailNum=%d, tailLength=%d\n",
-        M, K, N, totalLength, blockDim, formerNum, formerLength, tailNum, tailLength
+    printf("BcsrSpmmCustom Tiling: M=%d, K=%d, N=%d, totalLength=%d, blockDim=%d, formerNum=%d, formerLength=%d, tailNum=%d, tailLength=%d, %s\n",
+        M, K, N, totalLength, blockDim, formerNum, formerLength, tailNum, tailLength, BcsrSpmmFormatTune(tune).c_str()
     );
 
     uint32_t alignNum = 32 / sizeof(uint16_t);
     // mmad相关参数计算
-    uint32_t mmadN = MAX_MMAD_N;
+    uint32_t mmadN = tune.mmadN;
     uint32_t mmadNum = (N + mmadN - 1) / mmadN;
     uint32_t lastMmadN = N - (mmadNum - 1) * mmadN;
     uint32_t lastMmadCubeBlockNum = (lastMmadN + alignNum - 1) / alignNum;
@@ -64,6 +115,46 @@ static ge::graphStatus TilingFunc(gert::TilingContext* context)
     tiling.set_lastMmadN(lastMmadN);
     tiling.set_lastMmadCubeBlockNum(lastMmadCubeBlockNum);
 
+    // B 面板缓存的槽位数由 L1 容量与面板大小决定，向量 kernel 不使用
+    uint32_t bCacheSlots = 0;
+    if ((flags & BCSR_SPMM_FLAG_B_CACHE) != 0 && !smallN) {
+        uint64_t l1Size = 0;
+        ascendcPlatform.GetCoreMemSize(platform_ascendc::CoreMemType::L1, l1Size);
+        bCacheSlots = BcsrSpmmBCacheSlots(l1Size, mmadN);
+    }
+    tiling.set_bCacheSlots(bCacheSlots);
+
+    // 稠密窗口由 host 按窗口填充率分类，只有数目经 a_shape 传入，用来确定 workspace 的大小；
+    // 窗口表与稠密行由 host 在每次 launch 前写入 user workspace
+    int64_t denseNum = shapeNum > BCSR_SPMM_SHAPE_DENSE ? shape_a_addr[BCSR_SPMM_SHAPE_DENSE] : 0;
+    if (denseNum < 0 || denseNum > windowNum) {
+        printf("BcsrSpmmCustom Tiling: %ld dense windows out of %ld\n", static_cast<long>(denseNum),
+            static_cast<long>(windowNum));
+        return ge::GRAPH_FAILED;
+    }
+    BcsrSpmmUserLayout layout = BcsrSpmmUserWorkspaceLayout(flags, K, N, windowNum, denseNum, mixNum);
+    bool dense = BcsrSpmmDenseActive(flags, N, denseNum);
+    uint32_t denseKTile = 0;
+    if (dense) {
+        uint64_t l0bSize = 0;
+        ascendcPlatform.GetCoreMemSize(platform_ascendc::CoreMemType::L0_B, l0bSize);
+        denseKTile = BcsrSpmmDenseKTile(l0bSize, mmadN, K);
+    }
+    tiling.set_denseNum(dense ? static_cast<uint32_t>(denseNum) : 0);
+    tiling.set_denseKTile(denseKTile);
+    tiling.set_denseMapOffset(layout.denseMap);
+    tiling.set_denseStoreOffset(layout.denseStore);
+
+    // 向量核的累加器与 B 行都放在 UB 中，N 按 UB 容量分段
+    uint32_t mixNTile = 0;
+    if (mix) {
+        uint64_t ubSize = 0;
+        ascendcPlatform.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
+        mixNTile = BcsrSpmmMixNTile(ubSize, N);
+    }
+    tiling.set_mixNum(mix ? static_cast<uint32_t>(mixNum) : 0);
+    tiling.set_mixNTile(mixNTile);
+
     // 处理K不对齐
     uint32_t lastKLength = K % alignNum;
     if (lastKLength == 0) {
@@ -71,10 +162,43 @@ static ge::graphStatus TilingFunc(gert::TilingContext* context)
     }
     tiling.set_lastKLength(lastKLength);
 
+    // col 索引编码决定 kernel 的解码方式
+    uint64_t tilingKey = BCSR_SPMM_TILING_KEY_COL_INT32;
+    auto colDesc = context->GetInputDesc(2);
+    if (colDesc != nullptr && colDesc->GetDataType() == ge::DT_UINT16) {
+        tilingKey = BCSR_SPMM_TILING_KEY_COL_UINT16;
+    } else if (colDesc != nullptr && colDesc->GetDataType() == ge::DT_INT64) {
+        tilingKey = BCSR_SPMM_TILING_KEY_COL_INT64;
+    }
+    // 块数超出 int32 时 row_ptr 须为 int64；int32 row_ptr 已由其数据类型保证不溢出
+    auto rowPtrDesc = context->GetInputDesc(1);
+    if (rowPtrDesc != nullptr && rowPtrDesc->GetDataType() == ge::DT_INT64) {
+        tilingKey += BCSR_SPMM_TILING_KEY_ROW_PTR_INT64;
+    } else if (blockNum > INT32_MAX) {
+        printf("BcsrSpmmCustom Tiling: %ld blocks need an int64 row_ptr\n", static_cast<long>(blockNum));
+        return ge::GRAPH_FAILED;
+    }
+
+    if (smallN) {
+        tilingKey += BCSR_SPMM_TILING_KEY_SMALL_N;
+    } else if (mix) {
+        tilingKey += BCSR_SPMM_TILING_KEY_MIX;
+    }
+
+    // 性能计数需要插桩版 kernel 和 workspace 中的计数区；MIX 模式下向量核的槽位排在 cube core 之后
+    bool profile = (flags & BCSR_SPMM_FLAG_PROFILE) != 0;
+    uint32_t profileSlots = mix ? blockDim * 3 : blockDim;
+    if (profile && profileSlots > BCSR_SPMM_PROFILE_MAX_CORES) {
+        printf("BcsrSpmmCustom Tiling: %d cores exceed %d profile slots\n", profileSlots, BCSR_SPMM_PROFILE_MAX_CORES);
+        return ge::GRAPH_FAILED;
+    }
+    context->SetTilingKey(profile ? tilingKey + BCSR_SPMM_TILING_KEY_PROFILE : tilingKey);
+
     tiling.SaveToBuffer(context->GetRawTilingData()->GetData(), context->GetRawTilingData()->GetCapacity());
     context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
     size_t *currentWorkspace = context->GetWorkspaceSizes(1);
-    currentWorkspace[0] = 0;
+    // user workspace 位于整个 workspace 的末尾，各区见 BcsrSpmmUserLayout
+    currentWorkspace[0] = layout.bytes != 0 ? ascendcPlatform.GetLibApiWorkSpaceSize() + layout.bytes : 0;
     return ge::GRAPH_SUCCESS;
 }
 }
@@ -116,29 +240,31 @@ public:
     {
         this->Input("a_shape")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT64})
-            .Format({ge::FORMAT_ND})
+            .DataType({ge::DT_INT64, ge::DT_INT64, ge::DT_INT64, ge::DT_INT64})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND})
             .ValueDepend(REQUIRED); // 声明 a_shape 输入为数据依赖输入
+        // row_ptr: int32，或块数超出 2^31 时的 int64
         this->Input("row_ptr")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND});
+            .DataType({ge::DT_INT32, ge::DT_INT32, ge::DT_INT64, ge::DT_INT64})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
+        // col: int32 / int64 起始列，或 uint16 块列号（起始列 / CUBE_BLOCK_K）
         this->Input("col")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_INT32})
-            .Format({ge::FORMAT_ND});
+            .DataType({ge::DT_INT32, ge::DT_UINT16, ge::DT_INT64, ge::DT_UINT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("val")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT16})
-            .Format({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT16, ge::DT_FLOAT16, ge::DT_FLOAT16, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Input("b")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT16})
-            .Format({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT16, ge::DT_FLOAT16, ge::DT_FLOAT16, ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
         this->Output("c")
             .ParamType(REQUIRED)
-            .DataType({ge::DT_FLOAT})
-            .Format({ge::FORMAT_ND});
+            .DataType({ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT, ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND, ge::FORMAT_ND});
 
         this->SetInferShape(ge::InferShape).SetInferDataType(ge::InferDataType);
 
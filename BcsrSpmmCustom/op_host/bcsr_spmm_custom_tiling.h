@@ -22,6 +22,21 @@ BEGIN_TILING_DATA_DEF(BcsrSpmmCustomTilingData)
   TILING_DATA_FIELD_DEF(uint32_t, formerLength);
   TILING_DATA_FIELD_DEF(uint32_t, tailNum);
   TILING_DATA_FIELD_DEF(uint32_t, tailLength);
+  // BCSR_SPMM_PARTITION_*，cyclic 时忽略 former / tail
+  TILING_DATA_FIELD_DEF(uint32_t, partition);
+  // 非 0 时 cube kernel 在 L0C 中累加整个窗口后覆盖写 C，空窗口写 0，不用原子加
+  TILING_DATA_FIELD_DEF(uint32_t, directOutput);
+  // L1 中 B 面板缓存的槽位数，0 为不缓存
+  TILING_DATA_FIELD_DEF(uint32_t, bCacheSlots);
+  // 稠密窗口数与一次 Mmad 的 K 长度，0 为不走稠密行路径
+  TILING_DATA_FIELD_DEF(uint32_t, denseNum);
+  TILING_DATA_FIELD_DEF(uint32_t, denseKTile);
+  // 稠密窗口表与稠密行相对 user workspace 起点的字节偏移
+  TILING_DATA_FIELD_DEF(uint64_t, denseMapOffset);
+  TILING_DATA_FIELD_DEF(uint64_t, denseStoreOffset);
+  // MIX 模式分给向量核的窗口数（调度表的最后 mixNum 项）与向量核一次累加的 N 列数，0 为不启动向量核
+  TILING_DATA_FIELD_DEF(uint32_t, mixNum);
+  TILING_DATA_FIELD_DEF(uint32_t, mixNTile);
 
   // 处理K不对齐
   TILING_DATA_FIELD_DEF(uint32_t, lastKLength);
@@ -0,0 +1,309 @@
+/**
+ * @file bcsr_spmm_tune.h
+ *
+ * Tuning database shared by TilingFunc and the host autotuner. A problem is
+ * keyed by its sparsity signature: M, K, N, the log2 bucket of the block count
+ * and a summary of the blocks-per-window distribution that the host computes
+ * from row_ptr and passes in a_shape. Each line of the database reads
+ *     <key> mmad_n=<16|32|64|128> cores=<n, 0 for all> partition=<contiguous|cyclic> [us=<t>] [sample=<name>]
+ * with '#' starting a comment; the last line of a key wins. TilingFunc reads
+ * the file named by BCSR_SPMM_TUNE_DB, or ../output/tune_db.txt when it is
+ * unset, the same default the autotuner writes to. Header only, so the host
+ * side can include it without linking op_host.
+ */
+#ifndef BCSR_SPMM_TUNE_H
+#define BCSR_SPMM_TUNE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../op_kernel/bcsr_spmm_desc.h"
+
+constexpr const char *BCSR_SPMM_TUNE_DB_ENV = "BCSR_SPMM_TUNE_DB";
+// 相对当前目录，与 autotuner 未指定 --tune-db 时写入的位置一致
+constexpr const char *BCSR_SPMM_TUNE_DB_DEFAULT = "../output/tune_db.txt";
+
+struct BcsrSpmmTuneConfig {
+    uint32_t mmadN = 32;        // 一次 Mmad 处理的 N 列数
+    uint32_t coreNum = 0;       // 0 表示全部 cube core
+    uint32_t partition = BCSR_SPMM_PARTITION_CONTIGUOUS;
+};
+
+// 0 -> 0, 1 -> 1, [2, 4) -> 2, [4, 8) -> 3 ...
+inline uint32_t BcsrSpmmLog2Bucket(uint64_t value)
+{
+    uint32_t bucket = 0;
+    while (value != 0) {
+        ++bucket;
+        value >>= 1;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Summary of the blocks-per-window distribution, one byte each: log2
+ *        bucket of the mean, log2 bucket of the max, coefficient of variation
+ *        in quarters, and sixteenths of empty windows
+ */
+template <typename T>
+inline int64_t BcsrSpmmWindowSignature(const T *rowPtr, int64_t windowNum)
+{
+    if (rowPtr == nullptr || windowNum <= 0) {
+        return 0;
+    }
+    double sum = 0.0;
+    double squareSum = 0.0;
+    uint64_t maxBlocks = 0;
+    int64_t empty = 0;
+    for (int64_t w = 0; w < windowNum; ++w) {
+        uint64_t blocks = static_cast<uint64_t>(rowPtr[w + 1] - rowPtr[w]);
+        sum += static_cast<double>(blocks);
+        squareSum += static_cast<double>(blocks) * static_cast<double>(blocks);
+        maxBlocks = std::max(maxBlocks, blocks);
+        empty += blocks == 0 ? 1 : 0;
+    }
+    double mean = sum / windowNum;
+    double variance = std::max(squareSum / windowNum - mean * mean, 0.0);
+    double cv = mean > 0.0 ? std::sqrt(variance) / mean : 0.0;
+    uint64_t meanBucket = BcsrSpmmLog2Bucket(static_cast<uint64_t>(mean + 0.5));
+    uint64_t maxBucket = BcsrSpmmLog2Bucket(maxBlocks);
+    uint64_t cvBucket = std::min<uint64_t>(static_cast<uint64_t>(cv * 4.0 + 0.5), 255);
+    uint64_t emptyBucket = static_cast<uint64_t>(empty * 16 / windowNum);
+    return static_cast<int64_t>(meanBucket | (maxBucket << 8) | (cvBucket << 16) | (emptyBucket << 24));
+}
+
+inline std::string BcsrSpmmTuneKey(int64_t m, int64_t k, int64_t n, int64_t blockNum, int64_t signature)
+{
+    std::ostringstream key;
+    key << "m" << m << "_k" << k << "_n" << n << "_b" << BcsrSpmmLog2Bucket(static_cast<uint64_t>(blockNum))
+        << "_w" << (signature & 0xff) << '.' << ((signature >> 8) & 0xff) << '.' << ((signature >> 16) & 0xff)
+        << '.' << ((signature >> 24) & 0xff);
+    return key.str();
+}
+
+inline int64_t BcsrSpmmPackTune(const BcsrSpmmTuneConfig &config)
+{
+    return static_cast<int64_t>(config.mmadN) | (static_cast<int64_t>(config.coreNum) << 16) |
+           (static_cast<int64_t>(config.partition) << 32);
+}
+
+inline BcsrSpmmTuneConfig BcsrSpmmUnpackTune(int64_t packed)
+{
+    BcsrSpmmTuneConfig config;
+    config.mmadN = static_cast<uint32_t>(packed & 0xffff);
+    config.coreNum = static_cast<uint32_t>((packed >> 16) & 0xffff);
+    config.partition = static_cast<uint32_t>((packed >> 32) & 0xff);
+    return config;
+}
+
+/**
+ * @brief Slots of the direct-mapped L1 B panel cache for BCSR_SPMM_FLAG_B_CACHE:
+ *        the largest power of two of 16 x mmadN fp16 panels that fits in half
+ *        of L1, capped at BCSR_SPMM_B_CACHE_MAX_SLOTS; the other half stays
+ *        with the A1 / B1 queues
+ */
+inline uint32_t BcsrSpmmBCacheSlots(uint64_t l1Bytes, uint32_t mmadN)
+{
+    uint64_t panelBytes = static_cast<uint64_t>(16) * mmadN * sizeof(uint16_t);
+    uint64_t fit = panelBytes == 0 ? 0 : l1Bytes / 2 / panelBytes;
+    uint32_t slots = 1;
+    while (slots * 2 <= fit && slots * 2 <= BCSR_SPMM_B_CACHE_MAX_SLOTS) {
+        slots *= 2;
+    }
+    return fit == 0 ? 0 : slots;
+}
+
+/**
+ * @brief Whether the launch runs in MIX mode: BCSR_SPMM_FLAG_MIX with at least
+ *        one window routed to the vector cores; small N is all-vector already
+ */
+inline bool BcsrSpmmMixActive(int64_t flags, int64_t n, int64_t mixNum)
+{
+    return (flags & BCSR_SPMM_FLAG_MIX) != 0 && n >= BCSR_SPMM_SMALL_N && mixNum > 0;
+}
+
+/**
+ * @brief Bytes of the window schedule, one uint32 window index per row window;
+ *        in MIX mode the last mixNum entries are the vector windows. Only the
+ *        large-N launch reads it, so it is 0 for N < BCSR_SPMM_SMALL_N
+ */
+inline uint64_t BcsrSpmmScheduleBytes(int64_t flags, int64_t n, int64_t windowNum, int64_t mixNum)
+{
+    bool table = (flags & BCSR_SPMM_FLAG_SCHEDULE) != 0 || BcsrSpmmMixActive(flags, n, mixNum);
+    return table && n >= BCSR_SPMM_SMALL_N && windowNum > 0 ? static_cast<uint64_t>(windowNum) * sizeof(uint32_t) : 0;
+}
+
+/**
+ * @brief N extent the MIX vector kernel accumulates at a time: a multiple of 16
+ *        whose 16-row fp32 accumulator and two fp16 B rows fit in UB next to two
+ *        A blocks, capped at BCSR_SPMM_MIX_MAX_N_TILE and at N padded to 16
+ */
+inline uint32_t BcsrSpmmMixNTile(uint64_t ubBytes, int64_t n)
+{
+    uint64_t fixed = 2 * 16 * 16 * sizeof(uint16_t) + 32;
+    uint64_t perColumn = 16 * sizeof(float) + 2 * sizeof(uint16_t);
+    uint64_t fit = ubBytes > fixed ? (ubBytes - fixed) / perColumn / 16 * 16 : 0;
+    uint64_t nPad = static_cast<uint64_t>((n + 15) / 16) * 16;
+    uint64_t tile = std::min<uint64_t>(std::min<uint64_t>(fit, BCSR_SPMM_MIX_MAX_N_TILE), nPad);
+    return static_cast<uint32_t>(std::max<uint64_t>(tile, 16));
+}
+
+/**
+ * @brief Whether the cube kernel runs dense windows from the dense-row store:
+ *        BCSR_SPMM_FLAG_DENSE with at least one window classified dense
+ */
+inline bool BcsrSpmmDenseActive(int64_t flags, int64_t n, int64_t denseNum)
+{
+    return (flags & BCSR_SPMM_FLAG_DENSE) != 0 && n >= BCSR_SPMM_SMALL_N && denseNum > 0;
+}
+
+/**
+ * @brief Elements of one dense row: 16 x K fp16 with K padded to 16, stored as
+ *        K / 16 consecutive row-major 16 x 16 blocks like val, so a K range is
+ *        contiguous and already in the fractal order L0A expects
+ */
+inline uint64_t BcsrSpmmDenseRowElems(int64_t k)
+{
+    return static_cast<uint64_t>((k + 15) / 16) * 16 * 16;
+}
+
+/**
+ * @brief K extent of one dense Mmad: a multiple of 16 whose B tile of
+ *        kTile x mmadN fp16 fills at most half of L0B, capped at
+ *        BCSR_SPMM_DENSE_MAX_K_TILE and at K padded to 16
+ */
+inline uint32_t BcsrSpmmDenseKTile(uint64_t l0bBytes, uint32_t mmadN, int64_t k)
+{
+    uint64_t fit = mmadN == 0 ? 0 : l0bBytes / 2 / (static_cast<uint64_t>(mmadN) * sizeof(uint16_t)) / 16 * 16;
+    uint64_t kPad = static_cast<uint64_t>((k + 15) / 16) * 16;
+    uint64_t tile = std::min<uint64_t>(std::min<uint64_t>(fit, BCSR_SPMM_DENSE_MAX_K_TILE), kPad);
+    return static_cast<uint32_t>(std::max<uint64_t>(tile, 16));
+}
+
+/**
+ * Regions of the user workspace, which ends the workspace: the counter region
+ * with BCSR_SPMM_FLAG_PROFILE, the window schedule, then the dense window map
+ * (one uint32 per row window, dense slot + 1 or 0) and the dense-row store.
+ * Offsets are from the start of the user workspace, each 32-byte aligned.
+ */
+struct BcsrSpmmUserLayout {
+    uint64_t schedule = 0;
+    uint64_t denseMap = 0;
+    uint64_t denseStore = 0;
+    uint64_t bytes = 0;
+};
+
+inline uint64_t BcsrSpmmAlign32(uint64_t bytes)
+{
+    return (bytes + 31) / 32 * 32;
+}
+
+inline BcsrSpmmUserLayout BcsrSpmmUserWorkspaceLayout(int64_t flags, int64_t k, int64_t n, int64_t windowNum,
+                                                      int64_t denseNum, int64_t mixNum)
+{
+    BcsrSpmmUserLayout layout;
+    layout.schedule = (flags & BCSR_SPMM_FLAG_PROFILE) != 0 ? BCSR_SPMM_PROFILE_BYTES : 0;
+    layout.bytes = layout.schedule + BcsrSpmmScheduleBytes(flags, n, windowNum, mixNum);
+    layout.denseMap = layout.bytes;
+    layout.denseStore = layout.bytes;
+    if (BcsrSpmmDenseActive(flags, n, denseNum) && windowNum > 0) {
+        layout.denseMap = BcsrSpmmAlign32(layout.bytes);
+        layout.denseStore = BcsrSpmmAlign32(layout.denseMap + static_cast<uint64_t>(windowNum) * sizeof(uint32_t));
+        layout.bytes = layout.denseStore + static_cast<uint64_t>(denseNum) * BcsrSpmmDenseRowElems(k) * sizeof(uint16_t);
+    }
+    return layout;
+}
+
+// mmadN 须为 16 的倍数，受 L0B / L0C 中单个 B 分块与 C 分块的大小限制
+inline bool BcsrSpmmTuneValid(const BcsrSpmmTuneConfig &config)
+{
+    return config.mmadN >= 16 && config.mmadN <= 128 && config.mmadN % 16 == 0 &&
+           config.partition <= BCSR_SPMM_PARTITION_CYCLIC;
+}
+
+inline const char *BcsrSpmmPartitionName(uint32_t partition)
+{
+    return partition == BCSR_SPMM_PARTITION_CYCLIC ? "cyclic" : "contiguous";
+}
+
+inline bool BcsrSpmmParsePartition(const std::string &name, uint32_t &partition)
+{
+    if (name == "contiguous") {
+        partition = BCSR_SPMM_PARTITION_CONTIGUOUS;
+    } else if (name == "cyclic") {
+        partition = BCSR_SPMM_PARTITION_CYCLIC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline std::string BcsrSpmmFormatTune(const BcsrSpmmTuneConfig &config)
+{
+    std::ostringstream text;
+    text << "mmad_n=" << config.mmadN << " cores=" << config.coreNum
+         << " partition=" << BcsrSpmmPartitionName(config.partition);
+    return text.str();
+}
+
+/**
+ * @brief Parse one database line; comments, blank and malformed lines return false
+ */
+inline bool BcsrSpmmParseTuneLine(const std::string &line, std::string &key, BcsrSpmmTuneConfig &config)
+{
+    std::istringstream in(line.substr(0, line.find('#')));
+    if (!(in >> key)) {
+        return false;
+    }
+    config = BcsrSpmmTuneConfig();
+    std::string field;
+    while (in >> field) {
+        size_t eq = field.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        std::string name = field.substr(0, eq);
+        std::string value = field.substr(eq + 1);
+        if (name == "mmad_n") {
+            config.mmadN = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (name == "cores") {
+            config.coreNum = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (name == "partition" && !BcsrSpmmParsePartition(value, config.partition)) {
+            return false;
+        }
+    }
+    return BcsrSpmmTuneValid(config);
+}
+
+/**
+ * @brief Find the last entry of key in the database at path
+ */
+inline bool BcsrSpmmLookupTune(const std::string &path, const std::string &key, BcsrSpmmTuneConfig &config)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::string lineKey;
+    BcsrSpmmTuneConfig lineConfig;
+    bool found = false;
+    while (std::getline(in, line)) {
+        if (BcsrSpmmParseTuneLine(line, lineKey, lineConfig) && lineKey == key) {
+            config = lineConfig;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// TilingFunc 查表的位置：$BCSR_SPMM_TUNE_DB，未设置时为默认路径
+inline std::string BcsrSpmmTuneDbPath()
+{
+    const char *env = std::getenv(BCSR_SPMM_TUNE_DB_ENV);
+    return env != nullptr && env[0] != '\0' ? std::string(env) : std::string(BCSR_SPMM_TUNE_DB_DEFAULT);
+}
+
+#endif // BCSR_SPMM_TUNE_H
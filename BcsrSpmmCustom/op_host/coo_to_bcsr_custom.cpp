@@ -0,0 +1,160 @@
+
+#include "coo_to_bcsr_custom_tiling.h"
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+#include "../op_kernel/coo_to_bcsr_desc.h"
+
+namespace optiling {
+static ge::graphStatus TilingFunc(gert::TilingContext* context)
+{
+    CooToBcsrCustomTilingData tiling;
+    auto ascendcPlatform = platform_ascendc::PlatformAscendC(context->GetPlatformInfo());
+
+    // coo_shape, row, col, value
+    auto shape_addr = context->GetInputTensor(0)->GetData<int64_t>();
+    int64_t shapeNum = context->GetInputTensor(0)->GetShapeSize();
+    if (shape_addr == nullptr || shapeNum < COO_TO_BCSR_SHAPE_NUM) {
+        printf("CooToBcsrCustom Tiling: coo_shape must be [M, K, capacity]\n");
+        return ge::GRAPH_FAILED;
+    }
+    int32_t M = shape_addr[0];
+    int32_t K = shape_addr[1];
+    uint32_t capacity = shape_addr[COO_TO_BCSR_SHAPE_CAPACITY];
+    uint32_t nnz = context->GetInputShape(1)->GetOriginShape().GetShapeSize();
+
+    // 位图按窗口复用，K 决定 UB 占用
+    uint32_t blockCols = (K + COO_TO_BCSR_TILE - 1) / COO_TO_BCSR_TILE;
+    uint32_t bitmapWords = (blockCols + 63) / 64;
+    bitmapWords = (bitmapWords + 7) / 8 * 8;
+    bitmapWords = bitmapWords == 0 ? 8 : bitmapWords;
+    if (bitmapWords > COO_TO_BCSR_MAX_BITMAP_WORDS) {
+        printf("CooToBcsrCustom Tiling: K=%d exceeds the block column bitmap\n", K);
+        return ge::GRAPH_FAILED;
+    }
+    tiling.set_M(M);
+    tiling.set_K(K);
+    tiling.set_nnz(nnz);
+    tiling.set_capacity(capacity);
+    tiling.set_bitmapWords(bitmapWords);
+
+    // totalLength 行窗口数，M 为 0 时仍需一个 core 写 row_ptr[0]
+    uint32_t totalLength = (M + COO_TO_BCSR_TILE - 1) / COO_TO_BCSR_TILE;
+    uint32_t blockDim = ascendcPlatform.GetCoreNumAiv();    // Vector core 数量
+    blockDim = blockDim > COO_TO_BCSR_MAX_CORES ? COO_TO_BCSR_MAX_CORES : blockDim;
+    blockDim = blockDim > totalLength ? totalLength : blockDim;
+    blockDim = blockDim == 0 ? 1 : blockDim;
+    context->SetBlockDim(blockDim);
+    // kernel 中有 SyncAll，所有 core 必须同时在位
+    context->SetScheduleMode(1);
+    tiling.set_totalLength(totalLength);
+
+    uint32_t formerNum = totalLength % blockDim;
+    if (formerNum == 0) {
+        formerNum = blockDim;
+    }
+    uint32_t formerLength = (totalLength + blockDim - 1) / blockDim;
+    uint32_t tailNum = blockDim - formerNum;
+    uint32_t tailLength = totalLength / blockDim;
+    tiling.set_formerNum(formerNum);
+    tiling.set_formerLength(formerLength);
+    tiling.set_tailNum(tailNum);
+    tiling.set_tailLength(tailLength);
+
+    printf("CooToBcsrCustom Tiling: M=%d, K=%d, nnz=%u, capacity=%u, totalLength=%u, blockDim=%u, bitmapWords=%u\n",
+        M, K, nnz, capacity, totalLength, blockDim, bitmapWords
+    );
+
+    tiling.SaveToBuffer(context->GetRawTilingData()->GetData(), context->GetRawTilingData()->GetCapacity());
+    context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+    size_t *currentWorkspace = context->GetWorkspaceSizes(1);
+    // 每个 core 的块数槽位，SyncAll 后各 core 据此求块偏移
+    currentWorkspace[0] = ascendcPlatform.GetLibApiWorkSpaceSize() +
+        COO_TO_BCSR_MAX_CORES * COO_TO_BCSR_TOTAL_SLOT * sizeof(int32_t);
+    return ge::GRAPH_SUCCESS;
+}
+}
+
+
+namespace ge {
+static ge::graphStatus InferShape(gert::InferShapeContext* context)
+{
+    // coo_shape, row, col, value -> row_ptr, bcsr_col, bcsr_val
+    auto shape_addr = context->GetInputTensor(0)->GetData<int64_t>();
+    auto row_ptr_shape = context->GetOutputShape(0);
+    auto col_shape = context->GetOutputShape(1);
+    auto val_shape = context->GetOutputShape(2);
+    if (shape_addr == nullptr || row_ptr_shape == nullptr || col_shape == nullptr || val_shape == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+
+    int64_t M = shape_addr[0];
+    int64_t capacity = shape_addr[COO_TO_BCSR_SHAPE_CAPACITY];
+    row_ptr_shape->SetDimNum(1);
+    row_ptr_shape->SetDim(0, (M + COO_TO_BCSR_TILE - 1) / COO_TO_BCSR_TILE + 1);
+    col_shape->SetDimNum(1);
+    col_shape->SetDim(0, capacity);
+    val_shape->SetDimNum(1);
+    val_shape->SetDim(0, capacity * COO_TO_BCSR_TILE * COO_TO_BCSR_TILE);
+
+    return ge::GRAPH_SUCCESS;
+}
+static ge::graphStatus InferDataType(gert::InferDataTypeContext *context)
+{
+    if (context->SetOutputDataType(0, ge::DataType::DT_INT32) != ge::GRAPH_SUCCESS ||
+        context->SetOutputDataType(1, ge::DataType::DT_INT32) != ge::GRAPH_SUCCESS ||
+        context->SetOutputDataType(2, ge::DataType::DT_FLOAT16) != ge::GRAPH_SUCCESS) {
+        return ge::GRAPH_FAILED;
+    }
+    return ge::GRAPH_SUCCESS;
+}
+}
+
+
+namespace ops {
+class CooToBcsrCustom : public OpDef {
+public:
+    explicit CooToBcsrCustom(const char* name) : OpDef(name)
+    {
+        this->Input("coo_shape")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT64})
+            .Format({ge::FORMAT_ND})
+            .ValueDepend(REQUIRED); // 声明 coo_shape 输入为数据依赖输入
+        // COO 元素须按行有序，同一位置的重复元素以后出现的为准
+        this->Input("row")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND});
+        this->Input("col")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND});
+        this->Input("value")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND});
+        this->Output("row_ptr")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND});
+        // int32 起始列，与 BcsrSpmmCustom 的 col 输入一致
+        this->Output("bcsr_col")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_INT32})
+            .Format({ge::FORMAT_ND});
+        this->Output("bcsr_val")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND});
+
+        this->SetInferShape(ge::InferShape).SetInferDataType(ge::InferDataType);
+
+        this->AICore()
+            .SetTiling(optiling::TilingFunc);
+        this->AICore().AddConfig("ascend910b");
+
+    }
+};
+
+OP_ADD(CooToBcsrCustom);
+}
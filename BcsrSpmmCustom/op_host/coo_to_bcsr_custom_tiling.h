@@ -0,0 +1,26 @@
+
+#include "register/tilingdata_base.h"
+
+namespace optiling {
+BEGIN_TILING_DATA_DEF(CooToBcsrCustomTilingData)
+  TILING_DATA_FIELD_DEF(int32_t, M);
+  TILING_DATA_FIELD_DEF(int32_t, K);
+  TILING_DATA_FIELD_DEF(uint32_t, nnz);
+  // bcsr_col 能容纳的块数，块数超出时只写 row_ptr
+  TILING_DATA_FIELD_DEF(uint32_t, capacity);
+
+  // 行窗口总数
+  TILING_DATA_FIELD_DEF(uint32_t, totalLength);
+  // 块列位图的 uint64 个数，取 8 的倍数，其 uint32 前缀数组同样 32B 对齐
+  TILING_DATA_FIELD_DEF(uint32_t, bitmapWords);
+
+  // 均分行窗口给每个vector core
+  TILING_DATA_FIELD_DEF(uint32_t, formerNum);
+  TILING_DATA_FIELD_DEF(uint32_t, formerLength);
+  TILING_DATA_FIELD_DEF(uint32_t, tailNum);
+  TILING_DATA_FIELD_DEF(uint32_t, tailLength);
+
+END_TILING_DATA_DEF;
+
+REGISTER_TILING_DATA_CLASS(CooToBcsrCustom, CooToBcsrCustomTilingData)
+}
@@ -0,0 +1,116 @@
+
+#include "spmm_iter_epilogue_custom_tiling.h"
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+#include "../op_kernel/spmm_iter_desc.h"
+
+namespace optiling {
+static ge::graphStatus TilingFunc(gert::TilingContext* context)
+{
+    SpmmIterEpilogueCustomTilingData tiling;
+    auto ascendcPlatform = platform_ascendc::PlatformAscendC(context->GetPlatformInfo());
+
+    // c, x -> x_next, norm
+    uint32_t totalLength = context->GetInputShape(0)->GetOriginShape().GetShapeSize();
+    auto attrs = context->GetAttrs();
+    const float *scale = attrs == nullptr ? nullptr : attrs->GetAttrPointer<float>(0);
+    const bool *withNorm = attrs == nullptr ? nullptr : attrs->GetAttrPointer<bool>(1);
+    tiling.set_totalLength(totalLength);
+    tiling.set_scale(scale == nullptr ? 1.0f : *scale);
+    tiling.set_withNorm(withNorm != nullptr && *withNorm ? 1 : 0);
+    tiling.set_tileLength(SPMM_ITER_TILE);
+
+    // 元素按 SPMM_ITER_ALIGN 分组后均分，保证每段在 GM 上 32B 对齐
+    uint32_t units = (totalLength + SPMM_ITER_ALIGN - 1) / SPMM_ITER_ALIGN;
+    uint32_t blockDim = ascendcPlatform.GetCoreNumAiv();    // Vector core 数量
+    blockDim = blockDim > SPMM_ITER_MAX_CORES ? SPMM_ITER_MAX_CORES : blockDim;
+    blockDim = blockDim > units ? units : blockDim;
+    blockDim = blockDim == 0 ? 1 : blockDim;
+    context->SetBlockDim(blockDim);
+
+    uint32_t formerNum = units % blockDim;
+    if (formerNum == 0) {
+        formerNum = blockDim;
+    }
+    tiling.set_formerNum(formerNum);
+    tiling.set_formerLength((units + blockDim - 1) / blockDim * SPMM_ITER_ALIGN);
+    tiling.set_tailNum(blockDim - formerNum);
+    tiling.set_tailLength(units / blockDim * SPMM_ITER_ALIGN);
+
+    printf("SpmmIterEpilogueCustom Tiling: totalLength=%u, blockDim=%u, scale=%f, withNorm=%u\n",
+        totalLength, blockDim, tiling.get_scale(), tiling.get_withNorm()
+    );
+
+    tiling.SaveToBuffer(context->GetRawTilingData()->GetData(), context->GetRawTilingData()->GetCapacity());
+    context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+    size_t *currentWorkspace = context->GetWorkspaceSizes(1);
+    currentWorkspace[0] = ascendcPlatform.GetLibApiWorkSpaceSize();
+    return ge::GRAPH_SUCCESS;
+}
+}
+
+
+namespace ge {
+static ge::graphStatus InferShape(gert::InferShapeContext* context)
+{
+    // c, x -> x_next, norm
+    const gert::Shape* c_shape = context->GetInputShape(0);
+    gert::Shape* x_next_shape = context->GetOutputShape(0);
+    gert::Shape* norm_shape = context->GetOutputShape(1);
+    if (c_shape == nullptr || x_next_shape == nullptr || norm_shape == nullptr) {
+        return ge::GRAPH_FAILED;
+    }
+    *x_next_shape = *c_shape;
+    norm_shape->SetDimNum(1);
+    norm_shape->SetDim(0, SPMM_ITER_NORM_NUM);
+    return ge::GRAPH_SUCCESS;
+}
+static ge::graphStatus InferDataType(gert::InferDataTypeContext *context)
+{
+    if (context->SetOutputDataType(0, ge::DataType::DT_FLOAT16) != ge::GRAPH_SUCCESS ||
+        context->SetOutputDataType(1, ge::DataType::DT_FLOAT) != ge::GRAPH_SUCCESS) {
+        return ge::GRAPH_FAILED;
+    }
+    return ge::GRAPH_SUCCESS;
+}
+}
+
+
+namespace ops {
+class SpmmIterEpilogueCustom : public OpDef {
+public:
+    explicit SpmmIterEpilogueCustom(const char* name) : OpDef(name)
+    {
+        // BcsrSpmmCustom 的 fp32 输出
+        this->Input("c")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND});
+        // 本步的 fp16 输入，只在 with_norm 时读取
+        this->Input("x")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND});
+        this->Output("x_next")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT16})
+            .Format({ge::FORMAT_ND});
+        // 每个 core 的部分平方和，布局见 spmm_iter_desc.h
+        this->Output("norm")
+            .ParamType(REQUIRED)
+            .DataType({ge::DT_FLOAT})
+            .Format({ge::FORMAT_ND});
+        this->Attr("scale").AttrType(OPTIONAL).Float(1.0);
+        this->Attr("with_norm").AttrType(OPTIONAL).Bool(false);
+
+        this->SetInferShape(ge::InferShape).SetInferDataType(ge::InferDataType);
+
+        this->AICore()
+            .SetTiling(optiling::TilingFunc);
+        this->AICore().AddConfig("ascend910b");
+
+    }
+};
+
+OP_ADD(SpmmIterEpilogueCustom);
+}
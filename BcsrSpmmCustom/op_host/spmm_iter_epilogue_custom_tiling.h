@@ -0,0 +1,22 @@
+
+#include "register/tilingdata_base.h"
+
+namespace optiling {
+BEGIN_TILING_DATA_DEF(SpmmIterEpilogueCustomTilingData)
+  // C 的元素总数
+  TILING_DATA_FIELD_DEF(uint32_t, totalLength);
+
+  // 按 SPMM_ITER_ALIGN 个元素为单位均分给每个vector core，最后一段由 kernel 截到 totalLength
+  TILING_DATA_FIELD_DEF(uint32_t, formerNum);
+  TILING_DATA_FIELD_DEF(uint32_t, formerLength);
+  TILING_DATA_FIELD_DEF(uint32_t, tailNum);
+  TILING_DATA_FIELD_DEF(uint32_t, tailLength);
+  TILING_DATA_FIELD_DEF(uint32_t, tileLength);
+
+  TILING_DATA_FIELD_DEF(float, scale);
+  TILING_DATA_FIELD_DEF(uint32_t, withNorm);
+
+END_TILING_DATA_DEF;
+
+REGISTER_TILING_DATA_CLASS(SpmmIterEpilogueCustom, SpmmIterEpilogueCustomTilingData)
+}
@@ -1,12 +1,34 @@
 #include "kernel_operator.h"
+#include "bcsr_spmm_desc.h"
 
 
-template<typename aType, typename bType, typename cType>
+// 每个 core 写自己的槽位，host 按 magic 判断槽位是否有效；coreTypes 为每个 block 占用的槽位数，
+// MIX 模式下一个 cube core 与两个向量核共 3 个
+__aicore__ inline void WriteBcsrSpmmCounters(AscendC::GlobalTensor<uint64_t> &profileGm, uint64_t *counters,
+                                             uint32_t coreTypes = 1)
+{
+    counters[BCSR_SPMM_CNT_MAGIC] = BCSR_SPMM_PROFILE_MAGIC;
+    counters[BCSR_SPMM_CNT_BLOCK_DIM] = AscendC::GetBlockNum() * coreTypes;
+    counters[BCSR_SPMM_CNT_CYCLE_MHZ] = BCSR_SPMM_SYSTEM_CYCLE_MHZ;
+    for (uint32_t i = 0; i < BCSR_SPMM_CNT_NUM; i++) {
+        profileGm.SetValue(i, counters[i]);
+    }
+    AscendC::DataCacheCleanAndInvalid<uint64_t, AscendC::CacheLine::ENTIRE_DATA_CACHE,
+        AscendC::DcciDst::CACHELINE_OUT>(profileGm);
+}
+
+// idxType: row_ptr 的类型，int32_t 或 int64_t（块数 * 256 超出 2^31 的矩阵）
+// colType: int32_t / int64_t 存起始列；uint16_t 存块列号（起始列 / CUBE_BLOCK_K），读取时解码
+// PROFILE: 插桩版，统计每个 core 的工作量与各阶段周期，写入 workspace 的计数区
+// GM 偏移一律按 64 位计算：块号 * 256、起始列 * N、行号 * N 都可能超出 int32
+template<typename aType, typename bType, typename cType, typename idxType, typename colType, bool PROFILE = false>
 class BcsrSpmmKernel {
 // output C Tile size [16, 16]
 uint32_t CUBE_BLOCK_M = 16;
 uint32_t CUBE_BLOCK_K = 32 / sizeof(aType);
 uint32_t CUBE_BLOCK_SIZE = CUBE_BLOCK_M * CUBE_BLOCK_K;
+// col 的解码倍数
+uint32_t COL_UNIT = sizeof(colType) == sizeof(uint16_t) ? CUBE_BLOCK_K : 1;
 
 public:
     __aicore__ inline BcsrSpmmKernel() {}
@@ -19,11 +41,11 @@ public:
         uint32_t tailNum, uint32_t tailLength,
         uint32_t mmadNum, uint32_t mmadN,   
         uint32_t lastMmadN, uint32_t lastMmadCubeBlockNum,
-        uint32_t lastKLength
+        uint32_t lastKLength, uint32_t totalLength, uint32_t partition,
+        uint32_t directOutput, uint32_t bCacheSlots,
+        uint32_t denseNum, uint32_t denseKTile, uint64_t denseMapOffset, uint64_t denseStoreOffset,
+        uint32_t mixNum
     ) {
-        // set cube only
-        KERNEL_TASK_TYPE_DEFAULT(KERNEL_TYPE_AIC_ONLY);
-
         this->M = M;
         this->K = K;
         this->N = N;
@@ -33,63 +55,292 @@ public:
         this->lastMmadCubeBlockNum = lastMmadCubeBlockNum;
         this->mmadN = mmadN;
         this->lastKLength = lastKLength;
+        this->directOutput = directOutput;
+        this->bCacheSlots = bCacheSlots > BCSR_SPMM_B_CACHE_MAX_SLOTS ? BCSR_SPMM_B_CACHE_MAX_SLOTS : bCacheSlots;
+        this->bCacheSlot = 0;
+        this->denseNum = denseNum;
+        this->denseKTile = denseKTile;
+        this->denseK = (this->K + CUBE_BLOCK_K - 1) / CUBE_BLOCK_K * CUBE_BLOCK_K;
+        this->profileCores = mixNum != 0 ? 3 : 1;
         // AscendC::printf("BcsrSpmmKernel Init: BlockIdx=%d, M=%d, K=%d, N=%d, mmadNum=%d, mmadN=%d\n", 
             // AscendC::GetBlockIdx(), M, K, N, mmadNum, mmadN);
-        if (AscendC::GetBlockIdx() < formerNum) {
+        // 本 core 处理第 rowStart + r * rowStride 个窗口，下标相对 rowPtrGm 的起点
+        this->rowStart = 0;
+        this->rowStride = 1;
+        this->windowBase = 0;
+        this->scheduled = partition == BCSR_SPMM_PARTITION_SCHEDULED;
+        if (partition == BCSR_SPMM_PARTITION_CYCLIC || this->scheduled) {
+            // 交错分配：块数集中在相邻窗口时（幂律图、带状矩阵的稠密段）比连续区间更均衡；
+            // MIX 模式下调度表的最后 mixNum 项归向量核，cube 的窗口可能少于 core 数
+            uint32_t blockNum = AscendC::GetBlockNum();
+            uint32_t cubeLength = totalLength - mixNum;
+            this->rowWindowNum = AscendC::GetBlockIdx() < cubeLength ?
+                (cubeLength - AscendC::GetBlockIdx() + blockNum - 1) / blockNum : 0;
+            this->rowStart = AscendC::GetBlockIdx();
+            this->rowStride = blockNum;
+            rowPtrGm.SetGlobalBuffer((__gm__ idxType *)row_ptr, totalLength + 1);
+            cGm.SetGlobalBuffer((__gm__ cType *)c, (uint64_t)totalLength * CUBE_BLOCK_M * N);
+            if (this->scheduled) {
+                // 调度表紧跟在计数区之后，交错分配的是表中的位置：同一时刻各 core 处理表中相邻、B 列相近的窗口
+                uint64_t offset = PROFILE ? BCSR_SPMM_PROFILE_BYTES : 0;
+                scheduleGm.SetGlobalBuffer((__gm__ uint32_t *)(AscendC::GetUserWorkspace(workspace) + offset),
+                    totalLength);
+            }
+        } else if (AscendC::GetBlockIdx() < formerNum) {
             this->rowWindowNum = formerLength;
-            rowPtrGm.SetGlobalBuffer((__gm__ int32_t *)row_ptr + formerLength * AscendC::GetBlockIdx(), formerLength + 1);
-            cGm.SetGlobalBuffer((__gm__ cType *)c + formerLength * AscendC::GetBlockIdx() * CUBE_BLOCK_M * N, 
-                formerLength * CUBE_BLOCK_M * N);
+            uint64_t firstWindow = (uint64_t)formerLength * AscendC::GetBlockIdx();
+            this->windowBase = firstWindow;
+            rowPtrGm.SetGlobalBuffer((__gm__ idxType *)row_ptr + firstWindow, formerLength + 1);
+            cGm.SetGlobalBuffer((__gm__ cType *)c + firstWindow * CUBE_BLOCK_M * N,
+                (uint64_t)formerLength * CUBE_BLOCK_M * N);
         } else if (AscendC::GetBlockIdx() < formerNum + tailNum) {
             this->rowWindowNum = tailLength;
-            rowPtrGm.SetGlobalBuffer((__gm__ int32_t *)row_ptr + formerLength * formerNum +
-                tailLength * (AscendC::GetBlockIdx() - formerNum), tailLength + 1
-            );
-            cGm.SetGlobalBuffer((__gm__ cType *)c + (formerLength * formerNum +
-                tailLength * (AscendC::GetBlockIdx() - formerNum)) * CUBE_BLOCK_M * N,
-                tailLength * CUBE_BLOCK_M * N
+            uint64_t firstWindow = (uint64_t)formerLength * formerNum +
+                (uint64_t)tailLength * (AscendC::GetBlockIdx() - formerNum);
+            this->windowBase = firstWindow;
+            rowPtrGm.SetGlobalBuffer((__gm__ idxType *)row_ptr + firstWindow, tailLength + 1);
+            cGm.SetGlobalBuffer((__gm__ cType *)c + firstWindow * CUBE_BLOCK_M * N,
+                (uint64_t)tailLength * CUBE_BLOCK_M * N
             );
         }
-        colGm.SetGlobalBuffer((__gm__ int32_t *)col + rowPtrGm.GetValue(0), 
-            rowPtrGm.GetValue(this->rowWindowNum) - rowPtrGm.GetValue(0)
-        );
-        valGm.SetGlobalBuffer((__gm__ aType *)val + CUBE_BLOCK_SIZE * rowPtrGm.GetValue(0),
-            CUBE_BLOCK_SIZE * (rowPtrGm.GetValue(this->rowWindowNum) - rowPtrGm.GetValue(0))
+        // 按调度表执行时窗口可能来自任何位置，col / val 覆盖全部块
+        uint32_t lastWindow = this->scheduled ? totalLength :
+            this->rowStart + this->rowWindowNum * this->rowStride - this->rowStride + 1;
+        int64_t firstBlock = static_cast<int64_t>(rowPtrGm.GetValue(0));
+        int64_t coreBlockNum = static_cast<int64_t>(rowPtrGm.GetValue(lastWindow)) - firstBlock;
+        colGm.SetGlobalBuffer((__gm__ colType *)col + firstBlock, coreBlockNum);
+        valGm.SetGlobalBuffer((__gm__ aType *)val + (uint64_t)CUBE_BLOCK_SIZE * firstBlock,
+            (uint64_t)CUBE_BLOCK_SIZE * coreBlockNum
         );
         bGm.SetGlobalBuffer((__gm__ bType *)b, (uint64_t)K * N);
+        if (PROFILE) {
+            profileGm.SetGlobalBuffer((__gm__ uint64_t *)AscendC::GetUserWorkspace(workspace) +
+                AscendC::GetBlockIdx() * BCSR_SPMM_CNT_NUM, BCSR_SPMM_CNT_NUM);
+            for (uint32_t i = 0; i < BCSR_SPMM_CNT_NUM; i++) {
+                counters[i] = 0;
+            }
+        }
 
-        pipe.InitBuffer(inQueueA1, 1, CUBE_BLOCK_SIZE * sizeof(aType)); // 512B
-        pipe.InitBuffer(inQueueA2, 1, CUBE_BLOCK_SIZE * sizeof(aType)); // 512B
-        pipe.InitBuffer(inQueueB1, 1, CUBE_BLOCK_K * this->mmadN * sizeof(bType));
-        pipe.InitBuffer(inQueueB2, 1, CUBE_BLOCK_K * this->mmadN * sizeof(bType));
+        if (denseNum != 0) {
+            // 稠密窗口表按全局窗口号索引，稠密行按槽位依次存放
+            denseMapGm.SetGlobalBuffer((__gm__ uint32_t *)(AscendC::GetUserWorkspace(workspace) + denseMapOffset),
+                totalLength);
+            denseGm.SetGlobalBuffer((__gm__ aType *)(AscendC::GetUserWorkspace(workspace) + denseStoreOffset),
+                (uint64_t)denseNum * CUBE_BLOCK_M * denseK);
+        }
+        // 有稠密窗口时 A / B 队列按一次 Mmad 的 K 长度申请，BCSR 块只用其中前 16 行
+        uint32_t kTile = denseNum != 0 ? denseKTile : CUBE_BLOCK_K;
+        pipe.InitBuffer(inQueueA1, 1, CUBE_BLOCK_M * kTile * sizeof(aType)); // BCSR 块 512B
+        pipe.InitBuffer(inQueueA2, 1, CUBE_BLOCK_M * kTile * sizeof(aType));
+        pipe.InitBuffer(inQueueB1, 1, kTile * this->mmadN * sizeof(bType));
+        pipe.InitBuffer(inQueueB2, 1, kTile * this->mmadN * sizeof(bType));
         pipe.InitBuffer(outQueueCO1, 1, CUBE_BLOCK_M * this->mmadN  * sizeof(cType));
+        if (bCacheSlots != 0) {
+            pipe.InitBuffer(bCacheBuf, (bCacheSlots + 1) * CUBE_BLOCK_K * this->mmadN * sizeof(bType));
+            for (uint32_t i = 0; i < bCacheSlots; i++) {
+                bCacheTags[i] = -1;
+            }
+            AscendC::Duplicate(bCacheBuf.Get<bType>()[bCacheSlots * CUBE_BLOCK_K * this->mmadN], (bType)0,
+                CUBE_BLOCK_K * this->mmadN);
+            AscendC::PipeBarrier<PIPE_ALL>();
+        }
     }
 
     __aicore__ inline void Process()
     {
-        for (int32_t row = 0; row < rowWindowNum; row++) {
+        if (directOutput != 0) {
+            ProcessDirect();
+            return;
+        }
+        uint64_t start = Cycle();
+        for (uint32_t r = 0; r < rowWindowNum; r++) {
+            uint32_t row = WindowAt(r);
             // AscendC::printf("Blockidx=%d, Processing row window %d/%d\n", AscendC::GetBlockIdx(), row, rowWindowNum);
             // 行窗口中的每块
-            int32_t rowBlockOffset = rowPtrGm.GetValue(row) - rowPtrGm.GetValue(0);
-            for (int32_t i = 0; i < rowPtrGm.GetValue(row + 1) - rowPtrGm.GetValue(row); i++) {
-                int32_t col = colGm.GetValue(rowBlockOffset + i);
+            int64_t rowBlockOffset = static_cast<int64_t>(rowPtrGm.GetValue(row) - rowPtrGm.GetValue(0));
+            int64_t rowBlockNum = static_cast<int64_t>(rowPtrGm.GetValue(row + 1) - rowPtrGm.GetValue(row));
+            uint32_t denseSlot = DenseSlot(row);
+            if (denseSlot != 0) {
+                ProcessDense(row, denseSlot - 1, rowBlockNum);
+                continue;
+            }
+            for (int64_t i = 0; i < rowBlockNum; i++) {
+                int64_t col = static_cast<int64_t>(colGm.GetValue(rowBlockOffset + i)) * COL_UNIT;
                 // AscendC::printf("  Processing block %d/%d, col block idx=%d\n", i, 
                     // rowPtrGm.GetValue(row + 1) - rowPtrGm.GetValue(row), col);
                 // B窗口行中的每个 mmad 块
                 for (int32_t j = 0; j < mmadNum; j++) {
                     // 因为是流水线式的，所以需要每次搬运 A 即使源地址一样
-                    CopyInA(row, i);
-                    CopyInB(j, col);
+                    // 阶段周期是标量侧看到的时间，包含 DeQue 等待前序流水的部分
+                    uint64_t t0 = Cycle();
+                    CopyInA(rowBlockOffset + i);
+                    uint64_t t1 = Cycle();
+                    bool hit = CopyInB(j, col);
+                    uint64_t t2 = Cycle();
                     SplitA();
                     SplitB(j);
+                    uint64_t t3 = Cycle();
                     Compute(j);
+                    uint64_t t4 = Cycle();
                     CopyOut(row, j);
+                    if (PROFILE) {
+                        uint64_t t5 = Cycle();
+                        counters[BCSR_SPMM_CNT_COPY_IN_A] += t1 - t0;
+                        counters[BCSR_SPMM_CNT_COPY_IN_B] += t2 - t1;
+                        counters[BCSR_SPMM_CNT_SPLIT] += t3 - t2;
+                        counters[BCSR_SPMM_CNT_COMPUTE] += t4 - t3;
+                        counters[BCSR_SPMM_CNT_COPY_OUT] += t5 - t4;
+                        counters[BCSR_SPMM_CNT_MMADS]++;
+                        // 越过 K 的行用 Duplicate 补 0，不计入搬运量；缓存命中的面板没有搬运
+                        int64_t validRows = K - col < (int64_t)CUBE_BLOCK_K ? K - col : (int64_t)CUBE_BLOCK_K;
+                        if (hit) {
+                            counters[BCSR_SPMM_CNT_B_HITS]++;
+                        } else {
+                            counters[BCSR_SPMM_CNT_B_BYTES] += (uint64_t)validRows * this->mmadN * sizeof(bType);
+                        }
+                    }
+                }
+                if (PROFILE) {
+                    counters[BCSR_SPMM_CNT_BLOCKS]++;
+                }
+            }
+            if (PROFILE) {
+                counters[BCSR_SPMM_CNT_WINDOWS]++;
+            }
+        }
+        if (PROFILE) {
+            counters[BCSR_SPMM_CNT_CYCLES] = Cycle() - start;
+            WriteBcsrSpmmCounters(profileGm, counters, profileCores);
+        }
+    }
+
+    // 直写模式：窗口只属于一个 core，每个 mmad 面板在 L0C 中累加窗口内全部块后一次 Fixpipe 覆盖写 C，
+    // 空窗口用零块做一次 Mmad 写出 0，因此 host 不需要预先清零 C，也没有原子加的读改写
+    __aicore__ inline void ProcessDirect()
+    {
+        uint64_t start = Cycle();
+        for (uint32_t r = 0; r < rowWindowNum; r++) {
+            uint32_t row = WindowAt(r);
+            int64_t rowBlockOffset = static_cast<int64_t>(rowPtrGm.GetValue(row) - rowPtrGm.GetValue(0));
+            int64_t rowBlockNum = static_cast<int64_t>(rowPtrGm.GetValue(row + 1) - rowPtrGm.GetValue(row));
+            uint32_t denseSlot = DenseSlot(row);
+            if (denseSlot != 0) {
+                ProcessDense(row, denseSlot - 1, rowBlockNum);
+                continue;
+            }
+            for (int32_t j = 0; j < mmadNum; j++) {
+                AscendC::LocalTensor<cType> c1Local = outQueueCO1.AllocTensor<cType>();
+                if (rowBlockNum == 0) {
+                    CopyInZero();
+                    SplitA();
+                    SplitB(j);
+                    Accumulate(c1Local, j, true);
+                }
+                for (int64_t i = 0; i < rowBlockNum; i++) {
+                    int64_t col = static_cast<int64_t>(colGm.GetValue(rowBlockOffset + i)) * COL_UNIT;
+                    uint64_t t0 = Cycle();
+                    CopyInA(rowBlockOffset + i);
+                    uint64_t t1 = Cycle();
+                    bool hit = CopyInB(j, col);
+                    uint64_t t2 = Cycle();
+                    SplitA();
+                    SplitB(j);
+                    uint64_t t3 = Cycle();
+                    // 第一块初始化 L0C，其余块累加
+                    Accumulate(c1Local, j, i == 0);
+                    if (PROFILE) {
+                        uint64_t t4 = Cycle();
+                        counters[BCSR_SPMM_CNT_COPY_IN_A] += t1 - t0;
+                        counters[BCSR_SPMM_CNT_COPY_IN_B] += t2 - t1;
+                        counters[BCSR_SPMM_CNT_SPLIT] += t3 - t2;
+                        counters[BCSR_SPMM_CNT_COMPUTE] += t4 - t3;
+                        counters[BCSR_SPMM_CNT_MMADS]++;
+                        int64_t validRows = K - col < (int64_t)CUBE_BLOCK_K ? K - col : (int64_t)CUBE_BLOCK_K;
+                        if (hit) {
+                            counters[BCSR_SPMM_CNT_B_HITS]++;
+                        } else {
+                            counters[BCSR_SPMM_CNT_B_BYTES] += (uint64_t)validRows * this->mmadN * sizeof(bType);
+                        }
+                    }
+                }
+                outQueueCO1.EnQue<cType>(c1Local);
+                uint64_t t5 = Cycle();
+                CopyOut(row, j);
+                if (PROFILE) {
+                    counters[BCSR_SPMM_CNT_COPY_OUT] += Cycle() - t5;
                 }
             }
+            if (PROFILE) {
+                counters[BCSR_SPMM_CNT_BLOCKS] += rowBlockNum;
+                counters[BCSR_SPMM_CNT_WINDOWS]++;
+            }
+        }
+        if (PROFILE) {
+            counters[BCSR_SPMM_CNT_CYCLES] = Cycle() - start;
+            WriteBcsrSpmmCounters(profileGm, counters, profileCores);
         }
     }
 
 private:
+    // 稠密窗口：A 整段取自 workspace 中的稠密行，缺失的块在其中为 0；K 按 denseKTile 连续切分，
+    // 每个 mmad 面板一次 Mmad 覆盖 denseKTile 行 K，在 L0C 中累加完整个 K 后写出一次。
+    // 写出方式与 BCSR 窗口相同：直写模式覆盖写，否则原子加到已清零的 C 上
+    __aicore__ inline void ProcessDense(uint32_t row, uint32_t slot, int64_t rowBlockNum)
+    {
+        for (int32_t j = 0; j < mmadNum; j++) {
+            AscendC::LocalTensor<cType> c1Local = outQueueCO1.AllocTensor<cType>();
+            for (int64_t k0 = 0; k0 < denseK; k0 += denseKTile) {
+                uint32_t kLength = denseK - k0 < (int64_t)denseKTile ? (uint32_t)(denseK - k0) : denseKTile;
+                uint32_t kBlocks = kLength / CUBE_BLOCK_K;
+                uint64_t t0 = Cycle();
+                CopyInDenseA(slot, k0, kBlocks);
+                uint64_t t1 = Cycle();
+                CopyInDenseB(j, k0, kBlocks);
+                uint64_t t2 = Cycle();
+                SplitA(kBlocks);
+                SplitDenseB(j, kBlocks);
+                uint64_t t3 = Cycle();
+                Accumulate(c1Local, j, k0 == 0, kBlocks);
+                if (PROFILE) {
+                    uint64_t t4 = Cycle();
+                    counters[BCSR_SPMM_CNT_COPY_IN_A] += t1 - t0;
+                    counters[BCSR_SPMM_CNT_COPY_IN_B] += t2 - t1;
+                    counters[BCSR_SPMM_CNT_SPLIT] += t3 - t2;
+                    counters[BCSR_SPMM_CNT_COMPUTE] += t4 - t3;
+                    counters[BCSR_SPMM_CNT_MMADS]++;
+                    int64_t validRows = K - k0 < (int64_t)kLength ? K - k0 : (int64_t)kLength;
+                    counters[BCSR_SPMM_CNT_B_BYTES] += (uint64_t)validRows * this->mmadN * sizeof(bType);
+                }
+            }
+            outQueueCO1.EnQue<cType>(c1Local);
+            uint64_t t5 = Cycle();
+            CopyOut(row, j);
+            if (PROFILE) {
+                counters[BCSR_SPMM_CNT_COPY_OUT] += Cycle() - t5;
+            }
+        }
+        if (PROFILE) {
+            counters[BCSR_SPMM_CNT_BLOCKS] += rowBlockNum;
+            counters[BCSR_SPMM_CNT_WINDOWS]++;
+            counters[BCSR_SPMM_CNT_DENSE_WINDOWS]++;
+        }
+    }
+
+    __aicore__ inline uint64_t Cycle() {
+        return PROFILE ? static_cast<uint64_t>(AscendC::GetSystemCycle()) : 0;
+    }
+
+    // 本 core 第 r 个窗口的窗口号，相对 rowPtrGm 的起点
+    __aicore__ inline uint32_t WindowAt(uint32_t r) {
+        uint32_t i = rowStart + r * rowStride;
+        return scheduled ? scheduleGm.GetValue(i) : i;
+    }
+
+    // 窗口在稠密行中的槽位 + 1，BCSR 窗口为 0
+    __aicore__ inline uint32_t DenseSlot(uint32_t row) {
+        return denseNum != 0 ? denseMapGm.GetValue(windowBase + row) : 0;
+    }
+
     // // 每次 A 只读一个块，所以 ND 即 ZZ
     // // 可以直接用 LoadData 搬运 512B, GM->A2
     // __aicore__ inline void CopyInA(int32_t row, int32_t i) {
@@ -104,9 +355,10 @@ private:
     // }
 
     // 但是这里保留 Gm->A1->A2 的形式，方便后续扩展
-    __aicore__ inline void CopyInA(int32_t row, int32_t i) {
+    // blk 为相对本 core 首块的块号
+    __aicore__ inline void CopyInA(int64_t blk) {
         AscendC::LocalTensor<aType> a1Local = inQueueA1.AllocTensor<aType>();
-        auto aGm = this->valGm[(rowPtrGm.GetValue(row) - rowPtrGm.GetValue(0) + i) * CUBE_BLOCK_SIZE];
+        auto aGm = this->valGm[(uint64_t)blk * CUBE_BLOCK_SIZE];
 
         AscendC::Nd2NzParams params;
         params.ndNum = 1;
@@ -128,14 +380,108 @@ private:
         inQueueA1.EnQue<aType>(a1Local);
     }
 
+    // 稠密行中 [k0, k0 + 16 * kBlocks) 一段是 kBlocks 个相接的 16 x 16 分形，整段搬入 A1 即为 L0A 的次序
+    __aicore__ inline void CopyInDenseA(uint32_t slot, int64_t k0, uint32_t kBlocks) {
+        AscendC::LocalTensor<aType> a1Local = inQueueA1.AllocTensor<aType>();
+        AscendC::DataCopy(a1Local, this->denseGm[((uint64_t)slot * denseK + k0) * CUBE_BLOCK_M],
+            kBlocks * CUBE_BLOCK_SIZE);
+        inQueueA1.EnQue<aType>(a1Local);
+    }
+
+    // B 的 [k0, k0 + 16 * kBlocks) 行依次放成 kBlocks 个 16 x mmadN 面板，布局与 LoadB 相同。
+    // 每个面板一次 ND2NZ 搬入，srcDValue 放不下 N 时退回逐行的 LoadB；越过 K 的行补 0，
+    // 最后一个面板越过 N 的列不清零，只影响 Fixpipe 不写出的 C 列
+    __aicore__ inline void CopyInDenseB(int32_t j, int64_t k0, uint32_t kBlocks) {
+        AscendC::LocalTensor<bType> b1Local = inQueueB1.AllocTensor<bType>();
+        uint32_t panelSize = CUBE_BLOCK_K * this->mmadN;
+        for (uint32_t kb = 0; kb < kBlocks; kb++) {
+            AscendC::LocalTensor<bType> panel = b1Local[kb * panelSize];
+            int64_t col = k0 + (int64_t)kb * CUBE_BLOCK_K;
+            if (N > 65535) {
+                LoadB(panel, j, col);
+                continue;
+            }
+            int64_t validRows = K - col < (int64_t)CUBE_BLOCK_K ? K - col : (int64_t)CUBE_BLOCK_K;
+            if (validRows > 0) {
+                AscendC::Nd2NzParams params;
+                params.ndNum = 1;
+                params.nValue = (uint16_t)validRows;
+                params.dValue = (uint16_t)((j == mmadNum - 1) ? lastMmadN : this->mmadN);
+                params.srcNdMatrixStride = 0;
+                params.srcDValue = (uint16_t)N;
+                params.dstNzC0Stride = CUBE_BLOCK_K;
+                params.dstNzNStride = 1;
+                params.dstNzMatrixStride = 0;
+                AscendC::DataCopy(panel, this->bGm[(uint64_t)col * N + (uint64_t)j * this->mmadN], params);
+            }
+            if (validRows < (int64_t)CUBE_BLOCK_K) {
+                int64_t start = validRows > 0 ? validRows : 0;
+                for (uint32_t k = 0; k < this->mmadN / 16; k++) {
+                    AscendC::Duplicate(panel[(start + k * CUBE_BLOCK_K) * 16], (bType)0,
+                        (int32_t)((CUBE_BLOCK_K - start) * 16));
+                }
+            }
+        }
+        inQueueB1.EnQue<bType>(b1Local);
+    }
+
+    // 空窗口的零 A 块与零 B 面板，直写模式用它们算出全 0 的 C 窗口
+    __aicore__ inline void CopyInZero() {
+        AscendC::LocalTensor<aType> a1Local = inQueueA1.AllocTensor<aType>();
+        AscendC::Duplicate(a1Local, (aType)0, CUBE_BLOCK_SIZE);
+        inQueueA1.EnQue<aType>(a1Local);
+        if (bCacheSlots != 0) {
+            // 缓存末尾多留的一个槽位在 Init 中清零，不带标签
+            bCacheSlot = bCacheSlots;
+            return;
+        }
+        AscendC::LocalTensor<bType> b1Local = inQueueB1.AllocTensor<bType>();
+        AscendC::Duplicate(b1Local, (bType)0, CUBE_BLOCK_K * this->mmadN);
+        inQueueB1.EnQue<bType>(b1Local);
+    }
+
     // DataCopy API for each line of B
     // 如果 leading N 太大用不了 ND2NZ 随路转化
-    __aicore__ inline void CopyInB(int32_t j, int32_t col) {
+    // 返回 B 面板是否命中 L1 缓存，不缓存时总是经 inQueueB1 从 GM 搬入
+    __aicore__ inline bool CopyInB(int32_t j, int64_t col) {
+        if (bCacheSlots != 0) {
+            return FetchB(j, col);
+        }
+        AscendC::LocalTensor<bType> b1Local = inQueueB1.AllocTensor<bType>();
+        LoadB(b1Local, j, col);
+        inQueueB1.EnQue<bType>(b1Local);
+        return false;
+    }
+
+    // 直接映射的 B 面板缓存：槽位由块列与面板号决定，标签为 col * mmadNum + j。
+    // 槽位只在 MTE2 写、MTE1 读之间交接：未命中时用 MTE1_MTE2 等读该槽位的 LoadData 完成再覆盖，
+    // 搬入后用 MTE2_MTE1 让 SplitB 等搬运完成，M 与 FixPipe 流水不受影响；
+    // 命中时 SplitB 直接从槽位读，省去整个面板的搬运
+    __aicore__ inline bool FetchB(int32_t j, int64_t col) {
+        int64_t tag = col * mmadNum + j;
+        bCacheSlot = (uint32_t)(((uint64_t)(col / CUBE_BLOCK_K) * mmadNum + j) & (bCacheSlots - 1));
+        if (bCacheTags[bCacheSlot] == tag) {
+            return true;
+        }
+        AscendC::LocalTensor<bType> b1Local = bCacheBuf.Get<bType>()[bCacheSlot * CUBE_BLOCK_K * this->mmadN];
+        WaitPipe<AscendC::HardEvent::MTE1_MTE2>();
+        LoadB(b1Local, j, col);
+        WaitPipe<AscendC::HardEvent::MTE2_MTE1>();
+        bCacheTags[bCacheSlot] = tag;
+        return false;
+    }
+
+    template <AscendC::HardEvent EVENT>
+    __aicore__ inline void WaitPipe() {
+        event_t eventId = static_cast<event_t>(GetTPipePtr()->FetchEventID(EVENT));
+        AscendC::SetFlag<EVENT>(eventId);
+        AscendC::WaitFlag<EVENT>(eventId);
+    }
+
+    __aicore__ inline void LoadB(AscendC::LocalTensor<bType> &b1Local, int32_t j, int64_t col) {
         // col是A的列，对B来说是行
         // j 是B的block的列
-        AscendC::LocalTensor<bType> b1Local = inQueueB1.AllocTensor<bType>();
-        
-        auto offset = col * N + j * this->mmadN;
+        uint64_t offset = (uint64_t)col * N + (uint64_t)j * this->mmadN;
         
         // AscendC::DataCopyParams params;
         // 有一小部分 padding 的数据是不需要的，Mmad 时会忽略
@@ -218,16 +564,16 @@ private:
         //     AscendC::ShapeInfo shapeInfo(2, array); 
         //     AscendC::DumpTensor(b1Local, 1, 16*32, shapeInfo);
         // }
-        inQueueB1.EnQue<bType>(b1Local);
     }
 
-    __aicore__ inline void SplitA() {
+    // kBlocks 为 K 方向的分形数，BCSR 块为 1，稠密窗口为一次 Mmad 的 K / 16
+    __aicore__ inline void SplitA(uint32_t kBlocks = 1) {
         AscendC::LocalTensor<aType> a1Local = inQueueA1.DeQue<aType>();
         AscendC::LocalTensor<aType> a2Local = inQueueA2.AllocTensor<aType>();
 
         AscendC::LoadData2DParams params;
         // params.repeatTimes = CUBE_BLOCK_SIZE * sizeof(aType) / 512;
-        params.repeatTimes = 1;
+        params.repeatTimes = (uint8_t)kBlocks;
         params.srcStride = 1;
         params.ifTranspose = false;
         AscendC::LoadData(a2Local, a1Local, params);
@@ -244,7 +590,9 @@ private:
     // NZ2ZN, LoadDataWithTranspose API
     // sizeof(bType) <= 2 时可以用
     __aicore__ inline void SplitB(int32_t progress) {
-        AscendC::LocalTensor<bType> b1Local = inQueueB1.DeQue<bType>();
+        // 缓存模式下面板留在槽位中，不经队列
+        AscendC::LocalTensor<bType> b1Local = bCacheSlots != 0 ?
+            bCacheBuf.Get<bType>()[bCacheSlot * CUBE_BLOCK_K * this->mmadN] : inQueueB1.DeQue<bType>();
         AscendC::LocalTensor<bType> b2Local = inQueueB2.AllocTensor<bType>();
 
         AscendC::LoadData2dTransposeParams params;
@@ -262,6 +610,28 @@ private:
         // // AscendC::DumpTensor(this->bGm[offset], 0, 16*32, shapeInfo);
         // AscendC::DumpTensor(b2Local, 1, 16*32, shapeInfo);
 
+        if (bCacheSlots == 0) {
+            inQueueB1.FreeTensor(b1Local);
+        }
+        inQueueB2.EnQue<bType>(b2Local);
+    }
+
+    // 稠密窗口的 B：kBlocks 个面板逐个转置，L0B 中 K 方向的分形行依次相接，与 Mmad 的 K 一致
+    __aicore__ inline void SplitDenseB(int32_t progress, uint32_t kBlocks) {
+        AscendC::LocalTensor<bType> b1Local = inQueueB1.DeQue<bType>();
+        AscendC::LocalTensor<bType> b2Local = inQueueB2.AllocTensor<bType>();
+
+        AscendC::LoadData2dTransposeParams params;
+        params.startIndex = 0;
+        params.repeatTimes = (progress == mmadNum - 1) ? lastMmadCubeBlockNum : mmadCubeBlockNum;
+        params.srcStride = 1;
+        params.dstGap = sizeof(bType) <= 2 ? 0 : 1;
+        params.dstFracGap = 0;
+        for (uint32_t kb = 0; kb < kBlocks; kb++) {
+            AscendC::LoadDataWithTranspose(b2Local[kb * params.repeatTimes * CUBE_BLOCK_K * 16],
+                b1Local[kb * CUBE_BLOCK_K * this->mmadN], params);
+        }
+
         inQueueB1.FreeTensor(b1Local);
         inQueueB2.EnQue<bType>(b2Local);
     }
@@ -304,9 +674,26 @@ private:
         inQueueB2.FreeTensor(b2Local);
     }
 
+    // 直写模式与稠密窗口的 Mmad：init 时覆盖 L0C，否则累加到 c1Local 已有的部分和上
+    __aicore__ inline void Accumulate(AscendC::LocalTensor<cType> &c1Local, int32_t progress, bool init,
+        uint32_t kBlocks = 1) {
+        AscendC::LocalTensor<aType> a2Local = inQueueA2.DeQue<aType>();
+        AscendC::LocalTensor<bType> b2Local = inQueueB2.DeQue<bType>();
+
+        AscendC::MmadParams params;
+        params.m = CUBE_BLOCK_M;
+        params.k = CUBE_BLOCK_K * kBlocks;
+        params.n = (progress == mmadNum - 1) ? lastMmadN : this->mmadN;
+        params.cmatrixInitVal = init;
+        AscendC::Mmad(c1Local, a2Local, b2Local, params);
+
+        inQueueA2.FreeTensor(a2Local);
+        inQueueB2.FreeTensor(b2Local);
+    }
+
     // Fixpipe API
-    __aicore__ inline void CopyOut(int32_t row, int32_t progress) {
-        auto cGm = this->cGm[row * CUBE_BLOCK_M * N + progress * mmadCubeBlockNum * CUBE_BLOCK_M];
+    __aicore__ inline void CopyOut(uint32_t row, int32_t progress) {
+        auto cGm = this->cGm[(uint64_t)row * CUBE_BLOCK_M * N + progress * mmadCubeBlockNum * CUBE_BLOCK_M];
         AscendC::LocalTensor<cType> c1Local = outQueueCO1.DeQue<cType>();
 
         AscendC::FixpipeParamsV220 params;
@@ -318,9 +705,16 @@ private:
         params.srcNdStride = 0;
         params.dstNdStride = 0;
 
-        AscendC::SetAtomicAdd<cType>();
-        AscendC::Fixpipe(cGm, c1Local, params);
-        AscendC::SetAtomicNone();
+        if (directOutput != 0) {
+            // 覆盖写不能越过 M，最后一个窗口只写有效行
+            int64_t rowEnd = (int64_t)M - (int64_t)(windowBase + row) * CUBE_BLOCK_M;
+            params.mSize = rowEnd < (int64_t)CUBE_BLOCK_M ? (uint16_t)rowEnd : (uint16_t)CUBE_BLOCK_M;
+            AscendC::Fixpipe(cGm, c1Local, params);
+        } else {
+            AscendC::SetAtomicAdd<cType>();
+            AscendC::Fixpipe(cGm, c1Local, params);
+            AscendC::SetAtomicNone();
+        }
         // AscendC::printf("Debug C Block: row %d, block col %d\n", row, progress);
         uint32_t array[] = {static_cast<uint32_t>(16), static_cast<uint32_t>(32)};
         AscendC::ShapeInfo shapeInfo(2, array); 
@@ -336,18 +730,36 @@ private:
     AscendC::TQue<AscendC::TPosition::B1, 1> inQueueB1;
     AscendC::TQue<AscendC::TPosition::B2, 1> inQueueB2;
     AscendC::TQue<AscendC::TPosition::CO1, 1> outQueueCO1;
+    AscendC::TBuf<AscendC::TPosition::B1> bCacheBuf;
 
-    AscendC::GlobalTensor<int32_t> rowPtrGm;
-    AscendC::GlobalTensor<int32_t> colGm;
+    AscendC::GlobalTensor<idxType> rowPtrGm;
+    AscendC::GlobalTensor<colType> colGm;
     AscendC::GlobalTensor<aType> valGm;
 
     AscendC::GlobalTensor<bType> bGm;
     AscendC::GlobalTensor<cType> cGm;
+    AscendC::GlobalTensor<uint64_t> profileGm;
+    AscendC::GlobalTensor<uint32_t> scheduleGm;
+    AscendC::GlobalTensor<uint32_t> denseMapGm;
+    AscendC::GlobalTensor<aType> denseGm;
+    uint64_t counters[BCSR_SPMM_CNT_NUM];
 
     int32_t M;
-    int32_t K;
+    int64_t K;
     int32_t N;
     uint32_t rowWindowNum;
+    uint32_t rowStart;
+    uint32_t rowStride;
+    bool scheduled;
+    uint64_t windowBase;    // rowPtrGm 起点的全局窗口号，直写时据此裁掉越过 M 的行
+    uint32_t directOutput;
+    uint32_t bCacheSlots;
+    uint32_t bCacheSlot;    // 本轮 SplitB 读取的槽位
+    int64_t bCacheTags[BCSR_SPMM_B_CACHE_MAX_SLOTS];
+    uint32_t denseNum;
+    uint32_t denseKTile;
+    int64_t denseK;         // K 补到 16 的倍数，即一条稠密行的列数
+    uint32_t profileCores;
     uint32_t mmadNum;
     uint32_t mmadCubeBlockNum;
     uint32_t lastMmadN;
@@ -356,21 +768,541 @@ private:
     uint32_t lastKLength;
 };
 
-extern "C" __global__ __aicore__ void bcsr_spmm_custom(
-    GM_ADDR a_shape, GM_ADDR row_ptr, GM_ADDR col, GM_ADDR val,
-    GM_ADDR b, GM_ADDR c,
-    GM_ADDR workspace, GM_ADDR tiling
+// N < BCSR_SPMM_SMALL_N（SpMV 与少量右端项）时在 AIV 上逐块做 fp16 -> fp32 的乘加：
+// A 块与 16 x N 的 B 面板转成 fp32，B 经 Gather 转置为 N 个 16 元列向量；Mul 以 src1 repeat stride 0
+// 把列向量广播到 16 行，WholeReduceSum 一次归约出全部 N x 16 个点积，累加在按列存放的窗口结果里。
+// 窗口只属于一个 core，结束时 Gather 回行主序直接写 C，不需要原子加
+template<typename idxType, typename colType, bool PROFILE = false>
+class BcsrSpmvKernel {
+uint32_t TILE = 16;
+uint32_t TILE_SIZE = 16 * 16;
+// col 的解码倍数
+uint32_t COL_UNIT = sizeof(colType) == sizeof(uint16_t) ? 16 : 1;
+
+public:
+    __aicore__ inline BcsrSpmvKernel() {}
+    __aicore__ inline void Init(
+        GM_ADDR row_ptr, GM_ADDR col, GM_ADDR val,
+        GM_ADDR b, GM_ADDR c, GM_ADDR workspace,
+        int32_t M, int32_t N, int32_t K,
+        uint32_t formerNum, uint32_t formerLength,
+        uint32_t tailNum, uint32_t tailLength,
+        uint32_t totalLength, uint32_t partition
+    ) {
+        this->M = M;
+        this->N = N;
+        this->K = K;
+        // 与 cube kernel 相同的窗口分配，这里下标都是全局的
+        this->rowStride = 1;
+        this->rowWindowNum = 0;
+        if (partition == BCSR_SPMM_PARTITION_CYCLIC) {
+            uint32_t blockNum = AscendC::GetBlockNum();
+            this->rowWindowNum = (totalLength - AscendC::GetBlockIdx() + blockNum - 1) / blockNum;
+            this->rowStart = AscendC::GetBlockIdx();
+            this->rowStride = blockNum;
+        } else if (AscendC::GetBlockIdx() < formerNum) {
+            this->rowWindowNum = formerLength;
+            this->rowStart = formerLength * AscendC::GetBlockIdx();
+        } else if (AscendC::GetBlockIdx() < formerNum + tailNum) {
+            this->rowWindowNum = tailLength;
+            this->rowStart = formerLength * formerNum + tailLength * (AscendC::GetBlockIdx() - formerNum);
+        }
+        rowPtrGm.SetGlobalBuffer((__gm__ idxType *)row_ptr, totalLength + 1);
+        int64_t blockNum = static_cast<int64_t>(rowPtrGm.GetValue(totalLength));
+        colGm.SetGlobalBuffer((__gm__ colType *)col, blockNum);
+        valGm.SetGlobalBuffer((__gm__ half *)val, (uint64_t)blockNum * TILE_SIZE);
+        bGm.SetGlobalBuffer((__gm__ half *)b, (uint64_t)K * N);
+        cGm.SetGlobalBuffer((__gm__ float *)c, (uint64_t)M * N);
+        if (PROFILE) {
+            profileGm.SetGlobalBuffer((__gm__ uint64_t *)AscendC::GetUserWorkspace(workspace) +
+                AscendC::GetBlockIdx() * BCSR_SPMM_CNT_NUM, BCSR_SPMM_CNT_NUM);
+            for (uint32_t i = 0; i < BCSR_SPMM_CNT_NUM; i++) {
+                counters[i] = 0;
+            }
+        }
+
+        pipe.InitBuffer(inQueueA, 2, TILE_SIZE * sizeof(half));
+        pipe.InitBuffer(inQueueB, 2, TILE_SIZE * sizeof(half));
+        pipe.InitBuffer(outQueueC, 1, TILE_SIZE * sizeof(float));
+        pipe.InitBuffer(aBuf, TILE_SIZE * sizeof(float));
+        pipe.InitBuffer(bBuf, TILE_SIZE * sizeof(float));
+        pipe.InitBuffer(bTBuf, TILE_SIZE * sizeof(float));
+        pipe.InitBuffer(productBuf, BCSR_SPMM_SMALL_N * TILE_SIZE * sizeof(float));
+        pipe.InitBuffer(sumBuf, TILE_SIZE * sizeof(float));
+        pipe.InitBuffer(accBuf, TILE_SIZE * sizeof(float));
+        pipe.InitBuffer(bOffsetBuf, TILE_SIZE * sizeof(uint32_t));
+        pipe.InitBuffer(cOffsetBuf, TILE_SIZE * sizeof(uint32_t));
+
+        // Gather 的字节偏移：bT[n][k] = b[k][n]，c[r][n] = acc[n][r]
+        AscendC::LocalTensor<uint32_t> bOffset = bOffsetBuf.Get<uint32_t>();
+        AscendC::LocalTensor<uint32_t> cOffset = cOffsetBuf.Get<uint32_t>();
+        for (int32_t n = 0; n < N; n++) {
+            for (uint32_t k = 0; k < TILE; k++) {
+                bOffset.SetValue(n * TILE + k, (k * N + n) * sizeof(float));
+                cOffset.SetValue(k * N + n, (n * TILE + k) * sizeof(float));
+            }
+        }
+        AscendC::PipeBarrier<PIPE_ALL>();
+    }
+
+    __aicore__ inline void Process()
+    {
+        uint64_t start = Cycle();
+        AscendC::LocalTensor<float> acc = accBuf.Get<float>();
+        for (uint32_t r = 0; r < rowWindowNum; r++) {
+            uint32_t row = rowStart + r * rowStride;
+            AscendC::Duplicate(acc, 0.0f, N * TILE);
+            AscendC::PipeBarrier<PIPE_V>();
+            int64_t blkEnd = static_cast<int64_t>(rowPtrGm.GetValue(row + 1));
+            for (int64_t blk = static_cast<int64_t>(rowPtrGm.GetValue(row)); blk < blkEnd; blk++) {
+                int64_t col = static_cast<int64_t>(colGm.GetValue(blk)) * COL_UNIT;
+                uint64_t t0 = Cycle();
+                CopyIn(blk, col);
+                uint64_t t1 = Cycle();
+                Compute();
+                if (PROFILE) {
+                    counters[BCSR_SPMM_CNT_COPY_IN_B] += t1 - t0;
+                    counters[BCSR_SPMM_CNT_COMPUTE] += Cycle() - t1;
+                    counters[BCSR_SPMM_CNT_BLOCKS]++;
+                    counters[BCSR_SPMM_CNT_MMADS]++;
+                    counters[BCSR_SPMM_CNT_B_BYTES] += (uint64_t)validRows * N * sizeof(half);
+                }
+            }
+            uint64_t t2 = Cycle();
+            CopyOut(row);
+            if (PROFILE) {
+                counters[BCSR_SPMM_CNT_COPY_OUT] += Cycle() - t2;
+                counters[BCSR_SPMM_CNT_WINDOWS]++;
+            }
+        }
+        if (PROFILE) {
+            counters[BCSR_SPMM_CNT_CYCLES] = Cycle() - start;
+            WriteBcsrSpmmCounters(profileGm, counters);
+        }
+    }
+
+private:
+    __aicore__ inline uint64_t Cycle() {
+        return PROFILE ? static_cast<uint64_t>(AscendC::GetSystemCycle()) : 0;
+    }
+
+    // A 块 512B 对齐整块搬运；B 面板是连续的 validRows x N 个 fp16，越过 K 的行不搬
+    __aicore__ inline void CopyIn(int64_t blk, int64_t col) {
+        AscendC::LocalTensor<half> aLocal = inQueueA.AllocTensor<half>();
+        AscendC::DataCopy(aLocal, valGm[(uint64_t)blk * TILE_SIZE], TILE_SIZE);
+        inQueueA.EnQue<half>(aLocal);
+
+        validRows = K - col < (int64_t)TILE ? (int32_t)(K - col) : (int32_t)TILE;
+        AscendC::LocalTensor<half> bLocal = inQueueB.AllocTensor<half>();
+        AscendC::DataCopyExtParams params{1, (uint32_t)(validRows * N * sizeof(half)), 0, 0, 0};
+        AscendC::DataCopyPadExtParams<half> padParams{false, 0, 0, 0};
+        AscendC::DataCopyPad(bLocal, bGm[(uint64_t)col * N], params, padParams);
+        inQueueB.EnQue<half>(bLocal);
+    }
+
+    __aicore__ inline void Compute() {
+        AscendC::LocalTensor<half> aLocal = inQueueA.DeQue<half>();
+        AscendC::LocalTensor<half> bLocal = inQueueB.DeQue<half>();
+        AscendC::LocalTensor<float> a = aBuf.Get<float>();
+        AscendC::LocalTensor<float> bRow = bBuf.Get<float>();
+        AscendC::LocalTensor<float> bT = bTBuf.Get<float>();
+        AscendC::LocalTensor<float> product = productBuf.Get<float>();
+        AscendC::LocalTensor<float> sum = sumBuf.Get<float>();
+        AscendC::LocalTensor<float> acc = accBuf.Get<float>();
+
+        AscendC::Cast(a, aLocal, AscendC::RoundMode::CAST_NONE, TILE_SIZE);
+        AscendC::Cast(bRow, bLocal, AscendC::RoundMode::CAST_NONE, validRows * N);
+        // 未搬运的行可能是任意位模式，A 中对应列虽为 0，0 * NaN 仍是 NaN
+        if (validRows < (int32_t)TILE) {
+            AscendC::Duplicate(bRow[validRows * N], 0.0f, (TILE - validRows) * N);
+        }
+        AscendC::PipeBarrier<PIPE_V>();
+        AscendC::Gather(bT, bRow, bOffsetBuf.Get<uint32_t>(), (uint32_t)0, N * TILE);
+        AscendC::PipeBarrier<PIPE_V>();
+
+        // product[n][r][k] = a[r][k] * bT[n][k]：一次 repeat 处理 A 的一行，bT 的 16 个元素重复使用
+        AscendC::BinaryRepeatParams repeatParams(1, 1, 1, 2, 2, 0);
+        for (int32_t n = 0; n < N; n++) {
+            AscendC::Mul(product[n * TILE_SIZE], a, bT[n * TILE], (uint64_t)TILE, TILE, repeatParams);
+        }
+        AscendC::PipeBarrier<PIPE_V>();
+        // 每 16 个元素归约为一个点积，得到按列存放的 sum[n][r]
+        AscendC::WholeReduceSum<float>(sum, product, TILE, N * TILE, 1, 1, 2);
+        AscendC::PipeBarrier<PIPE_V>();
+        AscendC::Add(acc, acc, sum, N * TILE);
+        AscendC::PipeBarrier<PIPE_V>();
+
+        inQueueA.FreeTensor(aLocal);
+        inQueueB.FreeTensor(bLocal);
+    }
+
+    __aicore__ inline void CopyOut(uint32_t row) {
+        AscendC::LocalTensor<float> cLocal = outQueueC.AllocTensor<float>();
+        AscendC::Gather(cLocal, accBuf.Get<float>(), cOffsetBuf.Get<uint32_t>(), (uint32_t)0, N * TILE);
+        outQueueC.EnQue<float>(cLocal);
+        cLocal = outQueueC.DeQue<float>();
+        // M 不对齐时最后一个窗口只写有效行
+        int64_t rowEnd = (int64_t)M - (int64_t)row * TILE;
+        int32_t validM = rowEnd < (int64_t)TILE ? (int32_t)rowEnd : (int32_t)TILE;
+        AscendC::DataCopyExtParams params{1, (uint32_t)(validM * N * sizeof(float)), 0, 0, 0};
+        AscendC::DataCopyPad(cGm[(uint64_t)row * TILE * N], cLocal, params);
+        outQueueC.FreeTensor(cLocal);
+    }
+
+private:
+    AscendC::TPipe pipe;
+    AscendC::TQue<AscendC::TPosition::VECIN, 2> inQueueA;
+    AscendC::TQue<AscendC::TPosition::VECIN, 2> inQueueB;
+    AscendC::TQue<AscendC::TPosition::VECOUT, 1> outQueueC;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> aBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> bBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> bTBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> productBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> sumBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> accBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> bOffsetBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> cOffsetBuf;
+
+    AscendC::GlobalTensor<idxType> rowPtrGm;
+    AscendC::GlobalTensor<colType> colGm;
+    AscendC::GlobalTensor<half> valGm;
+    AscendC::GlobalTensor<half> bGm;
+    AscendC::GlobalTensor<float> cGm;
+    AscendC::GlobalTensor<uint64_t> profileGm;
+    uint64_t counters[BCSR_SPMM_CNT_NUM];
+
+    int32_t M;
+    int64_t K;
+    int32_t N;
+    int32_t validRows;
+    uint32_t rowWindowNum;
+    uint32_t rowStart;
+    uint32_t rowStride;
+};
+
+// MIX 模式的向量核：处理调度表最后 mixNum 项中的极稀疏窗口。A 块整块搬入 UB 后与 0 比较得到
+// 16 x 16 的位图，标量侧只读 16 个行位图，块内用到的每个 K 行只搬一次 B 的 N 段，
+// 再对该行的每个非零元 a[r][k] 做 Axpy(acc[r], B[k], a)；块内空的列与零元都不产生搬运和计算。
+// 窗口只属于一个向量核，累加器按 mixNTile 列分段，每段结束时覆盖写 C，cube 不会写到这些行
+template<typename idxType, typename colType, bool PROFILE = false>
+class BcsrSpmmGatherKernel {
+uint32_t TILE = 16;
+uint32_t TILE_SIZE = 16 * 16;
+// col 的解码倍数
+uint32_t COL_UNIT = sizeof(colType) == sizeof(uint16_t) ? 16 : 1;
+
+public:
+    __aicore__ inline BcsrSpmmGatherKernel() {}
+    __aicore__ inline void Init(
+        GM_ADDR row_ptr, GM_ADDR col, GM_ADDR val,
+        GM_ADDR b, GM_ADDR c, GM_ADDR workspace,
+        int32_t M, int32_t N, int32_t K,
+        uint32_t totalLength, uint32_t mixNum, uint32_t mixNTile
+    ) {
+        this->M = M;
+        this->N = N;
+        this->K = K;
+        this->nTile = mixNTile;
+        // MIX_AIC_1_2 下向量核的 GetBlockIdx 取值为 [0, blockDim * 2)，GetBlockNum 为 cube core 数
+        uint32_t vectorIdx = AscendC::GetBlockIdx();
+        uint32_t vectorNum = AscendC::GetBlockNum() * AscendC::GetTaskRation();
+        this->rowStart = totalLength - mixNum + vectorIdx;
+        this->rowStride = vectorNum;
+        this->rowWindowNum = vectorIdx < mixNum ? (mixNum - vectorIdx + vectorNum - 1) / vectorNum : 0;
+
+        rowPtrGm.SetGlobalBuffer((__gm__ idxType *)row_ptr, totalLength + 1);
+        int64_t blockNum = static_cast<int64_t>(rowPtrGm.GetValue(totalLength));
+        colGm.SetGlobalBuffer((__gm__ colType *)col, blockNum);
+        valGm.SetGlobalBuffer((__gm__ half *)val, (uint64_t)blockNum * TILE_SIZE);
+        bGm.SetGlobalBuffer((__gm__ half *)b, (uint64_t)K * N);
+        cGm.SetGlobalBuffer((__gm__ float *)c, (uint64_t)M * N);
+        // 调度表紧跟在计数区之后，与 cube kernel 读的是同一张表
+        uint64_t offset = PROFILE ? BCSR_SPMM_PROFILE_BYTES : 0;
+        scheduleGm.SetGlobalBuffer((__gm__ uint32_t *)(AscendC::GetUserWorkspace(workspace) + offset), totalLength);
+        if (PROFILE) {
+            // 向量核的槽位排在全部 cube core 之后
+            profileGm.SetGlobalBuffer((__gm__ uint64_t *)AscendC::GetUserWorkspace(workspace) +
+                (AscendC::GetBlockNum() + vectorIdx) * BCSR_SPMM_CNT_NUM, BCSR_SPMM_CNT_NUM);
+            for (uint32_t i = 0; i < BCSR_SPMM_CNT_NUM; i++) {
+                counters[i] = 0;
+            }
+            counters[BCSR_SPMM_CNT_VECTOR] = 1;
+        }
+
+        pipe.InitBuffer(inQueueA, 2, TILE_SIZE * sizeof(half));
+        pipe.InitBuffer(inQueueB, 2, nTile * sizeof(half));
+        pipe.InitBuffer(outQueueC, 1, TILE * nTile * sizeof(float));
+        pipe.InitBuffer(maskBuf, TILE_SIZE / 8);
+    }
+
+    __aicore__ inline void Process()
+    {
+        uint64_t start = Cycle();
+        for (uint32_t r = 0; r < rowWindowNum; r++) {
+            uint32_t row = scheduleGm.GetValue(rowStart + r * rowStride);
+            int64_t blkBegin = static_cast<int64_t>(rowPtrGm.GetValue(row));
+            int64_t blkEnd = static_cast<int64_t>(rowPtrGm.GetValue(row + 1));
+            for (int32_t n0 = 0; n0 < N; n0 += nTile) {
+                int32_t nLength = N - n0 < (int32_t)nTile ? N - n0 : (int32_t)nTile;
+                AscendC::LocalTensor<float> acc = outQueueC.AllocTensor<float>();
+                AscendC::Duplicate(acc, 0.0f, TILE * nTile);
+                AscendC::PipeBarrier<PIPE_V>();
+                for (int64_t blk = blkBegin; blk < blkEnd; blk++) {
+                    int64_t col = static_cast<int64_t>(colGm.GetValue(blk)) * COL_UNIT;
+                    GatherBlock(acc, blk, col, n0, nLength);
+                }
+                outQueueC.EnQue<float>(acc);
+                uint64_t t0 = Cycle();
+                CopyOut(row, n0, nLength);
+                if (PROFILE) {
+                    counters[BCSR_SPMM_CNT_COPY_OUT] += Cycle() - t0;
+                }
+            }
+            if (PROFILE) {
+                counters[BCSR_SPMM_CNT_BLOCKS] += blkEnd - blkBegin;
+                counters[BCSR_SPMM_CNT_WINDOWS]++;
+            }
+        }
+        if (PROFILE) {
+            counters[BCSR_SPMM_CNT_CYCLES] = Cycle() - start;
+            WriteBcsrSpmmCounters(profileGm, counters, 1 + AscendC::GetTaskRation());
+        }
+    }
+
+private:
+    __aicore__ inline uint64_t Cycle() {
+        return PROFILE ? static_cast<uint64_t>(AscendC::GetSystemCycle()) : 0;
+    }
+
+    // 一个 A 块对累加器 acc 中 [n0, n0 + nLength) 列的贡献
+    __aicore__ inline void GatherBlock(AscendC::LocalTensor<float> &acc, int64_t blk, int64_t col,
+                                       int32_t n0, int32_t nLength) {
+        uint64_t t0 = Cycle();
+        AscendC::LocalTensor<half> aLocal = inQueueA.AllocTensor<half>();
+        AscendC::DataCopy(aLocal, valGm[(uint64_t)blk * TILE_SIZE], TILE_SIZE);
+        inQueueA.EnQue<half>(aLocal);
+        aLocal = inQueueA.DeQue<half>();
+        // 位 r * 16 + k 标记 a[r][k] != 0，按 uint16 读即第 r 行的位图
+        AscendC::LocalTensor<uint8_t> mask = maskBuf.Get<uint8_t>();
+        AscendC::CompareScalar(mask, aLocal, (half)0, AscendC::CMPMODE::NE, TILE_SIZE);
+        event_t eventVS = static_cast<event_t>(GetTPipePtr()->FetchEventID(AscendC::HardEvent::V_S));
+        AscendC::SetFlag<AscendC::HardEvent::V_S>(eventVS);
+        AscendC::WaitFlag<AscendC::HardEvent::V_S>(eventVS);
+        AscendC::LocalTensor<uint16_t> rowMask = mask.ReinterpretCast<uint16_t>();
+        uint16_t rowBits[16];
+        uint32_t colBits = 0;
+        for (uint32_t r = 0; r < TILE; r++) {
+            rowBits[r] = rowMask.GetValue(r);
+            colBits |= rowBits[r];
+        }
+        // 越过 K 的列在 A 中为 0，这里再截一次，保证不会读到 B 之外
+        int64_t validRows = K - col < (int64_t)TILE ? K - col : (int64_t)TILE;
+        colBits &= validRows >= (int64_t)TILE ? 0xffffu : ((1u << validRows) - 1);
+        uint64_t t1 = Cycle();
+        if (PROFILE) {
+            counters[BCSR_SPMM_CNT_COPY_IN_A] += t1 - t0;
+        }
+
+        for (uint32_t k = 0; k < TILE; k++) {
+            if ((colBits & (1u << k)) == 0) {
+                continue;
+            }
+            uint64_t t2 = Cycle();
+            AscendC::LocalTensor<half> bLocal = inQueueB.AllocTensor<half>();
+            AscendC::DataCopyExtParams params{1, (uint32_t)(nLength * sizeof(half)), 0, 0, 0};
+            AscendC::DataCopyPadExtParams<half> padParams{false, 0, 0, 0};
+            AscendC::DataCopyPad(bLocal, bGm[(uint64_t)(col + k) * N + n0], params, padParams);
+            inQueueB.EnQue<half>(bLocal);
+            bLocal = inQueueB.DeQue<half>();
+            uint64_t t3 = Cycle();
+            for (uint32_t r = 0; r < TILE; r++) {
+                if ((rowBits[r] & (1u << k)) != 0) {
+                    AscendC::Axpy<float, half>(acc[r * nTile], bLocal, aLocal.GetValue(r * TILE + k), nLength);
+                    if (PROFILE) {
+                        counters[BCSR_SPMM_CNT_MMADS]++;
+                    }
+                }
+            }
+            // 下一行 B 的 Axpy 会累加到同一批累加器行上
+            AscendC::PipeBarrier<PIPE_V>();
+            inQueueB.FreeTensor(bLocal);
+            if (PROFILE) {
+                counters[BCSR_SPMM_CNT_COPY_IN_B] += t3 - t2;
+                counters[BCSR_SPMM_CNT_COMPUTE] += Cycle() - t3;
+                counters[BCSR_SPMM_CNT_B_BYTES] += (uint64_t)nLength * sizeof(half);
+            }
+        }
+        inQueueA.FreeTensor(aLocal);
+    }
+
+    // 累加器每行 nTile 列，只写 [n0, n0 + nLength)；M 不对齐时最后一个窗口只写有效行
+    __aicore__ inline void CopyOut(uint32_t row, int32_t n0, int32_t nLength) {
+        AscendC::LocalTensor<float> acc = outQueueC.DeQue<float>();
+        int64_t rowEnd = (int64_t)M - (int64_t)row * TILE;
+        int32_t validM = rowEnd < (int64_t)TILE ? (int32_t)rowEnd : (int32_t)TILE;
+        uint32_t rowBlocks = (nLength * sizeof(float) + 31) / 32;
+        AscendC::DataCopyExtParams params{(uint16_t)validM, (uint32_t)(nLength * sizeof(float)),
+            nTile * (uint32_t)sizeof(float) / 32 - rowBlocks, (uint32_t)((N - nLength) * sizeof(float)), 0};
+        AscendC::DataCopyPad(cGm[(uint64_t)row * TILE * N + n0], acc, params);
+        outQueueC.FreeTensor(acc);
+    }
+
+private:
+    AscendC::TPipe pipe;
+    AscendC::TQue<AscendC::TPosition::VECIN, 2> inQueueA;
+    AscendC::TQue<AscendC::TPosition::VECIN, 2> inQueueB;
+    AscendC::TQue<AscendC::TPosition::VECOUT, 1> outQueueC;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> maskBuf;
+
+    AscendC::GlobalTensor<idxType> rowPtrGm;
+    AscendC::GlobalTensor<colType> colGm;
+    AscendC::GlobalTensor<half> valGm;
+    AscendC::GlobalTensor<half> bGm;
+    AscendC::GlobalTensor<float> cGm;
+    AscendC::GlobalTensor<uint32_t> scheduleGm;
+    AscendC::GlobalTensor<uint64_t> profileGm;
+    uint64_t counters[BCSR_SPMM_CNT_NUM];
+
+    int32_t M;
+    int64_t K;
+    int32_t N;
+    uint32_t nTile;
+    uint32_t rowWindowNum;
+    uint32_t rowStart;
+    uint32_t rowStride;
+};
+
+template<typename idxType, typename colType, bool PROFILE>
+__aicore__ inline void RunBcsrSpmv(
+    GM_ADDR row_ptr, GM_ADDR col, GM_ADDR val,
+    GM_ADDR b, GM_ADDR c, GM_ADDR workspace,
+    const BcsrSpmmCustomTilingData &tiling_data
 ) {
-    GET_TILING_DATA(tiling_data, tiling);
+    BcsrSpmvKernel<idxType, colType, PROFILE> op;
+    op.Init(row_ptr, col, val, b, c, workspace,
+        tiling_data.M, tiling_data.N, tiling_data.K,
+        tiling_data.formerNum, tiling_data.formerLength,
+        tiling_data.tailNum, tiling_data.tailLength,
+        tiling_data.totalLength, tiling_data.partition
+    );
+    op.Process();
+}
 
-    BcsrSpmmKernel<half, half, float> op;
+template<typename idxType, typename colType, bool PROFILE>
+__aicore__ inline void RunBcsrSpmm(
+    GM_ADDR a_shape, GM_ADDR row_ptr, GM_ADDR col, GM_ADDR val,
+    GM_ADDR b, GM_ADDR c, GM_ADDR workspace,
+    const BcsrSpmmCustomTilingData &tiling_data
+) {
+    BcsrSpmmKernel<half, half, float, idxType, colType, PROFILE> op;
     op.Init(a_shape, row_ptr, col, val, b, c, workspace,
         tiling_data.M, tiling_data.N, tiling_data.K,
         tiling_data.formerNum, tiling_data.formerLength,
         tiling_data.tailNum, tiling_data.tailLength,
         tiling_data.mmadNum, tiling_data.mmadN,
         tiling_data.lastMmadN, tiling_data.lastMmadCubeBlockNum, 
-        tiling_data.lastKLength
+        tiling_data.lastKLength, tiling_data.totalLength, tiling_data.partition,
+        tiling_data.directOutput, tiling_data.bCacheSlots,
+        tiling_data.denseNum, tiling_data.denseKTile, tiling_data.denseMapOffset, tiling_data.denseStoreOffset,
+        tiling_data.mixNum
     );
     op.Process();
+}
+
+// MIX 模式：cube core 取调度表的前段，向量核取最后 mixNum 项，两边写 C 的不同行窗口
+template<typename idxType, typename colType, bool PROFILE>
+__aicore__ inline void RunBcsrSpmmMix(
+    GM_ADDR a_shape, GM_ADDR row_ptr, GM_ADDR col, GM_ADDR val,
+    GM_ADDR b, GM_ADDR c, GM_ADDR workspace,
+    const BcsrSpmmCustomTilingData &tiling_data
+) {
+    if ASCEND_IS_AIC {
+        RunBcsrSpmm<idxType, colType, PROFILE>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    }
+    if ASCEND_IS_AIV {
+        BcsrSpmmGatherKernel<idxType, colType, PROFILE> op;
+        op.Init(row_ptr, col, val, b, c, workspace,
+            tiling_data.M, tiling_data.N, tiling_data.K,
+            tiling_data.totalLength, tiling_data.mixNum, tiling_data.mixNTile
+        );
+        op.Process();
+    }
+}
+
+extern "C" __global__ __aicore__ void bcsr_spmm_custom(
+    GM_ADDR a_shape, GM_ADDR row_ptr, GM_ADDR col, GM_ADDR val,
+    GM_ADDR b, GM_ADDR c,
+    GM_ADDR workspace, GM_ADDR tiling
+) {
+    GET_TILING_DATA(tiling_data, tiling);
+    // 未声明 KERNEL_TASK_TYPE 的 tiling key 只用 cube，向量与 MIX 的 key 在各自分支内声明
+    KERNEL_TASK_TYPE_DEFAULT(KERNEL_TYPE_AIC_ONLY);
+
+    // tiling key 见 bcsr_spmm_desc.h 中的 BCSR_SPMM_TILING_KEY_*：
+    // 个位为 col 编码，+10 插桩版，+20 小 N 向量 kernel，+40 int64 row_ptr，+80 MIX 模式
+    if (TILING_KEY_IS(0)) {
+        RunBcsrSpmm<int32_t, int32_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(1)) {
+        RunBcsrSpmm<int32_t, uint16_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(10)) {
+        RunBcsrSpmm<int32_t, int32_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(11)) {
+        RunBcsrSpmm<int32_t, uint16_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(20)) {
+        KERNEL_TASK_TYPE(20, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int32_t, int32_t, false>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(21)) {
+        KERNEL_TASK_TYPE(21, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int32_t, uint16_t, false>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(30)) {
+        KERNEL_TASK_TYPE(30, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int32_t, int32_t, true>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(31)) {
+        KERNEL_TASK_TYPE(31, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int32_t, uint16_t, true>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(41)) {
+        RunBcsrSpmm<int64_t, uint16_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(42)) {
+        RunBcsrSpmm<int64_t, int64_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(51)) {
+        RunBcsrSpmm<int64_t, uint16_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(52)) {
+        RunBcsrSpmm<int64_t, int64_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(61)) {
+        KERNEL_TASK_TYPE(61, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int64_t, uint16_t, false>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(62)) {
+        KERNEL_TASK_TYPE(62, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int64_t, int64_t, false>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(71)) {
+        KERNEL_TASK_TYPE(71, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int64_t, uint16_t, true>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(72)) {
+        KERNEL_TASK_TYPE(72, KERNEL_TYPE_AIV_ONLY);
+        RunBcsrSpmv<int64_t, int64_t, true>(row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(80)) {
+        KERNEL_TASK_TYPE(80, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int32_t, int32_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(81)) {
+        KERNEL_TASK_TYPE(81, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int32_t, uint16_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(90)) {
+        KERNEL_TASK_TYPE(90, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int32_t, int32_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(91)) {
+        KERNEL_TASK_TYPE(91, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int32_t, uint16_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(121)) {
+        KERNEL_TASK_TYPE(121, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int64_t, uint16_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(122)) {
+        KERNEL_TASK_TYPE(122, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int64_t, int64_t, false>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(131)) {
+        KERNEL_TASK_TYPE(131, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int64_t, uint16_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    } else if (TILING_KEY_IS(132)) {
+        KERNEL_TASK_TYPE(132, KERNEL_TYPE_MIX_AIC_1_2);
+        RunBcsrSpmmMix<int64_t, int64_t, true>(a_shape, row_ptr, col, val, b, c, workspace, tiling_data);
+    }
 }
\ No newline at end of file
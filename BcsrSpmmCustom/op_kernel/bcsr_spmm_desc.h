@@ -0,0 +1,82 @@
+/**
+ * @file bcsr_spmm_desc.h
+ *
+ * Constants shared by the BcsrSpmmCustom kernel, its tiling function and the
+ * host runner: the a_shape layout, the tiling keys and the layout of the
+ * per-core counter region the instrumented kernel writes to the workspace.
+ * Plain C++ only, so the host side can include it as is.
+ */
+#ifndef BCSR_SPMM_DESC_H
+#define BCSR_SPMM_DESC_H
+
+#include <cstdint>
+
+// a_shape = [M, K] 或 [M, K, flags, signature, tune, denseNum[, mixNum]]
+constexpr uint32_t BCSR_SPMM_SHAPE_FLAGS = 2;
+constexpr uint32_t BCSR_SPMM_SHAPE_SIGNATURE = 3;  // 行窗口分布摘要，见 op_host/bcsr_spmm_tune.h
+constexpr uint32_t BCSR_SPMM_SHAPE_TUNE = 4;       // 打包的调优参数，BCSR_SPMM_FLAG_TUNE 时生效
+constexpr uint32_t BCSR_SPMM_SHAPE_DENSE = 5;      // host 分出的稠密窗口数，BCSR_SPMM_FLAG_DENSE 时生效
+constexpr uint32_t BCSR_SPMM_SHAPE_MIX = 6;        // host 分给向量核的窗口数，BCSR_SPMM_FLAG_MIX 时生效
+constexpr uint32_t BCSR_SPMM_SHAPE_NUM = 7;
+constexpr int64_t BCSR_SPMM_FLAG_PROFILE = 1;   // 选择插桩版 kernel，并申请计数区
+constexpr int64_t BCSR_SPMM_FLAG_TUNE = 2;      // 使用 a_shape 中的调优参数，不查调优库
+constexpr int64_t BCSR_SPMM_FLAG_DIRECT_OUTPUT = 4;  // kernel 覆盖写 C 的每个元素，host 不再清零 C
+constexpr int64_t BCSR_SPMM_FLAG_B_CACHE = 8;   // cube kernel 在 L1 中按块列缓存 B 面板
+constexpr int64_t BCSR_SPMM_FLAG_SCHEDULE = 16; // cube kernel 按 host 写入 workspace 的窗口次序执行
+constexpr int64_t BCSR_SPMM_FLAG_DENSE = 32;    // 稠密窗口从 workspace 中的稠密行按整段 K 做 Mmad
+constexpr int64_t BCSR_SPMM_FLAG_MIX = 64;      // MIX 模式：调度表尾部的稀疏窗口由向量核逐非零元乘加
+
+// L1 中 B 面板缓存的槽位上限，直接映射，槽位数为 2 的幂
+constexpr uint32_t BCSR_SPMM_B_CACHE_MAX_SLOTS = 256;
+
+// 稠密窗口一次 Mmad 的 K 上限，实际取值还受 L0B 容量限制
+constexpr uint32_t BCSR_SPMM_DENSE_MAX_K_TILE = 512;
+
+// MIX 模式向量核一次累加的 N 列上限，实际取值还受 UB 容量限制
+constexpr uint32_t BCSR_SPMM_MIX_MAX_N_TILE = 2048;
+
+// 行窗口在 core 间的分配方式
+constexpr uint32_t BCSR_SPMM_PARTITION_CONTIGUOUS = 0;   // 连续区间，former / tail 切分
+constexpr uint32_t BCSR_SPMM_PARTITION_CYCLIC = 1;       // 窗口 w 归 core w % blockDim
+constexpr uint32_t BCSR_SPMM_PARTITION_SCHEDULED = 2;    // 调度表第 i 项归 core i % blockDim，由 FLAG_SCHEDULE / FLAG_MIX 选择
+
+// tiling key 与 kernel 中 TILING_KEY_IS 的分支一一对应
+constexpr uint64_t BCSR_SPMM_TILING_KEY_COL_INT32 = 0;
+constexpr uint64_t BCSR_SPMM_TILING_KEY_COL_UINT16 = 1;
+constexpr uint64_t BCSR_SPMM_TILING_KEY_COL_INT64 = 2;
+constexpr uint64_t BCSR_SPMM_TILING_KEY_ROW_PTR_INT64 = 40;  // 加在 col 编码的 key 上，int64 col 只与它组合
+constexpr uint64_t BCSR_SPMM_TILING_KEY_PROFILE = 10;   // 加在 col 编码的 key 上
+constexpr uint64_t BCSR_SPMM_TILING_KEY_SMALL_N = 20;   // 加在 col 编码的 key 上，可再加 PROFILE
+constexpr uint64_t BCSR_SPMM_TILING_KEY_MIX = 80;       // cube 与向量核同时启动，可再加 PROFILE 与 ROW_PTR_INT64
+
+// N 小于此值时走 AIV 向量 kernel：Cube 的 16 x 16 x mmadN 中几乎全是补零的列
+constexpr int64_t BCSR_SPMM_SMALL_N = 16;
+
+// 计数区：每个 core 一个槽位，槽位内为 uint64 计数器
+enum BcsrSpmmCounter {
+    BCSR_SPMM_CNT_MAGIC = 0,        // BCSR_SPMM_PROFILE_MAGIC，未写入的槽位为 0
+    BCSR_SPMM_CNT_BLOCK_DIM,
+    BCSR_SPMM_CNT_CYCLE_MHZ,        // 周期计数的频率
+    BCSR_SPMM_CNT_WINDOWS,
+    BCSR_SPMM_CNT_BLOCKS,
+    BCSR_SPMM_CNT_MMADS,            // 向量 kernel 中为块乘向量的次数
+    BCSR_SPMM_CNT_B_BYTES,
+    BCSR_SPMM_CNT_CYCLES,           // Process 的总周期
+    BCSR_SPMM_CNT_COPY_IN_A,        // 以下为各流水阶段的累计周期
+    BCSR_SPMM_CNT_COPY_IN_B,
+    BCSR_SPMM_CNT_SPLIT,
+    BCSR_SPMM_CNT_COMPUTE,
+    BCSR_SPMM_CNT_COPY_OUT,
+    BCSR_SPMM_CNT_B_HITS,           // B 面板缓存命中次数，命中的面板不计入 B_BYTES
+    BCSR_SPMM_CNT_DENSE_WINDOWS,    // 走稠密行路径的窗口数，已计入 WINDOWS
+    BCSR_SPMM_CNT_VECTOR,           // MIX 模式下由向量核写入的槽位为 1，排在全部 cube core 之后
+    BCSR_SPMM_CNT_NUM = 16
+};
+
+constexpr uint64_t BCSR_SPMM_PROFILE_MAGIC = 0x464f525052534342ULL;    // "BCSRPROF"
+constexpr uint64_t BCSR_SPMM_SYSTEM_CYCLE_MHZ = 50;                    // GetSystemCycle on ascend910b
+constexpr uint32_t BCSR_SPMM_PROFILE_MAX_CORES = 128;    // MIX 模式为 cube core 数的 3 倍
+constexpr uint32_t BCSR_SPMM_PROFILE_SLOT_BYTES = BCSR_SPMM_CNT_NUM * sizeof(uint64_t);
+constexpr uint32_t BCSR_SPMM_PROFILE_BYTES = BCSR_SPMM_PROFILE_MAX_CORES * BCSR_SPMM_PROFILE_SLOT_BYTES;
+
+#endif // BCSR_SPMM_DESC_H
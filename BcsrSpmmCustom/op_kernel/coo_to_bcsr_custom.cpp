@@ -0,0 +1,341 @@
+#include "kernel_operator.h"
+#include "coo_to_bcsr_desc.h"
+
+
+// 按行有序的 COO -> BcsrSpmmCustom 使用的 BCSR，每个 AIV core 负责一段连续的行窗口：
+//   1. 用块列位图统计每个窗口的块数，暂存到 row_ptr[w + 1]，本 core 的块数写入 workspace 槽位
+//   2. SyncAll 后由前序 core 的块数得到本 core 的块偏移，把 row_ptr 改写为前缀和
+//   3. 总块数不超过 capacity 时，块序号为块列在位图中的秩，块在 UB 中拼装后写出
+// 越界元素丢弃，同一位置的重复元素以后出现的为准，与 host 的 BuildBcsr 一致
+class CooToBcsrKernel {
+uint32_t TILE = COO_TO_BCSR_TILE;
+uint32_t TILE_SIZE = COO_TO_BCSR_TILE * COO_TO_BCSR_TILE;
+
+public:
+    __aicore__ inline CooToBcsrKernel() {}
+    __aicore__ inline void Init(
+        GM_ADDR row, GM_ADDR col, GM_ADDR value,
+        GM_ADDR row_ptr, GM_ADDR bcsr_col, GM_ADDR bcsr_val, GM_ADDR workspace,
+        int32_t M, int32_t K, uint32_t nnz, uint32_t capacity,
+        uint32_t totalLength, uint32_t bitmapWords,
+        uint32_t formerNum, uint32_t formerLength,
+        uint32_t tailNum, uint32_t tailLength
+    ) {
+        // set vector only
+        KERNEL_TASK_TYPE_DEFAULT(KERNEL_TYPE_AIV_ONLY);
+
+        this->M = M;
+        this->K = K;
+        this->nnz = nnz;
+        this->capacity = capacity;
+        this->bitmapWords = bitmapWords;
+        if (AscendC::GetBlockIdx() < formerNum) {
+            this->windowStart = formerLength * AscendC::GetBlockIdx();
+            this->windowNum = formerLength;
+        } else {
+            this->windowStart = formerLength * formerNum + tailLength * (AscendC::GetBlockIdx() - formerNum);
+            this->windowNum = tailLength;
+        }
+
+        rowGm.SetGlobalBuffer((__gm__ int32_t *)row, nnz);
+        colGm.SetGlobalBuffer((__gm__ int32_t *)col, nnz);
+        valueGm.SetGlobalBuffer((__gm__ half *)value, nnz);
+        rowPtrGm.SetGlobalBuffer((__gm__ int32_t *)row_ptr, totalLength + 1);
+        bcsrColGm.SetGlobalBuffer((__gm__ int32_t *)bcsr_col, capacity);
+        bcsrValGm.SetGlobalBuffer((__gm__ half *)bcsr_val, (uint64_t)capacity * TILE_SIZE);
+        totalGm.SetGlobalBuffer((__gm__ int32_t *)AscendC::GetUserWorkspace(workspace),
+            COO_TO_BCSR_MAX_CORES * COO_TO_BCSR_TOTAL_SLOT);
+
+        pipe.InitBuffer(bitmapBuf, bitmapWords * sizeof(uint64_t));
+        pipe.InitBuffer(prefixBuf, bitmapWords * sizeof(uint32_t));
+        pipe.InitBuffer(rowBuf, (COO_TO_BCSR_ROW_SEGMENT + 8) * sizeof(int32_t));
+        pipe.InitBuffer(totalBuf, COO_TO_BCSR_MAX_CORES * COO_TO_BCSR_TOTAL_SLOT * sizeof(int32_t));
+        pipe.InitBuffer(colBuf, COO_TO_BCSR_CHUNK_BLOCKS * sizeof(int32_t));
+        pipe.InitBuffer(valBuf, COO_TO_BCSR_CHUNK_BLOCKS * TILE_SIZE * sizeof(half));
+
+        bitmap = bitmapBuf.Get<uint64_t>();
+        prefix = prefixBuf.Get<uint32_t>();
+        AscendC::Duplicate(bitmap.ReinterpretCast<uint32_t>(), (uint32_t)0, bitmapWords * 2);
+        WaitPipe<AscendC::HardEvent::V_S>();
+    }
+
+    __aicore__ inline void Process()
+    {
+        entryStart = LowerBound(windowStart * TILE);
+        int32_t blocks = CountWindows();
+        int32_t blockOffset = 0;
+        int32_t blockNum = ExchangeTotals(blocks, blockOffset);
+        WriteRowPtr(blockOffset);
+        // 容量不足时只给出 row_ptr，host 按 row_ptr[windowNum] 扩容后重新转换
+        if (blockNum <= (int32_t)capacity) {
+            Fill(blockOffset);
+        }
+    }
+
+private:
+    template <AscendC::HardEvent EVENT>
+    __aicore__ inline void WaitPipe() {
+        event_t eventId = static_cast<event_t>(GetTPipePtr()->FetchEventID(EVENT));
+        AscendC::SetFlag<EVENT>(eventId);
+        AscendC::WaitFlag<EVENT>(eventId);
+    }
+
+    // 第一个行号不小于 target 的元素
+    __aicore__ inline uint32_t LowerBound(int32_t target) {
+        uint32_t lo = 0;
+        uint32_t hi = nnz;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (rowGm.GetValue(mid) < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // 窗口 w 的元素区间 [begin, end)，越过 M 的行不属于任何窗口
+    __aicore__ inline uint32_t WindowEnd(uint32_t w, uint32_t begin) {
+        int32_t rowEnd = (int32_t)((w + 1) * TILE) < M ? (int32_t)((w + 1) * TILE) : M;
+        uint32_t end = begin;
+        while (end < nnz && rowGm.GetValue(end) < rowEnd) {
+            end++;
+        }
+        return end;
+    }
+
+    __aicore__ inline bool Valid(uint32_t entry) {
+        int32_t c = colGm.GetValue(entry);
+        return c >= 0 && c < K;
+    }
+
+    // 置位窗口内元素的块列，返回新出现的块数，并记录涉及的位图字范围
+    __aicore__ inline int32_t MarkWindow(uint32_t begin, uint32_t end) {
+        int32_t blocks = 0;
+        minWord = bitmapWords;
+        maxWord = 0;
+        for (uint32_t e = begin; e < end; e++) {
+            if (!Valid(e)) {
+                continue;
+            }
+            uint32_t blockCol = colGm.GetValue(e) / TILE;
+            uint32_t word = blockCol / 64;
+            uint64_t bit = (uint64_t)1 << (blockCol % 64);
+            uint64_t bits = bitmap.GetValue(word);
+            if ((bits & bit) == 0) {
+                bitmap.SetValue(word, bits | bit);
+                blocks++;
+            }
+            minWord = word < minWord ? word : minWord;
+            maxWord = word > maxWord ? word : maxWord;
+        }
+        return blocks;
+    }
+
+    __aicore__ inline void ClearWindow() {
+        for (uint32_t word = minWord; word <= maxWord && word < bitmapWords; word++) {
+            bitmap.SetValue(word, 0);
+        }
+    }
+
+    __aicore__ inline int32_t CountWindows() {
+        AscendC::LocalTensor<int32_t> rowLocal = rowBuf.Get<int32_t>();
+        int32_t total = 0;
+        uint32_t entry = entryStart;
+        for (uint32_t s = 0; s < windowNum; s += COO_TO_BCSR_ROW_SEGMENT) {
+            uint32_t segment = windowNum - s < COO_TO_BCSR_ROW_SEGMENT ? windowNum - s : COO_TO_BCSR_ROW_SEGMENT;
+            for (uint32_t i = 0; i < segment; i++) {
+                uint32_t end = WindowEnd(windowStart + s + i, entry);
+                int32_t blocks = MarkWindow(entry, end);
+                ClearWindow();
+                rowLocal.SetValue(i, blocks);
+                total += blocks;
+                entry = end;
+            }
+            // 块数暂存到 row_ptr[w + 1]，SyncAll 后再改写为前缀和
+            WaitPipe<AscendC::HardEvent::S_MTE3>();
+            AscendC::DataCopyExtParams params{1, segment * (uint32_t)sizeof(int32_t), 0, 0, 0};
+            AscendC::DataCopyPad(rowPtrGm[windowStart + s + 1], rowLocal, params);
+            WaitPipe<AscendC::HardEvent::MTE3_S>();
+        }
+        return total;
+    }
+
+    // 各 core 交换块数，返回总块数，blockOffset 为前序 core 的块数之和
+    __aicore__ inline int32_t ExchangeTotals(int32_t blocks, int32_t &blockOffset) {
+        AscendC::LocalTensor<int32_t> totalLocal = totalBuf.Get<int32_t>();
+        totalLocal.SetValue(0, blocks);
+        WaitPipe<AscendC::HardEvent::S_MTE3>();
+        AscendC::DataCopy(totalGm[AscendC::GetBlockIdx() * COO_TO_BCSR_TOTAL_SLOT], totalLocal,
+            COO_TO_BCSR_TOTAL_SLOT);
+        AscendC::PipeBarrier<PIPE_ALL>();
+        AscendC::SyncAll();
+
+        uint32_t blockDim = AscendC::GetBlockNum();
+        AscendC::DataCopy(totalLocal, totalGm, blockDim * COO_TO_BCSR_TOTAL_SLOT);
+        WaitPipe<AscendC::HardEvent::MTE2_S>();
+        int32_t blockNum = 0;
+        blockOffset = 0;
+        for (uint32_t i = 0; i < blockDim; i++) {
+            int32_t count = totalLocal.GetValue(i * COO_TO_BCSR_TOTAL_SLOT);
+            if (i < AscendC::GetBlockIdx()) {
+                blockOffset += count;
+            }
+            blockNum += count;
+        }
+        return blockNum;
+    }
+
+    __aicore__ inline void WriteRowPtr(int32_t blockOffset) {
+        AscendC::LocalTensor<int32_t> rowLocal = rowBuf.Get<int32_t>();
+        int32_t running = blockOffset;
+        if (AscendC::GetBlockIdx() == 0) {
+            rowLocal.SetValue(0, 0);
+            WaitPipe<AscendC::HardEvent::S_MTE3>();
+            AscendC::DataCopyExtParams params{1, (uint32_t)sizeof(int32_t), 0, 0, 0};
+            AscendC::DataCopyPad(rowPtrGm, rowLocal, params);
+            WaitPipe<AscendC::HardEvent::MTE3_S>();
+        }
+        for (uint32_t s = 0; s < windowNum; s += COO_TO_BCSR_ROW_SEGMENT) {
+            uint32_t segment = windowNum - s < COO_TO_BCSR_ROW_SEGMENT ? windowNum - s : COO_TO_BCSR_ROW_SEGMENT;
+            AscendC::DataCopyExtParams params{1, segment * (uint32_t)sizeof(int32_t), 0, 0, 0};
+            AscendC::DataCopyPadExtParams<int32_t> padParams{false, 0, 0, 0};
+            AscendC::DataCopyPad(rowLocal, rowPtrGm[windowStart + s + 1], params, padParams);
+            WaitPipe<AscendC::HardEvent::MTE2_S>();
+            for (uint32_t i = 0; i < segment; i++) {
+                running += rowLocal.GetValue(i);
+                rowLocal.SetValue(i, running);
+            }
+            WaitPipe<AscendC::HardEvent::S_MTE3>();
+            AscendC::DataCopyPad(rowPtrGm[windowStart + s + 1], rowLocal, params);
+            WaitPipe<AscendC::HardEvent::MTE3_S>();
+        }
+    }
+
+    // 块列在窗口内的序号：所在字之前的块数加字内低位的置位数
+    __aicore__ inline int32_t Rank(uint32_t blockCol) {
+        uint32_t word = blockCol / 64;
+        uint64_t mask = ((uint64_t)1 << (blockCol % 64)) - 1;
+        return (int32_t)prefix.GetValue(word) +
+            (int32_t)AscendC::ScalarGetCountOfValue<1>(bitmap.GetValue(word) & mask);
+    }
+
+    __aicore__ inline void Fill(int32_t blockOffset) {
+        AscendC::LocalTensor<int32_t> colLocal = colBuf.Get<int32_t>();
+        AscendC::LocalTensor<half> valLocal = valBuf.Get<half>();
+        uint32_t entry = entryStart;
+        for (uint32_t i = 0; i < windowNum; i++) {
+            uint32_t end = WindowEnd(windowStart + i, entry);
+            int32_t blocks = MarkWindow(entry, end);
+            uint32_t running = 0;
+            for (uint32_t word = minWord; word <= maxWord && word < bitmapWords; word++) {
+                prefix.SetValue(word, running);
+                running += (uint32_t)AscendC::ScalarGetCountOfValue<1>(bitmap.GetValue(word));
+            }
+
+            // col：按块列升序，一次写出一段
+            uint32_t filled = 0;
+            for (uint32_t word = minWord; word <= maxWord && word < bitmapWords; word++) {
+                uint64_t bits = bitmap.GetValue(word);
+                for (uint32_t b = 0; b < 64 && bits != 0; b++) {
+                    if ((bits & ((uint64_t)1 << b)) == 0) {
+                        continue;
+                    }
+                    bits &= ~((uint64_t)1 << b);
+                    colLocal.SetValue(filled % COO_TO_BCSR_CHUNK_BLOCKS, (int32_t)((word * 64 + b) * TILE));
+                    filled++;
+                    if (filled % COO_TO_BCSR_CHUNK_BLOCKS == 0) {
+                        CopyOutCol(colLocal, blockOffset + filled - COO_TO_BCSR_CHUNK_BLOCKS,
+                            COO_TO_BCSR_CHUNK_BLOCKS);
+                    }
+                }
+            }
+            if (filled % COO_TO_BCSR_CHUNK_BLOCKS != 0) {
+                CopyOutCol(colLocal, blockOffset + filled - filled % COO_TO_BCSR_CHUNK_BLOCKS,
+                    filled % COO_TO_BCSR_CHUNK_BLOCKS);
+            }
+
+            // val：每段块先清零，再把落在本段的元素按块内行主序写入
+            for (int32_t c0 = 0; c0 < blocks; c0 += COO_TO_BCSR_CHUNK_BLOCKS) {
+                int32_t chunk = blocks - c0 < (int32_t)COO_TO_BCSR_CHUNK_BLOCKS ?
+                    blocks - c0 : (int32_t)COO_TO_BCSR_CHUNK_BLOCKS;
+                AscendC::Duplicate(valLocal, (half)0, chunk * TILE_SIZE);
+                WaitPipe<AscendC::HardEvent::V_S>();
+                for (uint32_t e = entry; e < end; e++) {
+                    if (!Valid(e)) {
+                        continue;
+                    }
+                    int32_t c = colGm.GetValue(e);
+                    int32_t rank = Rank(c / TILE) - c0;
+                    if (rank < 0 || rank >= chunk) {
+                        continue;
+                    }
+                    int32_t r = rowGm.GetValue(e);
+                    valLocal.SetValue(rank * TILE_SIZE + (r % TILE) * TILE + c % TILE, valueGm.GetValue(e));
+                }
+                WaitPipe<AscendC::HardEvent::S_MTE3>();
+                AscendC::DataCopy(bcsrValGm[(uint64_t)(blockOffset + c0) * TILE_SIZE], valLocal, chunk * TILE_SIZE);
+                WaitPipe<AscendC::HardEvent::MTE3_V>();
+            }
+
+            ClearWindow();
+            blockOffset += blocks;
+            entry = end;
+        }
+    }
+
+    __aicore__ inline void CopyOutCol(AscendC::LocalTensor<int32_t> &colLocal, int32_t offset, uint32_t count) {
+        WaitPipe<AscendC::HardEvent::S_MTE3>();
+        AscendC::DataCopyExtParams params{1, count * (uint32_t)sizeof(int32_t), 0, 0, 0};
+        AscendC::DataCopyPad(bcsrColGm[offset], colLocal, params);
+        WaitPipe<AscendC::HardEvent::MTE3_S>();
+    }
+
+private:
+    AscendC::TPipe pipe;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> bitmapBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> prefixBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> rowBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> totalBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> colBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> valBuf;
+    AscendC::LocalTensor<uint64_t> bitmap;
+    AscendC::LocalTensor<uint32_t> prefix;
+
+    AscendC::GlobalTensor<int32_t> rowGm;
+    AscendC::GlobalTensor<int32_t> colGm;
+    AscendC::GlobalTensor<half> valueGm;
+    AscendC::GlobalTensor<int32_t> rowPtrGm;
+    AscendC::GlobalTensor<int32_t> bcsrColGm;
+    AscendC::GlobalTensor<half> bcsrValGm;
+    AscendC::GlobalTensor<int32_t> totalGm;
+
+    int32_t M;
+    int32_t K;
+    uint32_t nnz;
+    uint32_t capacity;
+    uint32_t bitmapWords;
+    uint32_t windowStart;
+    uint32_t windowNum;
+    uint32_t entryStart;
+    uint32_t minWord;
+    uint32_t maxWord;
+};
+
+extern "C" __global__ __aicore__ void coo_to_bcsr_custom(
+    GM_ADDR coo_shape, GM_ADDR row, GM_ADDR col, GM_ADDR value,
+    GM_ADDR row_ptr, GM_ADDR bcsr_col, GM_ADDR bcsr_val,
+    GM_ADDR workspace, GM_ADDR tiling
+) {
+    GET_TILING_DATA(tiling_data, tiling);
+
+    CooToBcsrKernel op;
+    op.Init(row, col, value, row_ptr, bcsr_col, bcsr_val, workspace,
+        tiling_data.M, tiling_data.K, tiling_data.nnz, tiling_data.capacity,
+        tiling_data.totalLength, tiling_data.bitmapWords,
+        tiling_data.formerNum, tiling_data.formerLength,
+        tiling_data.tailNum, tiling_data.tailLength
+    );
+    op.Process();
+}
@@ -0,0 +1,25 @@
+/**
+ * @file coo_to_bcsr_desc.h
+ *
+ * Constants shared by the CooToBcsrCustom kernel, its tiling function and the
+ * host runner: the coo_shape layout and the UB budget of the kernel. Plain
+ * C++ only, so the host side can include it as is.
+ */
+#ifndef COO_TO_BCSR_DESC_H
+#define COO_TO_BCSR_DESC_H
+
+#include <cstdint>
+
+// coo_shape = [M, K, capacity]，capacity 为 bcsr_col 能容纳的块数
+constexpr uint32_t COO_TO_BCSR_SHAPE_CAPACITY = 2;
+constexpr uint32_t COO_TO_BCSR_SHAPE_NUM = 3;
+
+constexpr uint32_t COO_TO_BCSR_TILE = 16;       // 与 BcsrSpmmCustom 的 16 x 16 块一致
+// 每个窗口的块列位图常驻 UB，一个 uint64 覆盖 64 个块列，K 上限为 4096 * 64 * 16
+constexpr uint32_t COO_TO_BCSR_MAX_BITMAP_WORDS = 4096;
+constexpr uint32_t COO_TO_BCSR_CHUNK_BLOCKS = 32;   // 一次在 UB 中拼装的块数，16 KB
+constexpr uint32_t COO_TO_BCSR_ROW_SEGMENT = 1024;  // 一次搬运的 row_ptr 项数
+constexpr uint32_t COO_TO_BCSR_MAX_CORES = 64;
+constexpr uint32_t COO_TO_BCSR_TOTAL_SLOT = 8;      // workspace 中每个 core 一个 32B 槽位，存本 core 的块数
+
+#endif // COO_TO_BCSR_DESC_H
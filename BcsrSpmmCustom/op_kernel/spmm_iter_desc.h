@@ -0,0 +1,24 @@
+/**
+ * @file spmm_iter_desc.h
+ *
+ * Constants shared by the SpmmIterEpilogueCustom kernel, its tiling function
+ * and the host iteration loop: the split of C into per-core ranges and the
+ * layout of the per-core norm slots. Plain C++ only, so the host side can
+ * include it as is.
+ */
+#ifndef SPMM_ITER_DESC_H
+#define SPMM_ITER_DESC_H
+
+#include <cstdint>
+
+constexpr uint32_t SPMM_ITER_ALIGN = 16;        // 每个 core 的元素段按 16 个对齐，fp16 输出 32B 对齐
+constexpr uint32_t SPMM_ITER_TILE = 2048;       // 一次搬运的元素数
+constexpr uint32_t SPMM_ITER_MAX_CORES = 64;
+
+// norm 输出：每个 core 一个 64B 槽位，未运行的 core 槽位保持 host 清零后的 0，host 对所有槽位求和
+constexpr uint32_t SPMM_ITER_NORM_SLOT = 16;    // float 个数
+constexpr uint32_t SPMM_ITER_NORM_NEW = 0;      // sum(x_next^2)
+constexpr uint32_t SPMM_ITER_NORM_DELTA = 8;    // sum((x_next - x)^2)
+constexpr uint32_t SPMM_ITER_NORM_NUM = SPMM_ITER_MAX_CORES * SPMM_ITER_NORM_SLOT;
+
+#endif // SPMM_ITER_DESC_H
@@ -0,0 +1,165 @@
+#include "kernel_operator.h"
+#include "spmm_iter_desc.h"
+
+
+// 迭代 SpMM 每一步的收尾：x_next = fp16(scale * c)，作为下一步 BcsrSpmmCustom 的 B。
+// with_norm 时同时累加 sum(x_next^2) 与 sum((x_next - x)^2)，按 fp32 的 scale * c 计算，
+// 每个 core 的部分和写入 norm 中自己的槽位，由 host 求和，不需要原子加或核间同步
+class SpmmIterEpilogueKernel {
+public:
+    __aicore__ inline SpmmIterEpilogueKernel() {}
+    __aicore__ inline void Init(
+        GM_ADDR c, GM_ADDR x, GM_ADDR x_next, GM_ADDR norm,
+        uint32_t totalLength, uint32_t formerNum, uint32_t formerLength,
+        uint32_t tailLength, uint32_t tileLength, float scale, uint32_t withNorm
+    ) {
+        // set vector only
+        KERNEL_TASK_TYPE_DEFAULT(KERNEL_TYPE_AIV_ONLY);
+
+        uint32_t blockIdx = AscendC::GetBlockIdx();
+        uint32_t start = blockIdx < formerNum ? formerLength * blockIdx :
+            formerLength * formerNum + tailLength * (blockIdx - formerNum);
+        uint32_t length = blockIdx < formerNum ? formerLength : tailLength;
+        // 段长按 SPMM_ITER_ALIGN 取整，最后一段截到实际长度
+        if (start >= totalLength) {
+            length = 0;
+        } else if (length > totalLength - start) {
+            length = totalLength - start;
+        }
+        this->length = length;
+        this->tileLength = tileLength;
+        this->scale = scale;
+        this->withNorm = withNorm != 0;
+
+        cGm.SetGlobalBuffer((__gm__ float *)c + start, length);
+        xGm.SetGlobalBuffer((__gm__ half *)x + start, length);
+        xNextGm.SetGlobalBuffer((__gm__ half *)x_next + start, length);
+        normGm.SetGlobalBuffer((__gm__ float *)norm + blockIdx * SPMM_ITER_NORM_SLOT, SPMM_ITER_NORM_SLOT);
+
+        pipe.InitBuffer(inQueueC, 2, tileLength * sizeof(float));
+        pipe.InitBuffer(inQueueX, 2, tileLength * sizeof(half));
+        pipe.InitBuffer(outQueueX, 2, tileLength * sizeof(half));
+        pipe.InitBuffer(outQueueNorm, 1, SPMM_ITER_NORM_SLOT * sizeof(float));
+        pipe.InitBuffer(xFloatBuf, tileLength * sizeof(float));
+        pipe.InitBuffer(newSumBuf, tileLength * sizeof(float));
+        pipe.InitBuffer(deltaSumBuf, tileLength * sizeof(float));
+        pipe.InitBuffer(workBuf, tileLength * sizeof(float));
+    }
+
+    __aicore__ inline void Process()
+    {
+        if (withNorm) {
+            AscendC::Duplicate(newSumBuf.Get<float>(), 0.0f, tileLength);
+            AscendC::Duplicate(deltaSumBuf.Get<float>(), 0.0f, tileLength);
+        }
+        for (uint32_t offset = 0; offset < length; offset += tileLength) {
+            uint32_t count = length - offset < tileLength ? length - offset : tileLength;
+            CopyIn(offset, count);
+            Compute(count);
+            CopyOut(offset, count);
+        }
+        if (withNorm) {
+            WriteNorm();
+        }
+    }
+
+private:
+    // 元素数不一定是 8 的倍数，用 DataCopyPad 按字节搬运
+    __aicore__ inline void CopyIn(uint32_t offset, uint32_t count) {
+        AscendC::DataCopyExtParams cParams{1, (uint32_t)(count * sizeof(float)), 0, 0, 0};
+        AscendC::DataCopyPadExtParams<float> cPad{false, 0, 0, 0};
+        AscendC::LocalTensor<float> cLocal = inQueueC.AllocTensor<float>();
+        AscendC::DataCopyPad(cLocal, cGm[offset], cParams, cPad);
+        inQueueC.EnQue<float>(cLocal);
+        if (withNorm) {
+            AscendC::DataCopyExtParams xParams{1, (uint32_t)(count * sizeof(half)), 0, 0, 0};
+            AscendC::DataCopyPadExtParams<half> xPad{false, 0, 0, 0};
+            AscendC::LocalTensor<half> xLocal = inQueueX.AllocTensor<half>();
+            AscendC::DataCopyPad(xLocal, xGm[offset], xParams, xPad);
+            inQueueX.EnQue<half>(xLocal);
+        }
+    }
+
+    __aicore__ inline void Compute(uint32_t count) {
+        AscendC::LocalTensor<float> cLocal = inQueueC.DeQue<float>();
+        AscendC::LocalTensor<half> xNextLocal = outQueueX.AllocTensor<half>();
+        AscendC::Muls(cLocal, cLocal, scale, count);
+        AscendC::PipeBarrier<PIPE_V>();
+        AscendC::Cast(xNextLocal, cLocal, AscendC::RoundMode::CAST_RINT, count);
+        if (withNorm) {
+            // 只累加有效的 count 个元素，累加区其余部分保持 0
+            AscendC::LocalTensor<half> xLocal = inQueueX.DeQue<half>();
+            AscendC::LocalTensor<float> xFloat = xFloatBuf.Get<float>();
+            AscendC::LocalTensor<float> newSum = newSumBuf.Get<float>();
+            AscendC::LocalTensor<float> deltaSum = deltaSumBuf.Get<float>();
+            AscendC::Cast(xFloat, xLocal, AscendC::RoundMode::CAST_NONE, count);
+            AscendC::PipeBarrier<PIPE_V>();
+            AscendC::Sub(xFloat, cLocal, xFloat, count);
+            AscendC::Mul(cLocal, cLocal, cLocal, count);
+            AscendC::PipeBarrier<PIPE_V>();
+            AscendC::Mul(xFloat, xFloat, xFloat, count);
+            AscendC::Add(newSum, newSum, cLocal, count);
+            AscendC::PipeBarrier<PIPE_V>();
+            AscendC::Add(deltaSum, deltaSum, xFloat, count);
+            inQueueX.FreeTensor(xLocal);
+        }
+        outQueueX.EnQue<half>(xNextLocal);
+        inQueueC.FreeTensor(cLocal);
+    }
+
+    __aicore__ inline void CopyOut(uint32_t offset, uint32_t count) {
+        AscendC::LocalTensor<half> xNextLocal = outQueueX.DeQue<half>();
+        AscendC::DataCopyExtParams params{1, (uint32_t)(count * sizeof(half)), 0, 0, 0};
+        AscendC::DataCopyPad(xNextGm[offset], xNextLocal, params);
+        outQueueX.FreeTensor(xNextLocal);
+    }
+
+    __aicore__ inline void WriteNorm() {
+        AscendC::LocalTensor<float> normLocal = outQueueNorm.AllocTensor<float>();
+        AscendC::LocalTensor<float> work = workBuf.Get<float>();
+        AscendC::Duplicate(normLocal, 0.0f, SPMM_ITER_NORM_SLOT);
+        AscendC::PipeBarrier<PIPE_V>();
+        AscendC::ReduceSum<float>(normLocal[SPMM_ITER_NORM_NEW], newSumBuf.Get<float>(), work, tileLength);
+        AscendC::PipeBarrier<PIPE_V>();
+        AscendC::ReduceSum<float>(normLocal[SPMM_ITER_NORM_DELTA], deltaSumBuf.Get<float>(), work, tileLength);
+        outQueueNorm.EnQue<float>(normLocal);
+        normLocal = outQueueNorm.DeQue<float>();
+        AscendC::DataCopy(normGm, normLocal, SPMM_ITER_NORM_SLOT);
+        outQueueNorm.FreeTensor(normLocal);
+    }
+
+private:
+    AscendC::TPipe pipe;
+    AscendC::TQue<AscendC::TPosition::VECIN, 2> inQueueC;
+    AscendC::TQue<AscendC::TPosition::VECIN, 2> inQueueX;
+    AscendC::TQue<AscendC::TPosition::VECOUT, 2> outQueueX;
+    AscendC::TQue<AscendC::TPosition::VECOUT, 1> outQueueNorm;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> xFloatBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> newSumBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> deltaSumBuf;
+    AscendC::TBuf<AscendC::TPosition::VECCALC> workBuf;
+
+    AscendC::GlobalTensor<float> cGm;
+    AscendC::GlobalTensor<half> xGm;
+    AscendC::GlobalTensor<half> xNextGm;
+    AscendC::GlobalTensor<float> normGm;
+
+    uint32_t length;
+    uint32_t tileLength;
+    float scale;
+    bool withNorm;
+};
+
+extern "C" __global__ __aicore__ void spmm_iter_epilogue_custom(
+    GM_ADDR c, GM_ADDR x, GM_ADDR x_next, GM_ADDR norm,
+    GM_ADDR workspace, GM_ADDR tiling
+) {
+    GET_TILING_DATA(tiling_data, tiling);
+
+    SpmmIterEpilogueKernel op;
+    op.Init(c, x, x_next, norm,
+        tiling_data.totalLength, tiling_data.formerNum, tiling_data.formerLength,
+        tiling_data.tailLength, tiling_data.tileLength, tiling_data.scale, tiling_data.withNorm
+    );
+    op.Process();
+}
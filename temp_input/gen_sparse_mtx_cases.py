@@ -63,7 +63,7 @@ def _sparse_to_dense(m: int, k: int, entries: List[Tuple[int, int, float]], dtyp
     return a
 
 
-def gen_case(out_root: str, spec: CaseSpec, seed: int) -> None:
+def gen_case(out_root: str, spec: CaseSpec, seed: int, golden_mode: str = "numpy") -> None:
     # Removed alignment checks for arbitrary MNK support.
     rng = np.random.default_rng(seed)
 
@@ -81,14 +81,19 @@ def gen_case(out_root: str, spec: CaseSpec, seed: int) -> None:
     # Dense B: float16 KxN, values in [1,10]
     b = rng.integers(1, 11, size=(spec.k, spec.n), dtype=np.int32).astype(np.float16)
 
-    # Golden: float32 output (matches verify_result.py which reads float32)
-    a = _sparse_to_dense(spec.m, spec.k, entries, dtype=np.float16)
-    golden = (a.astype(np.float32) @ b.astype(np.float32)).astype(np.float32)
-
     _write_mtx(mtx_path, spec.m, spec.k, entries)
 
     b.tofile(os.path.join(sample_dir, "x2_gm.bin"))
-    golden.tofile(os.path.join(sample_dir, "golden.bin"))
+    golden_path = os.path.join(sample_dir, "golden.bin")
+    if golden_mode == "numpy":
+        # Golden: float32 output (matches verify_result.py which reads float32)
+        a = _sparse_to_dense(spec.m, spec.k, entries, dtype=np.float16)
+        golden = (a.astype(np.float32) @ b.astype(np.float32)).astype(np.float32)
+        golden.tofile(golden_path)
+    elif os.path.exists(golden_path):
+        # cpu: the dense A is O(M*K); samples without golden.bin are checked by
+        # `execute_spmm_op --batch` against the CPU engine in memory, nothing is written
+        os.remove(golden_path)
 
     # Helpful metadata: parse_matrix.py prints N=K, so record the intended N here.
     with open(os.path.join(sample_dir, "mnk.txt"), "w", encoding="utf-8") as f:
@@ -96,7 +101,10 @@ def gen_case(out_root: str, spec: CaseSpec, seed: int) -> None:
 
     print(f"[OK] {spec.name}: wrote {mtx_path}")
     print(f"     B: {os.path.join(sample_dir, 'x2_gm.bin')} (float16, shape {b.shape})")
-    print(f"     golden: {os.path.join(sample_dir, 'golden.bin')} (float32, shape {golden.shape})")
+    if golden_mode == "numpy":
+        print(f"     golden: {golden_path} (float32, shape ({spec.m}, {spec.n}))")
+    else:
+        print(f"     golden: computed by the CPU engine at test time")
     print(f"     nnz(A)={len(entries)}")
 
 
@@ -104,6 +112,8 @@ def main() -> None:
     ap = argparse.ArgumentParser(description="Generate aligned sparse A(.mtx), dense B(.bin float16), and golden C(.bin float32)")
     ap.add_argument("--out", default="/root/autodl-tmp/bcsr/temp_input", help="output root directory")
     ap.add_argument("--seed", type=int, default=20251213, help="random seed")
+    ap.add_argument("--golden", choices=["numpy", "cpu"], default="numpy",
+                    help="numpy: dense matmul here; cpu: no golden.bin, the batch driver verifies against the C++ CPU engine (large cases)")
     args = ap.parse_args()
 
     specs = [
@@ -116,7 +126,7 @@ def main() -> None:
     ]
 
     for i, spec in enumerate(specs):
-        gen_case(args.out, spec, seed=args.seed + i)
+        gen_case(args.out, spec, seed=args.seed + i, golden_mode=args.golden)
 
 
 if __name__ == "__main__":